@@ -306,18 +306,10 @@ documents_recreate_preview_cmd_callback (GimpAction *action,
 
   if (imagefile && gimp_container_have (container, GIMP_OBJECT (imagefile)))
     {
-      GError *error = NULL;
-
-      if (! gimp_imagefile_create_thumbnail (imagefile,
-                                             context, NULL,
-                                             context->gimp->config->thumbnail_size,
-                                             FALSE, &error))
-        {
-          gimp_message_literal (context->gimp,
-                                NULL , GIMP_MESSAGE_ERROR,
-                                error->message);
-          g_clear_error (&error);
-        }
+      /*  errors are reported when the thumbnail is done  */
+      gimp_imagefile_queue_thumbnail (imagefile, context,
+                                      context->gimp->config->thumbnail_size,
+                                      TRUE, TRUE);
     }
 }
 
@@ -33,6 +33,7 @@
 
 #include "core/core-enums.h"
 #include "core/gimp.h"
+#include "core/gimpasync.h"
 #include "core/gimpcontext.h"
 #include "core/gimpimage.h"
 #include "core/gimpimage-color-profile.h"
@@ -180,6 +181,8 @@ static void   image_softproof_profile_callback  (GtkWidget                *dialo
                                                  GimpColorRenderingIntent  intent,
                                                  gboolean                  bpc,
                                                  gpointer                  user_data);
+static void   image_duplicate_async_callback    (GimpAsync                *async,
+                                                 GimpDisplayShell         *shell);
 
 
 
@@ -226,19 +229,21 @@ image_duplicate_cmd_callback (GimpAction *action,
   GimpDisplay      *display;
   GimpImage        *image;
   GimpDisplayShell *shell;
-  GimpImage        *new_image;
+  GimpAsync        *async;
   return_if_no_display (display, data);
 
   image = gimp_display_get_image (display);
   shell = gimp_display_get_shell (display);
 
-  new_image = gimp_image_duplicate (image);
+  async = gimp_image_duplicate_async (image, GIMP_PROGRESS (display));
 
-  gimp_create_display (new_image->gimp, new_image, shell->unit,
-                       gimp_zoom_model_get_factor (shell->zoom),
-                       G_OBJECT (gimp_widget_get_monitor (GTK_WIDGET (shell))));
+  gimp_async_add_callback_for_object (
+    async,
+    (GimpAsyncCallback) image_duplicate_async_callback,
+    shell,
+    shell);
 
-  g_object_unref (new_image);
+  g_object_unref (async);
 }
 
 void
@@ -1622,6 +1627,22 @@ image_softproof_profile_callback (GtkWidget                *dialog,
   gtk_widget_destroy (dialog);
 }
 
+static void
+image_duplicate_async_callback (GimpAsync        *async,
+                                GimpDisplayShell *shell)
+{
+  GimpImage *new_image;
+
+  if (! gimp_async_is_finished (async))
+    return;
+
+  new_image = gimp_async_get_result (async);
+
+  gimp_create_display (new_image->gimp, new_image, shell->unit,
+                       gimp_zoom_model_get_factor (shell->zoom),
+                       G_OBJECT (gimp_widget_get_monitor (GTK_WIDGET (shell))));
+}
+
 void
 image_softproof_intent_cmd_callback (GimpAction *action,
                                      GVariant   *value,
@@ -177,6 +177,7 @@ app_run (const gchar         *full_prog_name,
          const gchar         *session_name,
          const gchar         *batch_interpreter,
          const gchar        **batch_commands,
+         gint                 batch_jobs,
          gboolean             quit,
          gboolean             as_new,
          gboolean             no_interface,
@@ -242,9 +243,9 @@ app_run (const gchar         *full_prog_name,
   g_clear_object (&default_folder);
 
 #ifndef GIMP_CONSOLE_COMPILATION
-  app = gimp_app_new (gimp, no_splash, quit, as_new, filenames, batch_interpreter, batch_commands);
+  app = gimp_app_new (gimp, no_splash, quit, as_new, filenames, batch_interpreter, batch_commands, batch_jobs);
 #else
-  app = gimp_console_app_new (gimp, quit, as_new, filenames, batch_interpreter, batch_commands);
+  app = gimp_console_app_new (gimp, quit, as_new, filenames, batch_interpreter, batch_commands, batch_jobs);
 #endif
 
   gimp->app = app;
@@ -500,7 +501,8 @@ app_activate_callback (GimpCoreApp *app,
 
   batch_retval = gimp_batch_run (gimp,
                                  gimp_core_app_get_batch_interpreter (app),
-                                 gimp_core_app_get_batch_commands (app));
+                                 gimp_core_app_get_batch_commands (app),
+                                 gimp_core_app_get_batch_jobs (app));
 
   if (gimp_core_app_get_quit (app))
     {
@@ -35,6 +35,7 @@ gint  app_run       (const gchar         *full_prog_name,
                      const gchar         *session_name,
                      const gchar         *batch_interpreter,
                      const gchar        **batch_commands,
+                     gint                 batch_jobs,
                      gboolean             quit,
                      gboolean             as_new,
                      gboolean             no_interface,
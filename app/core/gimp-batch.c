@@ -27,6 +27,8 @@
 
 #include "core-types.h"
 
+#include "config/gimpcoreconfig.h"
+
 #include "gimp.h"
 #include "gimp-batch.h"
 #include "gimpparamspecs.h"
@@ -34,25 +36,69 @@
 #include "pdb/gimppdb.h"
 #include "pdb/gimpprocedure.h"
 
+#include "plug-in/gimpplugin.h"
 #include "plug-in/gimppluginmanager.h"
 #include "plug-in/gimppluginprocedure.h"
+#include "plug-in/gimptemporaryprocedure.h"
 
 #include "gimp-intl.h"
 
 
-static void  gimp_batch_exit_after_callback (Gimp          *gimp) G_GNUC_NORETURN;
+typedef struct _GimpBatchJobs GimpBatchJobs;
 
-static gint  gimp_batch_run_cmd             (Gimp          *gimp,
-                                             const gchar   *proc_name,
-                                             GimpProcedure *procedure,
-                                             GimpRunMode    run_mode,
-                                             const gchar   *cmd);
+struct _GimpBatchJobs
+{
+  Gimp           *gimp;
+  GimpProcedure  *procedure;
+  const gchar   **commands;
+  gint            n_commands;
+  gint            max_running;
+
+  GimpPlugIn    **plug_ins;     /* the running interpreter of each job  */
+  gint           *retvals;      /* the exit code of each finished job   */
+  gint            next;         /* the next job to start                */
+  gint            n_running;
+  gint            starting;     /* the job being started, or -1         */
+
+  guint           idle_id;
+  GMainLoop      *main_loop;
+};
+
+
+static void      gimp_batch_exit_after_callback (Gimp              *gimp) G_GNUC_NORETURN;
+
+static GimpValueArray *
+                 gimp_batch_get_arguments       (GimpProcedure     *procedure,
+                                                 GimpRunMode        run_mode,
+                                                 const gchar       *cmd);
+static gint      gimp_batch_get_exit_code       (GimpPDBStatusType  status,
+                                                 const GError      *error);
+
+static gint      gimp_batch_run_cmd             (Gimp              *gimp,
+                                                 const gchar       *proc_name,
+                                                 GimpProcedure     *procedure,
+                                                 GimpRunMode        run_mode,
+                                                 const gchar       *cmd);
+
+static gint      gimp_batch_run_parallel        (Gimp              *gimp,
+                                                 GimpProcedure     *procedure,
+                                                 const gchar      **batch_commands,
+                                                 gint               batch_jobs);
+static gboolean  gimp_batch_jobs_start          (GimpBatchJobs     *jobs);
+static gboolean  gimp_batch_jobs_idle           (GimpBatchJobs     *jobs);
+static void      gimp_batch_jobs_plug_in_opened (GimpPlugInManager *manager,
+                                                 GimpPlugIn        *plug_in,
+                                                 GimpBatchJobs     *jobs);
+static void      gimp_batch_jobs_plug_in_closed (GimpPlugInManager *manager,
+                                                 GimpPlugIn        *plug_in,
+                                                 GimpBatchJobs     *jobs);
 
 
 gint
 gimp_batch_run (Gimp         *gimp,
                 const gchar  *batch_interpreter,
-                const gchar **batch_commands)
+                const gchar **batch_commands,
+                gint          batch_jobs)
 {
   GimpProcedure *eval_proc;
   GSList        *batch_procedures;
@@ -156,8 +202,25 @@ gimp_batch_run (Gimp         *gimp,
                                     G_CALLBACK (gimp_batch_exit_after_callback),
                                     NULL);
 
+  if (batch_jobs == 0)
+    batch_jobs = GIMP_GEGL_CONFIG (gimp->config)->num_processors;
+
   eval_proc = gimp_pdb_lookup_procedure (gimp->pdb, batch_interpreter);
-  if (eval_proc)
+
+  /*  Commands can only run concurrently if each one gets its own
+   *  interpreter process, which is not the case for temporary
+   *  procedures of an extension.
+   */
+  if (eval_proc                                  &&
+      batch_jobs > 1                             &&
+      batch_commands[1]                          &&
+      GIMP_IS_PLUG_IN_PROCEDURE (eval_proc)      &&
+      ! GIMP_IS_TEMPORARY_PROCEDURE (eval_proc))
+    {
+      retval = gimp_batch_run_parallel (gimp, eval_proc,
+                                        batch_commands, batch_jobs);
+    }
+  else if (eval_proc)
     {
       gint i;
 
@@ -215,18 +278,13 @@ GIMP_IS_PARAM_SPEC_RUN_MODE (GParamSpec *pspec)
           pspec->value_type == GIMP_TYPE_RUN_MODE);
 }
 
-static gint
-gimp_batch_run_cmd (Gimp          *gimp,
-                    const gchar   *proc_name,
-                    GimpProcedure *procedure,
-                    GimpRunMode    run_mode,
-                    const gchar   *cmd)
+static GimpValueArray *
+gimp_batch_get_arguments (GimpProcedure *procedure,
+                          GimpRunMode    run_mode,
+                          const gchar   *cmd)
 {
   GimpValueArray *args;
-  GimpValueArray *return_vals;
-  GError         *error  = NULL;
-  gint            i      = 0;
-  gint            retval = EXIT_SUCCESS;
+  gint            i = 0;
 
   args = gimp_procedure_get_arguments (procedure);
 
@@ -242,13 +300,16 @@ gimp_batch_run_cmd (Gimp          *gimp,
       g_value_set_static_string (gimp_value_array_index (args, i++), cmd);
     }
 
-  return_vals =
-    gimp_pdb_execute_procedure_by_name_args (gimp->pdb,
-                                             gimp_get_user_context (gimp),
-                                             NULL, &error,
-                                             proc_name, args);
+  return args;
+}
+
+static gint
+gimp_batch_get_exit_code (GimpPDBStatusType  status,
+                          const GError      *error)
+{
+  gint retval = EXIT_SUCCESS;
 
-  switch (g_value_get_enum (gimp_value_array_index (return_vals, 0)))
+  switch (status)
     {
     case GIMP_PDB_EXECUTION_ERROR:
       /* Using Linux's standard exit code as found in /usr/include/sysexits.h
@@ -297,6 +358,32 @@ gimp_batch_run_cmd (Gimp          *gimp,
       break;
     }
 
+  return retval;
+}
+
+static gint
+gimp_batch_run_cmd (Gimp          *gimp,
+                    const gchar   *proc_name,
+                    GimpProcedure *procedure,
+                    GimpRunMode    run_mode,
+                    const gchar   *cmd)
+{
+  GimpValueArray *args;
+  GimpValueArray *return_vals;
+  GError         *error  = NULL;
+  gint            retval;
+
+  args = gimp_batch_get_arguments (procedure, run_mode, cmd);
+
+  return_vals =
+    gimp_pdb_execute_procedure_by_name_args (gimp->pdb,
+                                             gimp_get_user_context (gimp),
+                                             NULL, &error,
+                                             proc_name, args);
+
+  retval = gimp_batch_get_exit_code (g_value_get_enum (gimp_value_array_index (return_vals, 0)),
+                                     error);
+
   gimp_value_array_unref (return_vals);
   gimp_value_array_unref (args);
 
@@ -305,3 +392,182 @@ gimp_batch_run_cmd (Gimp          *gimp,
 
   return retval;
 }
+
+/*  Runs independent batch commands concurrently, each one in its own
+ *  interpreter plug-in process, with at most @batch_jobs of them
+ *  running at any time.  Unlike the sequential mode, a failing command
+ *  doesn't stop the others; the exit code of each command is reported
+ *  at the end and the first failing one is returned.
+ */
+static gint
+gimp_batch_run_parallel (Gimp           *gimp,
+                         GimpProcedure  *procedure,
+                         const gchar   **batch_commands,
+                         gint            batch_jobs)
+{
+  GimpBatchJobs  jobs      = { 0, };
+  gulong         opened_id;
+  gulong         closed_id;
+  gint           n_failed  = 0;
+  gint           retval    = EXIT_SUCCESS;
+  gint           i;
+
+  jobs.gimp        = gimp;
+  jobs.procedure   = procedure;
+  jobs.commands    = batch_commands;
+  jobs.n_commands  = g_strv_length ((gchar **) batch_commands);
+  jobs.max_running = batch_jobs;
+  jobs.plug_ins    = g_new0 (GimpPlugIn *, jobs.n_commands);
+  jobs.retvals     = g_new0 (gint, jobs.n_commands);
+  jobs.starting    = -1;
+  jobs.main_loop   = g_main_loop_new (NULL, FALSE);
+
+  if (gimp->be_verbose)
+    g_printerr ("Running %d batch commands, %d at a time\n",
+                jobs.n_commands, batch_jobs);
+
+  opened_id = g_signal_connect (gimp->plug_in_manager, "plug-in-opened",
+                                G_CALLBACK (gimp_batch_jobs_plug_in_opened),
+                                &jobs);
+  closed_id = g_signal_connect (gimp->plug_in_manager, "plug-in-closed",
+                                G_CALLBACK (gimp_batch_jobs_plug_in_closed),
+                                &jobs);
+
+  if (gimp_batch_jobs_start (&jobs))
+    g_main_loop_run (jobs.main_loop);
+
+  g_signal_handler_disconnect (gimp->plug_in_manager, opened_id);
+  g_signal_handler_disconnect (gimp->plug_in_manager, closed_id);
+
+  if (jobs.idle_id)
+    g_source_remove (jobs.idle_id);
+
+  for (i = 0; i < jobs.n_commands; i++)
+    {
+      if (jobs.retvals[i] != EXIT_SUCCESS)
+        {
+          g_printerr ("Batch command [%d] failed with exit code %d: %s\n",
+                      i, jobs.retvals[i], batch_commands[i]);
+
+          if (n_failed++ == 0)
+            retval = jobs.retvals[i];
+        }
+    }
+
+  g_printerr ("%d of %d batch commands executed successfully\n",
+              jobs.n_commands - n_failed, jobs.n_commands);
+
+  g_main_loop_unref (jobs.main_loop);
+  g_free (jobs.plug_ins);
+  g_free (jobs.retvals);
+
+  return retval;
+}
+
+/*  Starts jobs until @max_running are running, returns FALSE when all
+ *  jobs are finished.
+ */
+static gboolean
+gimp_batch_jobs_start (GimpBatchJobs *jobs)
+{
+  while (jobs->n_running < jobs->max_running &&
+         jobs->next      < jobs->n_commands)
+    {
+      GimpValueArray *args;
+      GError         *error = NULL;
+      gint            job   = jobs->next++;
+
+      args = gimp_batch_get_arguments (jobs->procedure,
+                                       GIMP_RUN_NONINTERACTIVE,
+                                       jobs->commands[job]);
+
+      /*  the plug-in is registered in the "plug-in-opened" handler  */
+      jobs->starting = job;
+
+      gimp_procedure_execute_async (jobs->procedure, jobs->gimp,
+                                    gimp_get_user_context (jobs->gimp),
+                                    NULL, args, NULL, &error);
+
+      gimp_value_array_unref (args);
+
+      if (jobs->starting == job)
+        {
+          /*  the interpreter could not be started  */
+          jobs->retvals[job] = gimp_batch_get_exit_code (error ?
+                                                         GIMP_PDB_CALLING_ERROR :
+                                                         GIMP_PDB_EXECUTION_ERROR,
+                                                         error);
+          jobs->starting = -1;
+
+          g_clear_error (&error);
+        }
+    }
+
+  return jobs->n_running > 0;
+}
+
+static gboolean
+gimp_batch_jobs_idle (GimpBatchJobs *jobs)
+{
+  jobs->idle_id = 0;
+
+  if (! gimp_batch_jobs_start (jobs))
+    g_main_loop_quit (jobs->main_loop);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+gimp_batch_jobs_plug_in_opened (GimpPlugInManager *manager,
+                                GimpPlugIn        *plug_in,
+                                GimpBatchJobs     *jobs)
+{
+  if (jobs->starting >= 0)
+    {
+      jobs->plug_ins[jobs->starting] = plug_in;
+      jobs->starting = -1;
+      jobs->n_running++;
+    }
+}
+
+static void
+gimp_batch_jobs_plug_in_closed (GimpPlugInManager *manager,
+                                GimpPlugIn        *plug_in,
+                                GimpBatchJobs     *jobs)
+{
+  gint job;
+
+  for (job = 0; job < jobs->next; job++)
+    {
+      if (jobs->plug_ins[job] == plug_in)
+        break;
+    }
+
+  if (job == jobs->next)
+    return;
+
+  jobs->plug_ins[job] = NULL;
+  jobs->n_running--;
+
+  /*  the return values were already reported by the plug-in
+   *  procedure, which ran asynchronously; they are missing if the
+   *  interpreter crashed
+   */
+  if (plug_in->main_proc_frame.return_vals)
+    {
+      GimpValueArray *return_vals = plug_in->main_proc_frame.return_vals;
+
+      jobs->retvals[job] =
+        gimp_batch_get_exit_code (g_value_get_enum (gimp_value_array_index (return_vals, 0)),
+                                  NULL);
+    }
+  else
+    {
+      jobs->retvals[job] = gimp_batch_get_exit_code (GIMP_PDB_EXECUTION_ERROR,
+                                                     NULL);
+    }
+
+  /*  don't start new plug-ins from within the closing one's handler  */
+  if (! jobs->idle_id)
+    jobs->idle_id = g_idle_add ((GSourceFunc) gimp_batch_jobs_idle, jobs);
+}
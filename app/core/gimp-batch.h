@@ -20,4 +20,5 @@
 
 gint   gimp_batch_run (Gimp         *gimp,
                        const gchar  *batch_interpreter,
-                       const gchar **batch_commands);
+                       const gchar **batch_commands,
+                       gint          batch_jobs);
@@ -189,3 +189,12 @@ gimp_bezier_desc_free (GimpBezierDesc *desc)
   g_free (desc->data);
   g_slice_free (GimpBezierDesc, desc);
 }
+
+gsize
+gimp_bezier_desc_get_memsize (const GimpBezierDesc *desc)
+{
+  if (desc)
+    return sizeof (GimpBezierDesc) + desc->num_data * sizeof (cairo_path_data_t);
+
+  return 0;
+}
@@ -41,3 +41,5 @@ void             gimp_bezier_desc_translate           (GimpBezierDesc       *des
 
 GimpBezierDesc * gimp_bezier_desc_copy                (const GimpBezierDesc *desc);
 void             gimp_bezier_desc_free                (GimpBezierDesc       *desc);
+
+gsize            gimp_bezier_desc_get_memsize         (const GimpBezierDesc *desc);
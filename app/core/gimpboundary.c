@@ -45,6 +45,9 @@ struct _GimpBoundary
   /*  The array of vertical segments  */
   gint         *vert_segs;
 
+  /*  Vertical segments continued from above the first line of a band  */
+  gboolean     *vert_seeded;
+
   /*  The empty segment arrays */
   gint         *empty_segs_n;
   gint         *empty_segs_c;
@@ -99,7 +102,9 @@ static GimpBoundary * generate_boundary        (GeglBuffer          *buffer,
                                                 gint                 y1,
                                                 gint                 x2,
                                                 gint                 y2,
-                                                gfloat               threshold);
+                                                gfloat               threshold,
+                                                gint                 band_y1,
+                                                gint                 band_y2);
 
 static gint       cmp_segptr_xy1_addr     (const GimpBoundSeg **seg_ptr_a,
                                            const GimpBoundSeg **seg_ptr_b);
@@ -184,7 +189,77 @@ gimp_boundary_find (GeglBuffer          *buffer,
     }
 
   boundary = generate_boundary (buffer, &rect, format, type,
-                                x1, y1, x2, y2, threshold);
+                                x1, y1, x2, y2, threshold,
+                                G_MININT, G_MAXINT);
+
+  *num_segs = boundary->num_segs;
+
+  return gimp_boundary_free (boundary, FALSE);
+}
+
+/**
+ * gimp_boundary_find_band:
+ * @buffer:    a #GeglBuffer
+ * @region:    the region to analyze, or %NULL for the whole buffer
+ * @format:    a #Babl float format representing the component to analyze
+ * @type:      type of bounds
+ * @x1:        left side of bounds
+ * @y1:        top side of bounds
+ * @x2:        right side of bounds
+ * @y2:        bottom side of bounds
+ * @threshold: pixel value of boundary line
+ * @band_y1:   first boundary line of the band
+ * @band_y2:   boundary line after the last one of the band
+ * @num_segs:  number of returned #GimpBoundSeg's
+ *
+ * Like gimp_boundary_find(), but only returns the segments lying on
+ * the boundary lines @band_y1 <= y < @band_y2, with vertical segments
+ * clipped to the band. Line y separates pixel rows y - 1 and y, so a
+ * change to pixel row y only affects the bands containing lines y and
+ * y + 1.
+ *
+ * Concatenating the bands covering all lines yields the same outline
+ * as gimp_boundary_find(), except that vertical segments crossing a
+ * band border are split in two.
+ *
+ * Returns: the boundary array.
+ **/
+GimpBoundSeg *
+gimp_boundary_find_band (GeglBuffer          *buffer,
+                         const GeglRectangle *region,
+                         const Babl          *format,
+                         GimpBoundaryType     type,
+                         gint                 x1,
+                         gint                 y1,
+                         gint                 x2,
+                         gint                 y2,
+                         gfloat               threshold,
+                         gint                 band_y1,
+                         gint                 band_y2,
+                         gint                *num_segs)
+{
+  GimpBoundary  *boundary;
+  GeglRectangle  rect = { 0, };
+
+  g_return_val_if_fail (GEGL_IS_BUFFER (buffer), NULL);
+  g_return_val_if_fail (num_segs != NULL, NULL);
+  g_return_val_if_fail (format != NULL, NULL);
+  g_return_val_if_fail (babl_format_get_bytes_per_pixel (format) ==
+                        sizeof (gfloat), NULL);
+
+  if (region)
+    {
+      rect = *region;
+    }
+  else
+    {
+      rect.width  = gegl_buffer_get_width  (buffer);
+      rect.height = gegl_buffer_get_height (buffer);
+    }
+
+  boundary = generate_boundary (buffer, &rect, format, type,
+                                x1, y1, x2, y2, threshold,
+                                band_y1, band_y2);
 
   *num_segs = boundary->num_segs;
 
@@ -453,6 +528,7 @@ gimp_boundary_free (GimpBoundary *boundary,
     segs = boundary->segs;
 
   g_free (boundary->vert_segs);
+  g_free (boundary->vert_seeded);
   g_free (boundary->empty_segs_n);
   g_free (boundary->empty_segs_c);
   g_free (boundary->empty_segs_l);
@@ -614,7 +690,9 @@ process_horiz_seg (GimpBoundary *boundary,
 
   if (boundary->vert_segs[x1] >= 0)
     {
-      gimp_boundary_add_seg (boundary, x1, boundary->vert_segs[x1], x1, y1, !open);
+      if (! boundary->vert_seeded || ! boundary->vert_seeded[x1] ||
+          boundary->vert_segs[x1] != y1)
+        gimp_boundary_add_seg (boundary, x1, boundary->vert_segs[x1], x1, y1, !open);
       boundary->vert_segs[x1] = -1;
     }
   else
@@ -622,12 +700,21 @@ process_horiz_seg (GimpBoundary *boundary,
 
   if (boundary->vert_segs[x2] >= 0)
     {
-      gimp_boundary_add_seg (boundary, x2, boundary->vert_segs[x2], x2, y2, open);
+      if (! boundary->vert_seeded || ! boundary->vert_seeded[x2] ||
+          boundary->vert_segs[x2] != y2)
+        gimp_boundary_add_seg (boundary, x2, boundary->vert_segs[x2], x2, y2, open);
       boundary->vert_segs[x2] = -1;
     }
   else
     boundary->vert_segs[x2] = y2;
 
+  /*  a seeded vertical segment is only continued until it is closed  */
+  if (boundary->vert_seeded)
+    {
+      boundary->vert_seeded[x1] = FALSE;
+      boundary->vert_seeded[x2] = FALSE;
+    }
+
   gimp_boundary_add_seg (boundary, x1, y1, x2, y2, open);
 }
 
@@ -663,6 +750,33 @@ make_horiz_segs (GimpBoundary *boundary,
     }
 }
 
+static void
+read_scanline (GeglBuffer          *buffer,
+               const GeglRectangle *region,
+               const Babl          *format,
+               gint                 scanline,
+               gfloat              *line_data,
+               const gfloat       **line)
+{
+  GeglRectangle line_rect = { 0, };
+
+  if (scanline < region->y || scanline >= region->y + region->height)
+    {
+      *line = NULL;
+      return;
+    }
+
+  line_rect.y      = scanline;
+  line_rect.width  = gegl_buffer_get_width (buffer);
+  line_rect.height = 1;
+
+  gegl_buffer_get (buffer, &line_rect, 1.0, format,
+                   line_data, GEGL_AUTO_ROWSTRIDE,
+                   GEGL_ABYSS_NONE);
+
+  *line = line_data;
+}
+
 static GimpBoundary *
 generate_boundary (GeglBuffer          *buffer,
                    const GeglRectangle *region,
@@ -672,11 +786,13 @@ generate_boundary (GeglBuffer          *buffer,
                    gint                 y1,
                    gint                 x2,
                    gint                 y2,
-                   gfloat               threshold)
+                   gfloat               threshold,
+                   gint                 band_y1,
+                   gint                 band_y2)
 {
   GimpBoundary  *boundary;
-  GeglRectangle  line_rect = { 0, };
   gfloat        *line_data;
+  const gfloat  *line;
   gint           scanline;
   gint           i;
   gint           start, end;
@@ -688,10 +804,7 @@ generate_boundary (GeglBuffer          *buffer,
 
   boundary = gimp_boundary_new (region);
 
-  line_rect.width  = gegl_buffer_get_width (buffer);
-  line_rect.height = 1;
-
-  line_data = g_alloca (sizeof (gfloat) * line_rect.width);
+  line_data = g_alloca (sizeof (gfloat) * gegl_buffer_get_width (buffer));
 
   start = 0;
   end   = 0;
@@ -707,36 +820,55 @@ generate_boundary (GeglBuffer          *buffer,
       end   = region->y + region->height;
     }
 
+  /*  The boundary lines run from above the first scanline to below
+   *  the last one; only keep the lines of the requested band. The
+   *  segments of line y are found while processing scanlines y - 1
+   *  (their bottom edges) and y (their top edges).
+   */
+  band_y1 = MAX (band_y1, start);
+  band_y2 = MIN (band_y2, end + 1);
+
+  if (band_y1 >= band_y2)
+    return boundary;
+
   /*  Find the empty segments for the previous and current scanlines  */
-  find_empty_segs (region, NULL,
-                   start - 1, boundary->empty_segs_l,
+  read_scanline (buffer, region, format, band_y1 - 2, line_data, &line);
+
+  find_empty_segs (region, line,
+                   band_y1 - 2, boundary->empty_segs_l,
                    boundary->max_empty_segs, &num_empty_l,
                    type, x1, y1, x2, y2,
                    threshold);
 
-  line_rect.y = start;
-  gegl_buffer_get (buffer, &line_rect, 1.0, format,
-                   line_data, GEGL_AUTO_ROWSTRIDE,
-                   GEGL_ABYSS_NONE);
+  read_scanline (buffer, region, format, band_y1 - 1, line_data, &line);
 
-  find_empty_segs (region, line_data,
-                   start, boundary->empty_segs_c,
+  find_empty_segs (region, line,
+                   band_y1 - 1, boundary->empty_segs_c,
                    boundary->max_empty_segs, &num_empty_c,
                    type, x1, y1, x2, y2,
                    threshold);
 
-  for (scanline = start; scanline < end; scanline++)
+  /*  Vertical segments passing through the scanline above the band
+   *  continue into it; start them at the band's first line.
+   */
+  if (num_empty_c > 2)
+    {
+      boundary->vert_seeded = g_new0 (gboolean,
+                                      region->width + region->x + 1);
+
+      for (i = 1; i < num_empty_c - 1; i++)
+        {
+          boundary->vert_segs[boundary->empty_segs_c[i]]   = band_y1;
+          boundary->vert_seeded[boundary->empty_segs_c[i]] = TRUE;
+        }
+    }
+
+  for (scanline = band_y1 - 1; scanline < band_y2; scanline++)
     {
       /*  find the empty segment list for the next scanline  */
-      line_rect.y = scanline + 1;
-      if (scanline + 1 == end)
-        line_data = NULL;
-      else
-        gegl_buffer_get (buffer, &line_rect, 1.0, format,
-                         line_data, GEGL_AUTO_ROWSTRIDE,
-                         GEGL_ABYSS_NONE);
+      read_scanline (buffer, region, format, scanline + 1, line_data, &line);
 
-      find_empty_segs (region, line_data,
+      find_empty_segs (region, line,
                        scanline + 1, boundary->empty_segs_n,
                        boundary->max_empty_segs, &num_empty_n,
                        type, x1, y1, x2, y2,
@@ -745,16 +877,18 @@ generate_boundary (GeglBuffer          *buffer,
       /*  process the segments on the current scanline  */
       for (i = 1; i < num_empty_c - 1; i += 2)
         {
-          make_horiz_segs (boundary,
-                           boundary->empty_segs_c [i],
-                           boundary->empty_segs_c [i+1],
-                           scanline,
-                           boundary->empty_segs_l, num_empty_l, 1);
-          make_horiz_segs (boundary,
-                           boundary->empty_segs_c [i],
-                           boundary->empty_segs_c [i+1],
-                           scanline + 1,
-                           boundary->empty_segs_n, num_empty_n, 0);
+          if (scanline >= band_y1)
+            make_horiz_segs (boundary,
+                             boundary->empty_segs_c [i],
+                             boundary->empty_segs_c [i+1],
+                             scanline,
+                             boundary->empty_segs_l, num_empty_l, 1);
+          if (scanline + 1 < band_y2)
+            make_horiz_segs (boundary,
+                             boundary->empty_segs_c [i],
+                             boundary->empty_segs_c [i+1],
+                             scanline + 1,
+                             boundary->empty_segs_n, num_empty_n, 0);
         }
 
       /*  get the next scanline of empty segments, swap others  */
@@ -766,6 +900,32 @@ generate_boundary (GeglBuffer          *buffer,
       boundary->empty_segs_n = tmp_segs;
     }
 
+  /*  Close the vertical segments continuing below the band, these are
+   *  the edges of the runs of the band's last scanline; the left edge
+   *  of a run opens, the right edge closes.
+   */
+  for (i = 1; i < num_empty_l - 1; i += 2)
+    {
+      gint left  = boundary->empty_segs_l[i];
+      gint right = boundary->empty_segs_l[i + 1];
+
+      if (boundary->vert_segs[left] >= 0)
+        {
+          gimp_boundary_add_seg (boundary,
+                                 left, boundary->vert_segs[left],
+                                 left, band_y2, TRUE);
+          boundary->vert_segs[left] = -1;
+        }
+
+      if (boundary->vert_segs[right] >= 0)
+        {
+          gimp_boundary_add_seg (boundary,
+                                 right, boundary->vert_segs[right],
+                                 right, band_y2, FALSE);
+          boundary->vert_segs[right] = -1;
+        }
+    }
+
   return boundary;
 }
 
@@ -24,51 +24,90 @@
 #include <gegl.h>
 
 #include "libgimpbase/gimpbase.h"
+#include "libgimpmath/gimpmath.h"
 
 #include "core-types.h"
 
+#include "gimp-memsize.h"
 #include "gimpbrushcache.h"
 
 #include "gimp-log.h"
 #include "gimp-intl.h"
 
 
-#define MAX_CACHED_DATA 20
+/* the memory budget shared by all brush caches */
+#define MAX_CACHED_MEMSIZE (32 * 1024 * 1024)
+
+/* transform parameters are quantized to steps which change the
+ * transformed brush by about 1 / SUBPIXELS pixels, so that dabs with
+ * slightly different dynamics values can share a cache entry
+ */
+#define SUBPIXELS 4
 
 
 enum
 {
   PROP_0,
-  PROP_DATA_DESTROY
+  PROP_DATA_DESTROY,
+  PROP_DATA_GET_MEMSIZE
 };
 
 
+typedef struct _GimpBrushCacheKey  GimpBrushCacheKey;
 typedef struct _GimpBrushCacheUnit GimpBrushCacheUnit;
 
-struct _GimpBrushCacheUnit
+struct _GimpBrushCacheKey
 {
-  gpointer data;
-
   gint     width;
   gint     height;
-  gdouble  scale;
-  gdouble  aspect_ratio;
-  gdouble  angle;
+  gint     scale;
+  gint     aspect_ratio;
+  gint     angle;
   gboolean reflect;
-  gdouble  hardness;
+  gint     hardness;
 };
 
+struct _GimpBrushCacheUnit
+{
+  GimpBrushCacheKey  key;
 
-static void   gimp_brush_cache_constructed  (GObject      *object);
-static void   gimp_brush_cache_finalize     (GObject      *object);
-static void   gimp_brush_cache_set_property (GObject      *object,
-                                             guint         property_id,
-                                             const GValue *value,
-                                             GParamSpec   *pspec);
-static void   gimp_brush_cache_get_property (GObject      *object,
-                                             guint         property_id,
-                                             GValue       *value,
-                                             GParamSpec   *pspec);
+  GimpBrushCache    *cache;
+  gpointer           data;
+  gsize              memsize;
+
+  GList              cache_link;
+  GList              lru_link;
+};
+
+
+static void     gimp_brush_cache_constructed  (GObject            *object);
+static void     gimp_brush_cache_finalize     (GObject            *object);
+static void     gimp_brush_cache_set_property (GObject            *object,
+                                               guint               property_id,
+                                               const GValue       *value,
+                                               GParamSpec         *pspec);
+static void     gimp_brush_cache_get_property (GObject            *object,
+                                               guint               property_id,
+                                               GValue             *value,
+                                               GParamSpec         *pspec);
+
+static gint64   gimp_brush_cache_get_memsize  (GimpObject         *object,
+                                               gint64             *gui_size);
+
+static void     gimp_brush_cache_key_init     (GimpBrushCacheKey  *key,
+                                               gint                width,
+                                               gint                height,
+                                               gdouble             scale,
+                                               gdouble             aspect_ratio,
+                                               gdouble             angle,
+                                               gboolean            reflect,
+                                               gdouble             hardness);
+static guint    gimp_brush_cache_key_hash     (gconstpointer       key);
+static gboolean gimp_brush_cache_key_equal    (gconstpointer       key1,
+                                               gconstpointer       key2);
+
+static void     gimp_brush_cache_unit_free    (GimpBrushCacheUnit *unit);
+static void     gimp_brush_cache_evict        (gsize               memsize);
 
 
 G_DEFINE_TYPE (GimpBrushCache, gimp_brush_cache, GIMP_TYPE_OBJECT)
@@ -76,26 +115,48 @@ G_DEFINE_TYPE (GimpBrushCache, gimp_brush_cache, GIMP_TYPE_OBJECT)
 #define parent_class gimp_brush_cache_parent_class
 
 
+/*  all cached units, of all caches, most recently used first  */
+static GMutex   gimp_brush_cache_mutex;
+static GQueue   gimp_brush_cache_lru     = G_QUEUE_INIT;
+
+static guintptr gimp_brush_cache_memsize = 0;
+static gint     gimp_brush_cache_hits    = 0;
+static gint     gimp_brush_cache_misses  = 0;
+
+
 static void
 gimp_brush_cache_class_init (GimpBrushCacheClass *klass)
 {
-  GObjectClass  *object_class = G_OBJECT_CLASS (klass);
+  GObjectClass    *object_class      = G_OBJECT_CLASS (klass);
+  GimpObjectClass *gimp_object_class = GIMP_OBJECT_CLASS (klass);
 
-  object_class->constructed  = gimp_brush_cache_constructed;
-  object_class->finalize     = gimp_brush_cache_finalize;
-  object_class->set_property = gimp_brush_cache_set_property;
-  object_class->get_property = gimp_brush_cache_get_property;
+  object_class->constructed      = gimp_brush_cache_constructed;
+  object_class->finalize         = gimp_brush_cache_finalize;
+  object_class->set_property     = gimp_brush_cache_set_property;
+  object_class->get_property     = gimp_brush_cache_get_property;
+
+  gimp_object_class->get_memsize = gimp_brush_cache_get_memsize;
 
   g_object_class_install_property (object_class, PROP_DATA_DESTROY,
                                    g_param_spec_pointer ("data-destroy",
                                                          NULL, NULL,
                                                          GIMP_PARAM_READWRITE |
                                                          G_PARAM_CONSTRUCT_ONLY));
+
+  g_object_class_install_property (object_class, PROP_DATA_GET_MEMSIZE,
+                                   g_param_spec_pointer ("data-get-memsize",
+                                                         NULL, NULL,
+                                                         GIMP_PARAM_READWRITE |
+                                                         G_PARAM_CONSTRUCT_ONLY));
 }
 
 static void
-gimp_brush_cache_init (GimpBrushCache *brush)
+gimp_brush_cache_init (GimpBrushCache *cache)
 {
+  cache->cached_units = g_hash_table_new (gimp_brush_cache_key_hash,
+                                          gimp_brush_cache_key_equal);
+
+  g_queue_init (&cache->units);
 }
 
 static void
@@ -115,6 +176,8 @@ gimp_brush_cache_finalize (GObject *object)
 
   gimp_brush_cache_clear (cache);
 
+  g_clear_pointer (&cache->cached_units, g_hash_table_unref);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -132,6 +195,10 @@ gimp_brush_cache_set_property (GObject      *object,
       cache->data_destroy = g_value_get_pointer (value);
       break;
 
+    case PROP_DATA_GET_MEMSIZE:
+      cache->data_get_memsize = g_value_get_pointer (value);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -152,26 +219,57 @@ gimp_brush_cache_get_property (GObject    *object,
       g_value_set_pointer (value, cache->data_destroy);
       break;
 
+    case PROP_DATA_GET_MEMSIZE:
+      g_value_set_pointer (value, cache->data_get_memsize);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
     }
 }
 
+static gint64
+gimp_brush_cache_get_memsize (GimpObject *object,
+                              gint64     *gui_size)
+{
+  GimpBrushCache *cache   = GIMP_BRUSH_CACHE (object);
+  gint64          memsize = 0;
+  GList          *iter;
+
+  g_mutex_lock (&gimp_brush_cache_mutex);
+
+  for (iter = cache->units.head; iter; iter = g_list_next (iter))
+    {
+      GimpBrushCacheUnit *unit = iter->data;
+
+      memsize += unit->memsize;
+    }
+
+  g_mutex_unlock (&gimp_brush_cache_mutex);
+
+  memsize += gimp_g_hash_table_get_memsize (cache->cached_units, 0);
+
+  return memsize + GIMP_OBJECT_CLASS (parent_class)->get_memsize (object,
+                                                                  gui_size);
+}
+
 
 /*  public functions  */
 
 GimpBrushCache *
-gimp_brush_cache_new (GDestroyNotify  data_destroy,
-                      gchar           debug_hit,
-                      gchar           debug_miss)
+gimp_brush_cache_new (GDestroyNotify             data_destroy,
+                      GimpBrushCacheMemsizeFunc  data_get_memsize,
+                      gchar                      debug_hit,
+                      gchar                      debug_miss)
 {
   GimpBrushCache *cache;
 
   g_return_val_if_fail (data_destroy != NULL, NULL);
 
   cache =  g_object_new (GIMP_TYPE_BRUSH_CACHE,
-                         "data-destroy", data_destroy,
+                         "data-destroy",     data_destroy,
+                         "data-get-memsize", data_get_memsize,
                          NULL);
 
   cache->debug_hit  = debug_hit;
@@ -183,22 +281,26 @@ gimp_brush_cache_new (GDestroyNotify  data_destroy,
 void
 gimp_brush_cache_clear (GimpBrushCache *cache)
 {
+  GList *link;
+
   g_return_if_fail (GIMP_IS_BRUSH_CACHE (cache));
 
-  if (cache->cached_units)
-    {
-      GList *iter;
+  g_mutex_lock (&gimp_brush_cache_mutex);
+
+  g_hash_table_remove_all (cache->cached_units);
 
-      for (iter = cache->cached_units; iter; iter = g_list_next (iter))
-        {
-          GimpBrushCacheUnit *unit = iter->data;
+  while ((link = g_queue_pop_head_link (&cache->units)))
+    {
+      GimpBrushCacheUnit *unit = link->data;
 
-          cache->data_destroy (unit->data);
-        }
+      g_queue_unlink (&gimp_brush_cache_lru, &unit->lru_link);
 
-      g_list_free_full (cache->cached_units, g_free);
-      cache->cached_units = NULL;
+      gimp_brush_cache_unit_free (unit);
     }
+
+  cache->last_unit = NULL;
+
+  g_mutex_unlock (&gimp_brush_cache_mutex);
 }
 
 gconstpointer
@@ -211,41 +313,49 @@ gimp_brush_cache_get (GimpBrushCache *cache,
                       gboolean        reflect,
                       gdouble         hardness)
 {
-  GList *iter;
+  GimpBrushCacheKey   key;
+  GimpBrushCacheUnit *unit;
+  gconstpointer       data = NULL;
 
   g_return_val_if_fail (GIMP_IS_BRUSH_CACHE (cache), NULL);
 
-  for (iter = cache->cached_units; iter; iter = g_list_next (iter))
+  gimp_brush_cache_key_init (&key,
+                             width, height,
+                             scale, aspect_ratio, angle, reflect, hardness);
+
+  g_mutex_lock (&gimp_brush_cache_mutex);
+
+  unit = g_hash_table_lookup (cache->cached_units, &key);
+
+  if (unit)
     {
-      GimpBrushCacheUnit *unit = iter->data;
+      /* Make the returned cached brush the most recently used one. */
+      g_queue_unlink (&gimp_brush_cache_lru, &unit->lru_link);
+      g_queue_push_head_link (&gimp_brush_cache_lru, &unit->lru_link);
+
+      cache->last_unit = unit;
 
-      if (unit->data                         &&
-          unit->width        == width        &&
-          unit->height       == height       &&
-          unit->scale        == scale        &&
-          unit->aspect_ratio == aspect_ratio &&
-          unit->angle        == angle        &&
-          unit->reflect      == reflect      &&
-          unit->hardness     == hardness)
-        {
-          if (gimp_log_flags & GIMP_LOG_BRUSH_CACHE)
-            g_printerr ("%c", cache->debug_hit);
-
-          /* Make the returned cached brush first in the list. */
-          cache->cached_units = g_list_remove_link (cache->cached_units, iter);
-          iter->next = cache->cached_units;
-          if (cache->cached_units)
-            cache->cached_units->prev = iter;
-          cache->cached_units = iter;
-
-          return (gconstpointer) unit->data;
-        }
+      data = unit->data;
     }
 
-  if (gimp_log_flags & GIMP_LOG_BRUSH_CACHE)
-    g_printerr ("%c", cache->debug_miss);
+  g_mutex_unlock (&gimp_brush_cache_mutex);
+
+  if (data)
+    {
+      g_atomic_int_inc (&gimp_brush_cache_hits);
 
-  return NULL;
+      if (gimp_log_flags & GIMP_LOG_BRUSH_CACHE)
+        g_printerr ("%c", cache->debug_hit);
+    }
+  else
+    {
+      g_atomic_int_inc (&gimp_brush_cache_misses);
+
+      if (gimp_log_flags & GIMP_LOG_BRUSH_CACHE)
+        g_printerr ("%c", cache->debug_miss);
+    }
+
+  return data;
 }
 
 void
@@ -259,44 +369,171 @@ gimp_brush_cache_add (GimpBrushCache *cache,
                       gboolean        reflect,
                       gdouble         hardness)
 {
-  GList              *iter;
+  GimpBrushCacheKey   key;
   GimpBrushCacheUnit *unit;
-  GList              *last   = NULL;
-  gint                length = 0;
 
   g_return_if_fail (GIMP_IS_BRUSH_CACHE (cache));
   g_return_if_fail (data != NULL);
 
-  for (iter = cache->cached_units; iter; iter = g_list_next (iter))
-    {
-      unit = iter->data;
+  gimp_brush_cache_key_init (&key,
+                             width, height,
+                             scale, aspect_ratio, angle, reflect, hardness);
 
-      if (data == unit->data)
-        return;
+  g_mutex_lock (&gimp_brush_cache_mutex);
 
-      length++;
-      last = iter;
-    }
+  unit = g_hash_table_lookup (cache->cached_units, &key);
 
-  if (length > MAX_CACHED_DATA)
+  if (unit && unit->data == data)
     {
-      unit = last->data;
+      g_mutex_unlock (&gimp_brush_cache_mutex);
 
-      cache->data_destroy (unit->data);
-      cache->cached_units = g_list_delete_link (cache->cached_units, last);
-      g_free (unit);
+      return;
     }
 
-  unit = g_new0 (GimpBrushCacheUnit, 1);
+  unit = g_slice_new0 (GimpBrushCacheUnit);
+
+  unit->key             = key;
+  unit->cache           = cache;
+  unit->data            = data;
+  unit->memsize         = sizeof (GimpBrushCacheUnit);
+  unit->cache_link.data = unit;
+  unit->lru_link.data   = unit;
+
+  if (cache->data_get_memsize)
+    unit->memsize += cache->data_get_memsize (data);
+
+  gimp_brush_cache_evict (unit->memsize);
+
+  /*  a unit already using the same key is replaced in the hash table,
+   *  but stays in the lists until it gets evicted, since the caller
+   *  might still be using its data
+   */
+  g_hash_table_replace (cache->cached_units, &unit->key, unit);
+
+  g_queue_push_head_link (&cache->units,         &unit->cache_link);
+  g_queue_push_head_link (&gimp_brush_cache_lru, &unit->lru_link);
+
+  cache->last_unit = unit;
+
+  g_atomic_pointer_add (&gimp_brush_cache_memsize, +unit->memsize);
+
+  g_mutex_unlock (&gimp_brush_cache_mutex);
+}
 
-  unit->data         = data;
-  unit->width        = width;
-  unit->height       = height;
-  unit->scale        = scale;
-  unit->aspect_ratio = aspect_ratio;
-  unit->angle        = angle;
-  unit->reflect      = reflect;
-  unit->hardness     = hardness;
+guint64
+gimp_brush_cache_get_total_memsize (void)
+{
+  return g_atomic_pointer_get (&gimp_brush_cache_memsize);
+}
 
-  cache->cached_units = g_list_prepend (cache->cached_units, unit);
+gint
+gimp_brush_cache_get_hits (void)
+{
+  return g_atomic_int_get (&gimp_brush_cache_hits);
+}
+
+gint
+gimp_brush_cache_get_misses (void)
+{
+  return g_atomic_int_get (&gimp_brush_cache_misses);
+}
+
+
+/*  private functions  */
+
+static void
+gimp_brush_cache_key_init (GimpBrushCacheKey *key,
+                           gint               width,
+                           gint               height,
+                           gdouble            scale,
+                           gdouble            aspect_ratio,
+                           gdouble            angle,
+                           gboolean           reflect,
+                           gdouble            hardness)
+{
+  /*  the transformed brush size, in subpixels  */
+  gdouble size = MAX (MAX (width, height), 1) * SUBPIXELS;
+
+  key->width        = width;
+  key->height       = height;
+  key->scale        = RINT (log (scale)          * size);
+  key->aspect_ratio = RINT (aspect_ratio / 20.0  * size);
+  key->angle        = RINT (angle * G_PI         * size);
+  key->reflect      = reflect ? TRUE : FALSE;
+  key->hardness     = RINT (hardness / 2.0       * size);
+}
+
+static guint
+gimp_brush_cache_key_hash (gconstpointer key)
+{
+  const GimpBrushCacheKey *k    = key;
+  guint                    hash = 0;
+
+  hash = hash * 31 + k->width;
+  hash = hash * 31 + k->height;
+  hash = hash * 31 + k->scale;
+  hash = hash * 31 + k->aspect_ratio;
+  hash = hash * 31 + k->angle;
+  hash = hash * 31 + k->reflect;
+  hash = hash * 31 + k->hardness;
+
+  return hash;
+}
+
+static gboolean
+gimp_brush_cache_key_equal (gconstpointer key1,
+                            gconstpointer key2)
+{
+  const GimpBrushCacheKey *k1 = key1;
+  const GimpBrushCacheKey *k2 = key2;
+
+  return k1->width        == k2->width        &&
+         k1->height       == k2->height       &&
+         k1->scale        == k2->scale        &&
+         k1->aspect_ratio == k2->aspect_ratio &&
+         k1->angle        == k2->angle        &&
+         k1->reflect      == k2->reflect      &&
+         k1->hardness     == k2->hardness;
+}
+
+static void
+gimp_brush_cache_unit_free (GimpBrushCacheUnit *unit)
+{
+  unit->cache->data_destroy (unit->data);
+
+  g_atomic_pointer_add (&gimp_brush_cache_memsize, -unit->memsize);
+
+  g_slice_free (GimpBrushCacheUnit, unit);
+}
+
+/*  evicts the least recently used units, of all caches, until there's
+ *  room for @memsize more bytes.  must be called with the mutex held.
+ *  the most recently used unit of each cache is never evicted, since its
+ *  data may still be in use by the cache's owner.
+ */
+static void
+gimp_brush_cache_evict (gsize memsize)
+{
+  GList *link = gimp_brush_cache_lru.tail;
+
+  while (link &&
+         g_atomic_pointer_get (&gimp_brush_cache_memsize) + memsize >
+         MAX_CACHED_MEMSIZE)
+    {
+      GimpBrushCacheUnit *unit = link->data;
+      GimpBrushCache     *cache = unit->cache;
+
+      link = link->prev;
+
+      if (unit == cache->last_unit)
+        continue;
+
+      if (g_hash_table_lookup (cache->cached_units, &unit->key) == unit)
+        g_hash_table_remove (cache->cached_units, &unit->key);
+
+      g_queue_unlink (&cache->units,         &unit->cache_link);
+      g_queue_unlink (&gimp_brush_cache_lru, &unit->lru_link);
+
+      gimp_brush_cache_unit_free (unit);
+    }
 }
@@ -33,16 +33,21 @@
 
 typedef struct _GimpBrushCacheClass GimpBrushCacheClass;
 
+typedef gsize (* GimpBrushCacheMemsizeFunc) (gconstpointer data);
+
 struct _GimpBrushCache
 {
-  GimpObject      parent_instance;
+  GimpObject                 parent_instance;
 
-  GDestroyNotify  data_destroy;
+  GDestroyNotify             data_destroy;
+  GimpBrushCacheMemsizeFunc  data_get_memsize;
 
-  GList          *cached_units;
+  GHashTable                *cached_units;
+  GQueue                     units;
+  gpointer                   last_unit;
 
-  gchar           debug_hit;
-  gchar           debug_miss;
+  gchar                      debug_hit;
+  gchar                      debug_miss;
 };
 
 struct _GimpBrushCacheClass
@@ -51,28 +56,33 @@ struct _GimpBrushCacheClass
 };
 
 
-GType            gimp_brush_cache_get_type (void) G_GNUC_CONST;
-
-GimpBrushCache * gimp_brush_cache_new      (GDestroyNotify  data_destory,
-                                            gchar           debug_hit,
-                                            gchar           debug_miss);
-
-void             gimp_brush_cache_clear    (GimpBrushCache *cache);
-
-gconstpointer    gimp_brush_cache_get      (GimpBrushCache *cache,
-                                            gint            width,
-                                            gint            height,
-                                            gdouble         scale,
-                                            gdouble         aspect_ratio,
-                                            gdouble         angle,
-                                            gboolean        reflect,
-                                            gdouble         hardness);
-void             gimp_brush_cache_add      (GimpBrushCache *cache,
-                                            gpointer        data,
-                                            gint            width,
-                                            gint            height,
-                                            gdouble         scale,
-                                            gdouble         aspect_ratio,
-                                            gdouble         angle,
-                                            gboolean        reflect,
-                                            gdouble         hardness);
+GType            gimp_brush_cache_get_type          (void) G_GNUC_CONST;
+
+GimpBrushCache * gimp_brush_cache_new               (GDestroyNotify             data_destory,
+                                                     GimpBrushCacheMemsizeFunc  data_get_memsize,
+                                                     gchar                      debug_hit,
+                                                     gchar                      debug_miss);
+
+void             gimp_brush_cache_clear             (GimpBrushCache *cache);
+
+gconstpointer    gimp_brush_cache_get               (GimpBrushCache *cache,
+                                                     gint            width,
+                                                     gint            height,
+                                                     gdouble         scale,
+                                                     gdouble         aspect_ratio,
+                                                     gdouble         angle,
+                                                     gboolean        reflect,
+                                                     gdouble         hardness);
+void             gimp_brush_cache_add               (GimpBrushCache *cache,
+                                                     gpointer        data,
+                                                     gint            width,
+                                                     gint            height,
+                                                     gdouble         scale,
+                                                     gdouble         aspect_ratio,
+                                                     gdouble         angle,
+                                                     gboolean        reflect,
+                                                     gdouble         hardness);
+
+guint64          gimp_brush_cache_get_total_memsize (void);
+gint             gimp_brush_cache_get_hits          (void);
+gint             gimp_brush_cache_get_misses        (void);
@@ -61,6 +61,19 @@
 
 #define RGBA_EPSILON 1e-6
 
+/*  the number of boundary lines per cached band  */
+#define BOUNDARY_BAND_HEIGHT 64
+
+
+struct _GimpChannelBand
+{
+  GimpBoundSeg *segs_in;
+  GimpBoundSeg *segs_out;
+  gint          num_segs_in;
+  gint          num_segs_out;
+  gboolean      valid;
+};
+
 enum
 {
   COLOR_CHANGED,
@@ -204,6 +217,10 @@ static void      gimp_channel_buffer_changed (GeglBuffer          *buffer,
                                               const GeglRectangle *rect,
                                               GimpChannel         *channel);
 
+static void      gimp_channel_free_bands     (GimpChannel         *channel);
+static void      gimp_channel_invalidate_bands (GimpChannel         *channel,
+                                                const GeglRectangle *rect);
+
 
 G_DEFINE_TYPE_WITH_CODE (GimpChannel, gimp_channel, GIMP_TYPE_DRAWABLE,
                          G_IMPLEMENT_INTERFACE (GIMP_TYPE_PICKABLE,
@@ -314,6 +331,8 @@ gimp_channel_init (GimpChannel *channel)
   channel->segs_out       = NULL;
   channel->num_segs_in    = 0;
   channel->num_segs_out   = 0;
+  channel->bands          = NULL;
+  channel->n_bands        = 0;
   channel->empty          = FALSE;
   channel->full           = FALSE;
   channel->bounds_known   = FALSE;
@@ -336,6 +355,7 @@ gimp_channel_finalize (GObject *object)
 
   g_clear_pointer (&channel->segs_in,  g_free);
   g_clear_pointer (&channel->segs_out, g_free);
+  gimp_channel_free_bands (channel);
   g_clear_object (&channel->color);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
@@ -346,10 +366,17 @@ gimp_channel_get_memsize (GimpObject *object,
                           gint64     *gui_size)
 {
   GimpChannel *channel = GIMP_CHANNEL (object);
+  gint         i;
 
   *gui_size += channel->num_segs_in  * sizeof (GimpBoundSeg);
   *gui_size += channel->num_segs_out * sizeof (GimpBoundSeg);
 
+  for (i = 0; i < channel->n_bands; i++)
+    {
+      *gui_size += channel->bands[i].num_segs_in  * sizeof (GimpBoundSeg);
+      *gui_size += channel->bands[i].num_segs_out * sizeof (GimpBoundSeg);
+    }
+
   return GIMP_OBJECT_CLASS (parent_class)->get_memsize (object, gui_size);
 }
 
@@ -941,6 +968,9 @@ gimp_channel_invalidate_boundary (GimpDrawable *drawable)
 
   channel->boundary_known = FALSE;
   channel->bounds_known   = FALSE;
+
+  if (! channel->boundary_partial)
+    gimp_channel_invalidate_bands (channel, NULL);
 }
 
 static void
@@ -1034,51 +1064,152 @@ gimp_channel_real_boundary (GimpChannel         *channel,
       gint x3, y3, x4, y4;
 
       /* free the out of date boundary segments */
-      g_free (channel->segs_in);
-      g_free (channel->segs_out);
+      g_clear_pointer (&channel->segs_in,  g_free);
+      g_clear_pointer (&channel->segs_out, g_free);
+
+      channel->num_segs_in  = 0;
+      channel->num_segs_out = 0;
 
       if (gimp_item_bounds (GIMP_ITEM (channel), &x3, &y3, &x4, &y4))
         {
           GeglBuffer    *buffer;
-          GeglRectangle  rect = { x3, y3, x4, y4 };
+          GeglRectangle  rect;
+          GimpBoundSeg  *segs_in;
+          GimpBoundSeg  *segs_out;
+          gint           height;
+          gint           n_bands;
+          gint           i;
 
           x4 += x3;
           y4 += y3;
 
           buffer = gimp_drawable_get_buffer (GIMP_DRAWABLE (channel));
+          height = gegl_buffer_get_height (buffer);
 
-          channel->segs_out = gimp_boundary_find (buffer, &rect,
-                                                  babl_format ("Y float"),
-                                                  GIMP_BOUNDARY_IGNORE_BOUNDS,
-                                                  x1, y1, x2, y2,
-                                                  GIMP_BOUNDARY_HALF_WAY,
-                                                  &channel->num_segs_out);
-          x1 = MAX (x1, x3);
-          y1 = MAX (y1, y3);
-          x2 = MIN (x2, x4);
-          y2 = MIN (y2, y4);
-
-          if (x2 > x1 && y2 > y1)
+          /*  the boundary lines run from 0 to height, inclusive  */
+          n_bands = (height + BOUNDARY_BAND_HEIGHT) / BOUNDARY_BAND_HEIGHT;
+
+          /*  the segments only change where the mask did, unless we
+           *  are asked for a different boundary
+           */
+          if (n_bands != channel->n_bands ||
+              x1 != channel->bands_x1     ||
+              y1 != channel->bands_y1     ||
+              x2 != channel->bands_x2     ||
+              y2 != channel->bands_y2)
             {
-              channel->segs_in = gimp_boundary_find (buffer, NULL,
-                                                     babl_format ("Y float"),
-                                                     GIMP_BOUNDARY_WITHIN_BOUNDS,
-                                                     x1, y1, x2, y2,
-                                                     GIMP_BOUNDARY_HALF_WAY,
-                                                     &channel->num_segs_in);
+              gimp_channel_free_bands (channel);
+
+              channel->bands    = g_new0 (GimpChannelBand, n_bands);
+              channel->n_bands  = n_bands;
+              channel->bands_x1 = x1;
+              channel->bands_y1 = y1;
+              channel->bands_x2 = x2;
+              channel->bands_y2 = y2;
             }
-          else
+
+          /*  the mask is empty outside its bounds, so the segments
+           *  are the same whether or not we restrict the search to
+           *  them, which lets the bands stay valid when they change
+           */
+          rect.x      = x3;
+          rect.y      = 0;
+          rect.width  = x4 - x3;
+          rect.height = height;
+
+          for (i = 0; i < n_bands; i++)
             {
-              channel->segs_in     = NULL;
-              channel->num_segs_in = 0;
+              GimpChannelBand *band    = &channel->bands[i];
+              gint             band_y1 = i * BOUNDARY_BAND_HEIGHT;
+              gint             band_y2 = band_y1 + BOUNDARY_BAND_HEIGHT;
+
+              /*  the band's lines only touch rows band_y1 - 1 to
+               *  band_y2 - 1, if none of them is selected, it has
+               *  no segments
+               */
+              if (! band->valid && (band_y2 <= y3 || band_y1 > y4))
+                {
+                  g_clear_pointer (&band->segs_in,  g_free);
+                  g_clear_pointer (&band->segs_out, g_free);
+
+                  band->num_segs_in  = 0;
+                  band->num_segs_out = 0;
+                  band->valid        = TRUE;
+                }
+            }
+
+          x3 = MAX (x1, x3);
+          y3 = MAX (y1, y3);
+          x4 = MIN (x2, x4);
+          y4 = MIN (y2, y4);
+
+          for (i = 0; i < n_bands; i++)
+            {
+              GimpChannelBand *band    = &channel->bands[i];
+              gint             band_y1 = i * BOUNDARY_BAND_HEIGHT;
+              gint             band_y2 = band_y1 + BOUNDARY_BAND_HEIGHT;
+
+              if (band->valid)
+                continue;
+
+              g_clear_pointer (&band->segs_in,  g_free);
+              g_clear_pointer (&band->segs_out, g_free);
+
+              band->num_segs_in  = 0;
+              band->num_segs_out = 0;
+              band->valid        = TRUE;
+
+              band->segs_out = gimp_boundary_find_band (buffer, &rect,
+                                                        babl_format ("Y float"),
+                                                        GIMP_BOUNDARY_IGNORE_BOUNDS,
+                                                        x1, y1, x2, y2,
+                                                        GIMP_BOUNDARY_HALF_WAY,
+                                                        band_y1, band_y2,
+                                                        &band->num_segs_out);
+
+              if (x4 > x3 && y4 > y3)
+                {
+                  band->segs_in = gimp_boundary_find_band (buffer, NULL,
+                                                           babl_format ("Y float"),
+                                                           GIMP_BOUNDARY_WITHIN_BOUNDS,
+                                                           x3, y3, x4, y4,
+                                                           GIMP_BOUNDARY_HALF_WAY,
+                                                           band_y1, band_y2,
+                                                           &band->num_segs_in);
+                }
+            }
+
+          /*  splice the bands together  */
+          for (i = 0; i < n_bands; i++)
+            {
+              channel->num_segs_in  += channel->bands[i].num_segs_in;
+              channel->num_segs_out += channel->bands[i].num_segs_out;
+            }
+
+          if (channel->num_segs_in)
+            channel->segs_in = g_new (GimpBoundSeg, channel->num_segs_in);
+
+          if (channel->num_segs_out)
+            channel->segs_out = g_new (GimpBoundSeg, channel->num_segs_out);
+
+          segs_in  = channel->segs_in;
+          segs_out = channel->segs_out;
+
+          for (i = 0; i < n_bands; i++)
+            {
+              GimpChannelBand *band = &channel->bands[i];
+
+              if (band->num_segs_in)
+                memcpy (segs_in, band->segs_in,
+                        band->num_segs_in * sizeof (GimpBoundSeg));
+
+              if (band->num_segs_out)
+                memcpy (segs_out, band->segs_out,
+                        band->num_segs_out * sizeof (GimpBoundSeg));
+
+              segs_in  += band->num_segs_in;
+              segs_out += band->num_segs_out;
             }
-        }
-      else
-        {
-          channel->segs_in      = NULL;
-          channel->segs_out     = NULL;
-          channel->num_segs_in  = 0;
-          channel->num_segs_out = 0;
         }
 
       channel->boundary_known = TRUE;
@@ -1519,7 +1650,46 @@ gimp_channel_buffer_changed (GeglBuffer          *buffer,
                              const GeglRectangle *rect,
                              GimpChannel         *channel)
 {
+  /*  only the bands around the changed area need to be recomputed  */
+  gimp_channel_invalidate_bands (channel, rect);
+
+  channel->boundary_partial = TRUE;
   gimp_drawable_invalidate_boundary (GIMP_DRAWABLE (channel));
+  channel->boundary_partial = FALSE;
+}
+
+static void
+gimp_channel_free_bands (GimpChannel *channel)
+{
+  gint i;
+
+  for (i = 0; i < channel->n_bands; i++)
+    {
+      g_free (channel->bands[i].segs_in);
+      g_free (channel->bands[i].segs_out);
+    }
+
+  g_clear_pointer (&channel->bands, g_free);
+  channel->n_bands = 0;
+}
+
+static void
+gimp_channel_invalidate_bands (GimpChannel         *channel,
+                               const GeglRectangle *rect)
+{
+  gint first = 0;
+  gint last  = channel->n_bands - 1;
+  gint i;
+
+  /*  changing pixel row y affects boundary lines y and y + 1  */
+  if (rect)
+    {
+      first = MAX (first, rect->y / BOUNDARY_BAND_HEIGHT);
+      last  = MIN (last,  (rect->y + rect->height) / BOUNDARY_BAND_HEIGHT);
+    }
+
+  for (i = first; i <= last; i++)
+    channel->bands[i].valid = FALSE;
 }
 
 
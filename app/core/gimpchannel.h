@@ -29,6 +29,7 @@
 
 
 typedef struct _GimpChannelClass GimpChannelClass;
+typedef struct _GimpChannelBand  GimpChannelBand;
 
 struct _GimpChannel
 {
@@ -48,6 +49,11 @@ struct _GimpChannel
   GimpBoundSeg *segs_out;          /*  outline of selected region     */
   gint          num_segs_in;       /*  number of lines in boundary    */
   gint          num_segs_out;      /*  number of lines in boundary    */
+  GimpChannelBand *bands;          /*  boundary segments per band     */
+  gint          n_bands;           /*  number of bands                */
+  gint          bands_x1, bands_y1;/*  bounds the bands were found in */
+  gint          bands_x2, bands_y2;
+  gboolean      boundary_partial;  /*  only invalidate changed bands  */
   gboolean      empty;             /*  is the region empty?           */
   gboolean      full;              /*  is the region completely full? */
   gboolean      bounds_known;      /*  recalculate the bounds?        */
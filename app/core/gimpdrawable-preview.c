@@ -50,6 +50,13 @@
 #include "gimp-priorities.h"
 
 
+/*  previews larger than half the drawable's size are rendered from the
+ *  drawable directly
+ */
+#define MIN_PYRAMID_LEVEL 1
+#define MAX_PYRAMID_LEVEL 16
+
+
 typedef struct
 {
   const Babl        *format;
@@ -58,8 +65,23 @@ typedef struct
   gdouble            scale;
 
   GimpChunkIterator *iter;
+
+  /*  the part of the preview pyramid in @buffer to render first  */
+  GimpDrawable      *drawable;
+  GeglBuffer        *pyramid_src;
+  cairo_region_t    *pyramid_region;
+  gdouble            pyramid_scale;
+  guint              pyramid_serial;
 } SubPreviewData;
 
+typedef struct
+{
+  GimpDrawable      *drawable;
+  GeglBuffer        *pyramid;
+  cairo_region_t    *region;
+  gdouble            level_scale;
+} PyramidRenderData;
+
 
 /*  local function prototypes  */
 
@@ -69,6 +91,27 @@ static SubPreviewData * sub_preview_data_new  (const Babl          *format,
                                                gdouble              scale);
 static void             sub_preview_data_free (SubPreviewData      *data);
 
+static GeglBuffer     * gimp_drawable_get_preview_pyramid
+                                              (GimpDrawable        *drawable,
+                                               GeglBuffer          *buffer,
+                                               gdouble              scale,
+                                               gboolean             async,
+                                               gdouble             *pyramid_scale,
+                                               cairo_region_t     **region);
+static void             gimp_drawable_preview_pyramid_render
+                                              (GimpDrawable        *drawable,
+                                               GeglBuffer          *buffer,
+                                               GeglBuffer          *pyramid,
+                                               cairo_region_t      *region,
+                                               gdouble              level_scale,
+                                               guint                serial);
+static void             gimp_drawable_preview_pyramid_rendered
+                                              (GimpAsync           *async,
+                                               PyramidRenderData   *data);
+
+
+/*  serializes installing rendered parts into the preview pyramids  */
+static GMutex pyramid_render_mutex;
 
 
 /*  private functions  */
@@ -90,6 +133,12 @@ sub_preview_data_new (const Babl          *format,
 
   data->iter   = NULL;
 
+  data->drawable       = NULL;
+  data->pyramid_src    = NULL;
+  data->pyramid_region = NULL;
+  data->pyramid_scale  = 1.0;
+  data->pyramid_serial = 0;
+
   return data;
 }
 
@@ -101,9 +150,272 @@ sub_preview_data_free (SubPreviewData *data)
   if (data->iter)
     gimp_chunk_iterator_stop (data->iter, TRUE);
 
+  g_clear_object (&data->pyramid_src);
+  g_clear_pointer (&data->pyramid_region, cairo_region_destroy);
+
   g_slice_free (SubPreviewData, data);
 }
 
+/*  Returns a reference to a copy of @buffer, downscaled by a power of
+ *  two, which can be read at *pyramid_scale instead of reading @buffer
+ *  at @scale.  The copy is kept by the drawable and only the parts that
+ *  were updated since the last preview are rendered again, so painting
+ *  doesn't rescale the whole drawable for each new preview.  Returns
+ *  NULL if the preview should be read from @buffer.
+ *
+ *  The copy is not rendered here: the part of it that has to be
+ *  rendered from @buffer before reading it is returned in *region, in
+ *  the copy's coordinates, or NULL if it is up to date.  If @async is
+ *  TRUE, the caller renders it on another thread, and has to call
+ *  gimp_drawable_preview_pyramid_rendered() when done; until then, the
+ *  region is handed to later callers too.
+ *
+ *  Each render takes a new serial from preview_render_serial, see
+ *  gimp_drawable_preview_pyramid_render().
+ */
+static GeglBuffer *
+gimp_drawable_get_preview_pyramid (GimpDrawable    *drawable,
+                                   GeglBuffer      *buffer,
+                                   gdouble          scale,
+                                   gboolean         async,
+                                   gdouble         *pyramid_scale,
+                                   cairo_region_t **region)
+{
+  GimpDrawablePrivate *private = drawable->private;
+  GimpItem            *item    = GIMP_ITEM (drawable);
+  const Babl          *format  = gimp_drawable_get_preview_format (drawable);
+  gint                 level   = 0;
+  gint                 width;
+  gint                 height;
+  gdouble              level_scale;
+
+  *region = NULL;
+
+  while (level < MAX_PYRAMID_LEVEL && scale * (2 << level) <= 1.0)
+    level++;
+
+  /*  buffers that are rendered lazily, and indexed buffers whose
+   *  colormap can change without an update, are not kept
+   */
+  if (level < MIN_PYRAMID_LEVEL                          ||
+      gimp_drawable_is_indexed (drawable)                ||
+      gimp_tile_handler_validate_get_assigned (buffer))
+    {
+      return NULL;
+    }
+
+  /*  keep a finer pyramid, as long as it's still valid  */
+  if (private->preview_pyramid)
+    {
+      level_scale = 1.0 / (1 << private->preview_pyramid_level);
+
+      if (private->preview_pyramid_level > level                        ||
+          gegl_buffer_get_format (private->preview_pyramid) != format  ||
+          gegl_buffer_get_width  (private->preview_pyramid) !=
+          (gint) ceil (gimp_item_get_width  (item) * level_scale)     ||
+          gegl_buffer_get_height (private->preview_pyramid) !=
+          (gint) ceil (gimp_item_get_height (item) * level_scale))
+        {
+          gimp_drawable_preview_pyramid_clear (drawable);
+        }
+    }
+
+  if (! private->preview_pyramid)
+    {
+      cairo_rectangle_int_t rect;
+
+      level_scale = 1.0 / (1 << level);
+
+      width  = ceil (gimp_item_get_width  (item) * level_scale);
+      height = ceil (gimp_item_get_height (item) * level_scale);
+
+      private->preview_pyramid       =
+        gegl_buffer_new (GEGL_RECTANGLE (0, 0, width, height), format);
+      private->preview_pyramid_level = level;
+
+      rect.x      = 0;
+      rect.y      = 0;
+      rect.width  = gimp_item_get_width  (item);
+      rect.height = gimp_item_get_height (item);
+
+      g_clear_pointer (&private->preview_dirty_region, cairo_region_destroy);
+      private->preview_dirty_region = cairo_region_create_rectangle (&rect);
+    }
+
+  level_scale = 1.0 / (1 << private->preview_pyramid_level);
+
+  if (private->preview_dirty_region)
+    {
+      gint n_rects;
+      gint i;
+
+      /*  coalesce the updates at the pyramid's resolution first, where
+       *  the many small updates of a stroke mostly fall together
+       */
+      *region = cairo_region_create ();
+      n_rects = cairo_region_num_rectangles (private->preview_dirty_region);
+
+      for (i = 0; i < n_rects; i++)
+        {
+          cairo_rectangle_int_t rect;
+          cairo_rectangle_int_t scaled_rect;
+
+          cairo_region_get_rectangle (private->preview_dirty_region, i, &rect);
+
+          scaled_rect.x      = floor (rect.x * level_scale);
+          scaled_rect.y      = floor (rect.y * level_scale);
+          scaled_rect.width  = ceil ((rect.x + rect.width)  * level_scale) -
+                               scaled_rect.x;
+          scaled_rect.height = ceil ((rect.y + rect.height) * level_scale) -
+                               scaled_rect.y;
+
+          cairo_region_union_rectangle (*region, &scaled_rect);
+        }
+
+      cairo_region_intersect_rectangle (
+        *region,
+        (const cairo_rectangle_int_t *)
+          gegl_buffer_get_extent (private->preview_pyramid));
+
+      g_clear_pointer (&private->preview_dirty_region, cairo_region_destroy);
+    }
+
+  /*  the parts still being rendered by other previews may not be in the
+   *  pyramid yet, render them again
+   */
+  if (private->preview_pending_region)
+    {
+      if (! *region)
+        *region = cairo_region_create ();
+
+      cairo_region_union (*region, private->preview_pending_region);
+    }
+
+  if (*region && cairo_region_is_empty (*region))
+    g_clear_pointer (region, cairo_region_destroy);
+
+  if (*region && async)
+    {
+      g_clear_pointer (&private->preview_pending_region,
+                       cairo_region_destroy);
+
+      private->preview_pending_region = cairo_region_copy (*region);
+      private->preview_n_pending++;
+    }
+
+  *pyramid_scale = scale / level_scale;
+
+  return g_object_ref (private->preview_pyramid);
+}
+
+/*  may be called from any thread.  renders concurrently with other
+ *  renders, but only installs the result into @pyramid if no render
+ *  with a later @serial was installed meanwhile, whose region covers
+ *  this one's and whose pixels are newer.
+ */
+static void
+gimp_drawable_preview_pyramid_render (GimpDrawable   *drawable,
+                                      GeglBuffer     *buffer,
+                                      GeglBuffer     *pyramid,
+                                      cairo_region_t *region,
+                                      gdouble         level_scale,
+                                      guint           serial)
+{
+  GimpDrawablePrivate *private = drawable->private;
+  const Babl          *format  = gegl_buffer_get_format (pyramid);
+  gint                 n_rects = cairo_region_num_rectangles (region);
+  gpointer            *data;
+  gint                 i;
+
+  data = g_new (gpointer, n_rects);
+
+  for (i = 0; i < n_rects; i++)
+    {
+      GeglRectangle rect;
+
+      cairo_region_get_rectangle (region, i,
+                                  (cairo_rectangle_int_t *) &rect);
+
+      data[i] = g_malloc ((gsize) rect.width * rect.height *
+                          babl_format_get_bytes_per_pixel (format));
+
+      gegl_buffer_get (buffer, &rect, level_scale,
+                       format, data[i],
+                       GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_CLAMP);
+    }
+
+  g_mutex_lock (&pyramid_render_mutex);
+
+  if ((gint) (serial - private->preview_render_installed) > 0)
+    {
+      for (i = 0; i < n_rects; i++)
+        {
+          GeglRectangle rect;
+
+          cairo_region_get_rectangle (region, i,
+                                      (cairo_rectangle_int_t *) &rect);
+
+          gegl_buffer_set (pyramid, &rect, 0,
+                           format, data[i],
+                           GEGL_AUTO_ROWSTRIDE);
+        }
+
+      private->preview_render_installed = serial;
+    }
+
+  g_mutex_unlock (&pyramid_render_mutex);
+
+  for (i = 0; i < n_rects; i++)
+    g_free (data[i]);
+
+  g_free (data);
+}
+
+static void
+gimp_drawable_preview_pyramid_rendered (GimpAsync         *async,
+                                        PyramidRenderData *data)
+{
+  GimpDrawablePrivate *private = data->drawable->private;
+
+  /*  a pyramid that has been dropped meanwhile doesn't matter anymore  */
+  if (data->pyramid == private->preview_pyramid)
+    {
+      /*  the preview was canceled before rendering its part, mark it
+       *  dirty again so the next preview renders it
+       */
+      if (! gimp_async_is_finished (async))
+        {
+          gint n_rects = cairo_region_num_rectangles (data->region);
+          gint i;
+
+          for (i = 0; i < n_rects; i++)
+            {
+              cairo_rectangle_int_t rect;
+
+              cairo_region_get_rectangle (data->region, i, &rect);
+
+              gimp_drawable_preview_pyramid_update (
+                data->drawable,
+                floor (rect.x / data->level_scale),
+                floor (rect.y / data->level_scale),
+                ceil (rect.width  / data->level_scale),
+                ceil (rect.height / data->level_scale));
+            }
+        }
+
+      if (--private->preview_n_pending == 0)
+        {
+          g_clear_pointer (&private->preview_pending_region,
+                           cairo_region_destroy);
+        }
+    }
+
+  cairo_region_destroy (data->region);
+  g_object_unref (data->pyramid);
+  g_object_unref (data->drawable);
+
+  g_slice_free (PyramidRenderData, data);
+}
 
 /*  public functions  */
 
@@ -188,13 +500,16 @@ gimp_drawable_get_sub_preview (GimpDrawable *drawable,
                                gint          dest_width,
                                gint          dest_height)
 {
-  GimpItem    *item;
-  GimpImage   *image;
-  GeglBuffer  *buffer;
-  GimpTempBuf *preview;
-  gdouble      scale;
-  gint         scaled_x;
-  gint         scaled_y;
+  GimpItem       *item;
+  GimpImage      *image;
+  GeglBuffer     *buffer;
+  GeglBuffer     *pyramid;
+  cairo_region_t *region;
+  GimpTempBuf    *preview;
+  gdouble         scale;
+  gdouble         pyramid_scale;
+  gint            scaled_x;
+  gint            scaled_y;
 
   g_return_val_if_fail (GIMP_IS_DRAWABLE (drawable), NULL);
   g_return_val_if_fail (src_x >= 0, NULL);
@@ -225,6 +540,26 @@ gimp_drawable_get_sub_preview (GimpDrawable *drawable,
   scaled_x = RINT ((gdouble) src_x * scale);
   scaled_y = RINT ((gdouble) src_y * scale);
 
+  pyramid = gimp_drawable_get_preview_pyramid (drawable, buffer,
+                                               scale, FALSE,
+                                               &pyramid_scale, &region);
+
+  if (pyramid)
+    {
+      if (region)
+        {
+          gimp_drawable_preview_pyramid_render (
+            drawable, buffer, pyramid, region,
+            scale / pyramid_scale,
+            ++drawable->private->preview_render_serial);
+          cairo_region_destroy (region);
+        }
+
+      g_object_unref (buffer);
+      buffer = pyramid;
+      scale  = pyramid_scale;
+    }
+
   gegl_buffer_get (buffer,
                    GEGL_RECTANGLE (scaled_x, scaled_y, dest_width, dest_height),
                    scale,
@@ -388,6 +723,16 @@ gimp_drawable_get_sub_preview_async_func (GimpAsync      *async,
       data->iter = NULL;
     }
 
+  if (data->pyramid_region)
+    {
+      gimp_drawable_preview_pyramid_render (data->drawable,
+                                            data->pyramid_src,
+                                            data->buffer,
+                                            data->pyramid_region,
+                                            data->pyramid_scale,
+                                            data->pyramid_serial);
+    }
+
   gegl_buffer_get (data->buffer, &data->rect, data->scale,
                    gimp_temp_buf_get_format (preview),
                    gimp_temp_buf_get_data (preview),
@@ -412,8 +757,12 @@ gimp_drawable_get_sub_preview_async (GimpDrawable *drawable,
   GimpItem       *item;
   GimpImage      *image;
   GeglBuffer     *buffer;
+  GeglBuffer     *pyramid;
+  cairo_region_t *region = NULL;
   SubPreviewData *data;
+  GimpAsync      *async;
   gdouble         scale;
+  gdouble         pyramid_scale;
   gint            scaled_x;
   gint            scaled_y;
   static gint     no_async_drawable_previews = -1;
@@ -467,15 +816,49 @@ gimp_drawable_get_sub_preview_async (GimpDrawable *drawable,
   scaled_x = RINT ((gdouble) src_x * scale);
   scaled_y = RINT ((gdouble) src_y * scale);
 
-  data = sub_preview_data_new (
-    gimp_drawable_get_preview_format (drawable),
-    buffer,
-    GEGL_RECTANGLE (scaled_x, scaled_y, dest_width, dest_height),
-    scale);
+  /*  only the bookkeeping is done here, the pyramid's dirty part is
+   *  rendered by the async job, before reading the preview from it
+   */
+  pyramid = gimp_drawable_get_preview_pyramid (drawable, buffer,
+                                               scale, TRUE,
+                                               &pyramid_scale, &region);
 
-  if (gimp_tile_handler_validate_get_assigned (buffer))
+  if (pyramid)
     {
-      return gimp_idle_run_async_full (
+      data = sub_preview_data_new (
+        gimp_drawable_get_preview_format (drawable),
+        pyramid,
+        GEGL_RECTANGLE (scaled_x, scaled_y, dest_width, dest_height),
+        pyramid_scale);
+
+      if (region)
+        {
+          /*  not a reference, the PyramidRenderData added below
+           *  keeps the drawable alive until the job is done
+           */
+          data->drawable       = drawable;
+          data->pyramid_src    = buffer;
+          data->pyramid_region = cairo_region_copy (region);
+          data->pyramid_scale  = scale / pyramid_scale;
+          data->pyramid_serial = ++drawable->private->preview_render_serial;
+        }
+      else
+        {
+          g_object_unref (buffer);
+        }
+    }
+  else
+    {
+      data = sub_preview_data_new (
+        gimp_drawable_get_preview_format (drawable),
+        buffer,
+        GEGL_RECTANGLE (scaled_x, scaled_y, dest_width, dest_height),
+        scale);
+    }
+
+  if (gimp_tile_handler_validate_get_assigned (data->buffer))
+    {
+      async = gimp_idle_run_async_full (
         GIMP_PRIORITY_VIEWABLE_IDLE,
         (GimpRunAsyncFunc) gimp_drawable_get_sub_preview_async_func,
         data,
@@ -483,10 +866,70 @@ gimp_drawable_get_sub_preview_async (GimpDrawable *drawable,
     }
   else
     {
-      return gimp_parallel_run_async_full (
+      async = gimp_parallel_run_async_full (
         +1,
         (GimpRunAsyncFunc) gimp_drawable_get_sub_preview_async_func,
         data,
         (GDestroyNotify) sub_preview_data_free);
     }
+
+  if (region)
+    {
+      PyramidRenderData *render_data = g_slice_new (PyramidRenderData);
+
+      render_data->drawable    = g_object_ref (drawable);
+      render_data->pyramid     = g_object_ref (pyramid);
+      render_data->region      = region;
+      render_data->level_scale = scale / pyramid_scale;
+
+      gimp_async_add_callback (
+        async,
+        (GimpAsyncCallback) gimp_drawable_preview_pyramid_rendered,
+        render_data);
+    }
+
+  return async;
+}
+
+void
+gimp_drawable_preview_pyramid_update (GimpDrawable *drawable,
+                                      gint          x,
+                                      gint          y,
+                                      gint          width,
+                                      gint          height)
+{
+  GimpDrawablePrivate   *private;
+  cairo_rectangle_int_t  rect;
+
+  g_return_if_fail (GIMP_IS_DRAWABLE (drawable));
+
+  private = drawable->private;
+
+  /*  without a pyramid, there is nothing to keep up to date  */
+  if (! private->preview_pyramid)
+    return;
+
+  rect.x      = x;
+  rect.y      = y;
+  rect.width  = width;
+  rect.height = height;
+
+  if (private->preview_dirty_region)
+    cairo_region_union_rectangle (private->preview_dirty_region, &rect);
+  else
+    private->preview_dirty_region = cairo_region_create_rectangle (&rect);
+}
+
+void
+gimp_drawable_preview_pyramid_clear (GimpDrawable *drawable)
+{
+  g_return_if_fail (GIMP_IS_DRAWABLE (drawable));
+
+  g_clear_object (&drawable->private->preview_pyramid);
+  g_clear_pointer (&drawable->private->preview_dirty_region,
+                   cairo_region_destroy);
+  g_clear_pointer (&drawable->private->preview_pending_region,
+                   cairo_region_destroy);
+
+  drawable->private->preview_n_pending = 0;
 }
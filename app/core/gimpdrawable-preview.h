@@ -59,3 +59,10 @@ GimpAsync   * gimp_drawable_get_sub_preview_async (GimpDrawable *drawable,
                                                    gint          src_height,
                                                    gint          dest_width,
                                                    gint          dest_height);
+
+void          gimp_drawable_preview_pyramid_update (GimpDrawable *drawable,
+                                                    gint          x,
+                                                    gint          y,
+                                                    gint          width,
+                                                    gint          height);
+void          gimp_drawable_preview_pyramid_clear  (GimpDrawable *drawable);
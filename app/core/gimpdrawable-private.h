@@ -42,5 +42,13 @@ struct _GimpDrawablePrivate
   cairo_region_t   *paint_copy_region;
   cairo_region_t   *paint_update_region;
 
+  GeglBuffer       *preview_pyramid;       /* the buffer at 1 / 2^level */
+  gint              preview_pyramid_level;
+  cairo_region_t   *preview_dirty_region;  /* not yet in the pyramid   */
+  cairo_region_t   *preview_pending_region; /* handed to async jobs    */
+  gint              preview_n_pending;
+  guint             preview_render_serial;    /* of the last render     */
+  guint             preview_render_installed; /* newest render installed */
+
   gboolean          push_resize_undo;
 };
@@ -385,6 +385,7 @@ gimp_drawable_finalize (GObject *object)
   g_clear_object (&drawable->private->format_profile);
 
   gimp_drawable_free_shadow_buffer (drawable);
+  gimp_drawable_preview_pyramid_clear (drawable);
 
   g_clear_object (&drawable->private->source_node);
   g_clear_object (&drawable->private->buffer_source_node);
@@ -438,6 +439,7 @@ gimp_drawable_get_memsize (GimpObject *object,
 
   memsize += gimp_gegl_buffer_get_memsize (gimp_drawable_get_buffer (drawable));
   memsize += gimp_gegl_buffer_get_memsize (drawable->private->shadow);
+  memsize += gimp_gegl_buffer_get_memsize (drawable->private->preview_pyramid);
 
   return memsize + GIMP_OBJECT_CLASS (parent_class)->get_memsize (object,
                                                                   gui_size);
@@ -884,12 +886,16 @@ gimp_drawable_real_update (GimpDrawable *drawable,
                            gint          width,
                            gint          height)
 {
+  gimp_drawable_preview_pyramid_update (drawable, x, y, width, height);
+
   gimp_viewable_invalidate_preview (GIMP_VIEWABLE (drawable));
 }
 
 static void
 gimp_drawable_real_filters_changed (GimpDrawable *drawable)
 {
+  gimp_drawable_preview_pyramid_clear (drawable);
+
   gimp_drawable_update_bounding_box (drawable);
 }
 
@@ -995,6 +1001,8 @@ gimp_drawable_real_set_buffer (GimpDrawable        *drawable,
 
   g_set_object (&drawable->private->buffer, buffer);
 
+  gimp_drawable_preview_pyramid_clear (drawable);
+
   if (gimp_drawable_is_painting (drawable))
     g_set_object (&drawable->private->paint_buffer, buffer);
 
@@ -1044,28 +1052,16 @@ gimp_drawable_real_push_undo (GimpDrawable *drawable,
 
   if (! buffer)
     {
-      GeglBuffer    *drawable_buffer = gimp_drawable_get_buffer (drawable);
-      GeglRectangle  drawable_rect;
+      GeglRectangle drawable_rect;
 
-      gegl_rectangle_align_to_buffer (
-        &drawable_rect,
-        GEGL_RECTANGLE (x, y, width, height),
-        drawable_buffer,
-        GEGL_RECTANGLE_ALIGNMENT_SUPERSET);
+      buffer = gimp_gegl_buffer_snapshot (gimp_drawable_get_buffer (drawable),
+                                          GEGL_RECTANGLE (x, y, width, height),
+                                          &drawable_rect);
 
       x      = drawable_rect.x;
       y      = drawable_rect.y;
       width  = drawable_rect.width;
       height = drawable_rect.height;
-
-      buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, width, height),
-                                gimp_drawable_get_format (drawable));
-
-      gimp_gegl_buffer_copy (
-        drawable_buffer,
-        &drawable_rect, GEGL_ABYSS_NONE,
-        buffer,
-        GEGL_RECTANGLE (0, 0, 0, 0));
     }
   else
     {
@@ -39,6 +39,7 @@
 #include "core-types.h"
 
 #include "operations/gimp-operation-config.h"
+#include "operations/gimpoperationpointfilter.h"
 
 #include "gegl/gimp-babl.h"
 #include "gegl/gimpapplicator.h"
@@ -50,6 +51,7 @@
 #include "gimpdrawablefilter.h"
 #include "gimpdrawablefiltermask.h"
 #include "gimperror.h"
+#include "gimpfilterstack.h"
 #include "gimpidtable.h"
 #include "gimpimage.h"
 #include "gimplayer.h"
@@ -134,6 +136,9 @@ static void       gimp_drawable_filter_get_property          (GObject
 static void       gimp_drawable_filter_dispose               (GObject             *object);
 static void       gimp_drawable_filter_finalize              (GObject             *object);
 
+static GeglNode * gimp_drawable_filter_get_point_node        (GimpFilter          *filter,
+                                                              GeglRectangle       *clip);
+
 static void       gimp_drawable_filter_sync_active           (GimpDrawableFilter  *filter);
 static void       gimp_drawable_filter_sync_clip             (GimpDrawableFilter  *filter,
                                                               gboolean             sync_region);
@@ -150,6 +155,7 @@ static void       gimp_drawable_filter_sync_mode             (GimpDrawableFilter
 static void       gimp_drawable_filter_sync_affect           (GimpDrawableFilter  *filter);
 static void       gimp_drawable_filter_sync_format           (GimpDrawableFilter  *filter);
 static void       gimp_drawable_filter_sync_mask             (GimpDrawableFilter  *filter);
+static void       gimp_drawable_filter_sync_fusion           (GimpDrawableFilter  *filter);
 
 static gboolean   gimp_drawable_filter_is_added              (GimpDrawableFilter  *filter);
 static gboolean   gimp_drawable_filter_is_active             (GimpDrawableFilter  *filter);
@@ -191,7 +197,8 @@ static GParamSpec *drawable_filter_props[N_PROPS]       = { NULL, };
 static void
 gimp_drawable_filter_class_init (GimpDrawableFilterClass *klass)
 {
-  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  GObjectClass    *object_class = G_OBJECT_CLASS (klass);
+  GimpFilterClass *filter_class = GIMP_FILTER_CLASS (klass);
 
   drawable_filter_signals[FLUSH] =
     g_signal_new ("flush",
@@ -206,6 +213,8 @@ gimp_drawable_filter_class_init (GimpDrawableFilterClass *klass)
   object_class->dispose      = gimp_drawable_filter_dispose;
   object_class->finalize     = gimp_drawable_filter_finalize;
 
+  filter_class->get_point_node = gimp_drawable_filter_get_point_node;
+
   drawable_filter_props[PROP_ID]       = g_param_spec_int ("id", NULL, NULL,
                                                            0, G_MAXINT, 0,
                                                            GIMP_PARAM_READABLE);
@@ -371,6 +380,65 @@ gimp_drawable_filter_finalize (GObject *object)
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
+static GeglNode *
+gimp_drawable_filter_get_point_node (GimpFilter    *filter,
+                                     GeglRectangle *clip)
+{
+  GimpDrawableFilter *drawable_filter = GIMP_DRAWABLE_FILTER (filter);
+  GimpApplicator     *applicator      = drawable_filter->applicator;
+  GeglOperation      *operation;
+  GeglNode           *crop_nodes[2];
+  gint                i;
+
+  /*  the applicator must pass the operation's output on unchanged  */
+  if (! drawable_filter->has_input                          ||
+      ! applicator->active                                  ||
+      applicator->opacity        != GIMP_OPACITY_OPAQUE     ||
+      applicator->paint_mode     != GIMP_LAYER_MODE_REPLACE ||
+      applicator->affect         != GIMP_COMPONENT_MASK_ALL ||
+      applicator->output_format                             ||
+      applicator->crop_enabled                              ||
+      applicator->mask_buffer                               ||
+      applicator->apply_offset_x != 0                       ||
+      applicator->apply_offset_y != 0)
+    {
+      return NULL;
+    }
+
+  operation = gegl_node_get_gegl_operation (drawable_filter->operation);
+
+  if (! GIMP_IS_OPERATION_POINT_FILTER (operation) ||
+      ! gimp_operation_point_filter_can_chain (GIMP_OPERATION_POINT_FILTER (operation)))
+    {
+      return NULL;
+    }
+
+  crop_nodes[0] = drawable_filter->crop_before;
+  crop_nodes[1] = drawable_filter->crop_after;
+
+  for (i = 0; i < G_N_ELEMENTS (crop_nodes); i++)
+    {
+      if (! g_strcmp0 (gegl_node_get_operation (crop_nodes[i]), "gegl:crop"))
+        {
+          gdouble       x, y;
+          gdouble       width, height;
+          GeglRectangle rect;
+
+          gegl_node_get (crop_nodes[i],
+                         "x",      &x,
+                         "y",      &y,
+                         "width",  &width,
+                         "height", &height,
+                         NULL);
+
+          gegl_rectangle_set (&rect, x, y, width, height);
+          gegl_rectangle_intersect (clip, clip, &rect);
+        }
+    }
+
+  return drawable_filter->operation;
+}
+
 GimpDrawableFilter *
 gimp_drawable_filter_new (GimpDrawable *drawable,
                           const gchar  *undo_desc,
@@ -1383,6 +1451,8 @@ static void
 gimp_drawable_filter_sync_active (GimpDrawableFilter *filter)
 {
   gimp_applicator_set_active (filter->applicator, filter->preview_enabled);
+
+  gimp_drawable_filter_sync_fusion (filter);
 }
 
 static void
@@ -1529,6 +1599,8 @@ gimp_drawable_filter_sync_region (GimpDrawableFilter *filter)
       gimp_applicator_set_apply_offset (filter->applicator, 0, 0);
     }
 
+  gimp_drawable_filter_sync_fusion (filter);
+
   if (gimp_drawable_filter_is_active (filter))
     {
       if (gimp_drawable_update_bounding_box (filter->drawable))
@@ -1621,6 +1693,8 @@ gimp_drawable_filter_sync_crop (GimpDrawableFilter  *filter,
 
   gimp_applicator_set_crop (filter->applicator, enabled ? &new_rect : NULL);
 
+  gimp_drawable_filter_sync_fusion (filter);
+
   if (update                                  &&
       gimp_drawable_filter_is_active (filter) &&
       ! gegl_rectangle_equal (&old_rect, &new_rect))
@@ -1643,6 +1717,8 @@ gimp_drawable_filter_sync_opacity (GimpDrawableFilter *filter)
 {
   gimp_applicator_set_opacity (filter->applicator,
                                filter->opacity);
+
+  gimp_drawable_filter_sync_fusion (filter);
 }
 
 static void
@@ -1664,6 +1740,8 @@ gimp_drawable_filter_sync_mode (GimpDrawableFilter *filter)
                             filter->blend_space,
                             filter->composite_space,
                             filter->composite_mode);
+
+  gimp_drawable_filter_sync_fusion (filter);
 }
 
 static void
@@ -1679,6 +1757,8 @@ gimp_drawable_filter_sync_affect (GimpDrawableFilter *filter)
       GIMP_COMPONENT_MASK_ALPHA :
 
       gimp_drawable_get_active_mask (filter->drawable));
+
+  gimp_drawable_filter_sync_fusion (filter);
 }
 
 static void
@@ -1711,6 +1791,8 @@ gimp_drawable_filter_sync_format (GimpDrawableFilter *filter)
 
   changed = gimp_applicator_set_output_format (filter->applicator, format);
 
+  gimp_drawable_filter_sync_fusion (filter);
+
   if (changed && gimp_drawable_filter_is_active (filter))
     gimp_drawable_filter_update_drawable (filter, NULL);
 }
@@ -1763,6 +1845,22 @@ gimp_drawable_filter_sync_mask (GimpDrawableFilter *filter)
 
       gimp_drawable_filter_sync_region (filter);
     }
+
+  gimp_drawable_filter_sync_fusion (filter);
+}
+
+static void
+gimp_drawable_filter_sync_fusion (GimpDrawableFilter *filter)
+{
+  /*  whether the filter can be fused with its neighbors depends on
+   *  everything synced above, let the stack re-check its runs
+   */
+  if (gimp_drawable_filter_is_added (filter))
+    {
+      GimpContainer *filters = gimp_drawable_get_filters (filter->drawable);
+
+      gimp_filter_stack_update_fusion (GIMP_FILTER_STACK (filters));
+    }
 }
 
 static gboolean
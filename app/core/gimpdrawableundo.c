@@ -17,19 +17,33 @@
 
 #include "config.h"
 
+#include <errno.h>
+#include <string.h>
+
 #include <gdk-pixbuf/gdk-pixbuf.h>
 #include <gegl.h>
+#include <zlib.h>
+
+#include <glib/gstdio.h>
 
 #include "libgimpbase/gimpbase.h"
 
 #include "core-types.h"
 
 #include "gimp-memsize.h"
+#include "gimp-parallel.h"
+#include "gimpasync.h"
 #include "gimpimage.h"
 #include "gimpdrawable.h"
 #include "gimpdrawable-filters.h"
 #include "gimpdrawableundo.h"
 
+#include "gimp-intl.h"
+
+
+/*  number of rows compressed as one unit  */
+#define STORE_BAND_HEIGHT 64
+
 
 enum
 {
@@ -40,6 +54,40 @@ enum
 };
 
 
+struct _GimpDrawableUndoStore
+{
+  const Babl     *format;
+  GeglRectangle   extent;
+
+  gint            n_bands;
+  GBytes        **bands;      /*  the zlib compressed bands, or NULL  */
+  gsize          *band_sizes; /*  their sizes, also in the swap file  */
+  gint64          memsize;
+
+  gchar          *swap_file;
+};
+
+typedef struct
+{
+  GimpDrawableUndoStore *store;
+  GeglBuffer            *buffer;
+  const guchar          *data;     /*  the swap file contents, or NULL  */
+  goffset               *offsets;
+  GimpAsync             *async;
+  gboolean               failed;
+} StoreBandsData;
+
+typedef struct
+{
+  GimpDrawableUndo      *undo;
+  GeglBuffer            *buffer;   /*  the pixels to compress, or NULL    */
+  GimpDrawableUndoStore *store;    /*  the compressed pixels to swap out  */
+  GBytes                *key;      /*  the first band of undo->store      */
+  gchar                 *swap_dir;
+  GimpDrawableUndoStore *result;
+} CompressAsyncData;
+
+
 static void     gimp_drawable_undo_constructed  (GObject             *object);
 static void     gimp_drawable_undo_set_property (GObject             *object,
                                                  guint                property_id,
@@ -59,6 +107,34 @@ static void     gimp_drawable_undo_pop          (GimpUndo            *undo,
 static void     gimp_drawable_undo_free         (GimpUndo            *undo,
                                                  GimpUndoMode         undo_mode);
 
+static void     gimp_drawable_undo_compress_bands
+                                                (gint                 i,
+                                                 gint                 n,
+                                                 gpointer             user_data);
+static void     gimp_drawable_undo_restore_bands
+                                                (gint                 i,
+                                                 gint                 n,
+                                                 gpointer             user_data);
+static void     gimp_drawable_undo_restore      (GimpDrawableUndo    *undo);
+
+static void     gimp_drawable_undo_compress_async_func
+                                                (GimpAsync           *async,
+                                                 CompressAsyncData   *data);
+static void     gimp_drawable_undo_compress_async_callback
+                                                (GimpAsync           *async,
+                                                 CompressAsyncData   *data);
+
+static GimpDrawableUndoStore *
+                gimp_drawable_undo_store_new    (GeglBuffer          *buffer,
+                                                 GimpAsync           *async);
+static GimpDrawableUndoStore *
+                gimp_drawable_undo_store_copy   (GimpDrawableUndoStore *store);
+static gboolean gimp_drawable_undo_store_swap_out
+                                                (GimpDrawableUndoStore *store,
+                                                 const gchar         *swap_dir,
+                                                 GError             **error);
+static void     gimp_drawable_undo_store_free   (GimpDrawableUndoStore *store);
+
 
 G_DEFINE_TYPE (GimpDrawableUndo, gimp_drawable_undo, GIMP_TYPE_ITEM_UNDO)
 
@@ -177,6 +253,9 @@ gimp_drawable_undo_get_memsize (GimpObject *object,
 
   memsize += gimp_gegl_buffer_get_memsize (drawable_undo->buffer);
 
+  if (drawable_undo->store)
+    memsize += drawable_undo->store->memsize;
+
   return memsize + GIMP_OBJECT_CLASS (parent_class)->get_memsize (object,
                                                                   gui_size);
 }
@@ -191,6 +270,14 @@ gimp_drawable_undo_pop (GimpUndo            *undo,
 
   GIMP_UNDO_CLASS (parent_class)->pop (undo, undo_mode, accum);
 
+  /*  the pixels are swapped in place below, a compaction still running
+   *  would read them meanwhile and install stale ones afterwards
+   */
+  if (drawable_undo->compress_async)
+    gimp_async_cancel_and_wait (drawable_undo->compress_async);
+
+  gimp_drawable_undo_restore (drawable_undo);
+
   gimp_drawable_swap_pixels (drawable,
                              drawable_undo->buffer,
                              drawable_undo->x,
@@ -207,6 +294,504 @@ gimp_drawable_undo_free (GimpUndo     *undo,
   GimpDrawableUndo *drawable_undo = GIMP_DRAWABLE_UNDO (undo);
 
   g_clear_object (&drawable_undo->buffer);
+  g_clear_pointer (&drawable_undo->store, gimp_drawable_undo_store_free);
 
   GIMP_UNDO_CLASS (parent_class)->free (undo, undo_mode);
 }
+
+
+/*  public functions  */
+
+gboolean
+gimp_drawable_undo_is_compressed (GimpDrawableUndo *undo)
+{
+  g_return_val_if_fail (GIMP_IS_DRAWABLE_UNDO (undo), FALSE);
+
+  return undo->store != NULL;
+}
+
+gboolean
+gimp_drawable_undo_is_swapped (GimpDrawableUndo *undo)
+{
+  g_return_val_if_fail (GIMP_IS_DRAWABLE_UNDO (undo), FALSE);
+
+  return undo->store && undo->store->swap_file;
+}
+
+/**
+ * gimp_drawable_undo_compress_async:
+ * @undo:     a #GimpDrawableUndo
+ * @swap_dir: (nullable): the directory to swap the pixels out to
+ *
+ * Compresses the undo's pixel buffer with zlib on a worker thread.  If
+ * @swap_dir is not %NULL, the compressed pixels are also moved to a
+ * file in @swap_dir, so that they no longer use memory; this is done
+ * for an undo which is already compressed, too.
+ *
+ * The result is applied on the main thread once the returned #GimpAsync
+ * is finished, unless the undo has been freed in the meantime; popping
+ * the undo cancels the operation and waits for it first.  The pixels
+ * are restored transparently when the undo is popped, and the swap
+ * file is removed when the undo is freed.  The undo's size changes, so if it is on an undo stack, the caller has to
+ * call gimp_undo_stack_update_undo() from a callback added to the
+ * returned #GimpAsync.
+ *
+ * Returns: (nullable) (transfer full): a #GimpAsync, or %NULL if there
+ *          is nothing to do.
+ **/
+GimpAsync *
+gimp_drawable_undo_compress_async (GimpDrawableUndo *undo,
+                                   const gchar      *swap_dir)
+{
+  CompressAsyncData *data;
+  GimpAsync         *async;
+
+  g_return_val_if_fail (GIMP_IS_DRAWABLE_UNDO (undo), NULL);
+
+  if (undo->buffer)
+    {
+      const GeglRectangle *extent = gegl_buffer_get_extent (undo->buffer);
+
+      if (gegl_rectangle_is_empty (extent))
+        return NULL;
+    }
+  else if (! undo->store || undo->store->swap_file || ! swap_dir)
+    {
+      return NULL;
+    }
+
+  data = g_slice_new0 (CompressAsyncData);
+
+  data->undo     = g_object_ref (undo);
+  data->swap_dir = g_strdup (swap_dir);
+
+  if (undo->buffer)
+    {
+      data->buffer = g_object_ref (undo->buffer);
+    }
+  else
+    {
+      /*  the worker thread gets its own references to the compressed
+       *  bands, the undo's store may be freed while it runs
+       */
+      data->store = gimp_drawable_undo_store_copy (undo->store);
+      data->key   = g_bytes_ref (undo->store->bands[0]);
+    }
+
+  async = gimp_parallel_run_async (
+    (GimpRunAsyncFunc) gimp_drawable_undo_compress_async_func,
+    data);
+
+  /*  not a reference, cleared by the callback  */
+  undo->compress_async = async;
+
+  gimp_async_add_callback (
+    async,
+    (GimpAsyncCallback) gimp_drawable_undo_compress_async_callback,
+    data);
+
+  return async;
+}
+
+
+/*  private functions  */
+
+static void
+gimp_drawable_undo_compress_async_func (GimpAsync         *async,
+                                        CompressAsyncData *data)
+{
+  GimpDrawableUndoStore *store = data->store;
+  GError                *error = NULL;
+
+  if (data->buffer)
+    {
+      store = gimp_drawable_undo_store_new (data->buffer, async);
+
+      if (! store)
+        {
+          gimp_async_abort (async);
+
+          return;
+        }
+    }
+
+  data->store = NULL;
+
+  if (data->swap_dir && ! gimp_async_is_canceled (async) &&
+      ! gimp_drawable_undo_store_swap_out (store, data->swap_dir, &error))
+    {
+      g_printerr ("Swapping out undo step failed: %s\n", error->message);
+      g_clear_error (&error);
+
+      /*  a freshly compressed store is still worth keeping  */
+      if (! data->buffer)
+        {
+          gimp_drawable_undo_store_free (store);
+          gimp_async_abort (async);
+
+          return;
+        }
+    }
+
+  data->result = store;
+
+  gimp_async_finish (async, NULL);
+}
+
+static void
+gimp_drawable_undo_compress_async_callback (GimpAsync         *async,
+                                            CompressAsyncData *data)
+{
+  GimpDrawableUndo *undo = data->undo;
+
+  if (undo->compress_async == async)
+    undo->compress_async = NULL;
+
+  /*  only apply the result if the undo still holds the pixels it was
+   *  computed from, it might have been popped or freed meanwhile
+   */
+  if (gimp_async_is_finished (async) && data->result)
+    {
+      gboolean unchanged;
+
+      if (data->buffer)
+        unchanged = (undo->buffer == data->buffer);
+      else
+        unchanged = (undo->store                   &&
+                     ! undo->store->swap_file      &&
+                     undo->store->bands[0] == data->key);
+
+      if (unchanged)
+        {
+          g_clear_object (&undo->buffer);
+          g_clear_pointer (&undo->store, gimp_drawable_undo_store_free);
+
+          undo->store  = data->result;
+          data->result = NULL;
+        }
+    }
+
+  g_clear_pointer (&data->result, gimp_drawable_undo_store_free);
+  g_clear_pointer (&data->store,  gimp_drawable_undo_store_free);
+  g_clear_pointer (&data->key,    g_bytes_unref);
+  g_clear_object (&data->buffer);
+  g_free (data->swap_dir);
+  g_object_unref (data->undo);
+
+  g_slice_free (CompressAsyncData, data);
+}
+
+/*  may be called from any thread  */
+static GimpDrawableUndoStore *
+gimp_drawable_undo_store_new (GeglBuffer *buffer,
+                              GimpAsync  *async)
+{
+  GimpDrawableUndoStore *store;
+  StoreBandsData         data = { 0, };
+  gint                   b;
+
+  store = g_slice_new0 (GimpDrawableUndoStore);
+
+  store->format     = gegl_buffer_get_format (buffer);
+  store->extent     = *gegl_buffer_get_extent (buffer);
+  store->n_bands    = (store->extent.height + STORE_BAND_HEIGHT - 1) /
+                      STORE_BAND_HEIGHT;
+  store->bands      = g_new0 (GBytes *, store->n_bands);
+  store->band_sizes = g_new0 (gsize, store->n_bands);
+
+  data.store  = store;
+  data.buffer = buffer;
+  data.async  = async;
+
+  gegl_parallel_distribute (store->n_bands,
+                            gimp_drawable_undo_compress_bands, &data);
+
+  if (data.failed)
+    {
+      gimp_drawable_undo_store_free (store);
+
+      return NULL;
+    }
+
+  for (b = 0; b < store->n_bands; b++)
+    store->memsize += store->band_sizes[b];
+
+  store->memsize += (sizeof (GimpDrawableUndoStore) +
+                     store->n_bands * (sizeof (GBytes *) + sizeof (gsize)));
+
+  return store;
+}
+
+static GimpDrawableUndoStore *
+gimp_drawable_undo_store_copy (GimpDrawableUndoStore *store)
+{
+  GimpDrawableUndoStore *copy;
+  gint                   b;
+
+  copy = g_slice_dup (GimpDrawableUndoStore, store);
+
+  copy->bands      = g_new0 (GBytes *, store->n_bands);
+  copy->band_sizes = g_memdup2 (store->band_sizes,
+                                store->n_bands * sizeof (gsize));
+  copy->swap_file  = NULL;
+
+  for (b = 0; b < store->n_bands; b++)
+    copy->bands[b] = g_bytes_ref (store->bands[b]);
+
+  return copy;
+}
+
+/*  may be called from any thread, for a store which isn't shared  */
+static gboolean
+gimp_drawable_undo_store_swap_out (GimpDrawableUndoStore  *store,
+                                   const gchar            *swap_dir,
+                                   GError                **error)
+{
+  gchar *filename;
+  gchar *contents;
+  gsize  length = 0;
+  gsize  offset = 0;
+  gint   fd;
+  gint   b;
+
+  filename = g_build_filename (swap_dir, "gimp-undo-XXXXXX", NULL);
+
+  fd = g_mkstemp (filename);
+
+  if (fd == -1)
+    {
+      gint   saved_errno = errno;
+      /*  gimp_filename_to_utf8() isn't thread-safe  */
+      gchar *dirname     = g_filename_display_name (swap_dir);
+
+      g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (saved_errno),
+                   _("Could not create undo swap file in '%s': %s"),
+                   dirname, g_strerror (saved_errno));
+      g_free (dirname);
+      g_free (filename);
+
+      return FALSE;
+    }
+
+  g_close (fd, NULL);
+
+  for (b = 0; b < store->n_bands; b++)
+    length += store->band_sizes[b];
+
+  contents = g_malloc (length);
+
+  for (b = 0; b < store->n_bands; b++)
+    {
+      memcpy (contents + offset,
+              g_bytes_get_data (store->bands[b], NULL),
+              store->band_sizes[b]);
+
+      offset += store->band_sizes[b];
+    }
+
+  if (! g_file_set_contents (filename, contents, length, error))
+    {
+      g_unlink (filename);
+      g_free (filename);
+      g_free (contents);
+
+      return FALSE;
+    }
+
+  g_free (contents);
+
+  for (b = 0; b < store->n_bands; b++)
+    g_clear_pointer (&store->bands[b], g_bytes_unref);
+
+  store->swap_file = filename;
+  store->memsize   = (sizeof (GimpDrawableUndoStore) +
+                      store->n_bands * (sizeof (GBytes *) + sizeof (gsize)));
+
+  return TRUE;
+}
+
+static void
+gimp_drawable_undo_compress_bands (gint     i,
+                                   gint     n,
+                                   gpointer user_data)
+{
+  StoreBandsData        *data   = user_data;
+  GimpDrawableUndoStore *store  = data->store;
+  gint                   bpp    = babl_format_get_bytes_per_pixel (store->format);
+  gsize                  stride = (gsize) store->extent.width * bpp;
+  guchar                *pixels;
+  guchar                *dest;
+  gint                   b;
+
+  pixels = g_malloc (stride * STORE_BAND_HEIGHT);
+  dest   = g_malloc (compressBound (stride * STORE_BAND_HEIGHT));
+
+  for (b = i; b < store->n_bands && ! data->failed; b += n)
+    {
+      GeglRectangle rect;
+      uLongf        size;
+
+      if (data->async && gimp_async_is_canceled (data->async))
+        {
+          data->failed = TRUE;
+          break;
+        }
+
+      rect.x      = store->extent.x;
+      rect.y      = store->extent.y + b * STORE_BAND_HEIGHT;
+      rect.width  = store->extent.width;
+      rect.height = MIN (STORE_BAND_HEIGHT,
+                         store->extent.y + store->extent.height - rect.y);
+
+      gegl_buffer_get (data->buffer, &rect, 1.0, store->format, pixels,
+                       stride, GEGL_ABYSS_NONE);
+
+      size = compressBound (stride * rect.height);
+
+      if (compress2 (dest, &size, pixels, stride * rect.height,
+                     Z_BEST_SPEED) != Z_OK)
+        {
+          data->failed = TRUE;
+          break;
+        }
+
+      store->bands[b]      = g_bytes_new (dest, size);
+      store->band_sizes[b] = size;
+    }
+
+  g_free (dest);
+  g_free (pixels);
+}
+
+static void
+gimp_drawable_undo_restore_bands (gint     i,
+                                  gint     n,
+                                  gpointer user_data)
+{
+  StoreBandsData        *data   = user_data;
+  GimpDrawableUndoStore *store  = data->store;
+  gint                   bpp    = babl_format_get_bytes_per_pixel (store->format);
+  gsize                  stride = (gsize) store->extent.width * bpp;
+  guchar                *pixels;
+  gint                   b;
+
+  pixels = g_malloc (stride * STORE_BAND_HEIGHT);
+
+  for (b = i; b < store->n_bands && ! data->failed; b += n)
+    {
+      GeglRectangle  rect;
+      const guchar  *src;
+      uLongf         size;
+
+      rect.x      = store->extent.x;
+      rect.y      = store->extent.y + b * STORE_BAND_HEIGHT;
+      rect.width  = store->extent.width;
+      rect.height = MIN (STORE_BAND_HEIGHT,
+                         store->extent.y + store->extent.height - rect.y);
+
+      if (data->data)
+        src = data->data + data->offsets[b];
+      else
+        src = g_bytes_get_data (store->bands[b], NULL);
+
+      size = stride * rect.height;
+
+      if (uncompress (pixels, &size, src, store->band_sizes[b]) != Z_OK ||
+          size != stride * rect.height)
+        {
+          data->failed = TRUE;
+          break;
+        }
+
+      gegl_buffer_set (data->buffer, &rect, 0, store->format, pixels, stride);
+    }
+
+  g_free (pixels);
+}
+
+static void
+gimp_drawable_undo_restore (GimpDrawableUndo *undo)
+{
+  GimpDrawableUndoStore *store = undo->store;
+  StoreBandsData         data     = { 0, };
+  gchar                 *contents = NULL;
+  gsize                  length   = 0;
+
+  if (! store)
+    return;
+
+  data.store  = store;
+  data.buffer = gegl_buffer_new (&store->extent, store->format);
+
+  if (store->swap_file)
+    {
+      GError *error = NULL;
+
+      if (g_file_get_contents (store->swap_file, &contents, &length, &error))
+        {
+          goffset offset = 0;
+          gint    b;
+
+          data.data    = (const guchar *) contents;
+          data.offsets = g_new (goffset, store->n_bands);
+
+          for (b = 0; b < store->n_bands; b++)
+            {
+              data.offsets[b] = offset;
+              offset += store->band_sizes[b];
+            }
+
+          if (offset != length)
+            data.failed = TRUE;
+        }
+      else
+        {
+          g_printerr ("Reading undo swap file failed: %s\n", error->message);
+          g_clear_error (&error);
+
+          data.failed = TRUE;
+        }
+    }
+
+  if (! data.failed)
+    gegl_parallel_distribute (store->n_bands,
+                              gimp_drawable_undo_restore_bands, &data);
+
+  if (data.failed)
+    {
+      /*  we can't fail a pop, leave a transparent hole instead  */
+      g_printerr ("Restoring a compressed undo step failed.\n");
+
+      gegl_buffer_clear (data.buffer, &store->extent);
+    }
+
+  g_free (data.offsets);
+  g_free (contents);
+
+  undo->buffer = data.buffer;
+
+  g_clear_pointer (&undo->store, gimp_drawable_undo_store_free);
+}
+
+static void
+gimp_drawable_undo_store_free (GimpDrawableUndoStore *store)
+{
+  gint b;
+
+  for (b = 0; b < store->n_bands; b++)
+    {
+      if (store->bands[b])
+        g_bytes_unref (store->bands[b]);
+    }
+
+  g_free (store->bands);
+  g_free (store->band_sizes);
+
+  if (store->swap_file)
+    {
+      g_unlink (store->swap_file);
+      g_free (store->swap_file);
+    }
+
+  g_slice_free (GimpDrawableUndoStore, store);
+}
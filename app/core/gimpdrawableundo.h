@@ -30,14 +30,21 @@
 
 typedef struct _GimpDrawableUndo      GimpDrawableUndo;
 typedef struct _GimpDrawableUndoClass GimpDrawableUndoClass;
+typedef struct _GimpDrawableUndoStore GimpDrawableUndoStore;
 
 struct _GimpDrawableUndo
 {
-  GimpItemUndo  parent_instance;
+  GimpItemUndo           parent_instance;
 
-  GeglBuffer   *buffer;
-  gint          x;
-  gint          y;
+  GeglBuffer            *buffer;
+  gint                   x;
+  gint                   y;
+
+  /*  the pixels of a compressed or swapped out undo, buffer is NULL then  */
+  GimpDrawableUndoStore *store;
+
+  /*  compresses or swaps out the pixels, or NULL  */
+  GimpAsync             *compress_async;
 };
 
 struct _GimpDrawableUndoClass
@@ -46,4 +53,10 @@ struct _GimpDrawableUndoClass
 };
 
 
-GType   gimp_drawable_undo_get_type (void) G_GNUC_CONST;
+GType       gimp_drawable_undo_get_type       (void) G_GNUC_CONST;
+
+gboolean    gimp_drawable_undo_is_compressed  (GimpDrawableUndo *undo);
+gboolean    gimp_drawable_undo_is_swapped     (GimpDrawableUndo *undo);
+
+GimpAsync * gimp_drawable_undo_compress_async (GimpDrawableUndo *undo,
+                                               const gchar      *swap_dir);
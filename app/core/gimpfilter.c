@@ -108,6 +108,7 @@ gimp_filter_class_init (GimpFilterClass *klass)
 
   klass->active_changed          = NULL;
   klass->get_node                = gimp_filter_real_get_node;
+  klass->get_point_node          = NULL;
 
   g_object_class_install_property (object_class, PROP_ACTIVE,
                                    g_param_spec_boolean ("active", NULL, NULL,
@@ -242,6 +243,26 @@ gimp_filter_peek_node (GimpFilter *filter)
   return GET_PRIVATE (filter)->node;
 }
 
+/*  Returns the GimpOperationPointFilter node whose output the filter's
+ *  node produces unchanged, clipped to @clip, or NULL.  The filter
+ *  stack uses this to run adjacent point filters in one pass.
+ */
+GeglNode *
+gimp_filter_get_point_node (GimpFilter    *filter,
+                            GeglRectangle *clip)
+{
+  g_return_val_if_fail (GIMP_IS_FILTER (filter), NULL);
+  g_return_val_if_fail (clip != NULL, NULL);
+
+  *clip = gegl_rectangle_infinite_plane ();
+
+  if (! gimp_filter_get_active (filter) ||
+      ! GIMP_FILTER_GET_CLASS (filter)->get_point_node)
+    return NULL;
+
+  return GIMP_FILTER_GET_CLASS (filter)->get_point_node (filter, clip);
+}
+
 void
 gimp_filter_set_active (GimpFilter *filter,
                         gboolean    active)
@@ -37,7 +37,9 @@ struct _GimpFilterClass
   void       (* active_changed) (GimpFilter *filter);
 
   /*  virtual functions  */
-  GeglNode * (* get_node)       (GimpFilter *filter);
+  GeglNode * (* get_node)       (GimpFilter    *filter);
+  GeglNode * (* get_point_node) (GimpFilter    *filter,
+                                 GeglRectangle *clip);
 };
 
 
@@ -46,6 +48,8 @@ GimpFilter     * gimp_filter_new              (const gchar    *name);
 
 GeglNode       * gimp_filter_get_node         (GimpFilter     *filter);
 GeglNode       * gimp_filter_peek_node        (GimpFilter     *filter);
+GeglNode       * gimp_filter_get_point_node   (GimpFilter     *filter,
+                                               GeglRectangle  *clip);
 
 void             gimp_filter_set_active       (GimpFilter     *filter,
                                                gboolean        active);
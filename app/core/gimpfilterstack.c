@@ -25,10 +25,31 @@
 
 #include "core-types.h"
 
+#include "operations/gimpoperationpointfilterchain.h"
+
 #include "gimpfilter.h"
 #include "gimpfilterstack.h"
 
 
+/*  a run of adjacent filters whose point operations are evaluated by a
+ *  single gimp:point-filter-chain node.  the filters' own nodes stay
+ *  linked to each other, only the consumer above the run is relinked
+ *  to read from the chain instead of from the top filter.
+ */
+typedef struct _GimpFilterStackFusion GimpFilterStackFusion;
+
+struct _GimpFilterStackFusion
+{
+  GList         *filters;  /*  bottom to top                   */
+  GList         *nodes;    /*  the filters' point nodes        */
+  GeglRectangle  clip;
+
+  GeglNode      *consumer;
+  GeglNode      *chain;
+  GeglNode      *crop;
+};
+
+
 /*  local function prototypes  */
 
 static void   gimp_filter_stack_constructed      (GObject         *object);
@@ -52,6 +73,18 @@ static void   gimp_filter_stack_update_last_node (GimpFilterStack *stack);
 static void   gimp_filter_stack_filter_active    (GimpFilter      *filter,
                                                   GimpFilterStack *stack);
 
+static GList * gimp_filter_stack_get_fusable_runs (GimpFilterStack             *stack);
+static GList * gimp_filter_stack_add_run          (GList                       *runs,
+                                                   GimpFilterStackFusion       *run);
+static gint    gimp_filter_stack_fusion_compare   (const GimpFilterStackFusion *fusion1,
+                                                   const GimpFilterStackFusion *fusion2);
+static void    gimp_filter_stack_fusion_free      (GimpFilterStackFusion       *fusion);
+static void    gimp_filter_stack_fuse             (GimpFilterStack             *stack,
+                                                   GimpFilterStackFusion       *fusion);
+static void    gimp_filter_stack_unfuse           (GimpFilterStack             *stack,
+                                                   GimpFilterStackFusion       *fusion);
+static void    gimp_filter_stack_unfuse_all       (GimpFilterStack             *stack);
+
 
 G_DEFINE_TYPE (GimpFilterStack, gimp_filter_stack, GIMP_TYPE_LIST);
 
@@ -97,6 +130,10 @@ gimp_filter_stack_finalize (GObject *object)
 {
   GimpFilterStack *stack = GIMP_FILTER_STACK (object);
 
+  g_list_free_full (stack->fusions,
+                    (GDestroyNotify) gimp_filter_stack_fusion_free);
+  stack->fusions = NULL;
+
   g_clear_object (&stack->graph);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
@@ -109,6 +146,8 @@ gimp_filter_stack_add (GimpContainer *container,
   GimpFilterStack *stack  = GIMP_FILTER_STACK (container);
   GimpFilter      *filter = GIMP_FILTER (object);
 
+  gimp_filter_stack_unfuse_all (stack);
+
   GIMP_CONTAINER_CLASS (parent_class)->add (container, object);
 
   if (gimp_filter_get_active (filter))
@@ -121,6 +160,8 @@ gimp_filter_stack_add (GimpContainer *container,
 
       gimp_filter_stack_update_last_node (stack);
     }
+
+  gimp_filter_stack_update_fusion (stack);
 }
 
 static void
@@ -130,6 +171,8 @@ gimp_filter_stack_remove (GimpContainer *container,
   GimpFilterStack *stack  = GIMP_FILTER_STACK (container);
   GimpFilter      *filter = GIMP_FILTER (object);
 
+  gimp_filter_stack_unfuse_all (stack);
+
   if (stack->graph && gimp_filter_get_active (filter))
     {
       gimp_filter_stack_remove_node (stack, filter);
@@ -143,6 +186,8 @@ gimp_filter_stack_remove (GimpContainer *container,
       gimp_filter_set_is_last_node (filter, FALSE);
       gimp_filter_stack_update_last_node (stack);
     }
+
+  gimp_filter_stack_update_fusion (stack);
 }
 
 static void
@@ -154,6 +199,8 @@ gimp_filter_stack_reorder (GimpContainer *container,
   GimpFilterStack *stack  = GIMP_FILTER_STACK (container);
   GimpFilter      *filter = GIMP_FILTER (object);
 
+  gimp_filter_stack_unfuse_all (stack);
+
   if (stack->graph && gimp_filter_get_active (filter))
     gimp_filter_stack_remove_node (stack, filter);
 
@@ -167,6 +214,8 @@ gimp_filter_stack_reorder (GimpContainer *container,
       if (stack->graph)
         gimp_filter_stack_add_node (stack, filter);
     }
+
+  gimp_filter_stack_update_fusion (stack);
 }
 
 
@@ -223,9 +272,68 @@ gimp_filter_stack_get_graph (GimpFilterStack *stack)
 
   gegl_node_link (previous, output);
 
+  gimp_filter_stack_update_fusion (stack);
+
   return stack->graph;
 }
 
+/*  Runs each sequence of two or more adjacent active filters which have
+ *  a point node (see gimp_filter_get_point_node()) through one
+ *  gimp:point-filter-chain node, so the sequence costs one pass over
+ *  the pixels.  Sequences which didn't change keep their chain node,
+ *  so calling this after every filter property change is cheap and
+ *  doesn't invalidate anything.
+ */
+void
+gimp_filter_stack_update_fusion (GimpFilterStack *stack)
+{
+  GList *runs;
+  GList *list;
+
+  g_return_if_fail (GIMP_IS_FILTER_STACK (stack));
+
+  if (! stack->graph)
+    return;
+
+  runs = gimp_filter_stack_get_fusable_runs (stack);
+
+  list = stack->fusions;
+
+  while (list)
+    {
+      GimpFilterStackFusion *fusion = list->data;
+      GList                 *run;
+
+      list = g_list_next (list);
+
+      run = g_list_find_custom (runs, fusion,
+                                (GCompareFunc) gimp_filter_stack_fusion_compare);
+
+      if (run)
+        {
+          gimp_filter_stack_fusion_free (run->data);
+          runs = g_list_delete_link (runs, run);
+        }
+      else
+        {
+          stack->fusions = g_list_remove (stack->fusions, fusion);
+
+          gimp_filter_stack_unfuse (stack, fusion);
+        }
+    }
+
+  for (list = runs; list; list = g_list_next (list))
+    {
+      GimpFilterStackFusion *fusion = list->data;
+
+      gimp_filter_stack_fuse (stack, fusion);
+
+      stack->fusions = g_list_prepend (stack->fusions, fusion);
+    }
+
+  g_list_free (runs);
+}
+
 
 /*  private functions  */
 
@@ -327,6 +435,8 @@ static void
 gimp_filter_stack_filter_active (GimpFilter      *filter,
                                  GimpFilterStack *stack)
 {
+  gimp_filter_stack_unfuse_all (stack);
+
   if (stack->graph)
     {
       if (gimp_filter_get_active (filter))
@@ -345,4 +455,205 @@ gimp_filter_stack_filter_active (GimpFilter      *filter,
 
   if (! gimp_filter_get_active (filter))
     gimp_filter_set_is_last_node (filter, FALSE);
+
+  gimp_filter_stack_update_fusion (stack);
+}
+
+static GList *
+gimp_filter_stack_get_fusable_runs (GimpFilterStack *stack)
+{
+  GList                 *runs = NULL;
+  GimpFilterStackFusion *run  = NULL;
+  GList                 *list;
+
+  for (list = GIMP_LIST (stack)->queue->tail;
+       list;
+       list = g_list_previous (list))
+    {
+      GimpFilter    *filter = list->data;
+      GeglNode      *node;
+      GeglRectangle  clip;
+
+      if (! gimp_filter_get_active (filter))
+        continue;
+
+      node = gimp_filter_get_point_node (filter, &clip);
+
+      /*  the unfused filters clip after each filter, so only filters
+       *  with the same clip can share the chain's single crop
+       */
+      if (run && (! node || ! gegl_rectangle_equal (&run->clip, &clip)))
+        {
+          runs = gimp_filter_stack_add_run (runs, run);
+          run  = NULL;
+        }
+
+      if (node)
+        {
+          if (! run)
+            {
+              run = g_slice_new0 (GimpFilterStackFusion);
+
+              run->clip = clip;
+            }
+
+          run->filters = g_list_append (run->filters, filter);
+          run->nodes   = g_list_append (run->nodes,   node);
+        }
+    }
+
+  if (run)
+    runs = gimp_filter_stack_add_run (runs, run);
+
+  return runs;
+}
+
+static GList *
+gimp_filter_stack_add_run (GList                 *runs,
+                           GimpFilterStackFusion *run)
+{
+  /*  a single filter is run by its own node  */
+  if (! run->filters->next)
+    {
+      gimp_filter_stack_fusion_free (run);
+
+      return runs;
+    }
+
+  return g_list_prepend (runs, run);
+}
+
+static gint
+gimp_filter_stack_fusion_compare (const GimpFilterStackFusion *fusion1,
+                                  const GimpFilterStackFusion *fusion2)
+{
+  GList *list1;
+  GList *list2;
+
+  if (! gegl_rectangle_equal (&fusion1->clip, &fusion2->clip))
+    return 1;
+
+  for (list1 = fusion1->nodes, list2 = fusion2->nodes;
+       list1 && list2;
+       list1 = g_list_next (list1), list2 = g_list_next (list2))
+    {
+      if (list1->data != list2->data)
+        return 1;
+    }
+
+  return (list1 || list2) ? 1 : 0;
+}
+
+static void
+gimp_filter_stack_fusion_free (GimpFilterStackFusion *fusion)
+{
+  g_list_free (fusion->filters);
+  g_list_free (fusion->nodes);
+
+  g_slice_free (GimpFilterStackFusion, fusion);
+}
+
+static void
+gimp_filter_stack_fuse (GimpFilterStack       *stack,
+                        GimpFilterStackFusion *fusion)
+{
+  GimpFilter  *bottom = fusion->filters->data;
+  GimpFilter  *top    = g_list_last (fusion->filters)->data;
+  GeglNode    *producer;
+  GeglNode    *output;
+  GeglNode   **nodes;
+  GList       *iter;
+  gint         n_nodes;
+  gint         i;
+
+  producer = gegl_node_get_producer (gimp_filter_get_node (bottom),
+                                     "input", NULL);
+
+  iter = g_list_find (GIMP_LIST (stack)->queue->head, top);
+
+  while ((iter = g_list_previous (iter)))
+    {
+      GimpFilter *filter_above = iter->data;
+
+      if (gimp_filter_get_active (filter_above))
+        {
+          fusion->consumer = gimp_filter_get_node (filter_above);
+
+          break;
+        }
+    }
+
+  if (! fusion->consumer)
+    fusion->consumer = gegl_node_get_output_proxy (stack->graph, "output");
+
+  n_nodes = g_list_length (fusion->nodes);
+  nodes   = g_new (GeglNode *, n_nodes);
+
+  for (iter = fusion->nodes, i = 0; iter; iter = g_list_next (iter), i++)
+    nodes[i] = iter->data;
+
+  fusion->chain = gegl_node_new_child (stack->graph,
+                                       "operation", "gimp:point-filter-chain",
+                                       NULL);
+
+  gimp_operation_point_filter_chain_set_nodes (
+    GIMP_OPERATION_POINT_FILTER_CHAIN (
+      gegl_node_get_gegl_operation (fusion->chain)),
+    nodes, n_nodes);
+
+  g_free (nodes);
+
+  gegl_node_link (producer, fusion->chain);
+
+  output = fusion->chain;
+
+  if (! gegl_rectangle_is_infinite_plane (&fusion->clip))
+    {
+      fusion->crop = gegl_node_new_child (stack->graph,
+                                          "operation", "gegl:crop",
+                                          "x",         (gdouble) fusion->clip.x,
+                                          "y",         (gdouble) fusion->clip.y,
+                                          "width",     (gdouble) fusion->clip.width,
+                                          "height",    (gdouble) fusion->clip.height,
+                                          NULL);
+
+      gegl_node_link (output, fusion->crop);
+
+      output = fusion->crop;
+    }
+
+  gegl_node_link (output, fusion->consumer);
+}
+
+static void
+gimp_filter_stack_unfuse (GimpFilterStack       *stack,
+                          GimpFilterStackFusion *fusion)
+{
+  GimpFilter *top = g_list_last (fusion->filters)->data;
+
+  gegl_node_link (gimp_filter_get_node (top), fusion->consumer);
+
+  gegl_node_disconnect (fusion->chain, "input");
+  gegl_node_remove_child (stack->graph, fusion->chain);
+
+  if (fusion->crop)
+    {
+      gegl_node_disconnect (fusion->crop, "input");
+      gegl_node_remove_child (stack->graph, fusion->crop);
+    }
+
+  gimp_filter_stack_fusion_free (fusion);
+}
+
+static void
+gimp_filter_stack_unfuse_all (GimpFilterStack *stack)
+{
+  while (stack->fusions)
+    {
+      GimpFilterStackFusion *fusion = stack->fusions->data;
+
+      stack->fusions = g_list_delete_link (stack->fusions, stack->fusions);
+
+      gimp_filter_stack_unfuse (stack, fusion);
+    }
 }
@@ -37,6 +37,7 @@ struct _GimpFilterStack
   GimpList  parent_instance;
 
   GeglNode *graph;
+  GList    *fusions;
 };
 
 struct _GimpFilterStackClass
@@ -45,7 +46,9 @@ struct _GimpFilterStackClass
 };
 
 
-GType           gimp_filter_stack_get_type  (void) G_GNUC_CONST;
-GimpContainer * gimp_filter_stack_new       (GType            filter_type);
+GType           gimp_filter_stack_get_type      (void) G_GNUC_CONST;
+GimpContainer * gimp_filter_stack_new           (GType            filter_type);
 
-GeglNode *      gimp_filter_stack_get_graph (GimpFilterStack *stack);
+GeglNode *      gimp_filter_stack_get_graph     (GimpFilterStack *stack);
+
+void            gimp_filter_stack_update_fusion (GimpFilterStack *stack);
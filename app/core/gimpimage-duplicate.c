@@ -29,6 +29,10 @@
 #include "path/gimppath.h"
 
 #include "gimp.h"
+#include "gimp-utils.h"
+#include "gimpasync.h"
+#include "gimpcancelable.h"
+#include "gimpcontainer.h"
 #include "gimpchannel.h"
 #include "gimpguide.h"
 #include "gimpimage.h"
@@ -46,9 +50,66 @@
 #include "gimplayermask.h"
 #include "gimplayer-floating-selection.h"
 #include "gimpparasitelist.h"
+#include "gimpprogress.h"
 #include "gimpsamplepoint.h"
+#include "gimpwaitable.h"
 
+#include "gimp-intl.h"
 
+
+/*  The duplicate is built in steps run from idle: one step creates the
+ *  image, then each step copies one top-level layer (with all of its
+ *  children) or one channel, and the last ones copy the paths and
+ *  everything else.  The drawables' buffers are duplicated with
+ *  gimp_gegl_buffer_dup(), which shares their tiles copy-on-write, so
+ *  no pixels are copied until either image writes to them.
+ *
+ *  Should the source image change while the duplicate is built, the
+ *  partial duplicate is thrown away and started over, so the result is
+ *  always a copy of a single state of the image.
+ */
+
+typedef enum
+{
+  DUPLICATE_STAGE_IMAGE,
+  DUPLICATE_STAGE_LAYERS,
+  DUPLICATE_STAGE_CHANNELS,
+  DUPLICATE_STAGE_PATHS,
+  DUPLICATE_STAGE_FINISH
+} DuplicateStage;
+
+typedef struct
+{
+  GimpAsync      *async;
+  GimpImage      *image;
+  GimpImage      *new_image;
+  GimpProgress   *progress;
+
+  DuplicateStage  stage;
+  GList          *iter;
+  gint            count;
+
+  GList          *selected_layer_paths;
+  GList          *selected_channels;
+  GList          *new_selected_channels;
+  GList          *new_selected_paths;
+
+  gint            n_steps;
+  gint            n_done;
+} DuplicateData;
+
+
+static void          gimp_image_duplicate_async_func       (GimpAsync     *async,
+                                                            DuplicateData *data);
+static void          gimp_image_duplicate_data_free        (DuplicateData *data);
+static void          gimp_image_duplicate_data_reset       (DuplicateData *data);
+static void          gimp_image_duplicate_image_changed    (GimpImage     *image,
+                                                            GimpDirtyMask  dirty_mask,
+                                                            DuplicateData *data);
+static void          gimp_image_duplicate_progress_cancel  (GimpProgress  *progress,
+                                                            DuplicateData *data);
+
+static GimpImage   * gimp_image_duplicate_new_image        (GimpImage *image);
 static void          gimp_image_duplicate_resolution       (GimpImage *image,
                                                             GimpImage *new_image);
 static void          gimp_image_duplicate_save_source_file (GimpImage *image,
@@ -57,10 +118,16 @@ static void          gimp_image_duplicate_colormap         (GimpImage *image,
                                                             GimpImage *new_image);
 static GimpItem    * gimp_image_duplicate_item             (GimpItem  *item,
                                                             GimpImage *new_image);
-static GList       * gimp_image_duplicate_layers           (GimpImage *image,
-                                                            GimpImage *new_image);
-static GList       * gimp_image_duplicate_channels         (GimpImage *image,
-                                                            GimpImage *new_image);
+static GList       * gimp_image_duplicate_selected_layer_paths
+                                                           (GimpImage *image);
+static void          gimp_image_duplicate_layer            (GimpLayer *layer,
+                                                            GimpImage *new_image,
+                                                            gint       position);
+static GList       * gimp_image_duplicate_selected_layers  (GimpImage *new_image,
+                                                            GList     *selected_paths);
+static GimpChannel * gimp_image_duplicate_channel          (GimpChannel *channel,
+                                                            GimpImage   *new_image,
+                                                            gint         position);
 static GList       * gimp_image_duplicate_paths            (GimpImage *image,
                                                             GimpImage *new_image);
 static void          gimp_image_duplicate_floating_sel     (GimpImage *image,
@@ -88,18 +155,306 @@ static void          gimp_image_duplicate_simulation_profile
                                                             GimpImage *new_image);
 
 
+/*  public functions  */
+
 GimpImage *
 gimp_image_duplicate (GimpImage *image)
 {
-  GimpImage    *new_image;
-  GList        *active_layers;
-  GList        *active_channels;
-  GList        *active_path;
+  GimpAsync *async;
+  GimpImage *new_image;
 
   g_return_val_if_fail (GIMP_IS_IMAGE (image), NULL);
 
   gimp_set_busy_until_idle (image->gimp);
 
+  async = gimp_image_duplicate_async (image, NULL);
+
+  /*  runs all the steps right away  */
+  gimp_waitable_wait (GIMP_WAITABLE (async));
+
+  new_image = g_object_ref (gimp_async_get_result (async));
+
+  g_object_unref (async);
+
+  return new_image;
+}
+
+/*  Starts duplicating @image from idle, and returns the #GimpAsync of
+ *  the operation, whose result is the new image.  If @progress is
+ *  given, it reports the progress of the operation, and canceling it
+ *  cancels the operation.
+ */
+GimpAsync *
+gimp_image_duplicate_async (GimpImage    *image,
+                            GimpProgress *progress)
+{
+  DuplicateData *data;
+  GimpAsync     *async;
+
+  g_return_val_if_fail (GIMP_IS_IMAGE (image), NULL);
+  g_return_val_if_fail (progress == NULL || GIMP_IS_PROGRESS (progress), NULL);
+
+  data = g_slice_new0 (DuplicateData);
+
+  data->image = g_object_ref (image);
+
+  if (progress)
+    progress = gimp_progress_start (progress, TRUE, _("Duplicating image"));
+
+  if (progress)
+    {
+      data->progress = g_object_ref (progress);
+
+      g_signal_connect (progress, "cancel",
+                        G_CALLBACK (gimp_image_duplicate_progress_cancel),
+                        data);
+    }
+
+  gimp_image_duplicate_data_reset (data);
+
+  g_signal_connect (image, "dirty",
+                    G_CALLBACK (gimp_image_duplicate_image_changed),
+                    data);
+  g_signal_connect (image, "clean",
+                    G_CALLBACK (gimp_image_duplicate_image_changed),
+                    data);
+
+  async = gimp_idle_run_async_full (
+    G_PRIORITY_DEFAULT_IDLE,
+    (GimpRunAsyncFunc) gimp_image_duplicate_async_func,
+    data,
+    (GDestroyNotify) gimp_image_duplicate_data_free);
+
+  /*  not a reference, @data doesn't outlive the operation  */
+  data->async = async;
+
+  return async;
+}
+
+
+/*  private functions  */
+
+static void
+gimp_image_duplicate_async_func (GimpAsync     *async,
+                                 DuplicateData *data)
+{
+  GimpImage *image     = data->image;
+  GimpImage *new_image = data->new_image;
+
+  switch (data->stage)
+    {
+    case DUPLICATE_STAGE_IMAGE:
+      data->new_image = gimp_image_duplicate_new_image (image);
+
+      data->selected_layer_paths =
+        gimp_image_duplicate_selected_layer_paths (image);
+      data->selected_channels =
+        g_list_copy (gimp_image_get_selected_channels (image));
+
+      data->iter  = gimp_image_get_layer_iter (image);
+      data->count = 0;
+      data->stage = DUPLICATE_STAGE_LAYERS;
+      break;
+
+    case DUPLICATE_STAGE_LAYERS:
+      if (data->iter)
+        {
+          GimpLayer *layer = data->iter->data;
+
+          if (! gimp_layer_is_floating_sel (layer))
+            gimp_image_duplicate_layer (layer, new_image, data->count++);
+
+          data->iter = g_list_next (data->iter);
+          break;
+        }
+
+      data->iter  = gimp_image_get_channel_iter (image);
+      data->count = 0;
+      data->stage = DUPLICATE_STAGE_CHANNELS;
+      /*  fall through  */
+
+    case DUPLICATE_STAGE_CHANNELS:
+      if (data->iter)
+        {
+          GimpChannel *channel = data->iter->data;
+          GimpChannel *new_channel;
+
+          new_channel = gimp_image_duplicate_channel (channel, new_image,
+                                                      data->count++);
+
+          if (g_list_find (data->selected_channels, channel))
+            data->new_selected_channels =
+              g_list_prepend (data->new_selected_channels, new_channel);
+
+          data->iter = g_list_next (data->iter);
+          break;
+        }
+
+      data->iter  = NULL;
+      data->stage = DUPLICATE_STAGE_PATHS;
+      /*  fall through  */
+
+    case DUPLICATE_STAGE_PATHS:
+      data->new_selected_paths = gimp_image_duplicate_paths (image, new_image);
+
+      data->stage = DUPLICATE_STAGE_FINISH;
+      break;
+
+    case DUPLICATE_STAGE_FINISH:
+      {
+        GList *new_selected_layers;
+
+        /*  Copy floating layer  */
+        gimp_image_duplicate_floating_sel (image, new_image);
+
+        /*  Copy the selection mask  */
+        gimp_image_duplicate_mask (image, new_image);
+
+        /*  Set active layer, active channel, active path  */
+        new_selected_layers =
+          gimp_image_duplicate_selected_layers (new_image,
+                                                data->selected_layer_paths);
+
+        if (new_selected_layers)
+          gimp_image_set_selected_layers (new_image, new_selected_layers);
+
+        if (data->new_selected_channels)
+          gimp_image_set_selected_channels (new_image,
+                                            data->new_selected_channels);
+
+        if (data->new_selected_paths)
+          gimp_image_set_selected_paths (new_image, data->new_selected_paths);
+
+        g_list_free (new_selected_layers);
+
+        /*  Copy state of all color components  */
+        gimp_image_duplicate_components (image, new_image);
+
+        /*  Copy any guides  */
+        gimp_image_duplicate_guides (image, new_image);
+
+        /*  Copy any sample points  */
+        gimp_image_duplicate_sample_points (image, new_image);
+
+        /*  Copy the grid  */
+        gimp_image_duplicate_grid (image, new_image);
+
+        /*  Copy the metadata  */
+        gimp_image_duplicate_metadata (image, new_image);
+
+        /*  Copy the quick mask info  */
+        gimp_image_duplicate_quick_mask (image, new_image);
+
+        /*  Only now make the duplicate known  */
+        gimp_container_add (image->gimp->images, GIMP_OBJECT (new_image));
+
+        gimp_image_undo_enable (new_image);
+
+        /*  Explicitly mark image as dirty, so that its dirty time is set  */
+        gimp_image_dirty (new_image, GIMP_DIRTY_ALL);
+
+        /* XXX Without flushing the duplicated image, we had at least one case
+         * where it wouldn't properly render the image (with empty
+         * pass-through groups with layer effects, which I think is because we
+         * have code believing the group is smaller that it really is, because
+         * of the specificity of pass-through groups). See #13057.
+         * So I'm not entirely happy of calling this here, which feels more
+         * like a workaround than a real fix. But it will do for now.
+         */
+        gimp_image_flush (new_image);
+
+        data->new_image = NULL;
+
+        gimp_image_duplicate_data_free (data);
+
+        gimp_async_finish_full (async, new_image,
+                                (GDestroyNotify) g_object_unref);
+      }
+      return;
+    }
+
+  data->n_done++;
+
+  if (data->progress)
+    gimp_progress_set_value (data->progress,
+                             (gdouble) data->n_done / data->n_steps);
+}
+
+static void
+gimp_image_duplicate_data_free (DuplicateData *data)
+{
+  g_signal_handlers_disconnect_by_func (data->image,
+                                        gimp_image_duplicate_image_changed,
+                                        data);
+
+  if (data->progress)
+    {
+      g_signal_handlers_disconnect_by_func (data->progress,
+                                            gimp_image_duplicate_progress_cancel,
+                                            data);
+      gimp_progress_end (data->progress);
+
+      g_clear_object (&data->progress);
+    }
+
+  /*  frees the partial duplicate, if any  */
+  gimp_image_duplicate_data_reset (data);
+
+  g_object_unref (data->image);
+
+  g_slice_free (DuplicateData, data);
+}
+
+static void
+gimp_image_duplicate_data_reset (DuplicateData *data)
+{
+  g_clear_object (&data->new_image);
+
+  g_list_free_full (data->selected_layer_paths, (GDestroyNotify) g_list_free);
+  data->selected_layer_paths = NULL;
+
+  g_clear_pointer (&data->selected_channels,     g_list_free);
+  g_clear_pointer (&data->new_selected_channels, g_list_free);
+  g_clear_pointer (&data->new_selected_paths,    g_list_free);
+
+  data->stage   = DUPLICATE_STAGE_IMAGE;
+  data->iter    = NULL;
+  data->count   = 0;
+  data->n_done  = 0;
+
+  /*  the image, the top-level layers, the channels, the paths, and the
+   *  rest
+   */
+  data->n_steps = 3 +
+                  gimp_container_get_n_children (gimp_image_get_layers (data->image)) +
+                  gimp_container_get_n_children (gimp_image_get_channels (data->image));
+
+  if (data->progress)
+    gimp_progress_set_value (data->progress, 0.0);
+}
+
+static void
+gimp_image_duplicate_image_changed (GimpImage     *image,
+                                    GimpDirtyMask  dirty_mask,
+                                    DuplicateData *data)
+{
+  /*  the items copied so far may no longer match the image, start over  */
+  if (data->stage != DUPLICATE_STAGE_IMAGE)
+    gimp_image_duplicate_data_reset (data);
+}
+
+static void
+gimp_image_duplicate_progress_cancel (GimpProgress  *progress,
+                                      DuplicateData *data)
+{
+  gimp_cancelable_cancel (GIMP_CANCELABLE (data->async));
+}
+
+static GimpImage *
+gimp_image_duplicate_new_image (GimpImage *image)
+{
+  GimpImage *new_image;
+
   /*  Create a new image  */
   new_image = gimp_create_image (image->gimp,
                                  gimp_image_get_width  (image),
@@ -109,6 +464,13 @@ gimp_image_duplicate (GimpImage *image)
                                  FALSE);
   gimp_image_undo_disable (new_image);
 
+  /*  Keep the partial duplicate out of the image list until it's
+   *  complete, so it's neither shown in the Images dockable nor
+   *  returned by gimp-get-images while it's built, or when it's thrown
+   *  away to start over
+   */
+  gimp_container_remove (image->gimp->images, GIMP_OBJECT (new_image));
+
   /*  Store the source uri to be used by the save dialog  */
   gimp_image_duplicate_save_source_file (image, new_image);
 
@@ -125,64 +487,6 @@ gimp_image_duplicate (GimpImage *image)
   /*  Copy the colormap if necessary  */
   gimp_image_duplicate_colormap (image, new_image);
 
-  /*  Copy the layers  */
-  active_layers = gimp_image_duplicate_layers (image, new_image);
-
-  /*  Copy the channels  */
-  active_channels = gimp_image_duplicate_channels (image, new_image);
-
-  /*  Copy any path  */
-  active_path = gimp_image_duplicate_paths (image, new_image);
-
-  /*  Copy floating layer  */
-  gimp_image_duplicate_floating_sel (image, new_image);
-
-  /*  Copy the selection mask  */
-  gimp_image_duplicate_mask (image, new_image);
-
-  /*  Set active layer, active channel, active path  */
-  if (active_layers)
-    gimp_image_set_selected_layers (new_image, active_layers);
-
-  if (active_channels)
-    gimp_image_set_selected_channels (new_image, active_channels);
-
-  if (active_path)
-    gimp_image_set_selected_paths (new_image, active_path);
-
-  /*  Copy state of all color components  */
-  gimp_image_duplicate_components (image, new_image);
-
-  /*  Copy any guides  */
-  gimp_image_duplicate_guides (image, new_image);
-
-  /*  Copy any sample points  */
-  gimp_image_duplicate_sample_points (image, new_image);
-
-  /*  Copy the grid  */
-  gimp_image_duplicate_grid (image, new_image);
-
-  /*  Copy the metadata  */
-  gimp_image_duplicate_metadata (image, new_image);
-
-  /*  Copy the quick mask info  */
-  gimp_image_duplicate_quick_mask (image, new_image);
-
-  gimp_image_undo_enable (new_image);
-
-  /*  Explicitly mark image as dirty, so that its dirty time is set  */
-  gimp_image_dirty (new_image, GIMP_DIRTY_ALL);
-
-  /* XXX Without flushing the duplicated image, we had at least one case
-   * where it wouldn't properly render the image (with empty
-   * pass-through groups with layer effects, which I think is because we
-   * have code believing the group is smaller that it really is, because
-   * of the specificity of pass-through groups). See #13057.
-   * So I'm not entirely happy of calling this here, which feels more
-   * like a workaround than a real fix. But it will do for now.
-   */
-  gimp_image_flush (new_image);
-
   return new_image;
 }
 
@@ -237,85 +541,69 @@ gimp_image_duplicate_item (GimpItem  *item,
 }
 
 static GList *
-gimp_image_duplicate_layers (GimpImage *image,
-                             GimpImage *new_image)
+gimp_image_duplicate_selected_layer_paths (GimpImage *image)
 {
-  GList         *new_selected_layers = NULL;
-  GList         *selected_paths      = NULL;
-  GList         *selected_layers;
-  GimpItemStack *new_item_stack;
-  GList         *list;
-  gint           count;
-
-  selected_layers = gimp_image_get_selected_layers (image);
+  GList *selected_paths = NULL;
+  GList *list;
 
-  for (list = selected_layers; list; list = list->next)
+  for (list = gimp_image_get_selected_layers (image); list; list = list->next)
     selected_paths = g_list_prepend (selected_paths,
                                      gimp_item_get_path (list->data));
 
-  for (list = gimp_image_get_layer_iter (image), count = 0;
-       list;
-       list = g_list_next (list))
-    {
-      GimpLayer *layer = list->data;
-      GimpLayer *new_layer;
+  return selected_paths;
+}
 
-      if (gimp_layer_is_floating_sel (layer))
-        continue;
+static void
+gimp_image_duplicate_layer (GimpLayer *layer,
+                            GimpImage *new_image,
+                            gint       position)
+{
+  GimpLayer *new_layer;
 
-      new_layer = GIMP_LAYER (gimp_image_duplicate_item (GIMP_ITEM (layer),
-                                                         new_image));
+  new_layer = GIMP_LAYER (gimp_image_duplicate_item (GIMP_ITEM (layer),
+                                                     new_image));
 
-      /*  Make sure that if the layer has a layer mask,
-       *  its name isn't screwed up
-       */
-      if (new_layer->mask)
-        gimp_object_set_name (GIMP_OBJECT (new_layer->mask),
-                              gimp_object_get_name (layer->mask));
+  /*  Make sure that if the layer has a layer mask,
+   *  its name isn't screwed up
+   */
+  if (new_layer->mask)
+    gimp_object_set_name (GIMP_OBJECT (new_layer->mask),
+                          gimp_object_get_name (layer->mask));
 
-      gimp_image_add_layer (new_image, new_layer,
-                            NULL, count++, FALSE);
-    }
+  gimp_image_add_layer (new_image, new_layer,
+                        NULL, position, FALSE);
+}
+
+static GList *
+gimp_image_duplicate_selected_layers (GimpImage *new_image,
+                                      GList     *selected_paths)
+{
+  GList         *new_selected_layers = NULL;
+  GimpItemStack *new_item_stack;
+  GList         *list;
 
   new_item_stack = GIMP_ITEM_STACK (gimp_image_get_layers (new_image));
   for (list = selected_paths; list; list = list->next)
     new_selected_layers = g_list_prepend (new_selected_layers,
                                           gimp_item_stack_get_item_by_path (new_item_stack, list->data));
 
-  g_list_free_full (selected_paths, (GDestroyNotify) g_list_free);
-
   return new_selected_layers;
 }
 
-static GList *
-gimp_image_duplicate_channels (GimpImage *image,
-                               GimpImage *new_image)
+static GimpChannel *
+gimp_image_duplicate_channel (GimpChannel *channel,
+                              GimpImage   *new_image,
+                              gint         position)
 {
-  GList *new_selected_channels = NULL;
-  GList *selected_channels;
-  GList *list;
-  gint   count;
-
-  selected_channels = gimp_image_get_selected_channels (image);
-
-  for (list = gimp_image_get_channel_iter (image), count = 0;
-       list;
-       list = g_list_next (list))
-    {
-      GimpChannel  *channel = list->data;
-      GimpChannel  *new_channel;
-
-      new_channel = GIMP_CHANNEL (gimp_image_duplicate_item (GIMP_ITEM (channel),
-                                                             new_image));
+  GimpChannel *new_channel;
 
-      if (g_list_find (selected_channels, channel))
-        new_selected_channels = g_list_prepend (new_selected_channels, new_channel);
+  new_channel = GIMP_CHANNEL (gimp_image_duplicate_item (GIMP_ITEM (channel),
+                                                         new_image));
 
-      gimp_image_add_channel (new_image, new_channel,
-                              NULL, count++, FALSE);
-    }
+  gimp_image_add_channel (new_image, new_channel,
+                          NULL, position, FALSE);
 
-  return new_selected_channels;
+  return new_channel;
 }
 
 static GList *
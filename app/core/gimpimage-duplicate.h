@@ -18,4 +18,6 @@
 #pragma once
 
 
-GimpImage * gimp_image_duplicate (GimpImage *image);
+GimpImage * gimp_image_duplicate       (GimpImage    *image);
+GimpAsync * gimp_image_duplicate_async (GimpImage    *image,
+                                        GimpProgress *progress);
@@ -38,6 +38,7 @@
 #include "gimpcontext.h"
 #include "gimpdrawable-filters.h"
 #include "gimperror.h"
+#include "gimpfilterstack.h"
 #include "gimpgrouplayer.h"
 #include "gimpimage.h"
 #include "gimpimage-merge.h"
@@ -267,6 +268,84 @@ gimp_image_flatten (GimpImage     *image,
   return NULL;
 }
 
+/*  Returns the format of the pixels gimp_image_get_merged_region()
+ *  returns, i.e. the format of the layer that merging (or flattening)
+ *  the visible layers would create.
+ */
+const Babl *
+gimp_image_get_merged_format (GimpImage *image,
+                              gboolean   flatten)
+{
+  g_return_val_if_fail (GIMP_IS_IMAGE (image), NULL);
+
+  return gimp_image_get_layer_format (image, ! flatten);
+}
+
+/*  Renders @rect of the image's visible layers, merged, or flattened
+ *  onto the context's background color, into @data, without creating a
+ *  merged layer.  Only memory for @rect is allocated, which lets
+ *  exporters pull huge images band by band.
+ */
+void
+gimp_image_get_merged_region (GimpImage           *image,
+                              GimpContext         *context,
+                              gboolean             flatten,
+                              const GeglRectangle *rect,
+                              gpointer             data)
+{
+  GeglNode   *node;
+  GeglBuffer *buffer;
+
+  g_return_if_fail (GIMP_IS_IMAGE (image));
+  g_return_if_fail (GIMP_IS_CONTEXT (context));
+  g_return_if_fail (rect != NULL);
+  g_return_if_fail (data != NULL);
+
+  /*  Make sure the image's graph is constructed  */
+  (void) gimp_projectable_get_graph (GIMP_PROJECTABLE (image));
+
+  node = gimp_filter_stack_get_graph (
+    GIMP_FILTER_STACK (gimp_image_get_layers (image)));
+
+  buffer = gegl_buffer_new (rect, gimp_image_get_merged_format (image, FALSE));
+
+  gegl_node_blit_buffer (node, buffer, rect, 0, GEGL_ABYSS_NONE);
+
+  if (flatten)
+    {
+      GeglBuffer          *flat_buffer;
+      GimpLayerColorSpace  composite_space = GIMP_LAYER_COLOR_SPACE_RGB_LINEAR;
+      GList               *list;
+
+      /*  Like gimp_image_flatten(), composite in the space of the bottom
+       *  visible layer
+       */
+      for (list = gimp_image_get_layer_iter (image);
+           list;
+           list = g_list_next (list))
+        {
+          if (gimp_item_get_visible (list->data))
+            composite_space = gimp_layer_get_real_composite_space (list->data);
+        }
+
+      flat_buffer = gegl_buffer_new (rect,
+                                     gimp_image_get_merged_format (image,
+                                                                   TRUE));
+
+      gimp_gegl_apply_flatten (buffer, NULL, NULL, flat_buffer,
+                               gimp_context_get_background (context),
+                               composite_space);
+
+      g_object_unref (buffer);
+      buffer = flat_buffer;
+    }
+
+  gegl_buffer_get (buffer, rect, 1.0, NULL, data,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  g_object_unref (buffer);
+}
+
 GList *
 gimp_image_merge_down (GimpImage      *image,
                        GList          *layers,
@@ -40,3 +40,11 @@ GimpLayer   * gimp_image_flatten               (GimpImage      *image,
 
 GimpPath    * gimp_image_merge_visible_paths   (GimpImage      *image,
                                                 GError        **error);
+
+const Babl  * gimp_image_get_merged_format     (GimpImage      *image,
+                                                gboolean        flatten);
+void          gimp_image_get_merged_region     (GimpImage      *image,
+                                                GimpContext    *context,
+                                                gboolean        flatten,
+                                                const GeglRectangle *rect,
+                                                gpointer        data);
@@ -144,6 +144,7 @@ struct _GimpImagePrivate
   GimpUndoStack     *redo_stack;            /*  stack for redo operations    */
   gint               group_count;           /*  nested undo groups           */
   GimpUndoType       pushing_undo_group;    /*  undo group status flag       */
+  GimpAsync         *undo_compress_async;   /*  compacts an old undo step    */
 
   /*  Signal emission accumulator  */
   GimpImageFlushAccumulator  flush_accum;
@@ -26,6 +26,8 @@
 
 #include "gimp.h"
 #include "gimp-utils.h"
+#include "gimpasync.h"
+#include "gimpdrawableundo.h"
 #include "gimpimage.h"
 #include "gimpimage-private.h"
 #include "gimpimage-undo.h"
@@ -34,15 +36,34 @@
 #include "gimpundostack.h"
 
 
+typedef struct
+{
+  GimpImage     *image;
+  GimpUndoStack *stack;
+  GimpUndo      *undo;
+} CompressUndoData;
+
+
 /*  local function prototypes  */
 
 static void          gimp_image_undo_pop_stack       (GimpImage     *image,
                                                       GimpUndoStack *undo_stack,
                                                       GimpUndoStack *redo_stack,
                                                       GimpUndoMode   undo_mode);
-static void          gimp_image_undo_free_space      (GimpImage     *image);
+static void          gimp_image_undo_free_space      (GimpImage     *image,
+                                                      gboolean       compact);
 static void          gimp_image_undo_free_redo       (GimpImage     *image);
 
+static void          gimp_image_undo_update_top      (GimpImage     *image);
+static gboolean      gimp_image_undo_compress_start  (GimpImage     *image);
+static gboolean      gimp_image_undo_compress_undo   (GimpImage     *image,
+                                                      GimpUndoStack *stack,
+                                                      GimpUndo      *undo,
+                                                      const gchar   *swap_dir);
+static void          gimp_image_undo_compress_callback
+                                                     (GimpAsync        *async,
+                                                      CompressUndoData *data);
+
 static GimpDirtyMask gimp_image_undo_dirty_from_type (GimpUndoType   undo_type);
 
 
@@ -245,6 +266,9 @@ gimp_image_undo_free (GimpImage *image)
    */
   gimp_image_undo_event (image, GIMP_UNDO_EVENT_UNDO_FREE, NULL);
 
+  if (private->undo_compress_async)
+    gimp_async_cancel_and_wait (private->undo_compress_async);
+
   gimp_undo_free (GIMP_UNDO (private->undo_stack), GIMP_UNDO_MODE_UNDO);
   gimp_undo_free (GIMP_UNDO (private->redo_stack), GIMP_UNDO_MODE_REDO);
 
@@ -306,6 +330,8 @@ gimp_image_undo_group_start (GimpImage    *image,
   /*  nuke the redo stack  */
   gimp_image_undo_free_redo (image);
 
+  gimp_image_undo_update_top (image);
+
   undo_group = gimp_undo_stack_new (image);
 
   gimp_object_set_name (GIMP_OBJECT (undo_group), name);
@@ -345,7 +371,7 @@ gimp_image_undo_group_end (GimpImage *image)
       gimp_image_undo_event (image, GIMP_UNDO_EVENT_UNDO_PUSHED,
                              gimp_undo_stack_peek (private->undo_stack));
 
-      gimp_image_undo_free_space (image);
+      gimp_image_undo_free_space (image, TRUE);
     }
 
   return TRUE;
@@ -410,11 +436,13 @@ gimp_image_undo_push (GimpImage     *image,
 
   if (private->pushing_undo_group == GIMP_UNDO_GROUP_NONE)
     {
+      gimp_image_undo_update_top (image);
+
       gimp_undo_stack_push_undo (private->undo_stack, undo);
 
       gimp_image_undo_event (image, GIMP_UNDO_EVENT_UNDO_PUSHED, undo);
 
-      gimp_image_undo_free_space (image);
+      gimp_image_undo_free_space (image, TRUE);
 
       /*  freeing undo space may have freed the newly pushed undo  */
       if (gimp_undo_stack_peek (private->undo_stack) == undo)
@@ -513,7 +541,8 @@ gimp_image_undo_pop_stack (GimpImage     *image,
 }
 
 static void
-gimp_image_undo_free_space (GimpImage *image)
+gimp_image_undo_free_space (GimpImage *image,
+                            gboolean   compact)
 {
   GimpImagePrivate *private = GIMP_IMAGE_GET_PRIVATE (image);
   GimpContainer    *container;
@@ -527,27 +556,44 @@ gimp_image_undo_free_space (GimpImage *image)
   max_undo_levels = 1024; /* FIXME */
   undo_size       = image->gimp->config->undo_size;
 
+  gimp_image_undo_update_top (image);
+
 #ifdef DEBUG_IMAGE_UNDO
   g_printerr ("undo_steps: %d    undo_bytes: %ld\n",
               gimp_container_get_n_children (container),
-              (glong) gimp_object_get_memsize (GIMP_OBJECT (container), NULL));
+              (glong) gimp_undo_stack_get_size (private->undo_stack));
 #endif
 
   /*  keep at least min_undo_levels undo steps  */
   if (gimp_container_get_n_children (container) <= min_undo_levels)
     return;
 
-  while ((gimp_object_get_memsize (GIMP_OBJECT (container), NULL) > undo_size) ||
+  while ((gimp_undo_stack_get_size (private->undo_stack) > undo_size) ||
          (gimp_container_get_n_children (container) > max_undo_levels))
     {
-      GimpUndo *freed = gimp_undo_stack_free_bottom (private->undo_stack,
-                                                     GIMP_UNDO_MODE_UNDO);
+      GimpUndo *freed;
+
+      /*  rather than dropping undo steps to get below undo_size,
+       *  compress them, and then swap them out, one at a time in the
+       *  background.  Only drop steps meanwhile if the stack grows
+       *  far beyond undo_size.
+       */
+      if (compact &&
+          gimp_container_get_n_children (container) <= max_undo_levels &&
+          gimp_undo_stack_get_size (private->undo_stack) / 2 <= undo_size &&
+          (private->undo_compress_async ||
+           gimp_image_undo_compress_start (image)))
+        {
+          return;
+        }
+
+      freed = gimp_undo_stack_free_bottom (private->undo_stack,
+                                           GIMP_UNDO_MODE_UNDO);
 
 #ifdef DEBUG_IMAGE_UNDO
       g_printerr ("freed one step: undo_steps: %d    undo_bytes: %ld\n",
                   gimp_container_get_n_children (container),
-                  (glong) gimp_object_get_memsize (GIMP_OBJECT (container),
-                                                   NULL));
+                  (glong) gimp_undo_stack_get_size (private->undo_stack));
 #endif
 
       gimp_image_undo_event (image, GIMP_UNDO_EVENT_UNDO_EXPIRED, freed);
@@ -568,7 +614,7 @@ gimp_image_undo_free_redo (GimpImage *image)
 #ifdef DEBUG_IMAGE_UNDO
   g_printerr ("redo_steps: %d    redo_bytes: %ld\n",
               gimp_container_get_n_children (container),
-              (glong) gimp_object_get_memsize (GIMP_OBJECT (container), NULL));
+              (glong) gimp_undo_stack_get_size (private->redo_stack));
 #endif
 
   if (gimp_container_is_empty (container))
@@ -582,8 +628,7 @@ gimp_image_undo_free_redo (GimpImage *image)
 #ifdef DEBUG_IMAGE_UNDO
       g_printerr ("freed one step: redo_steps: %d    redo_bytes: %ld\n",
                   gimp_container_get_n_children (container),
-                  (glong )gimp_object_get_memsize (GIMP_OBJECT (container),
-                                                   NULL));
+                  (glong) gimp_undo_stack_get_size (private->redo_stack));
 #endif
 
       gimp_image_undo_event (image, GIMP_UNDO_EVENT_REDO_EXPIRED, freed);
@@ -605,6 +650,151 @@ gimp_image_undo_free_redo (GimpImage *image)
     }
 }
 
+/*  Undos are pushed before the change they record is done, so an item
+ *  removed from the image after its undo was pushed, and then only held
+ *  by the undo, isn't counted yet.  Updates the size of the most recent
+ *  undo step once that change is done.
+ */
+static void
+gimp_image_undo_update_top (GimpImage *image)
+{
+  GimpImagePrivate *private = GIMP_IMAGE_GET_PRIVATE (image);
+  GimpUndo         *undo    = gimp_undo_stack_peek (private->undo_stack);
+
+  if (undo)
+    gimp_undo_stack_update_undo (private->undo_stack, undo);
+}
+
+/*  the most recent undo steps are never compressed, so that undoing
+ *  them stays fast
+ */
+#define UNDO_HOT_STEPS 2
+
+/*  starts compressing the oldest drawable undo that isn't yet, or if
+ *  there is none, swapping out the oldest one that isn't yet.  Returns
+ *  FALSE if there is nothing left to compact.
+ */
+static gboolean
+gimp_image_undo_compress_start (GimpImage *image)
+{
+  GimpImagePrivate *private  = GIMP_IMAGE_GET_PRIVATE (image);
+  GQueue           *queue    = GIMP_LIST (private->undo_stack->undos)->queue;
+  gchar            *swap_dir = NULL;
+  gboolean          started  = FALSE;
+  gint              pass;
+
+  /*  use GEGL's swap directory, which gimp-gegl.c keeps in sync with
+   *  the swap-path preference
+   */
+  g_object_get (gegl_config (), "swap", &swap_dir, NULL);
+
+  if (swap_dir && ! g_file_test (swap_dir, G_FILE_TEST_IS_DIR))
+    g_clear_pointer (&swap_dir, g_free);
+
+  for (pass = 0; pass < 2 && ! started; pass++)
+    {
+      const gchar *dir = (pass == 0) ? NULL : swap_dir;
+      GList       *list;
+      gint         depth;
+
+      if (pass == 1 && ! swap_dir)
+        break;
+
+      for (list = queue->tail, depth = queue->length;
+           list && depth > UNDO_HOT_STEPS && ! started;
+           list = g_list_previous (list), depth--)
+        {
+          GimpUndo *undo = list->data;
+
+          if (GIMP_IS_UNDO_STACK (undo))
+            {
+              GimpUndoStack *group = GIMP_UNDO_STACK (undo);
+              GList         *child;
+
+              for (child = GIMP_LIST (group->undos)->queue->tail;
+                   child && ! started;
+                   child = g_list_previous (child))
+                {
+                  started = gimp_image_undo_compress_undo (image, group,
+                                                           child->data, dir);
+                }
+            }
+          else
+            {
+              started = gimp_image_undo_compress_undo (image,
+                                                       private->undo_stack,
+                                                       undo, dir);
+            }
+        }
+    }
+
+  g_free (swap_dir);
+
+  return started;
+}
+
+static gboolean
+gimp_image_undo_compress_undo (GimpImage     *image,
+                               GimpUndoStack *stack,
+                               GimpUndo      *undo,
+                               const gchar   *swap_dir)
+{
+  GimpImagePrivate *private = GIMP_IMAGE_GET_PRIVATE (image);
+  CompressUndoData *data;
+  GimpAsync        *async;
+
+  if (! GIMP_IS_DRAWABLE_UNDO (undo))
+    return FALSE;
+
+  async = gimp_drawable_undo_compress_async (GIMP_DRAWABLE_UNDO (undo),
+                                             swap_dir);
+
+  if (! async)
+    return FALSE;
+
+  data = g_slice_new0 (CompressUndoData);
+
+  data->image = image;
+  data->stack = g_object_ref (stack);
+  data->undo  = g_object_ref (undo);
+
+  /*  runs after the drawable undo applied the result  */
+  gimp_async_add_callback (async,
+                           (GimpAsyncCallback) gimp_image_undo_compress_callback,
+                           data);
+
+  private->undo_compress_async = async;
+
+  g_object_unref (async);
+
+  return TRUE;
+}
+
+static void
+gimp_image_undo_compress_callback (GimpAsync        *async,
+                                   CompressUndoData *data)
+{
+  GimpImage        *image   = data->image;
+  GimpImagePrivate *private = GIMP_IMAGE_GET_PRIVATE (image);
+
+  private->undo_compress_async = NULL;
+
+  if (gimp_container_have (data->stack->undos, GIMP_OBJECT (data->undo)))
+    gimp_undo_stack_update_undo (data->stack, data->undo);
+
+  g_object_unref (data->undo);
+  g_object_unref (data->stack);
+
+  g_slice_free (CompressUndoData, data);
+
+  /*  go on with the next step, or if this one failed, drop steps
+   *  instead.  A canceled step means the undo stack is being freed,
+   *  or the step is being popped, the next push goes on then.
+   */
+  if (! gimp_async_is_canceled (async))
+    gimp_image_undo_free_space (image, gimp_async_is_finished (async));
+}
+
 static GimpDirtyMask
 gimp_image_undo_dirty_from_type (GimpUndoType undo_type)
 {
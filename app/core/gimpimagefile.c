@@ -38,6 +38,8 @@
 #include "gegl/gimp-gegl-utils.h"
 
 #include "gimp.h"
+#include "gimp-parallel.h"
+#include "gimpasync.h"
 #include "gimpcontainer.h"
 #include "gimpcontext.h"
 #include "gimpimage.h"
@@ -80,6 +82,36 @@ struct _GimpImagefilePrivate
 #define GET_PRIVATE(imagefile) ((GimpImagefilePrivate *) gimp_imagefile_get_instance_private ((GimpImagefile *) (imagefile)))
 
 
+/*  A pending or running thumbnail creation of the thumbnail queue.
+ *  There is at most one request per file and size; all imagefiles
+ *  which asked for it are updated when it is done.
+ */
+typedef struct _ThumbnailRequest ThumbnailRequest;
+
+struct _ThumbnailRequest
+{
+  GFile         *file;
+  gint           size;
+  gboolean       force;
+  gboolean       visible;
+  GimpContext   *context;
+
+  /*  not referenced, imagefiles remove themselves in dispose()  */
+  GSList        *imagefiles;
+
+  GimpImagefile *local;
+  GimpAsync     *async;
+};
+
+typedef struct
+{
+  GimpThumbnail *thumbnail;
+  GdkPixbuf     *pixbuf;
+  gint           size;
+  gboolean       replace;
+} ThumbnailSaveData;
+
+
 static void        gimp_imagefile_dispose          (GObject        *object);
 static void        gimp_imagefile_finalize         (GObject        *object);
 
@@ -110,12 +142,35 @@ static void        gimp_imagefile_icon_callback    (GObject        *source_objec
 static GdkPixbuf * gimp_imagefile_load_thumb       (GimpImagefile  *imagefile,
                                                     gint            width,
                                                     gint            height);
+static GimpImage * gimp_imagefile_load_thumb_image (GimpImagefile  *imagefile,
+                                                    GimpContext    *context,
+                                                    GimpProgress   *progress,
+                                                    gint            size,
+                                                    gboolean       *skip,
+                                                    GError        **error);
+static GdkPixbuf * gimp_imagefile_render_thumb     (GimpImage      *image,
+                                                    gint           *size);
 static gboolean    gimp_imagefile_save_thumb       (GimpImagefile  *imagefile,
                                                     GimpImage      *image,
                                                     gint            size,
                                                     gboolean        replace,
                                                     GError        **error);
 
+static ThumbnailRequest *
+                   thumbnail_request_find          (GFile          *file,
+                                                    gint            size);
+static void        thumbnail_request_free          (ThumbnailRequest *request);
+static void        thumbnail_request_done          (ThumbnailRequest *request,
+                                                    gboolean          success,
+                                                    const GError     *error);
+static void        thumbnail_request_run           (ThumbnailRequest *request);
+static void        thumbnail_request_saved         (GimpAsync        *async,
+                                                    ThumbnailRequest *request);
+static gboolean    thumbnail_queue_idle            (gpointer          data);
+static void        thumbnail_save_async_func       (GimpAsync        *async,
+                                                    ThumbnailSaveData *data);
+static void        thumbnail_save_data_free        (ThumbnailSaveData *data);
+
 static void     gimp_thumbnail_set_info_from_image (GimpThumbnail  *thumbnail,
                                                     const gchar    *mime_type,
                                                     GimpImage      *image);
@@ -133,6 +188,11 @@ G_DEFINE_TYPE_WITH_PRIVATE (GimpImagefile, gimp_imagefile, GIMP_TYPE_VIEWABLE)
 
 static guint gimp_imagefile_signals[LAST_SIGNAL] = { 0 };
 
+/*  requests waiting for their turn, and the ones being worked on  */
+static GQueue thumbnail_queue    = G_QUEUE_INIT;
+static GList *thumbnail_running  = NULL;
+static guint  thumbnail_queue_id = 0;
+
 
 static void
 gimp_imagefile_class_init (GimpImagefileClass *klass)
@@ -166,6 +226,7 @@ gimp_imagefile_class_init (GimpImagefileClass *klass)
                              GIMP_MAJOR_VERSION, GIMP_MINOR_VERSION);
 
   gimp_thumb_init (creator, NULL);
+  gimp_thumb_use_cache (TRUE);
 
   g_free (creator);
 }
@@ -186,6 +247,21 @@ static void
 gimp_imagefile_dispose (GObject *object)
 {
   GimpImagefilePrivate *private = GET_PRIVATE (object);
+  GList                *list;
+
+  for (list = thumbnail_queue.head; list; list = g_list_next (list))
+    {
+      ThumbnailRequest *request = list->data;
+
+      request->imagefiles = g_slist_remove (request->imagefiles, object);
+    }
+
+  for (list = thumbnail_running; list; list = g_list_next (list))
+    {
+      ThumbnailRequest *request = list->data;
+
+      request->imagefiles = g_slist_remove (request->imagefiles, object);
+    }
 
   if (private->icon_cancellable)
     {
@@ -261,11 +337,24 @@ gimp_imagefile_get_new_pixbuf (GimpViewable *viewable,
                                gint          height,
                                GeglColor    *fg_color G_GNUC_UNUSED)
 {
-  GimpImagefile *imagefile = GIMP_IMAGEFILE (viewable);
+  GimpImagefile        *imagefile = GIMP_IMAGEFILE (viewable);
+  GimpImagefilePrivate *private   = GET_PRIVATE (imagefile);
 
   if (! gimp_object_get_name (imagefile))
     return NULL;
 
+  /*  we are being rendered, so whatever is queued for us is visible  */
+  if (! g_queue_is_empty (&thumbnail_queue) && private->file)
+    {
+      ThumbnailRequest *request;
+
+      request = thumbnail_request_find (private->file,
+                                        private->gimp->config->thumbnail_size);
+
+      if (request)
+        request->visible = TRUE;
+    }
+
   return gimp_imagefile_load_thumb (imagefile, width, height);
 }
 
@@ -450,8 +539,9 @@ gimp_imagefile_create_thumbnail (GimpImagefile  *imagefile,
                                  GError        **error)
 {
   GimpImagefilePrivate *private;
-  GimpThumbnail        *thumbnail;
-  GimpThumbState        image_state;
+  GimpImage            *image;
+  gboolean              skip    = FALSE;
+  gboolean              success = TRUE;
 
   g_return_val_if_fail (GIMP_IS_IMAGEFILE (imagefile), FALSE);
   g_return_val_if_fail (GIMP_IS_CONTEXT (context), FALSE);
@@ -464,136 +554,134 @@ gimp_imagefile_create_thumbnail (GimpImagefile  *imagefile,
 
   private = GET_PRIVATE (imagefile);
 
-  thumbnail = private->thumbnail;
+  g_object_ref (imagefile);
 
-  gimp_thumbnail_set_uri (thumbnail,
-                          gimp_object_get_name (imagefile));
+  image = gimp_imagefile_load_thumb_image (imagefile, context, progress,
+                                           size, &skip, error);
 
-  image_state = gimp_thumbnail_peek_image (thumbnail);
+  if (image)
+    {
+      success = gimp_imagefile_save_thumb (imagefile,
+                                           image, size, replace,
+                                           error);
 
-  if (image_state == GIMP_THUMB_STATE_REMOTE ||
-      image_state >= GIMP_THUMB_STATE_EXISTS)
+      g_object_unref (image);
+    }
+  else if (! skip)
     {
-      GimpImage     *image;
-      gboolean       success;
-      gint           width      = 0;
-      gint           height     = 0;
-      const gchar   *mime_type  = NULL;
-      const Babl    *format     = NULL;
-      gint           num_layers = -1;
-
-      /*  we only want to attempt thumbnailing on readable, regular files  */
-      if (g_file_is_native (private->file))
-        {
-          GFileInfo *file_info;
-          gboolean   regular;
-          gboolean   readable;
+      /* If the error object is already set (i.e. we have an error
+       * message for why the thumbnail creation failed), this is the
+       * error we want to return. Ignore any error from failed
+       * thumbnail saving.
+       */
+      gimp_thumbnail_save_failure (private->thumbnail,
+                                   "GIMP " GIMP_VERSION,
+                                   error && *error ? NULL : error);
+      gimp_imagefile_update (imagefile);
+      success = FALSE;
+    }
 
-          file_info = g_file_query_info (private->file,
-                                         G_FILE_ATTRIBUTE_STANDARD_TYPE ","
-                                         G_FILE_ATTRIBUTE_ACCESS_CAN_READ,
-                                         G_FILE_QUERY_INFO_NONE,
-                                         NULL, NULL);
+  if (! success)
+    {
+      g_object_set (private->thumbnail,
+                    "thumb-state", GIMP_THUMB_STATE_FAILED,
+                    NULL);
+    }
 
-          regular  = (g_file_info_get_attribute_uint32 (file_info, G_FILE_ATTRIBUTE_STANDARD_TYPE) == G_FILE_TYPE_REGULAR);
-          readable = g_file_info_get_attribute_boolean (file_info,
-                                                        G_FILE_ATTRIBUTE_ACCESS_CAN_READ);
+  g_object_unref (imagefile);
 
-          g_object_unref (file_info);
+  return success;
+}
 
-          if (! (regular && readable))
-            return TRUE;
-        }
+/*  Queues the creation of a thumbnail for the file @imagefile
+ *  currently refers to.  Thumbnails are created one at a time from an
+ *  idle handler, so the user interface stays responsive, and are
+ *  written to disk by the async thread pool.  Visible requests are
+ *  served before all others, and queueing a file which is already
+ *  queued only updates the existing request.
+ *
+ *  Unless @force is set, nothing is done for files that already have
+ *  a valid or a failed thumbnail.
+ */
+void
+gimp_imagefile_queue_thumbnail (GimpImagefile *imagefile,
+                                GimpContext   *context,
+                                gint           size,
+                                gboolean       force,
+                                gboolean       visible)
+{
+  GimpImagefilePrivate *private;
+  ThumbnailRequest     *request;
 
-      g_object_ref (imagefile);
+  g_return_if_fail (GIMP_IS_IMAGEFILE (imagefile));
+  g_return_if_fail (GIMP_IS_CONTEXT (context));
 
-      image = file_open_thumbnail (private->gimp, context, progress,
-                                   private->file, size,
-                                   &mime_type, &width, &height,
-                                   &format, &num_layers, error);
+  if (size < 1)
+    return;
 
-      if (image)
-        {
-          gimp_thumbnail_set_info (private->thumbnail,
-                                   mime_type, width, height,
-                                   format, num_layers);
-        }
-      else
-        {
-          GimpPDBStatusType  status;
+  private = GET_PRIVATE (imagefile);
 
-          if (error && *error)
-            {
-              g_printerr ("Info: Thumbnail load procedure failed: %s\n"
-                          "      Falling back to metadata or file load.\n",
-                          (*error)->message);
-              g_clear_error (error);
-            }
+  if (! private->file)
+    return;
 
-          image = gimp_image_metadata_load_thumbnail (private->gimp, private->file, &width, &height, &format, error);
-          if (image)
-            {
-              gimp_thumbnail_set_info (private->thumbnail,
-                                       mime_type, width, height,
-                                       format, 0);
-            }
-          else
-            {
-              if (error && *error)
-                {
-                  g_printerr ("Info: metadata load failed: %s\n"
-                              "      Falling back to file load procedure.\n",
-                              (*error)->message);
-                  g_clear_error (error);
-                }
+  request = thumbnail_request_find (private->file, size);
 
-              image = file_open_image (private->gimp, context, progress,
-                                       private->file, size, size, TRUE,
-                                       FALSE, NULL,
-                                       GIMP_RUN_NONINTERACTIVE,
-                                       NULL, &status, &mime_type, error);
+  if (! request)
+    {
+      request = g_slice_new0 (ThumbnailRequest);
 
-              if (image)
-                gimp_thumbnail_set_info_from_image (private->thumbnail,
-                                                    mime_type, image);
-            }
-        }
+      request->file    = g_object_ref (private->file);
+      request->size    = size;
+      request->context = g_object_ref (context);
 
-      if (image)
-        {
-          success = gimp_imagefile_save_thumb (imagefile,
-                                               image, size, replace,
-                                               error);
+      g_queue_push_tail (&thumbnail_queue, request);
+    }
 
-          g_object_unref (image);
-        }
-      else
-        {
-          /* If the error object is already set (i.e. we have an error
-           * message for why the thumbnail creation failed), this is the
-           * error we want to return. Ignore any error from failed
-           * thumbnail saving.
-           */
-          gimp_thumbnail_save_failure (thumbnail,
-                                       "GIMP " GIMP_VERSION,
-                                       error && *error ? NULL : error);
-          gimp_imagefile_update (imagefile);
-          success = FALSE;
-        }
+  request->force   |= force;
+  request->visible |= visible;
+
+  if (! g_slist_find (request->imagefiles, imagefile))
+    request->imagefiles = g_slist_prepend (request->imagefiles, imagefile);
 
-      g_object_unref (imagefile);
+  if (! thumbnail_queue_id)
+    {
+      thumbnail_queue_id = g_idle_add_full (G_PRIORITY_LOW,
+                                            thumbnail_queue_idle,
+                                            NULL, NULL);
+    }
+}
 
-      if (! success)
+/*  Drops @imagefile from the queued thumbnail creations it waits for,
+ *  e.g. because it is no longer shown.  A request itself is only dropped
+ *  once no other imagefile waits for it.  A thumbnail that is already
+ *  being created is finished.
+ */
+void
+gimp_imagefile_cancel_thumbnail (GimpImagefile *imagefile)
+{
+  GList *list;
+
+  g_return_if_fail (GIMP_IS_IMAGEFILE (imagefile));
+
+  for (list = thumbnail_queue.head; list; )
+    {
+      ThumbnailRequest *request = list->data;
+      GList            *next    = g_list_next (list);
+
+      if (g_slist_find (request->imagefiles, imagefile))
         {
-          g_object_set (thumbnail,
-                        "thumb-state", GIMP_THUMB_STATE_FAILED,
-                        NULL);
+          request->imagefiles = g_slist_remove (request->imagefiles,
+                                                imagefile);
+
+          if (! request->imagefiles)
+            {
+              g_queue_delete_link (&thumbnail_queue, list);
+              thumbnail_request_free (request);
+            }
         }
 
-      return success;
+      list = next;
     }
-
-  return TRUE;
 }
 
 /*  The weak version doesn't ref the imagefile but deals gracefully
@@ -1064,42 +1152,148 @@ gimp_imagefile_load_thumb (GimpImagefile *imagefile,
   return pixbuf;
 }
 
-static gboolean
-gimp_imagefile_save_thumb (GimpImagefile  *imagefile,
-                           GimpImage      *image,
-                           gint            size,
-                           gboolean        replace,
-                           GError        **error)
+/*  Loads the image to create @imagefile's thumbnail from.  Returns
+ *  NULL and sets @skip if there is no image to create a thumbnail for.
+ */
+static GimpImage *
+gimp_imagefile_load_thumb_image (GimpImagefile  *imagefile,
+                                 GimpContext    *context,
+                                 GimpProgress   *progress,
+                                 gint            size,
+                                 gboolean       *skip,
+                                 GError        **error)
 {
   GimpImagefilePrivate *private   = GET_PRIVATE (imagefile);
   GimpThumbnail        *thumbnail = private->thumbnail;
-  GdkPixbuf            *pixbuf;
-  gint                  width, height;
-  gboolean              success = FALSE;
+  GimpThumbState        image_state;
+  GimpImage            *image;
+  gint                  width      = 0;
+  gint                  height     = 0;
+  const gchar          *mime_type  = NULL;
+  const Babl           *format     = NULL;
+  gint                  num_layers = -1;
 
-  if (size < 1)
-    return TRUE;
+  *skip = TRUE;
+
+  gimp_thumbnail_set_uri (thumbnail,
+                          gimp_object_get_name (imagefile));
+
+  image_state = gimp_thumbnail_peek_image (thumbnail);
+
+  if (image_state != GIMP_THUMB_STATE_REMOTE &&
+      image_state <  GIMP_THUMB_STATE_EXISTS)
+    return NULL;
+
+  /*  we only want to attempt thumbnailing on readable, regular files  */
+  if (g_file_is_native (private->file))
+    {
+      GFileInfo *file_info;
+      gboolean   regular;
+      gboolean   readable;
+
+      file_info = g_file_query_info (private->file,
+                                     G_FILE_ATTRIBUTE_STANDARD_TYPE ","
+                                     G_FILE_ATTRIBUTE_ACCESS_CAN_READ,
+                                     G_FILE_QUERY_INFO_NONE,
+                                     NULL, NULL);
+
+      regular  = (g_file_info_get_attribute_uint32 (file_info, G_FILE_ATTRIBUTE_STANDARD_TYPE) == G_FILE_TYPE_REGULAR);
+      readable = g_file_info_get_attribute_boolean (file_info,
+                                                    G_FILE_ATTRIBUTE_ACCESS_CAN_READ);
+
+      g_object_unref (file_info);
 
-  if (gimp_image_get_width  (image) <= size &&
-      gimp_image_get_height (image) <= size)
+      if (! (regular && readable))
+        return NULL;
+    }
+
+  *skip = FALSE;
+
+  image = file_open_thumbnail (private->gimp, context, progress,
+                               private->file, size,
+                               &mime_type, &width, &height,
+                               &format, &num_layers, error);
+
+  if (image)
+    {
+      gimp_thumbnail_set_info (private->thumbnail,
+                               mime_type, width, height,
+                               format, num_layers);
+    }
+  else
+    {
+      GimpPDBStatusType  status;
+
+      if (error && *error)
+        {
+          g_printerr ("Info: Thumbnail load procedure failed: %s\n"
+                      "      Falling back to metadata or file load.\n",
+                      (*error)->message);
+          g_clear_error (error);
+        }
+
+      image = gimp_image_metadata_load_thumbnail (private->gimp, private->file, &width, &height, &format, error);
+      if (image)
+        {
+          gimp_thumbnail_set_info (private->thumbnail,
+                                   mime_type, width, height,
+                                   format, 0);
+        }
+      else
+        {
+          if (error && *error)
+            {
+              g_printerr ("Info: metadata load failed: %s\n"
+                          "      Falling back to file load procedure.\n",
+                          (*error)->message);
+              g_clear_error (error);
+            }
+
+          image = file_open_image (private->gimp, context, progress,
+                                   private->file, size, size, TRUE,
+                                   FALSE, NULL,
+                                   GIMP_RUN_NONINTERACTIVE,
+                                   NULL, &status, &mime_type, error);
+
+          if (image)
+            gimp_thumbnail_set_info_from_image (private->thumbnail,
+                                                mime_type, image);
+        }
+    }
+
+  return image;
+}
+
+/*  Renders @image at thumbnail @size, and adjusts @size to the size of
+ *  the thumbnail actually rendered.  Returns NULL when layer previews
+ *  are disabled.
+ */
+static GdkPixbuf *
+gimp_imagefile_render_thumb (GimpImage *image,
+                             gint      *size)
+{
+  gint width, height;
+
+  if (gimp_image_get_width  (image) <= *size &&
+      gimp_image_get_height (image) <= *size)
     {
       width  = gimp_image_get_width  (image);
       height = gimp_image_get_height (image);
 
-      size = MAX (width, height);
+      *size = MAX (width, height);
     }
   else
     {
       if (gimp_image_get_width (image) < gimp_image_get_height (image))
         {
-          height = size;
-          width  = MAX (1, (size * gimp_image_get_width (image) /
+          height = *size;
+          width  = MAX (1, (*size * gimp_image_get_width (image) /
                             gimp_image_get_height (image)));
         }
       else
         {
-          width  = size;
-          height = MAX (1, (size * gimp_image_get_height (image) /
+          width  = *size;
+          height = MAX (1, (*size * gimp_image_get_height (image) /
                             gimp_image_get_width (image)));
         }
     }
@@ -1107,10 +1301,28 @@ gimp_imagefile_save_thumb (GimpImagefile  *imagefile,
   /*  we need the projection constructed NOW, not some time later  */
   gimp_pickable_flush (GIMP_PICKABLE (image));
 
-  pixbuf = gimp_viewable_get_new_pixbuf (GIMP_VIEWABLE (image),
-                                         /* random context, unused */
-                                         gimp_get_user_context (image->gimp),
-                                         width, height, NULL);
+  return gimp_viewable_get_new_pixbuf (GIMP_VIEWABLE (image),
+                                       /* random context, unused */
+                                       gimp_get_user_context (image->gimp),
+                                       width, height, NULL);
+}
+
+static gboolean
+gimp_imagefile_save_thumb (GimpImagefile  *imagefile,
+                           GimpImage      *image,
+                           gint            size,
+                           gboolean        replace,
+                           GError        **error)
+{
+  GimpImagefilePrivate *private   = GET_PRIVATE (imagefile);
+  GimpThumbnail        *thumbnail = private->thumbnail;
+  GdkPixbuf            *pixbuf;
+  gboolean              success = FALSE;
+
+  if (size < 1)
+    return TRUE;
+
+  pixbuf = gimp_imagefile_render_thumb (image, &size);
 
   /*  when layer previews are disabled, we won't get a pixbuf  */
   if (! pixbuf)
@@ -1136,6 +1348,293 @@ gimp_imagefile_save_thumb (GimpImagefile  *imagefile,
   return success;
 }
 
+
+/*  the thumbnail queue  */
+
+static ThumbnailRequest *
+thumbnail_request_find (GFile *file,
+                        gint   size)
+{
+  GList *list;
+
+  for (list = thumbnail_queue.head; list; list = g_list_next (list))
+    {
+      ThumbnailRequest *request = list->data;
+
+      if (request->size == size && g_file_equal (request->file, file))
+        return request;
+    }
+
+  for (list = thumbnail_running; list; list = g_list_next (list))
+    {
+      ThumbnailRequest *request = list->data;
+
+      /*  a running request may be done before a newer version of the
+       *  file is looked at, so only reuse it if nothing is forced
+       */
+      if (request->size == size && ! request->force &&
+          g_file_equal (request->file, file))
+        return request;
+    }
+
+  return NULL;
+}
+
+static void
+thumbnail_request_free (ThumbnailRequest *request)
+{
+  g_slist_free (request->imagefiles);
+
+  g_clear_object (&request->async);
+  g_clear_object (&request->local);
+  g_clear_object (&request->context);
+  g_clear_object (&request->file);
+
+  g_slice_free (ThumbnailRequest, request);
+}
+
+/*  Updates all imagefiles that asked for @request and still refer to
+ *  its file, and frees the request.
+ */
+static void
+thumbnail_request_done (ThumbnailRequest *request,
+                        gboolean          success,
+                        const GError     *error)
+{
+  GSList *list;
+
+  thumbnail_running = g_list_remove (thumbnail_running, request);
+
+  if (error && request->force)
+    {
+      Gimp *gimp = request->context->gimp;
+
+      gimp_message_literal (gimp, NULL, GIMP_MESSAGE_ERROR, error->message);
+    }
+
+  for (list = request->imagefiles; list; list = g_slist_next (list))
+    {
+      GimpImagefile        *imagefile = list->data;
+      GimpImagefilePrivate *private   = GET_PRIVATE (imagefile);
+
+      if (! private->file || ! g_file_equal (private->file, request->file))
+        continue;
+
+      if (success)
+        gimp_thumbnail_peek_thumb (private->thumbnail, request->size);
+      else
+        g_object_set (private->thumbnail,
+                      "thumb-state", GIMP_THUMB_STATE_FAILED,
+                      NULL);
+
+      gimp_imagefile_update (imagefile);
+    }
+
+  thumbnail_request_free (request);
+}
+
+static void
+thumbnail_request_run (ThumbnailRequest *request)
+{
+  Gimp                 *gimp = request->context->gimp;
+  GimpImagefilePrivate *private;
+  GimpImage            *image;
+  GError               *error = NULL;
+  gboolean              skip  = FALSE;
+
+  thumbnail_running = g_list_prepend (thumbnail_running, request);
+
+  /*  work on a private imagefile, the ones that asked for the
+   *  thumbnail may be switched to other files meanwhile
+   */
+  request->local = gimp_imagefile_new (gimp, request->file);
+  private        = GET_PRIVATE (request->local);
+
+  gimp_thumbnail_set_uri (private->thumbnail,
+                          gimp_object_get_name (request->local));
+
+  if (! request->force &&
+      (gimp_thumbnail_peek_thumb (private->thumbnail, request->size) >=
+       GIMP_THUMB_STATE_FAILED ||
+       gimp_thumbnail_has_failed (private->thumbnail)))
+    {
+      thumbnail_request_done (request, TRUE, NULL);
+      return;
+    }
+
+  /*  the plug-in call below runs the main loop, imagefiles may go
+   *  away or be queued again in the meantime
+   */
+  image = gimp_imagefile_load_thumb_image (request->local, request->context,
+                                           NULL, request->size,
+                                           &skip, &error);
+
+  if (image)
+    {
+      ThumbnailSaveData *data;
+      GdkPixbuf         *pixbuf;
+      gint               size = request->size;
+      gchar             *mime_type;
+      gchar             *image_type;
+      gint               width;
+      gint               height;
+      gint               num_layers;
+
+      pixbuf = gimp_imagefile_render_thumb (image, &size);
+
+      g_object_unref (image);
+
+      if (! pixbuf)
+        {
+          thumbnail_request_done (request, TRUE, NULL);
+          return;
+        }
+
+      /*  encoding and writing the PNG happens on a worker thread, on a
+       *  copy of the thumbnail nobody else is watching
+       */
+      data = g_slice_new0 (ThumbnailSaveData);
+
+      data->thumbnail = gimp_thumbnail_new ();
+      data->pixbuf    = pixbuf;
+      data->size      = size;
+      data->replace   = ! request->force;
+
+      g_object_get (private->thumbnail,
+                    "image-mimetype",   &mime_type,
+                    "image-width",      &width,
+                    "image-height",     &height,
+                    "image-type",       &image_type,
+                    "image-num-layers", &num_layers,
+                    NULL);
+
+      gimp_thumbnail_set_uri (data->thumbnail,
+                              gimp_object_get_name (request->local));
+      gimp_thumbnail_peek_image (data->thumbnail);
+
+      g_object_set (data->thumbnail,
+                    "image-mimetype",   mime_type,
+                    "image-width",      width,
+                    "image-height",     height,
+                    "image-type",       image_type,
+                    "image-num-layers", num_layers,
+                    NULL);
+
+      g_free (mime_type);
+      g_free (image_type);
+
+      request->async =
+        gimp_parallel_run_async_full (+1,
+                                      (GimpRunAsyncFunc) thumbnail_save_async_func,
+                                      data,
+                                      (GDestroyNotify) thumbnail_save_data_free);
+
+      gimp_async_add_callback (request->async,
+                               (GimpAsyncCallback) thumbnail_request_saved,
+                               request);
+    }
+  else if (skip)
+    {
+      thumbnail_request_done (request, TRUE, NULL);
+    }
+  else
+    {
+      gimp_thumbnail_save_failure (private->thumbnail,
+                                   "GIMP " GIMP_VERSION,
+                                   error ? NULL : &error);
+
+      thumbnail_request_done (request, FALSE, error);
+    }
+
+  g_clear_error (&error);
+}
+
+static void
+thumbnail_request_saved (GimpAsync        *async,
+                         ThumbnailRequest *request)
+{
+  if (gimp_async_is_finished (async))
+    {
+      const GError *error = gimp_async_get_result (async);
+
+      thumbnail_request_done (request, error == NULL, error);
+    }
+  else
+    {
+      thumbnail_request_done (request, FALSE, NULL);
+    }
+}
+
+static gboolean
+thumbnail_queue_idle (gpointer data)
+{
+  ThumbnailRequest *request = NULL;
+  GList            *list;
+
+  for (list = thumbnail_queue.head; list; list = g_list_next (list))
+    {
+      ThumbnailRequest *r = list->data;
+
+      if (r->visible)
+        {
+          request = r;
+
+          g_queue_delete_link (&thumbnail_queue, list);
+          break;
+        }
+    }
+
+  if (! request)
+    request = g_queue_pop_head (&thumbnail_queue);
+
+  if (request)
+    thumbnail_request_run (request);
+
+  if (g_queue_is_empty (&thumbnail_queue))
+    {
+      thumbnail_queue_id = 0;
+
+      return G_SOURCE_REMOVE;
+    }
+
+  return G_SOURCE_CONTINUE;
+}
+
+static void
+thumbnail_save_async_func (GimpAsync         *async,
+                           ThumbnailSaveData *data)
+{
+  GError *error = NULL;
+
+  if (gimp_thumbnail_save_thumb (data->thumbnail,
+                                 data->pixbuf,
+                                 "GIMP " GIMP_VERSION,
+                                 &error))
+    {
+      if (data->replace)
+        gimp_thumbnail_delete_others (data->thumbnail, data->size);
+      else
+        gimp_thumbnail_delete_failure (data->thumbnail);
+
+      gimp_async_finish (async, NULL);
+    }
+  else
+    {
+      gimp_async_finish_full (async, error, (GDestroyNotify) g_error_free);
+    }
+
+  thumbnail_save_data_free (data);
+}
+
+static void
+thumbnail_save_data_free (ThumbnailSaveData *data)
+{
+  g_object_unref (data->thumbnail);
+  g_object_unref (data->pixbuf);
+
+  g_slice_free (ThumbnailSaveData, data);
+}
+
 static void
 gimp_thumbnail_set_info_from_image (GimpThumbnail *thumbnail,
                                     const gchar   *mime_type,
@@ -79,6 +79,11 @@ struct _GimpLineArtPrivate
   GeglBuffer   *closed;
   gfloat       *distmap;
 
+  /* The binarized strokes @closed was computed from, to reuse it when
+   * the input changes without changing the strokes.
+   */
+  GeglBuffer   *strokes;
+
   /* Used in the closing step. */
   gboolean      select_transparent;
   gdouble       threshold;
@@ -100,12 +105,18 @@ typedef struct
   gboolean     automatic_closure;
   gint         spline_max_len;
   gint         segment_max_len;
+
+  /* The previous result, if computed with the same closure settings. */
+  GeglBuffer  *prev_strokes;
+  GeglBuffer  *prev_closed;
+  gfloat      *prev_distmap;
 } LineArtData;
 
 typedef struct
 {
   GeglBuffer *closed;
   gfloat     *distmap;
+  GeglBuffer *strokes;
 } LineArtResult;
 
 static int DeltaX[4] = {+1, -1, 0, 0};
@@ -147,6 +158,64 @@ typedef struct _Edgel
   guint     next, previous;
 } Edgel;
 
+/* Data shared by the parallel parts of the computation. */
+
+typedef struct
+{
+  GeglBuffer *buffer;
+  gboolean    select_transparent;
+  guchar      threshold;
+  guchar      max_value;
+  GMutex      mutex;
+  GimpAsync  *async;
+} BinarizeData;
+
+typedef struct
+{
+  GeglBuffer   *buffer;
+  GSList       *chunks;
+  GMutex        mutex;
+  GimpAsync    *async;
+} EdgelsData;
+
+typedef struct
+{
+  GeglRectangle area;
+  GArray       *edgels;
+} EdgelsChunk;
+
+typedef struct
+{
+  GeglBuffer   *mask;
+  gfloat       *normals;
+  gfloat       *curvatures;
+  gfloat       *smoothed_curvatures;
+  gfloat       *radii;
+  gfloat       *dist;
+  gfloat        threshold;
+  gfloat        clamped_threshold;
+  gint          width;
+  gint          height;
+  GimpAsync    *async;
+} PixelsData;
+
+typedef struct
+{
+  GArray       *set;
+  GeglBuffer   *buffer;
+  GHashTable   *edgel2index;
+  const gfloat *weights;
+  gint          mask_size;
+  gfloat       *smoothed_curvatures;
+  GimpAsync    *async;
+} EdgelsetData;
+
+#define PIXELS_PER_THREAD \
+  (/* each thread costs as much as */ 64.0 * 64.0 /* pixels */)
+
+#define EDGELS_PER_THREAD \
+  (/* each thread costs as much as */ 4096.0 /* edgels */)
+
 
 static void            gimp_line_art_finalize                  (GObject               *object);
 static void            gimp_line_art_set_property              (GObject                *object,
@@ -172,7 +241,8 @@ static LineArtData   * line_art_data_new                       (GeglBuffer
                                                                 GimpLineArt            *line_art);
 static void            line_art_data_free                      (LineArtData            *data);
 static LineArtResult * line_art_result_new                     (GeglBuffer             *line_art,
-                                                                gfloat                 *distmap);
+                                                                gfloat                 *distmap,
+                                                                GeglBuffer             *strokes);
 static void            line_art_result_free                    (LineArtResult          *result);
 
 static gboolean        gimp_line_art_idle                      (GimpLineArt            *line_art);
@@ -182,13 +252,22 @@ static void            gimp_line_art_input_invalidate_preview  (GimpViewable
 
 /* All actual computation functions. */
 
-static GeglBuffer    * gimp_line_art_close                     (GeglBuffer             *buffer,
+static GeglBuffer    * gimp_line_art_binarize                  (GeglBuffer             *buffer,
                                                                 gboolean                select_transparent,
                                                                 gdouble                 stroke_threshold,
+                                                                gint                    minimal_lineart_area,
+                                                                GimpAsync              *async);
+static void            gimp_line_art_binarize_max_area         (const GeglRectangle    *area,
+                                                                BinarizeData           *data);
+static void            gimp_line_art_binarize_area             (const GeglRectangle    *area,
+                                                                BinarizeData           *data);
+static gboolean        gimp_line_art_strokes_equal             (GeglBuffer             *strokes1,
+                                                                GeglBuffer             *strokes2,
+                                                                GimpAsync              *async);
+static GeglBuffer    * gimp_line_art_close                     (GeglBuffer             *strokes,
                                                                 gboolean                automatic_closure,
                                                                 gint                    spline_max_length,
                                                                 gint                    segment_max_length,
-                                                                gint                    minimal_lineart_area,
                                                                 gint                    normal_estimate_mask_size,
                                                                 gfloat                  end_point_rate,
                                                                 gfloat                  spline_max_angle,
@@ -210,8 +289,18 @@ static void            gimp_lineart_compute_normals_curvatures (GeglBuffer
                                                                 gfloat                 *smoothed_curvatures,
                                                                 int                     normal_estimate_mask_size,
                                                                 GimpAsync              *async);
+static void            gimp_lineart_normalize_normals_range    (gsize                   offset,
+                                                                gsize                   size,
+                                                                PixelsData             *data);
+static void            gimp_lineart_end_points_range           (gsize                   offset,
+                                                                gsize                   size,
+                                                                PixelsData             *data);
 static gfloat        * gimp_lineart_get_smooth_curvatures      (GArray                 *edgelset,
                                                                 GimpAsync              *async);
+static void            gimp_lineart_get_smooth_curvatures_range
+                                                               (gsize                   offset,
+                                                                gsize                   size,
+                                                                EdgelsetData           *data);
 static GArray        * gimp_lineart_curvature_extremums        (gfloat                 *curvatures,
                                                                 gfloat                 *smoothed_curvatures,
                                                                 gint                    curvatures_width,
@@ -245,6 +334,8 @@ static GArray        * gimp_lineart_line_segment_until_hit      (const GeglBuffe
                                                                  int                     size);
 static gfloat        * gimp_lineart_estimate_strokes_radii      (GeglBuffer             *mask,
                                                                  GimpAsync              *async);
+static void            gimp_lineart_estimate_strokes_radii_area (const GeglRectangle    *area,
+                                                                 PixelsData             *data);
 static void            gimp_line_art_simple_fill                (GeglBuffer             *buffer,
                                                                  gint                    x,
                                                                  gint                    y,
@@ -286,22 +377,32 @@ static glong      gimp_edgel_region_area          (const GeglBuffer   *mask,
 
 static GArray   * gimp_edgelset_new               (GeglBuffer         *buffer,
                                                    GimpAsync          *async);
-static void       gimp_edgelset_add               (GArray             *set,
-                                                   int                 x,
-                                                   int                 y,
-                                                   Direction           direction,
-                                                   GHashTable         *edgel2index);
+static void       gimp_edgelset_new_area          (const GeglRectangle *area,
+                                                   EdgelsData         *data);
+static gint       gimp_edgelset_chunk_cmp         (const EdgelsChunk  *chunk1,
+                                                   const EdgelsChunk  *chunk2);
 static void       gimp_edgelset_init_normals      (GArray             *set);
 static void       gimp_edgelset_smooth_normals    (GArray             *set,
                                                    int                 mask_size,
                                                    GimpAsync          *async);
+static void       gimp_edgelset_smooth_normals_range
+                                                  (gsize               offset,
+                                                   gsize               size,
+                                                   EdgelsetData       *data);
 static void       gimp_edgelset_compute_curvature (GArray             *set,
                                                    GimpAsync          *async);
+static void       gimp_edgelset_compute_curvature_range
+                                                  (gsize               offset,
+                                                   gsize               size,
+                                                   EdgelsetData       *data);
 
 static void       gimp_edgelset_build_graph       (GArray            *set,
                                                    GeglBuffer        *buffer,
                                                    GHashTable        *edgel2index,
                                                    GimpAsync         *async);
+static void       gimp_edgelset_build_graph_range (gsize              offset,
+                                                   gsize              size,
+                                                   EdgelsetData      *data);
 static void       gimp_edgelset_next8             (const GeglBuffer  *buffer,
                                                    Edgel             *it,
                                                    Edgel             *n);
@@ -429,6 +530,7 @@ gimp_line_art_set_property (GObject      *object,
       if (line_art->priv->automatic_closure != g_value_get_boolean (value))
         {
           line_art->priv->automatic_closure = g_value_get_boolean (value);
+          g_clear_object (&line_art->priv->strokes);
           gimp_line_art_compute (line_art);
         }
       break;
@@ -438,6 +540,7 @@ gimp_line_art_set_property (GObject      *object,
           line_art->priv->spline_max_len = g_value_get_int (value);
           if (line_art->priv->max_len_bound)
             line_art->priv->segment_max_len = line_art->priv->spline_max_len;
+          g_clear_object (&line_art->priv->strokes);
           gimp_line_art_compute (line_art);
         }
       break;
@@ -447,6 +550,7 @@ gimp_line_art_set_property (GObject      *object,
           line_art->priv->segment_max_len = g_value_get_int (value);
           if (line_art->priv->max_len_bound)
             line_art->priv->spline_max_len = line_art->priv->segment_max_len;
+          g_clear_object (&line_art->priv->strokes);
           gimp_line_art_compute (line_art);
         }
       break;
@@ -619,9 +723,6 @@ gimp_line_art_compute (GimpLineArt *line_art)
       line_art->priv->idle_id = 0;
     }
 
-  g_clear_object (&line_art->priv->closed);
-  g_clear_pointer (&line_art->priv->distmap, g_free);
-
   if (line_art->priv->input)
     {
       /* gimp_line_art_prepare_async() will flush the pickable, which
@@ -643,6 +744,10 @@ gimp_line_art_compute (GimpLineArt *line_art)
                                           (GimpAsyncCallback) gimp_line_art_compute_cb,
                                           line_art, line_art);
     }
+
+  g_clear_object (&line_art->priv->closed);
+  g_clear_pointer (&line_art->priv->distmap, g_free);
+  g_clear_object (&line_art->priv->strokes);
 }
 
 static void
@@ -659,6 +764,7 @@ gimp_line_art_compute_cb (GimpAsync   *async,
       result = gimp_async_get_result (async);
 
       line_art->priv->closed  = g_object_ref (result->closed);
+      line_art->priv->strokes = g_object_ref (result->strokes);
       line_art->priv->distmap = result->distmap;
       result->distmap  = NULL;
       g_signal_emit (line_art, gimp_line_art_signals[COMPUTING_END], 0);
@@ -699,12 +805,14 @@ gimp_line_art_prepare_async_func (GimpAsync   *async,
                                   LineArtData *data)
 {
   GeglBuffer *buffer;
+  GeglBuffer *strokes;
   GeglBuffer *closed  = NULL;
   gfloat     *distmap = NULL;
   gint        buffer_x;
   gint        buffer_y;
   gboolean    has_alpha;
   gboolean    select_transparent = FALSE;
+  gboolean    reused             = FALSE;
 
   has_alpha = babl_format_has_alpha (gegl_buffer_get_format (data->buffer));
 
@@ -772,43 +880,68 @@ gimp_line_art_prepare_async_func (GimpAsync   *async,
    */
   GIMP_TIMER_START();
 
-  closed = gimp_line_art_close (buffer,
-                                select_transparent,
-                                data->threshold,
-                                data->automatic_closure,
-                                data->spline_max_len,
-                                data->segment_max_len,
-                                /*minimal_lineart_area,*/
-                                5,
-                                /*normal_estimate_mask_size,*/
-                                5,
-                                /*end_point_rate,*/
-                                0.85,
-                                /*spline_max_angle,*/
-                                90.0,
-                                /*end_point_connectivity,*/
-                                2,
-                                /*spline_roundness,*/
-                                1.0,
-                                /*allow_self_intersections,*/
-                                TRUE,
-                                /*created_regions_significant_area,*/
-                                4,
-                                /*created_regions_minimum_area,*/
-                                100,
-                                /*small_segments_from_spline_sources,*/
-                                TRUE,
-                                &distmap,
-                                async);
-
-  GIMP_TIMER_END("close line-art");
+  strokes = gimp_line_art_binarize (buffer,
+                                    select_transparent,
+                                    data->threshold,
+                                    /*minimal_lineart_area,*/
+                                    5,
+                                    async);
 
   if (buffer != data->buffer)
     g_object_unref (buffer);
 
+  if (! strokes)
+    {
+      line_art_data_free (data);
+
+      return;
+    }
+
+  /* Edits which don't change the binarized strokes, such as coloring
+   * under the line art, leave the closed line art unchanged.
+   */
+  if (data->prev_strokes &&
+      gegl_rectangle_equal (gegl_buffer_get_extent (data->prev_closed),
+                            gegl_buffer_get_extent (data->buffer)) &&
+      gimp_line_art_strokes_equal (strokes, data->prev_strokes, async))
+    {
+      closed  = g_object_ref (data->prev_closed);
+      distmap = g_steal_pointer (&data->prev_distmap);
+      reused  = TRUE;
+    }
+  else if (! gimp_async_is_stopped (async))
+    {
+      closed = gimp_line_art_close (strokes,
+                                    data->automatic_closure,
+                                    data->spline_max_len,
+                                    data->segment_max_len,
+                                    /*normal_estimate_mask_size,*/
+                                    5,
+                                    /*end_point_rate,*/
+                                    0.85,
+                                    /*spline_max_angle,*/
+                                    90.0,
+                                    /*end_point_connectivity,*/
+                                    2,
+                                    /*spline_roundness,*/
+                                    1.0,
+                                    /*allow_self_intersections,*/
+                                    TRUE,
+                                    /*created_regions_significant_area,*/
+                                    4,
+                                    /*created_regions_minimum_area,*/
+                                    100,
+                                    /*small_segments_from_spline_sources,*/
+                                    TRUE,
+                                    &distmap,
+                                    async);
+    }
+
+  GIMP_TIMER_END("close line-art");
+
   if (! gimp_async_is_stopped (async))
     {
-      if (buffer_x != 0 || buffer_y != 0)
+      if (! reused && (buffer_x != 0 || buffer_y != 0))
         {
           buffer = g_object_new (GEGL_TYPE_BUFFER,
                                  "source",  closed,
@@ -822,9 +955,16 @@ gimp_line_art_prepare_async_func (GimpAsync   *async,
         }
 
       gimp_async_finish_full (async,
-                              line_art_result_new (closed, distmap),
+                              line_art_result_new (closed, distmap, strokes),
                               (GDestroyNotify) line_art_result_free);
     }
+  else
+    {
+      g_clear_object (&closed);
+      g_free (distmap);
+    }
+
+  g_object_unref (strokes);
 
   line_art_data_free (data);
 }
@@ -841,6 +981,19 @@ line_art_data_new (GeglBuffer  *buffer,
   data->automatic_closure  = line_art->priv->automatic_closure;
   data->spline_max_len     = line_art->priv->spline_max_len;
   data->segment_max_len    = line_art->priv->segment_max_len;
+  data->prev_strokes       = NULL;
+  data->prev_closed        = NULL;
+  data->prev_distmap       = NULL;
+
+  /* The closed line art is only kept along with its strokes as long as
+   * the closure settings don't change.
+   */
+  if (line_art->priv->strokes && line_art->priv->distmap)
+    {
+      data->prev_strokes = g_object_ref (line_art->priv->strokes);
+      data->prev_closed  = g_object_ref (line_art->priv->closed);
+      data->prev_distmap = g_steal_pointer (&line_art->priv->distmap);
+    }
 
   return data;
 }
@@ -849,19 +1002,24 @@ static void
 line_art_data_free (LineArtData *data)
 {
   g_object_unref (data->buffer);
+  g_clear_object (&data->prev_strokes);
+  g_clear_object (&data->prev_closed);
+  g_clear_pointer (&data->prev_distmap, g_free);
 
   g_slice_free (LineArtData, data);
 }
 
 static LineArtResult *
 line_art_result_new (GeglBuffer *closed,
-                     gfloat     *distmap)
+                     gfloat     *distmap,
+                     GeglBuffer *strokes)
 {
   LineArtResult *data;
 
   data = g_slice_new (LineArtResult);
   data->closed  = closed;
   data->distmap = distmap;
+  data->strokes = g_object_ref (strokes);
 
   return data;
 }
@@ -870,6 +1028,7 @@ static void
 line_art_result_free (LineArtResult *data)
 {
   g_object_unref (data->closed);
+  g_object_unref (data->strokes);
   g_clear_pointer (&data->distmap, g_free);
 
   g_slice_free (LineArtResult, data);
@@ -901,12 +1060,216 @@ gimp_line_art_input_invalidate_preview (GimpViewable *viewable,
 /* All actual computation functions. */
 
 /**
- * gimp_line_art_close:
+ * gimp_line_art_binarize:
  * @buffer: the input #GeglBuffer.
  * @select_transparent: whether we binarize the alpha channel or the
  *                      luminosity.
  * @stroke_threshold: [0-1] threshold value for detecting stroke pixels
  *                    (higher values will detect more stroke pixels).
+ * @minimal_lineart_area: the minimum size in number pixels for area to
+ *                        be considered as line art.
+ * @async: the #GimpAsync associated with the computation
+ *
+ * Creates a binarized version of the strokes of @buffer, detected either
+ * with luminosity (light means background) or alpha values depending on
+ * @select_transparent, and removes the strokes smaller than
+ * @minimal_lineart_area.
+ *
+ * Returns: a new #GeglBuffer of format "Y' u8", where 1 is stroke and 0
+ *          background, or %NULL if @async was canceled.
+ */
+static GeglBuffer *
+gimp_line_art_binarize (GeglBuffer *buffer,
+                        gboolean    select_transparent,
+                        gdouble     stroke_threshold,
+                        gint        minimal_lineart_area,
+                        GimpAsync  *async)
+{
+  const Babl   *gray_format;
+  GeglBuffer   *strokes;
+  BinarizeData  data;
+
+  if (select_transparent)
+    /* Keep alpha channel as gray levels */
+    gray_format = babl_format ("A u8");
+  else
+    /* Keep luminance */
+    gray_format = babl_format ("Y' u8");
+
+  /* Transform the line art from any format to gray. */
+  strokes = gegl_buffer_new (gegl_buffer_get_extent (buffer),
+                             gray_format);
+  gimp_gegl_buffer_copy (buffer, NULL, GEGL_ABYSS_NONE, strokes, NULL);
+  gegl_buffer_set_format (strokes, babl_format ("Y' u8"));
+
+  data.buffer             = strokes;
+  data.select_transparent = select_transparent;
+  data.threshold          = (guchar) (255.0f * (1.0f - stroke_threshold));
+  data.max_value          = 0;
+  data.async              = async;
+
+  g_mutex_init (&data.mutex);
+
+  if (! select_transparent)
+    {
+      /* Compute the biggest value */
+      gegl_parallel_distribute_area (
+        gegl_buffer_get_extent (strokes), PIXELS_PER_THREAD,
+        GEGL_SPLIT_STRATEGY_AUTO,
+        (GeglParallelDistributeAreaFunc) gimp_line_art_binarize_max_area,
+        &data);
+    }
+
+  /* Make the image binary: 1 is stroke, 0 background */
+  if (! gimp_async_is_canceled (async))
+    {
+      gegl_parallel_distribute_area (
+        gegl_buffer_get_extent (strokes), PIXELS_PER_THREAD,
+        GEGL_SPLIT_STRATEGY_AUTO,
+        (GeglParallelDistributeAreaFunc) gimp_line_art_binarize_area,
+        &data);
+    }
+
+  g_mutex_clear (&data.mutex);
+
+  if (gimp_async_is_canceled (async))
+    {
+      gimp_async_abort (async);
+
+      g_object_unref (strokes);
+
+      return NULL;
+    }
+
+  /* Denoise (remove small connected components) */
+  gimp_lineart_denoise (strokes, minimal_lineart_area, async);
+  if (gimp_async_is_stopped (async))
+    g_clear_object (&strokes);
+
+  return strokes;
+}
+
+static void
+gimp_line_art_binarize_max_area (const GeglRectangle *area,
+                                 BinarizeData        *data)
+{
+  GeglBufferIterator *gi;
+  guchar              max_value = 0;
+
+  gi = gegl_buffer_iterator_new (data->buffer, area, 0, NULL,
+                                 GEGL_ACCESS_READ, GEGL_ABYSS_NONE, 1);
+  while (gegl_buffer_iterator_next (gi))
+    {
+      guchar *p = (guchar*) gi->items[0].data;
+      gint    k;
+
+      if (gimp_async_is_canceled (data->async))
+        {
+          gegl_buffer_iterator_stop (gi);
+
+          return;
+        }
+
+      for (k = 0; k < gi->length; k++)
+        {
+          if (*p > max_value)
+            max_value = *p;
+          p++;
+        }
+    }
+
+  g_mutex_lock (&data->mutex);
+
+  data->max_value = MAX (data->max_value, max_value);
+
+  g_mutex_unlock (&data->mutex);
+}
+
+static void
+gimp_line_art_binarize_area (const GeglRectangle *area,
+                             BinarizeData        *data)
+{
+  GeglBufferIterator *gi;
+
+  gi = gegl_buffer_iterator_new (data->buffer, area, 0, NULL,
+                                 GEGL_ACCESS_READWRITE, GEGL_ABYSS_NONE, 1);
+  while (gegl_buffer_iterator_next (gi))
+    {
+      guchar *p = (guchar*) gi->items[0].data;
+      gint    k;
+
+      if (gimp_async_is_canceled (data->async))
+        {
+          gegl_buffer_iterator_stop (gi);
+
+          return;
+        }
+
+      for (k = 0; k < gi->length; k++)
+        {
+          if (! data->select_transparent)
+            /* Negate the value. */
+            *p = data->max_value - *p;
+          /* Apply a threshold. */
+          if (*p > data->threshold)
+            *p = 1;
+          else
+            *p = 0;
+          p++;
+        }
+    }
+}
+
+/**
+ * gimp_line_art_strokes_equal:
+ * @strokes1: binarized strokes.
+ * @strokes2: other binarized strokes.
+ * @async: the #GimpAsync associated with the computation
+ *
+ * Returns: %TRUE if @strokes1 and @strokes2 have the same extent and
+ *          contents.
+ */
+static gboolean
+gimp_line_art_strokes_equal (GeglBuffer *strokes1,
+                             GeglBuffer *strokes2,
+                             GimpAsync  *async)
+{
+  GeglBufferIterator *gi;
+
+  if (! gegl_rectangle_equal (gegl_buffer_get_extent (strokes1),
+                              gegl_buffer_get_extent (strokes2)))
+    return FALSE;
+
+  gi = gegl_buffer_iterator_new (strokes1, NULL, 0, NULL,
+                                 GEGL_ACCESS_READ, GEGL_ABYSS_NONE, 2);
+  gegl_buffer_iterator_add (gi, strokes2, NULL, 0, NULL,
+                            GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
+  while (gegl_buffer_iterator_next (gi))
+    {
+      if (gimp_async_is_canceled (async))
+        {
+          gegl_buffer_iterator_stop (gi);
+
+          gimp_async_abort (async);
+
+          return FALSE;
+        }
+
+      if (memcmp (gi->items[0].data, gi->items[1].data, gi->length))
+        {
+          gegl_buffer_iterator_stop (gi);
+
+          return FALSE;
+        }
+    }
+
+  return TRUE;
+}
+
+/**
+ * gimp_line_art_close:
+ * @strokes: the binarized strokes, as returned by
+ *           gimp_line_art_binarize().
  * @automatic_closure: whether the closing step should be performed or
  *                     not. @spline_max_length and @segment_max_len are
  *                     used only if @automatic_closure is %TRUE.
@@ -915,8 +1278,6 @@ gimp_line_art_input_invalidate_preview (GimpViewable *viewable,
  * @segment_max_length: the maximum length for creating segments
  *                      between end points. Unlike splines, segments
  *                      are straight lines.
- * @minimal_lineart_area: the minimum size in number pixels for area to
- *                        be considered as line art.
  * @normal_estimate_mask_size:
  * @end_point_rate: threshold to estimate if a curvature is an end-point
  *                  in [0-1] range value.
@@ -932,9 +1293,7 @@ gimp_line_art_input_invalidate_preview (GimpViewable *viewable,
  * @closed_distmap: a distance map of the closed line art pixels.
  * @async: the #GimpAsync associated with the computation
  *
- * Creates a binarized version of the strokes of @buffer, detected either
- * with luminosity (light means background) or alpha values depending on
- * @select_transparent. This binary version of the strokes will have closed
+ * Closes the binarized @strokes, so that they will have closed
  * regions allowing adequate selection of "nearly closed regions".
  * This algorithm is meant for digital painting (and in particular on the
  * sketch-only step), and therefore will likely produce unexpected results on
@@ -951,13 +1310,10 @@ gimp_line_art_input_invalidate_preview (GimpViewable *viewable,
  *          for overflowing created masks later.
  */
 static GeglBuffer *
-gimp_line_art_close (GeglBuffer  *buffer,
-                     gboolean     select_transparent,
-                     gdouble      stroke_threshold,
+gimp_line_art_close (GeglBuffer  *strokes,
                      gboolean     automatic_closure,
                      gint         spline_max_length,
                      gint         segment_max_length,
-                     gint         minimal_lineart_area,
                      gint         normal_estimate_mask_size,
                      gfloat       end_point_rate,
                      gfloat       spline_max_angle,
@@ -970,91 +1326,13 @@ gimp_line_art_close (GeglBuffer  *buffer,
                      gfloat     **closed_distmap,
                      GimpAsync   *async)
 {
-  const Babl         *gray_format;
-  GeglBufferIterator *gi;
-  GeglBuffer         *closed  = NULL;
-  GeglBuffer         *strokes = NULL;
-  guchar              max_value = 0;
-  gint                width  = gegl_buffer_get_width (buffer);
-  gint                height = gegl_buffer_get_height (buffer);
-  gint                i;
-
-  if (select_transparent)
-    /* Keep alpha channel as gray levels */
-    gray_format = babl_format ("A u8");
-  else
-    /* Keep luminance */
-    gray_format = babl_format ("Y' u8");
-
-  /* Transform the line art from any format to gray. */
-  strokes = gegl_buffer_new (gegl_buffer_get_extent (buffer),
-                             gray_format);
-  gimp_gegl_buffer_copy (buffer, NULL, GEGL_ABYSS_NONE, strokes, NULL);
-  gegl_buffer_set_format (strokes, babl_format ("Y' u8"));
-
-  if (! select_transparent)
-    {
-      /* Compute the biggest value */
-      gi = gegl_buffer_iterator_new (strokes, NULL, 0, NULL,
-                                     GEGL_ACCESS_READ, GEGL_ABYSS_NONE, 1);
-      while (gegl_buffer_iterator_next (gi))
-        {
-          guchar *data = (guchar*) gi->items[0].data;
-          gint    k;
-
-          if (gimp_async_is_canceled (async))
-            {
-              gegl_buffer_iterator_stop (gi);
-
-              gimp_async_abort (async);
-
-              goto end1;
-            }
-
-          for (k = 0; k < gi->length; k++)
-            {
-              if (*data > max_value)
-                max_value = *data;
-              data++;
-            }
-        }
-    }
-
-  /* Make the image binary: 1 is stroke, 0 background */
-  gi = gegl_buffer_iterator_new (strokes, NULL, 0, NULL,
-                                 GEGL_ACCESS_READWRITE, GEGL_ABYSS_NONE, 1);
-  while (gegl_buffer_iterator_next (gi))
-    {
-      guchar *data = (guchar*) gi->items[0].data;
-      gint    k;
-
-      if (gimp_async_is_canceled (async))
-        {
-          gegl_buffer_iterator_stop (gi);
-
-          gimp_async_abort (async);
-
-          goto end1;
-        }
-
-      for (k = 0; k < gi->length; k++)
-        {
-          if (! select_transparent)
-            /* Negate the value. */
-            *data = max_value - *data;
-          /* Apply a threshold. */
-          if (*data > (guchar) (255.0f * (1.0f - stroke_threshold)))
-            *data = 1;
-          else
-            *data = 0;
-          data++;
-        }
-    }
+  GeglBuffer *closed = NULL;
+  gint        width  = gegl_buffer_get_width (strokes);
+  gint        height = gegl_buffer_get_height (strokes);
+  gint        i;
 
-  /* Denoise (remove small connected components) */
-  gimp_lineart_denoise (strokes, minimal_lineart_area, async);
-  if (gimp_async_is_stopped (async))
-    goto end1;
+  /* Work on our own copy, which may get closed in-place. */
+  strokes = gimp_gegl_buffer_dup (strokes);
 
   closed = g_object_ref (strokes);
 
@@ -1067,8 +1345,7 @@ gimp_line_art_close (GeglBuffer  *buffer,
       gfloat     *normals             = NULL;
       gfloat     *curvatures          = NULL;
       gfloat     *smoothed_curvatures = NULL;
-      gfloat      threshold;
-      gfloat      clamped_threshold;
+      PixelsData  data;
       GList      *fill_pixels         = NULL;
       GList      *iter;
 
@@ -1087,27 +1364,25 @@ gimp_line_art_close (GeglBuffer  *buffer,
       radii = gimp_lineart_estimate_strokes_radii (strokes, async);
       if (gimp_async_is_stopped (async))
         goto end2;
-      threshold = 1.0f - end_point_rate;
-      clamped_threshold = MAX (0.25f, threshold);
-      for (i = 0; i < width; i++)
-        {
-          gint j;
 
-          if (gimp_async_is_canceled (async))
-            {
-              gimp_async_abort (async);
+      data.curvatures          = curvatures;
+      data.smoothed_curvatures = smoothed_curvatures;
+      data.radii               = radii;
+      data.threshold           = 1.0f - end_point_rate;
+      data.clamped_threshold   = MAX (0.25f, data.threshold);
+      data.width               = width;
+      data.async               = async;
 
-              goto end2;
-            }
+      gegl_parallel_distribute_range (
+        height, PIXELS_PER_THREAD / width,
+        (GeglParallelDistributeRangeFunc) gimp_lineart_end_points_range,
+        &data);
 
-          for (j = 0; j < height; j++)
-            {
-              if (smoothed_curvatures[i + j * width] >= (threshold / MAX (1.0f, radii[i + j * width])) ||
-                  curvatures[i + j * width] >= clamped_threshold)
-                curvatures[i + j * width] = 1.0;
-              else
-                curvatures[i + j * width] = 0.0;
-            }
+      if (gimp_async_is_canceled (async))
+        {
+          gimp_async_abort (async);
+
+          goto end2;
         }
       g_clear_pointer (&radii, g_free);
 
@@ -1357,6 +1632,34 @@ gimp_line_art_close (GeglBuffer  *buffer,
   return closed;
 }
 
+static void
+gimp_lineart_end_points_range (gsize       offset,
+                               gsize       size,
+                               PixelsData *data)
+{
+  gint j;
+
+  for (j = offset; j < offset + size; j++)
+    {
+      gfloat *curvatures          = data->curvatures          + j * data->width;
+      gfloat *smoothed_curvatures = data->smoothed_curvatures + j * data->width;
+      gfloat *radii               = data->radii               + j * data->width;
+      gint    i;
+
+      if (gimp_async_is_canceled (data->async))
+        return;
+
+      for (i = 0; i < data->width; i++)
+        {
+          if (smoothed_curvatures[i] >= (data->threshold / MAX (1.0f, radii[i])) ||
+              curvatures[i] >= data->clamped_threshold)
+            curvatures[i] = 1.0;
+          else
+            curvatures[i] = 0.0;
+        }
+    }
+}
+
 static void
 gimp_lineart_denoise (GeglBuffer *buffer,
                       int         minimum_area,
@@ -1577,11 +1880,12 @@ gimp_lineart_compute_normals_curvatures (GeglBuffer *mask,
                                          int         normal_estimate_mask_size,
                                          GimpAsync  *async)
 {
-  gfloat  *edgels_curvatures  = NULL;
-  gfloat  *smoothed_curvature;
-  GArray  *es                 = NULL;
-  Edgel  **e;
-  gint     width              = gegl_buffer_get_width (mask);
+  gfloat     *edgels_curvatures  = NULL;
+  gfloat     *smoothed_curvature;
+  GArray     *es                 = NULL;
+  Edgel     **e;
+  PixelsData  data;
+  gint        width              = gegl_buffer_get_width (mask);
 
   es = gimp_edgelset_new (mask, async);
   if (gimp_async_is_stopped (async))
@@ -1615,22 +1919,21 @@ gimp_lineart_compute_normals_curvatures (GeglBuffer *mask,
                                                    curvatures[(*e)->x + (*e)->y * width]);
       e++;
     }
-  for (int y = 0; y < gegl_buffer_get_height (mask); ++y)
-    {
-      if (gimp_async_is_canceled (async))
-        {
-          gimp_async_abort (async);
 
-          goto end;
-        }
+  data.normals = normals;
+  data.width   = width;
+  data.async   = async;
 
-      for (int x = 0; x < gegl_buffer_get_width (mask); ++x)
-        {
-          const float _angle = atan2f (normals[(x + y * width) * 2 + 1],
-                                       normals[(x + y * width) * 2]);
-          normals[(x + y * width) * 2] = cosf (_angle);
-          normals[(x + y * width) * 2 + 1] = sinf (_angle);
-        }
+  gegl_parallel_distribute_range (
+    gegl_buffer_get_height (mask), PIXELS_PER_THREAD / width,
+    (GeglParallelDistributeRangeFunc) gimp_lineart_normalize_normals_range,
+    &data);
+
+  if (gimp_async_is_canceled (async))
+    {
+      gimp_async_abort (async);
+
+      goto end;
     }
 
   /* Smooth curvatures on edgels, then take maximum on each pixel. */
@@ -1659,39 +1962,88 @@ gimp_lineart_compute_normals_curvatures (GeglBuffer *mask,
     g_array_free (es, TRUE);
 }
 
+static void
+gimp_lineart_normalize_normals_range (gsize       offset,
+                                      gsize       size,
+                                      PixelsData *data)
+{
+  gint y;
+
+  for (y = offset; y < offset + size; y++)
+    {
+      gfloat *normals = data->normals + y * data->width * 2;
+      gint    x;
+
+      if (gimp_async_is_canceled (data->async))
+        return;
+
+      for (x = 0; x < data->width; x++)
+        {
+          const float _angle = atan2f (normals[x * 2 + 1], normals[x * 2]);
+
+          normals[x * 2]     = cosf (_angle);
+          normals[x * 2 + 1] = sinf (_angle);
+        }
+    }
+}
+
 static gfloat *
 gimp_lineart_get_smooth_curvatures (GArray    *edgelset,
                                     GimpAsync *async)
 {
-  Edgel  **e;
-  gfloat  *smoothed_curvatures = g_new0 (gfloat, edgelset->len);
-  gfloat   weights[9];
-  gfloat   smoothed_curvature;
-  gfloat   weights_sum;
-  gint     idx = 0;
+  EdgelsetData  data;
+  gfloat       *smoothed_curvatures = g_new0 (gfloat, edgelset->len);
+  gfloat        weights[9];
 
   weights[0] = 1.0f;
   for (int i = 1; i <= 8; ++i)
     weights[i] = expf (-(i * i) / 30.0f);
 
-  e = (Edgel **) edgelset->data;
-  while (*e)
+  data.set                 = edgelset;
+  data.weights             = weights;
+  data.smoothed_curvatures = smoothed_curvatures;
+  data.async               = async;
+
+  gegl_parallel_distribute_range (
+    edgelset->len, EDGELS_PER_THREAD,
+    (GeglParallelDistributeRangeFunc) gimp_lineart_get_smooth_curvatures_range,
+    &data);
+
+  if (gimp_async_is_canceled (async))
     {
-      Edgel *edgel_before = g_array_index (edgelset, Edgel*, (*e)->previous);
-      Edgel *edgel_after  = g_array_index (edgelset, Edgel*, (*e)->next);
-      int    n = 5;
-      int    i = 1;
+      gimp_async_abort (async);
 
-      if (gimp_async_is_canceled (async))
-        {
-          gimp_async_abort (async);
+      g_free (smoothed_curvatures);
 
-          g_free (smoothed_curvatures);
+      return NULL;
+    }
 
-          return NULL;
-        }
+  return smoothed_curvatures;
+}
+
+static void
+gimp_lineart_get_smooth_curvatures_range (gsize         offset,
+                                          gsize         size,
+                                          EdgelsetData *data)
+{
+  GArray       *edgelset = data->set;
+  const gfloat *weights  = data->weights;
+  gint          idx;
 
-      smoothed_curvature = (*e)->curvature;
+  for (idx = offset; idx < offset + size; idx++)
+    {
+      Edgel  *e            = g_array_index (edgelset, Edgel*, idx);
+      Edgel  *edgel_before = g_array_index (edgelset, Edgel*, e->previous);
+      Edgel  *edgel_after  = g_array_index (edgelset, Edgel*, e->next);
+      gfloat  smoothed_curvature;
+      gfloat  weights_sum;
+      int     n = 5;
+      int     i = 1;
+
+      if (gimp_async_is_canceled (data->async))
+        return;
+
+      smoothed_curvature = e->curvature;
       weights_sum = weights[0];
       while (n-- && (edgel_after != edgel_before))
         {
@@ -1703,12 +2055,8 @@ gimp_lineart_get_smooth_curvatures (GArray    *edgelset,
           i++;
         }
       smoothed_curvature /= weights_sum;
-      smoothed_curvatures[idx++] = smoothed_curvature;
-
-      e++;
+      data->smoothed_curvatures[idx] = smoothed_curvature;
     }
-
-  return smoothed_curvatures;
 }
 
 /**
@@ -2320,14 +2668,14 @@ static gfloat *
 gimp_lineart_estimate_strokes_radii (GeglBuffer *mask,
                                      GimpAsync  *async)
 {
-  GeglBufferIterator *gi;
-  gfloat             *dist;
-  gfloat             *thickness;
-  GeglNode           *graph;
-  GeglNode           *input;
-  GeglNode           *op;
-  gint                width  = gegl_buffer_get_width (mask);
-  gint                height = gegl_buffer_get_height (mask);
+  PixelsData  data;
+  gfloat     *dist;
+  gfloat     *thickness;
+  GeglNode   *graph;
+  GeglNode   *input;
+  GeglNode   *op;
+  gint        width  = gegl_buffer_get_width (mask);
+  gint        height = gegl_buffer_get_height (mask);
 
   /* Compute a distance map for the line art. */
   dist = g_new (gfloat, width * height);
@@ -2348,7 +2696,44 @@ gimp_lineart_estimate_strokes_radii (GeglBuffer *mask,
   g_object_unref (graph);
 
   thickness = g_new0 (gfloat, width * height);
-  gi = gegl_buffer_iterator_new (mask, NULL, 0, NULL,
+
+  data.mask   = mask;
+  data.dist   = dist;
+  data.radii  = thickness;
+  data.width  = width;
+  data.height = height;
+  data.async  = async;
+
+  /*  Each stroke pixel only writes its own radius.  */
+  gegl_parallel_distribute_area (
+    gegl_buffer_get_extent (mask), PIXELS_PER_THREAD,
+    GEGL_SPLIT_STRATEGY_AUTO,
+    (GeglParallelDistributeAreaFunc) gimp_lineart_estimate_strokes_radii_area,
+    &data);
+
+  if (gimp_async_is_canceled (async))
+    gimp_async_abort (async);
+
+  g_free (dist);
+
+  if (gimp_async_is_stopped (async))
+    g_clear_pointer (&thickness, g_free);
+
+  return thickness;
+}
+
+static void
+gimp_lineart_estimate_strokes_radii_area (const GeglRectangle *area,
+                                          PixelsData          *data)
+{
+  GeglBufferIterator *gi;
+  gint                width  = data->width;
+  gint                height = data->height;
+
+  if (gimp_async_is_canceled (data->async))
+    return;
+
+  gi = gegl_buffer_iterator_new (data->mask, area, 0, NULL,
                                  GEGL_ACCESS_READ, GEGL_ABYSS_NONE, 1);
   while (gegl_buffer_iterator_next (gi))
     {
@@ -2360,19 +2745,17 @@ gimp_lineart_estimate_strokes_radii (GeglBuffer *mask,
       gint    x;
       gint    y;
 
-      if (gimp_async_is_canceled (async))
+      if (gimp_async_is_canceled (data->async))
         {
           gegl_buffer_iterator_stop (gi);
 
-          gimp_async_abort (async);
-
-          goto end;
+          break;
         }
 
       for (y = starty; y < endy; y++)
         for (x = startx; x < endx; x++)
           {
-            if (*m && dist[x + y * width] == 1.0)
+            if (*m && data->dist[x + y * width] == 1.0)
               {
                 gint     dx = x;
                 gint     dy = y;
@@ -2390,14 +2773,14 @@ gimp_lineart_estimate_strokes_radii (GeglBuffer *mask,
                     neighbour_thicker = FALSE;
                     if (px >= 0)
                       {
-                        if ((nd = dist[px + dy * width]) > d)
+                        if ((nd = data->dist[px + dy * width]) > d)
                           {
                             d = nd;
                             dx = px;
                             neighbour_thicker = TRUE;
                             continue;
                           }
-                        if (py >= 0 && (nd = dist[px + py * width]) > d)
+                        if (py >= 0 && (nd = data->dist[px + py * width]) > d)
                           {
                             d = nd;
                             dx = px;
@@ -2405,7 +2788,7 @@ gimp_lineart_estimate_strokes_radii (GeglBuffer *mask,
                             neighbour_thicker = TRUE;
                             continue;
                           }
-                        if (ny < height && (nd = dist[px + ny * width]) > d)
+                        if (ny < height && (nd = data->dist[px + ny * width]) > d)
                           {
                             d = nd;
                             dx = px;
@@ -2416,14 +2799,14 @@ gimp_lineart_estimate_strokes_radii (GeglBuffer *mask,
                       }
                     if (nx < width)
                       {
-                        if ((nd = dist[nx + dy * width]) > d)
+                        if ((nd = data->dist[nx + dy * width]) > d)
                           {
                             d = nd;
                             dx = nx;
                             neighbour_thicker = TRUE;
                             continue;
                           }
-                        if (py >= 0 && (nd = dist[nx + py * width]) > d)
+                        if (py >= 0 && (nd = data->dist[nx + py * width]) > d)
                           {
                             d = nd;
                             dx = nx;
@@ -2431,7 +2814,7 @@ gimp_lineart_estimate_strokes_radii (GeglBuffer *mask,
                             neighbour_thicker = TRUE;
                             continue;
                           }
-                        if (ny < height && (nd = dist[nx + ny * width]) > d)
+                        if (ny < height && (nd = data->dist[nx + ny * width]) > d)
                           {
                             d = nd;
                             dx = nx;
@@ -2440,14 +2823,14 @@ gimp_lineart_estimate_strokes_radii (GeglBuffer *mask,
                             continue;
                           }
                       }
-                    if (py > 0 && (nd = dist[dx + py * width]) > d)
+                    if (py > 0 && (nd = data->dist[dx + py * width]) > d)
                       {
                         d = nd;
                         dy = py;
                         neighbour_thicker = TRUE;
                         continue;
                       }
-                    if (ny < height && (nd = dist[dx + ny * width]) > d)
+                    if (ny < height && (nd = data->dist[dx + ny * width]) > d)
                       {
                         d = nd;
                         dy = ny;
@@ -2455,19 +2838,12 @@ gimp_lineart_estimate_strokes_radii (GeglBuffer *mask,
                         continue;
                       }
                   }
-                thickness[(gint) x + (gint) y * width] = d;
+                data->radii[(gint) x + (gint) y * width] = d;
               }
             m++;
           }
     }
 
- end:
-  g_free (dist);
-
-  if (gimp_async_is_stopped (async))
-    g_clear_pointer (&thickness, g_free);
-
-  return thickness;
 }
 
 static void
@@ -2694,11 +3070,12 @@ static GArray *
 gimp_edgelset_new (GeglBuffer *buffer,
                    GimpAsync  *async)
 {
-  GeglBufferIterator *gi;
-  GArray             *set;
-  GHashTable         *edgel2index;
-  gint                width  = gegl_buffer_get_width (buffer);
-  gint                height = gegl_buffer_get_height (buffer);
+  EdgelsData  data;
+  GArray     *set;
+  GHashTable *edgel2index;
+  GSList     *iter;
+  gint        width  = gegl_buffer_get_width (buffer);
+  gint        height = gegl_buffer_get_height (buffer);
 
   set = g_array_new (TRUE, TRUE, sizeof (Edgel *));
   g_array_set_clear_func (set, (GDestroyNotify) gimp_edgel_clear);
@@ -2709,15 +3086,103 @@ gimp_edgelset_new (GeglBuffer *buffer,
   edgel2index = g_hash_table_new ((GHashFunc) edgel2index_hash_fun,
                                   (GEqualFunc) edgel2index_equal_fun);
 
-  gi = gegl_buffer_iterator_new (buffer, GEGL_RECTANGLE (0, 0, width, height),
+  /* Extract the edgels of separate areas in parallel, then gather them
+   * in a fixed order, so that the set does not depend on the threading.
+   */
+  data.buffer = buffer;
+  data.chunks = NULL;
+  data.async  = async;
+  g_mutex_init (&data.mutex);
+
+  gegl_parallel_distribute_area (
+    GEGL_RECTANGLE (0, 0, width, height), PIXELS_PER_THREAD,
+    GEGL_SPLIT_STRATEGY_AUTO,
+    (GeglParallelDistributeAreaFunc) gimp_edgelset_new_area,
+    &data);
+
+  g_mutex_clear (&data.mutex);
+
+  data.chunks = g_slist_sort (data.chunks,
+                              (GCompareFunc) gimp_edgelset_chunk_cmp);
+
+  for (iter = data.chunks; iter; iter = g_slist_next (iter))
+    {
+      EdgelsChunk *chunk = iter->data;
+      gint         i;
+
+      for (i = 0; i < chunk->edgels->len; i++)
+        {
+          Edgel *edgel    = g_array_index (chunk->edgels, Edgel *, i);
+          guint  position = set->len;
+
+          g_array_append_val (set, edgel);
+          g_hash_table_insert (edgel2index, edgel,
+                               GUINT_TO_POINTER (position));
+        }
+
+      g_array_free (chunk->edgels, TRUE);
+      g_slice_free (EdgelsChunk, chunk);
+    }
+
+  g_slist_free (data.chunks);
+
+  if (gimp_async_is_canceled (async))
+    {
+      gimp_async_abort (async);
+
+      goto end;
+    }
+
+  gimp_edgelset_build_graph (set, buffer, edgel2index, async);
+  if (gimp_async_is_stopped (async))
+    goto end;
+
+  gimp_edgelset_init_normals (set);
+
+ end:
+  g_hash_table_destroy (edgel2index);
+
+  if (gimp_async_is_stopped (async))
+    {
+      g_array_free (set, TRUE);
+      set = NULL;
+    }
+
+  return set;
+}
+
+static void
+gimp_edgelset_new_area (const GeglRectangle *area,
+                        EdgelsData          *data)
+{
+  GeglBufferIterator *gi;
+  EdgelsChunk        *chunk;
+  GArray             *edgels;
+
+  if (gimp_async_is_canceled (data->async))
+    return;
+
+  edgels = g_array_new (FALSE, FALSE, sizeof (Edgel *));
+
+  gi = gegl_buffer_iterator_new (data->buffer,
+                                 GEGL_RECTANGLE (area->x, area->y,
+                                                 area->width, area->height),
                                  0, NULL, GEGL_ACCESS_READ, GEGL_ABYSS_NONE, 5);
-  gegl_buffer_iterator_add (gi, buffer, GEGL_RECTANGLE (0, -1, width, height),
+  gegl_buffer_iterator_add (gi, data->buffer,
+                            GEGL_RECTANGLE (area->x, area->y - 1,
+                                            area->width, area->height),
                             0, NULL, GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
-  gegl_buffer_iterator_add (gi, buffer, GEGL_RECTANGLE (0, 1, width, height),
+  gegl_buffer_iterator_add (gi, data->buffer,
+                            GEGL_RECTANGLE (area->x, area->y + 1,
+                                            area->width, area->height),
                             0, NULL, GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
-  gegl_buffer_iterator_add (gi, buffer, GEGL_RECTANGLE (-1, 0, width, height),
+  gegl_buffer_iterator_add (gi, data->buffer,
+                            GEGL_RECTANGLE (area->x - 1, area->y,
+                                            area->width, area->height),
                             0, NULL, GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
-  gegl_buffer_iterator_add (gi, buffer, GEGL_RECTANGLE (1, 0, width, height),
+  gegl_buffer_iterator_add (gi, data->buffer,
+                            GEGL_RECTANGLE (area->x + 1, area->y,
+                                            area->width, area->height),
                             0, NULL, GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
   while (gegl_buffer_iterator_next (gi))
     {
@@ -2733,13 +3198,11 @@ gimp_edgelset_new (GeglBuffer *buffer,
       gint    x;
       gint    y;
 
-      if (gimp_async_is_canceled (async))
+      if (gimp_async_is_canceled (data->async))
         {
           gegl_buffer_iterator_stop (gi);
 
-          gimp_async_abort (async);
-
-          goto end;
+          break;
         }
 
       for (y = starty; y < endy; y++)
@@ -2747,14 +3210,28 @@ gimp_edgelset_new (GeglBuffer *buffer,
           {
             if (*(p++))
               {
+                Edgel *edgel;
+
                 if (! *prevy)
-                  gimp_edgelset_add (set, x, y, YMinusDirection, edgel2index);
+                  {
+                    edgel = gimp_edgel_new (x, y, YMinusDirection);
+                    g_array_append_val (edgels, edgel);
+                  }
                 if (! *nexty)
-                  gimp_edgelset_add (set, x, y, YPlusDirection, edgel2index);
+                  {
+                    edgel = gimp_edgel_new (x, y, YPlusDirection);
+                    g_array_append_val (edgels, edgel);
+                  }
                 if (! *prevx)
-                  gimp_edgelset_add (set, x, y, XMinusDirection, edgel2index);
+                  {
+                    edgel = gimp_edgel_new (x, y, XMinusDirection);
+                    g_array_append_val (edgels, edgel);
+                  }
                 if (! *nextx)
-                  gimp_edgelset_add (set, x, y, XPlusDirection, edgel2index);
+                  {
+                    edgel = gimp_edgel_new (x, y, XPlusDirection);
+                    g_array_append_val (edgels, edgel);
+                  }
               }
             prevy++;
             nexty++;
@@ -2763,36 +3240,29 @@ gimp_edgelset_new (GeglBuffer *buffer,
           }
     }
 
-  gimp_edgelset_build_graph (set, buffer, edgel2index, async);
-  if (gimp_async_is_stopped (async))
-    goto end;
-
-  gimp_edgelset_init_normals (set);
-
- end:
-  g_hash_table_destroy (edgel2index);
-
-  if (gimp_async_is_stopped (async))
-    {
-      g_array_free (set, TRUE);
-      set = NULL;
-    }
+  /* Even a canceled chunk is handed over, so that its edgels get freed
+   * along with the set.
+   */
+  chunk         = g_slice_new (EdgelsChunk);
+  chunk->area   = *area;
+  chunk->edgels = edgels;
 
-  return set;
+  g_mutex_lock (&data->mutex);
+  data->chunks = g_slist_prepend (data->chunks, chunk);
+  g_mutex_unlock (&data->mutex);
 }
 
-static void
-gimp_edgelset_add (GArray     *set,
-                   int         x,
-                   int         y,
-                   Direction   direction,
-                   GHashTable *edgel2index)
+static gint
+gimp_edgelset_chunk_cmp (const EdgelsChunk *chunk1,
+                         const EdgelsChunk *chunk2)
 {
-  Edgel         *edgel    = gimp_edgel_new (x, y, direction);
-  unsigned long  position = set->len;
+  if (chunk1->area.y != chunk2->area.y)
+    return chunk1->area.y < chunk2->area.y ? -1 : 1;
+
+  if (chunk1->area.x != chunk2->area.x)
+    return chunk1->area.x < chunk2->area.x ? -1 : 1;
 
-  g_array_append_val (set, edgel);
-  g_hash_table_insert (edgel2index, edgel, GUINT_TO_POINTER (position));
+  return 0;
 }
 
 static void
@@ -2815,11 +3285,10 @@ gimp_edgelset_smooth_normals (GArray    *set,
                               int        mask_size,
                               GimpAsync *async)
 {
+  EdgelsetData data;
   const gfloat sigma = mask_size * 0.775;
   const gfloat den   = 2 * sigma * sigma;
   gfloat       weights[65];
-  GimpVector2  smoothed_normal;
-  gint         i;
 
   gimp_assert (mask_size <= 65);
 
@@ -2827,20 +3296,43 @@ gimp_edgelset_smooth_normals (GArray    *set,
   for (int i = 1; i <= mask_size; ++i)
     weights[i] = expf (-(i * i) / den);
 
-  for (i = 0; i < set->len; i++)
+  data.set       = set;
+  data.weights   = weights;
+  data.mask_size = mask_size;
+  data.async     = async;
+
+  /*  Each edgel only reads the (constant) directions of its neighbors,
+   *  so that the normals can be smoothed in place concurrently.
+   */
+  gegl_parallel_distribute_range (
+    set->len, EDGELS_PER_THREAD,
+    (GeglParallelDistributeRangeFunc) gimp_edgelset_smooth_normals_range,
+    &data);
+
+  if (gimp_async_is_canceled (async))
+    gimp_async_abort (async);
+}
+
+static void
+gimp_edgelset_smooth_normals_range (gsize         offset,
+                                    gsize         size,
+                                    EdgelsetData *data)
+{
+  GArray       *set     = data->set;
+  const gfloat *weights = data->weights;
+  GimpVector2   smoothed_normal;
+  gint          i;
+
+  for (i = offset; i < offset + size; i++)
     {
       Edgel *it           = g_array_index (set, Edgel*, i);
       Edgel *edgel_before = g_array_index (set, Edgel*, it->previous);
       Edgel *edgel_after  = g_array_index (set, Edgel*, it->next);
-      int    n = mask_size;
+      int    n = data->mask_size;
       int    i = 1;
 
-      if (gimp_async_is_canceled (async))
-        {
-          gimp_async_abort (async);
-
-          return;
-        }
+      if (gimp_async_is_canceled (data->async))
+        return;
 
       smoothed_normal = Direction2Normal[it->direction];
       while (n-- && (edgel_after != edgel_before))
@@ -2863,9 +3355,29 @@ static void
 gimp_edgelset_compute_curvature (GArray    *set,
                                  GimpAsync *async)
 {
-  gint i;
+  EdgelsetData data;
 
-  for (i = 0; i < set->len; i++)
+  data.set   = set;
+  data.async = async;
+
+  gegl_parallel_distribute_range (
+    set->len, EDGELS_PER_THREAD,
+    (GeglParallelDistributeRangeFunc) gimp_edgelset_compute_curvature_range,
+    &data);
+
+  if (gimp_async_is_canceled (async))
+    gimp_async_abort (async);
+}
+
+static void
+gimp_edgelset_compute_curvature_range (gsize         offset,
+                                       gsize         size,
+                                       EdgelsetData *data)
+{
+  GArray *set = data->set;
+  gint    i;
+
+  for (i = offset; i < offset + size; i++)
     {
       Edgel       *it       = g_array_index (set, Edgel*, i);
       Edgel       *previous = g_array_index (set, Edgel *, it->previous);
@@ -2879,12 +3391,8 @@ gimp_edgelset_compute_curvature (GArray    *set,
 
       it->curvature = (crossp > 0.0f) ? c : -c;
 
-      if (gimp_async_is_canceled (async))
-        {
-          gimp_async_abort (async);
-
-          return;
-        }
+      if (gimp_async_is_canceled (data->async))
+        return;
     }
 }
 
@@ -2894,26 +3402,49 @@ gimp_edgelset_build_graph (GArray     *set,
                            GHashTable *edgel2index,
                            GimpAsync  *async)
 {
-  Edgel edgel;
-  gint  i;
+  EdgelsetData data;
+
+  data.set         = set;
+  data.buffer      = buffer;
+  data.edgel2index = edgel2index;
+  data.async       = async;
 
-  for (i = 0; i < set->len; i++)
+  /*  The hash table is only read from here on, and every edgel is the
+   *  successor of exactly one other edgel, so that each thread only
+   *  writes to links no other thread touches.
+   */
+  gegl_parallel_distribute_range (
+    set->len, EDGELS_PER_THREAD,
+    (GeglParallelDistributeRangeFunc) gimp_edgelset_build_graph_range,
+    &data);
+
+  if (gimp_async_is_canceled (async))
+    gimp_async_abort (async);
+}
+
+static void
+gimp_edgelset_build_graph_range (gsize         offset,
+                                 gsize         size,
+                                 EdgelsetData *data)
+{
+  GArray *set = data->set;
+  Edgel   edgel;
+  gint    i;
+
+  for (i = offset; i < offset + size; i++)
     {
       Edgel *neighbor;
       Edgel *it = g_array_index (set, Edgel *, i);
       guint  neighbor_pos;
 
-      if (gimp_async_is_canceled (async))
-        {
-          gimp_async_abort (async);
-
-          return;
-        }
+      if (gimp_async_is_canceled (data->async))
+        return;
 
-      gimp_edgelset_next8 (buffer, it, &edgel);
+      gimp_edgelset_next8 (data->buffer, it, &edgel);
 
-      gimp_assert (g_hash_table_contains (edgel2index, &edgel));
-      neighbor_pos = GPOINTER_TO_UINT (g_hash_table_lookup (edgel2index, &edgel));
+      gimp_assert (g_hash_table_contains (data->edgel2index, &edgel));
+      neighbor_pos = GPOINTER_TO_UINT (g_hash_table_lookup (data->edgel2index,
+                                                            &edgel));
       it->next = neighbor_pos;
       neighbor = g_array_index (set, Edgel *, neighbor_pos);
       neighbor->previous = i;
@@ -18,6 +18,7 @@
 #include "config.h"
 
 #include <stdlib.h>
+#include <string.h>
 
 #include <cairo.h>
 #include <gegl.h>
@@ -47,6 +48,13 @@ extern "C"
 #define PIXELS_PER_THREAD \
   (/* each thread costs as much as */ 64.0 * 64.0 /* pixels */)
 
+/* the size of the tiles the parallel flood fill labels independently */
+#define CONTIGUOUS_TILE_SIZE 256
+
+/* the region size past which the parallel flood fill takes over */
+#define CONTIGUOUS_MAX_FLOOD_FILL_PIXELS \
+  (4 * CONTIGUOUS_TILE_SIZE * CONTIGUOUS_TILE_SIZE)
+
 
 typedef struct
 {
@@ -55,6 +63,23 @@ typedef struct
   gint   level;
 } BorderPixel;
 
+typedef struct
+{
+  GeglRectangle  rect;
+  gint           n_labels;     /* number of border labels              */
+  gint           base;         /* offset of the labels in the tile set */
+  gint           seed_label;   /* border label of the seed pixel, or 0 */
+  gboolean       selected;     /* whether any pixel was within range   */
+  gboolean       interior;     /* whether any component misses the
+                                * tile border
+                                */
+  gint          *border;       /* border labels, 0 for unselected      */
+  gint          *top;
+  gint          *bottom;
+  gint          *left;
+  gint          *right;
+} ContiguousTile;
+
 
 /*  local function prototypes  */
 
@@ -101,7 +126,42 @@ static gboolean find_contiguous_segment   (const gfloat        *col,
                                            gint                *start,
                                            gint                *end,
                                            gfloat              *row);
-static void     find_contiguous_region    (GeglBuffer          *src_buffer,
+static gboolean find_contiguous_region    (GeglBuffer          *src_buffer,
+                                           GeglBuffer          *mask_buffer,
+                                           const Babl          *format,
+                                           gint                 n_components,
+                                           gboolean             has_alpha,
+                                           gboolean             select_transparent,
+                                           GimpSelectCriterion  select_criterion,
+                                           gboolean             antialias,
+                                           gfloat               threshold,
+                                           gboolean             diagonal_neighbors,
+                                           gint                 x,
+                                           gint                 y,
+                                           const gfloat        *col,
+                                           gint64               max_pixels);
+
+static gint     contiguous_find           (gint                *parent,
+                                           gint                 label);
+static gint     contiguous_union          (gint                *parent,
+                                           gint                 label1,
+                                           gint                 label2);
+static gint     contiguous_label_tile     (const gfloat        *mask,
+                                           gint                 width,
+                                           gint                 height,
+                                           gboolean             diagonal_neighbors,
+                                           gint                 seed_x,
+                                           gint                 seed_y,
+                                           gint                *labels,
+                                           gint                *parent,
+                                           gboolean            *interior);
+static void     contiguous_union_tiles    (gint                *parent,
+                                           const ContiguousTile *tile1,
+                                           gint                 label1,
+                                           const ContiguousTile *tile2,
+                                           gint                 label2);
+static void     find_contiguous_region_parallel
+                                          (GeglBuffer          *src_buffer,
                                            GeglBuffer          *mask_buffer,
                                            const Babl          *format,
                                            gint                 n_components,
@@ -176,11 +236,29 @@ gimp_pickable_contiguous_region_by_seed (GimpPickable        *pickable,
     {
       GIMP_TIMER_START();
 
-      find_contiguous_region (src_buffer, mask_buffer,
-                              format, n_components, has_alpha,
-                              select_transparent, select_criterion,
-                              antialias, threshold, diagonal_neighbors,
-                              x, y, start_col);
+      /*  most regions are small, grow them with the scanline flood fill,
+       *  whose cost only depends on the region's size, and only switch
+       *  to labeling the whole extent in parallel once the region turns
+       *  out to be large
+       */
+      if (! find_contiguous_region (src_buffer, mask_buffer,
+                                    format, n_components, has_alpha,
+                                    select_transparent, select_criterion,
+                                    antialias, threshold,
+                                    diagonal_neighbors,
+                                    x, y, start_col,
+                                    CONTIGUOUS_MAX_FLOOD_FILL_PIXELS))
+        {
+          gegl_buffer_clear (mask_buffer, NULL);
+
+          find_contiguous_region_parallel (src_buffer, mask_buffer,
+                                           format, n_components, has_alpha,
+                                           select_transparent,
+                                           select_criterion,
+                                           antialias, threshold,
+                                           diagonal_neighbors,
+                                           x, y, start_col);
+        }
 
       GIMP_TIMER_END("foo");
     }
@@ -419,7 +497,7 @@ gimp_pickable_contiguous_region_by_line_art (GimpPickable  *pickable,
                                     format, 1, FALSE,
                                     FALSE, GIMP_SELECT_CRITERION_COMPOSITE,
                                     FALSE, 0.0, FALSE,
-                                    x - 1, y - 1, &col);
+                                    x - 1, y - 1, &col, -1);
 
           if (x - 1 >= extent.x && x - 1 < extent.x + extent.width &&
               y >= extent.y && y < (extent.y + extent.height))
@@ -427,7 +505,7 @@ gimp_pickable_contiguous_region_by_line_art (GimpPickable  *pickable,
                                     format, 1, FALSE,
                                     FALSE, GIMP_SELECT_CRITERION_COMPOSITE,
                                     FALSE, 0.0, FALSE,
-                                    x - 1, y, &col);
+                                    x - 1, y, &col, -1);
 
           if (x - 1 >= extent.x && x - 1 < extent.x + extent.width &&
               y + 1 >= extent.y && y + 1 < (extent.y + extent.height))
@@ -435,7 +513,7 @@ gimp_pickable_contiguous_region_by_line_art (GimpPickable  *pickable,
                                     format, 1, FALSE,
                                     FALSE, GIMP_SELECT_CRITERION_COMPOSITE,
                                     FALSE, 0.0, FALSE,
-                                    x - 1, y + 1, &col);
+                                    x - 1, y + 1, &col, -1);
 
           if (x >= extent.x && x < extent.x + extent.width &&
               y - 1 >= extent.y && y - 1 < (extent.y + extent.height))
@@ -443,7 +521,7 @@ gimp_pickable_contiguous_region_by_line_art (GimpPickable  *pickable,
                                     format, 1, FALSE,
                                     FALSE, GIMP_SELECT_CRITERION_COMPOSITE,
                                     FALSE, 0.0, FALSE,
-                                    x, y - 1, &col);
+                                    x, y - 1, &col, -1);
 
           if (x >= extent.x && x < extent.x + extent.width &&
               y + 1 >= extent.y && y + 1 < (extent.y + extent.height))
@@ -451,7 +529,7 @@ gimp_pickable_contiguous_region_by_line_art (GimpPickable  *pickable,
                                     format, 1, FALSE,
                                     FALSE, GIMP_SELECT_CRITERION_COMPOSITE,
                                     FALSE, 0.0, FALSE,
-                                    x, y + 1, &col);
+                                    x, y + 1, &col, -1);
 
           if (x + 1 >= extent.x && x + 1 < extent.x + extent.width &&
               y - 1 >= extent.y && y - 1 < (extent.y + extent.height))
@@ -459,7 +537,7 @@ gimp_pickable_contiguous_region_by_line_art (GimpPickable  *pickable,
                                     format, 1, FALSE,
                                     FALSE, GIMP_SELECT_CRITERION_COMPOSITE,
                                     FALSE, 0.0, FALSE,
-                                    x + 1, y - 1, &col);
+                                    x + 1, y - 1, &col, -1);
 
           if (x + 1 >= extent.x && x + 1 < extent.x + extent.width &&
               y >= extent.y && y < (extent.y + extent.height))
@@ -467,7 +545,7 @@ gimp_pickable_contiguous_region_by_line_art (GimpPickable  *pickable,
                                     format, 1, FALSE,
                                     FALSE, GIMP_SELECT_CRITERION_COMPOSITE,
                                     FALSE, 0.0, FALSE,
-                                    x + 1, y, &col);
+                                    x + 1, y, &col, -1);
 
           if (x + 1 >= extent.x && x + 1 < extent.x + extent.width &&
               y + 1 >= extent.y && y + 1 < (extent.y + extent.height))
@@ -475,7 +553,7 @@ gimp_pickable_contiguous_region_by_line_art (GimpPickable  *pickable,
                                     format, 1, FALSE,
                                     FALSE, GIMP_SELECT_CRITERION_COMPOSITE,
                                     FALSE, 0.0, FALSE,
-                                    x + 1, y + 1, &col);
+                                    x + 1, y + 1, &col, -1);
 
           filled = TRUE;
         }
@@ -489,7 +567,7 @@ gimp_pickable_contiguous_region_by_line_art (GimpPickable  *pickable,
                               format, 1, FALSE,
                               FALSE, GIMP_SELECT_CRITERION_COMPOSITE,
                               FALSE, 0.0, FALSE,
-                              x, y, &col);
+                              x, y, &col, -1);
       filled = TRUE;
     }
 
@@ -1069,7 +1147,11 @@ find_contiguous_segment (const gfloat        *col,
   return TRUE;
 }
 
-static void
+/* a scanline flood fill from the seed.  if @max_pixels is not negative,
+ * gives up once more than @max_pixels pixels are selected, leaving a
+ * partial region in @mask_buffer, and returns FALSE.
+ */
+static gboolean
 find_contiguous_region (GeglBuffer          *src_buffer,
                         GeglBuffer          *mask_buffer,
                         const Babl          *format,
@@ -1082,7 +1164,8 @@ find_contiguous_region (GeglBuffer          *src_buffer,
                         gboolean             diagonal_neighbors,
                         gint                 x,
                         gint                 y,
-                        const gfloat        *col)
+                        const gfloat        *col,
+                        gint64               max_pixels)
 {
   const Babl          *mask_format = babl_format ("Y float");
   GeglSampler         *src_sampler;
@@ -1091,7 +1174,9 @@ find_contiguous_region (GeglBuffer          *src_buffer,
   gint                 start, end;
   gint                 new_start, new_end;
   GQueue              *segment_queue;
-  gfloat              *row = NULL;
+  gfloat              *row      = NULL;
+  gint64               n_pixels = 0;
+  gboolean             complete = TRUE;
 
   src_extent = gegl_buffer_get_extent (src_buffer);
 
@@ -1143,6 +1228,14 @@ find_contiguous_region (GeglBuffer          *src_buffer,
                                          row))
             continue;
 
+          n_pixels += new_end - new_start - 1;
+
+          if (max_pixels >= 0 && n_pixels > max_pixels)
+            {
+              complete = FALSE;
+              break;
+            }
+
           /* We can skip directly to `new_end + 1` on the next iteration, since
            * we've just selected all pixels in the range `[x, new_end)`, and
            * the pixel at `new_end` is above threshold.  (Note that we assume
@@ -1176,7 +1269,7 @@ find_contiguous_region (GeglBuffer          *src_buffer,
 
         }
     }
-  while (! g_queue_is_empty (segment_queue));
+  while (complete && ! g_queue_is_empty (segment_queue));
 
   g_queue_free (segment_queue);
 
@@ -1185,6 +1278,550 @@ find_contiguous_region (GeglBuffer          *src_buffer,
 #ifdef FETCH_ROW
   g_free (row);
 #endif
+
+  return complete;
+}
+
+static gint
+contiguous_find (gint *parent,
+                 gint  label)
+{
+  while (parent[label] != label)
+    {
+      parent[label] = parent[parent[label]];
+      label         = parent[label];
+    }
+
+  return label;
+}
+
+static gint
+contiguous_union (gint *parent,
+                  gint  label1,
+                  gint  label2)
+{
+  if (! label1)
+    return label2 ? contiguous_find (parent, label2) : 0;
+  else if (! label2)
+    return contiguous_find (parent, label1);
+
+  label1 = contiguous_find (parent, label1);
+  label2 = contiguous_find (parent, label2);
+
+  /* always keep the lower label as the root, so that roots precede the
+   * labels pointing to them
+   */
+  if (label1 < label2)
+    {
+      parent[label2] = label1;
+
+      return label1;
+    }
+  else
+    {
+      parent[label1] = label2;
+
+      return label2;
+    }
+}
+
+/* labels the connected components of the nonzero pixels of @mask, using
+ * a two-pass union-find.  on return, @labels holds, for each pixel, the
+ * label of its component, if the component touches the tile border or
+ * contains the seed pixel, or 0 otherwise.  labels are numbered from 1,
+ * in the order their components are met on the border, with the seed's
+ * component, if any, coming first.  @parent must be large enough to hold
+ * (width * height + 4) elements.  returns the number of labels.
+ */
+static gint
+contiguous_label_tile (const gfloat *mask,
+                       gint          width,
+                       gint          height,
+                       gboolean      diagonal_neighbors,
+                       gint          seed_x,
+                       gint          seed_y,
+                       gint         *labels,
+                       gint         *parent,
+                       gboolean     *interior)
+{
+  gint *border_labels;
+  gint  n_provisional = 0;
+  gint  n_components  = 0;
+  gint  n_labels      = 0;
+  gint  max_labels    = width * height / 2 + 2;
+  gint  x, y;
+  gint  i;
+
+  /*  first pass: assign provisional labels, recording their equivalences  */
+  for (y = 0, i = 0; y < height; y++)
+    {
+      for (x = 0; x < width; x++, i++)
+        {
+          gint label = 0;
+
+          if (! mask[i])
+            {
+              labels[i] = 0;
+
+              continue;
+            }
+
+          if (x > 0)
+            label = labels[i - 1];
+
+          if (y > 0)
+            {
+              label = contiguous_union (parent, label, labels[i - width]);
+
+              if (diagonal_neighbors)
+                {
+                  if (x > 0)
+                    label = contiguous_union (parent, label,
+                                              labels[i - width - 1]);
+
+                  if (x < width - 1)
+                    label = contiguous_union (parent, label,
+                                              labels[i - width + 1]);
+                }
+            }
+
+          if (! label)
+            {
+              label         = ++n_provisional;
+              parent[label] = label;
+            }
+
+          labels[i] = label;
+        }
+    }
+
+  /*  resolve each provisional label to a component index.  since a
+   *  label's parent always precedes it, and its root has been resolved
+   *  by the time we get to it, a single ascending pass suffices.
+   */
+  for (i = 1; i <= n_provisional; i++)
+    {
+      if (parent[i] == i)
+        parent[i] = ++n_components;
+      else
+        parent[i] = parent[parent[i]];
+    }
+
+  /*  assign border labels to the components that may connect to other
+   *  tiles, or that contain the seed
+   */
+  border_labels = parent + max_labels;
+
+  memset (border_labels, 0, (n_components + 1) * sizeof (gint));
+
+#define BORDER_LABEL(i)                                               \
+  G_STMT_START                                                        \
+    {                                                                 \
+      gint component = labels[i] ? parent[labels[i]] : 0;            \
+                                                                      \
+      if (component && ! border_labels[component])                    \
+        border_labels[component] = ++n_labels;                        \
+    }                                                                 \
+  G_STMT_END
+
+  if (seed_x >= 0)
+    BORDER_LABEL (seed_y * width + seed_x);
+
+  for (x = 0; x < width; x++)
+    {
+      BORDER_LABEL (x);
+      BORDER_LABEL ((height - 1) * width + x);
+    }
+
+  for (y = 0; y < height; y++)
+    {
+      BORDER_LABEL (y * width);
+      BORDER_LABEL (y * width + width - 1);
+    }
+
+#undef BORDER_LABEL
+
+  *interior = n_labels < n_components;
+
+  /*  second pass: replace provisional labels with border labels  */
+  for (i = 0; i < width * height; i++)
+    {
+      if (labels[i])
+        labels[i] = border_labels[parent[labels[i]]];
+    }
+
+  return n_labels;
+}
+
+static void
+contiguous_union_tiles (gint                 *parent,
+                        const ContiguousTile *tile1,
+                        gint                  label1,
+                        const ContiguousTile *tile2,
+                        gint                  label2)
+{
+  if (label1 && label2)
+    {
+      contiguous_union (parent,
+                        tile1->base + label1,
+                        tile2->base + label2);
+    }
+}
+
+/* a tile-parallel version of find_contiguous_region().  the extent is
+ * split into tiles, whose threshold masks are computed and labeled
+ * independently.  the labels on the tile borders are then merged using
+ * a union-find, and the components not connected to the seed are
+ * cleared.  unlike find_contiguous_region(), this overwrites the entire
+ * contents of @mask_buffer.
+ */
+static void
+find_contiguous_region_parallel (GeglBuffer          *src_buffer,
+                                 GeglBuffer          *mask_buffer,
+                                 const Babl          *format,
+                                 gint                 n_components,
+                                 gboolean             has_alpha,
+                                 gboolean             select_transparent,
+                                 GimpSelectCriterion  select_criterion,
+                                 gboolean             antialias,
+                                 gfloat               threshold,
+                                 gboolean             diagonal_neighbors,
+                                 gint                 x,
+                                 gint                 y,
+                                 const gfloat        *col)
+{
+  const Babl          *mask_format = babl_format ("Y float");
+  const GeglRectangle *extent;
+  ContiguousTile      *tiles;
+  ContiguousTile      *seed_tile   = NULL;
+  gint                *parent;
+  gint                 n_tiles_x;
+  gint                 n_tiles_y;
+  gint                 n_tiles;
+  gint                 n_labels    = 0;
+  gint                 seed_root;
+  gint                 i;
+  gint                 tx, ty;
+
+  extent = gegl_buffer_get_extent (src_buffer);
+
+  n_tiles_x = (extent->width  + CONTIGUOUS_TILE_SIZE - 1) / CONTIGUOUS_TILE_SIZE;
+  n_tiles_y = (extent->height + CONTIGUOUS_TILE_SIZE - 1) / CONTIGUOUS_TILE_SIZE;
+  n_tiles   = n_tiles_x * n_tiles_y;
+
+  tiles = g_new0 (ContiguousTile, n_tiles);
+
+  for (ty = 0, i = 0; ty < n_tiles_y; ty++)
+    {
+      for (tx = 0; tx < n_tiles_x; tx++, i++)
+        {
+          GeglRectangle *rect = &tiles[i].rect;
+
+          rect->x      = extent->x + tx * CONTIGUOUS_TILE_SIZE;
+          rect->y      = extent->y + ty * CONTIGUOUS_TILE_SIZE;
+          rect->width  = MIN (CONTIGUOUS_TILE_SIZE,
+                              extent->x + extent->width  - rect->x);
+          rect->height = MIN (CONTIGUOUS_TILE_SIZE,
+                              extent->y + extent->height - rect->y);
+
+          if (x >= rect->x && x < rect->x + rect->width &&
+              y >= rect->y && y < rect->y + rect->height)
+            {
+              seed_tile = &tiles[i];
+            }
+        }
+    }
+
+  /*  compute and label the threshold mask of each tile, keeping only the
+   *  labels on the tile's border
+   */
+  gegl_parallel_distribute_range (
+    n_tiles,
+    PIXELS_PER_THREAD / (CONTIGUOUS_TILE_SIZE * CONTIGUOUS_TILE_SIZE),
+    [=] (gint offset, gint size)
+    {
+      gint t;
+
+      for (t = offset; t < offset + size; t++)
+        {
+          ContiguousTile *tile   = &tiles[t];
+          gint            width  = tile->rect.width;
+          gint            height = tile->rect.height;
+          gfloat         *src;
+          gfloat         *mask;
+          gint           *labels;
+          gint           *tile_parent;
+          gint            j;
+
+          src         = gegl_scratch_new (gfloat, width * height * n_components);
+          mask        = gegl_scratch_new (gfloat, width * height);
+          labels      = gegl_scratch_new (gint,   width * height);
+          tile_parent = gegl_scratch_new (gint,   width * height + 4);
+
+          gegl_buffer_get (src_buffer, &tile->rect, 1.0, format,
+                           src, GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+          for (j = 0; j < width * height; j++)
+            {
+              mask[j] = pixel_difference (col, src + j * n_components,
+                                          antialias,
+                                          threshold,
+                                          n_components,
+                                          has_alpha,
+                                          select_transparent,
+                                          select_criterion);
+
+              if (mask[j])
+                tile->selected = TRUE;
+            }
+
+          if (tile->selected)
+            {
+              gegl_buffer_set (mask_buffer, &tile->rect, 0, mask_format,
+                               mask, GEGL_AUTO_ROWSTRIDE);
+
+              tile->n_labels = contiguous_label_tile (
+                mask, width, height, diagonal_neighbors,
+                tile == seed_tile ? x - tile->rect.x : -1,
+                tile == seed_tile ? y - tile->rect.y : -1,
+                labels, tile_parent, &tile->interior);
+
+              tile->border = g_new (gint, 2 * (width + height));
+              tile->top    = tile->border;
+              tile->bottom = tile->top    + width;
+              tile->left   = tile->bottom + width;
+              tile->right  = tile->left   + height;
+
+              for (j = 0; j < width; j++)
+                {
+                  tile->top[j]    = labels[j];
+                  tile->bottom[j] = labels[(height - 1) * width + j];
+                }
+
+              for (j = 0; j < height; j++)
+                {
+                  tile->left[j]  = labels[j * width];
+                  tile->right[j] = labels[j * width + width - 1];
+                }
+
+              if (tile == seed_tile)
+                {
+                  tile->seed_label = labels[(y - tile->rect.y) * width +
+                                            (x - tile->rect.x)];
+                }
+            }
+
+          gegl_scratch_free (tile_parent);
+          gegl_scratch_free (labels);
+          gegl_scratch_free (mask);
+          gegl_scratch_free (src);
+        }
+    });
+
+  if (! seed_tile || ! seed_tile->seed_label)
+    {
+      gegl_buffer_clear (mask_buffer, NULL);
+
+      for (i = 0; i < n_tiles; i++)
+        g_free (tiles[i].border);
+      g_free (tiles);
+
+      return;
+    }
+
+  /*  merge the border labels of adjacent tiles  */
+  for (i = 0; i < n_tiles; i++)
+    {
+      tiles[i].base  = n_labels;
+      n_labels      += tiles[i].n_labels;
+    }
+
+  parent = g_new (gint, n_labels + 1);
+
+  for (i = 0; i <= n_labels; i++)
+    parent[i] = i;
+
+  for (ty = 0; ty < n_tiles_y; ty++)
+    {
+      for (tx = 0; tx < n_tiles_x; tx++)
+        {
+          const ContiguousTile *tile = &tiles[ty * n_tiles_x + tx];
+          gint                  j;
+
+          if (! tile->selected)
+            continue;
+
+          if (tx + 1 < n_tiles_x)
+            {
+              const ContiguousTile *right = tile + 1;
+              gint                  height = tile->rect.height;
+
+              if (right->selected)
+                {
+                  for (j = 0; j < height; j++)
+                    {
+                      if (! tile->right[j])
+                        continue;
+
+                      contiguous_union_tiles (parent,
+                                              tile, tile->right[j],
+                                              right, right->left[j]);
+
+                      if (diagonal_neighbors)
+                        {
+                          if (j > 0)
+                            contiguous_union_tiles (parent,
+                                                    tile, tile->right[j],
+                                                    right, right->left[j - 1]);
+
+                          if (j < height - 1)
+                            contiguous_union_tiles (parent,
+                                                    tile, tile->right[j],
+                                                    right, right->left[j + 1]);
+                        }
+                    }
+                }
+            }
+
+          if (ty + 1 < n_tiles_y)
+            {
+              const ContiguousTile *below = tile + n_tiles_x;
+              gint                  width = tile->rect.width;
+
+              if (below->selected)
+                {
+                  for (j = 0; j < width; j++)
+                    {
+                      if (! tile->bottom[j])
+                        continue;
+
+                      contiguous_union_tiles (parent,
+                                              tile, tile->bottom[j],
+                                              below, below->top[j]);
+
+                      if (diagonal_neighbors)
+                        {
+                          if (j > 0)
+                            contiguous_union_tiles (parent,
+                                                    tile, tile->bottom[j],
+                                                    below, below->top[j - 1]);
+
+                          if (j < width - 1)
+                            contiguous_union_tiles (parent,
+                                                    tile, tile->bottom[j],
+                                                    below, below->top[j + 1]);
+                        }
+                    }
+                }
+
+              /*  diagonal neighbors across tile corners  */
+              if (diagonal_neighbors)
+                {
+                  if (tx + 1 < n_tiles_x && below[1].selected)
+                    {
+                      contiguous_union_tiles (parent,
+                                              tile, tile->bottom[width - 1],
+                                              &below[1], below[1].top[0]);
+                    }
+
+                  if (tx > 0 && below[-1].selected)
+                    {
+                      contiguous_union_tiles (parent,
+                                              tile, tile->bottom[0],
+                                              &below[-1],
+                                              below[-1].top[below[-1].rect.width - 1]);
+                    }
+                }
+            }
+        }
+    }
+
+  /*  flatten the label forest, so that it can be read concurrently  */
+  for (i = 1; i <= n_labels; i++)
+    parent[i] = parent[parent[i]];
+
+  seed_root = parent[seed_tile->base + seed_tile->seed_label];
+
+  /*  clear the components not connected to the seed  */
+  gegl_parallel_distribute_range (
+    n_tiles,
+    PIXELS_PER_THREAD / (CONTIGUOUS_TILE_SIZE * CONTIGUOUS_TILE_SIZE),
+    [=] (gint offset, gint size)
+    {
+      gint t;
+
+      for (t = offset; t < offset + size; t++)
+        {
+          const ContiguousTile *tile      = &tiles[t];
+          gint                  width     = tile->rect.width;
+          gint                  height    = tile->rect.height;
+          gboolean              any_kept  = FALSE;
+          gboolean              all_kept  = TRUE;
+          gboolean              interior;
+          gboolean             *keep;
+          gfloat               *mask;
+          gint                 *labels;
+          gint                 *tile_parent;
+          gint                  j;
+
+          if (! tile->selected)
+            continue;
+
+          keep = gegl_scratch_new (gboolean, tile->n_labels + 1);
+
+          keep[0] = FALSE;
+
+          for (j = 1; j <= tile->n_labels; j++)
+            {
+              keep[j] = parent[tile->base + j] == seed_root;
+
+              any_kept |= keep[j];
+              all_kept &= keep[j];
+            }
+
+          if (! any_kept)
+            {
+              gegl_buffer_clear (mask_buffer, &tile->rect);
+            }
+          else if (! all_kept || tile->interior)
+            {
+              mask        = gegl_scratch_new (gfloat, width * height);
+              labels      = gegl_scratch_new (gint,   width * height);
+              tile_parent = gegl_scratch_new (gint,   width * height + 4);
+
+              gegl_buffer_get (mask_buffer, &tile->rect, 1.0, mask_format,
+                               mask, GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+              /*  relabeling the same mask yields the same labels  */
+              contiguous_label_tile (
+                mask, width, height, diagonal_neighbors,
+                tile == seed_tile ? x - tile->rect.x : -1,
+                tile == seed_tile ? y - tile->rect.y : -1,
+                labels, tile_parent, &interior);
+
+              for (j = 0; j < width * height; j++)
+                {
+                  if (! keep[labels[j]])
+                    mask[j] = 0.0;
+                }
+
+              gegl_buffer_set (mask_buffer, &tile->rect, 0, mask_format,
+                               mask, GEGL_AUTO_ROWSTRIDE);
+
+              gegl_scratch_free (tile_parent);
+              gegl_scratch_free (labels);
+              gegl_scratch_free (mask);
+            }
+
+          gegl_scratch_free (keep);
+        }
+    });
+
+  g_free (parent);
+
+  for (i = 0; i < n_tiles; i++)
+    g_free (tiles[i].border);
+  g_free (tiles);
 }
 
 static void
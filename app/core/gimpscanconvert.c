@@ -56,6 +56,46 @@ struct _GimpScanConvert
   GArray         *path_data;
 };
 
+typedef struct
+{
+  GimpScanConvert *sc;
+  GeglBuffer      *buffer;
+  cairo_path_t    *path;
+  gint             off_x;
+  gint             off_y;
+  gboolean         replace;
+  gboolean         antialias;
+  gdouble          value;
+  GArray          *tiles;     /* the rects of the tiles to render */
+} RenderData;
+
+
+#define PIXELS_PER_THREAD \
+  (/* each thread costs as much as */ 64.0 * 64.0 /* pixels */)
+
+
+static void   gimp_scan_convert_setup       (GimpScanConvert     *sc,
+                                             cairo_t             *cr,
+                                             cairo_path_t        *path,
+                                             gboolean             antialias,
+                                             gdouble              value);
+static void   gimp_scan_convert_draw        (GimpScanConvert     *sc,
+                                             cairo_t             *cr);
+static cairo_surface_t *
+              gimp_scan_convert_tile_map    (GimpScanConvert     *sc,
+                                             cairo_path_t        *path,
+                                             gint                 off_x,
+                                             gint                 off_y,
+                                             const GeglRectangle *grid,
+                                             gint                 tile_width,
+                                             gint                 tile_height);
+static void   gimp_scan_convert_render_tiles
+                                            (gsize                offset,
+                                             gsize                size,
+                                             RenderData          *data);
+static void   gimp_scan_convert_render_area (const GeglRectangle *area,
+                                             RenderData          *data);
+
 
 /*  public functions  */
 
@@ -496,17 +536,21 @@ gimp_scan_convert_render_full (GimpScanConvert *sc,
                                gboolean         antialias,
                                gdouble          value)
 {
-  const Babl         *format;
-  guchar             *shared_buf      = NULL;
-  gsize               shared_buf_size = 0;
-  GeglBufferIterator *iter;
-  GeglRectangle      *roi;
-  cairo_t            *cr;
-  cairo_surface_t    *surface;
-  cairo_path_t        path;
-  gint                bpp;
-  gint                x, y;
-  gint                width, height;
+  RenderData       data;
+  GeglRectangle    area;
+  GeglRectangle    grid;
+  cairo_t         *cr;
+  cairo_surface_t *surface;
+  cairo_path_t     path;
+  const guchar    *map;
+  gint             map_stride;
+  gint             tile_width;
+  gint             tile_height;
+  gdouble          x1, y1;
+  gdouble          x2, y2;
+  gint             x, y;
+  gint             width, height;
+  gint             i, j;
 
   g_return_if_fail (sc != NULL);
   g_return_if_fail (GEGL_IS_BUFFER (buffer));
@@ -526,19 +570,245 @@ gimp_scan_convert_render_full (GimpScanConvert *sc,
   path.data     = (cairo_path_data_t *) sc->path_data->data;
   path.num_data = sc->path_data->len;
 
-  format = babl_format ("Y u8");
-  bpp    = babl_format_get_bytes_per_pixel (format);
+  /*  find the area actually covered by the path, so that we only
+   *  rasterize, and allocate, the tiles it touches
+   */
+  surface = cairo_image_surface_create (CAIRO_FORMAT_A8, 1, 1);
+  cr      = cairo_create (surface);
+
+  gimp_scan_convert_setup (sc, cr, &path, antialias, value);
+
+  if (sc->do_stroke)
+    cairo_stroke_extents (cr, &x1, &y1, &x2, &y2);
+  else
+    cairo_fill_extents (cr, &x1, &y1, &x2, &y2);
+
+  cairo_user_to_device (cr, &x1, &y1);
+  cairo_user_to_device (cr, &x2, &y2);
+
+  cairo_destroy (cr);
+  cairo_surface_destroy (surface);
+
+  if (replace)
+    gegl_buffer_clear (buffer, NULL);
+
+  /*  add a pixel on each side for antialiasing  */
+  if (! gimp_rectangle_intersect (x, y, width, height,
+                                  floor (MIN (x1, x2)) - off_x - 1,
+                                  floor (MIN (y1, y2)) - off_y - 1,
+                                  ceil (fabs (x2 - x1)) + 3,
+                                  ceil (fabs (y2 - y1)) + 3,
+                                  &area.x, &area.y,
+                                  &area.width, &area.height))
+    return;
+
+  data.sc        = sc;
+  data.buffer    = buffer;
+  data.path      = &path;
+  data.off_x     = off_x;
+  data.off_y     = off_y;
+  data.replace   = replace;
+  data.antialias = antialias;
+  data.value     = value;
+  data.tiles     = g_array_new (FALSE, FALSE, sizeof (GeglRectangle));
+
+  /*  within the extents, only render the tiles the path actually
+   *  covers, a stroked outline leaves most of them empty
+   */
+  g_object_get (buffer,
+                "tile-width",  &tile_width,
+                "tile-height", &tile_height,
+                NULL);
+
+  gegl_rectangle_align_to_buffer (&grid, &area, buffer,
+                                  GEGL_RECTANGLE_ALIGNMENT_SUPERSET);
+
+  surface = gimp_scan_convert_tile_map (sc, &path, off_x, off_y,
+                                        &grid, tile_width, tile_height);
+
+  map        = cairo_image_surface_get_data (surface);
+  map_stride = cairo_image_surface_get_stride (surface);
+
+  for (j = 0; j < grid.height / tile_height; j++)
+    {
+      for (i = 0; i < grid.width / tile_width; i++)
+        {
+          GeglRectangle tile = { grid.x + i * tile_width,
+                                 grid.y + j * tile_height,
+                                 tile_width, tile_height };
+
+          if (map[j * map_stride + i] &&
+              gegl_rectangle_intersect (&tile, &tile, &area))
+            {
+              g_array_append_val (data.tiles, tile);
+            }
+        }
+    }
+
+  cairo_surface_destroy (surface);
+
+  gegl_parallel_distribute_range (
+    data.tiles->len, PIXELS_PER_THREAD / (tile_width * tile_height),
+    (GeglParallelDistributeRangeFunc) gimp_scan_convert_render_tiles,
+    &data);
+
+  g_array_free (data.tiles, TRUE);
+}
+
+
+/*  private functions  */
+
+static void
+gimp_scan_convert_setup (GimpScanConvert *sc,
+                         cairo_t         *cr,
+                         cairo_path_t    *path,
+                         gboolean         antialias,
+                         gdouble          value)
+{
+  cairo_set_source_rgba (cr, 0, 0, 0, value);
+  cairo_append_path (cr, path);
+
+  cairo_set_antialias (cr, antialias ?
+                       CAIRO_ANTIALIAS_GRAY : CAIRO_ANTIALIAS_NONE);
+  cairo_set_miter_limit (cr, sc->miter);
+
+  if (sc->do_stroke)
+    {
+      cairo_set_line_cap (cr,
+                          sc->cap == GIMP_CAP_BUTT ? CAIRO_LINE_CAP_BUTT :
+                          sc->cap == GIMP_CAP_ROUND ? CAIRO_LINE_CAP_ROUND :
+                          CAIRO_LINE_CAP_SQUARE);
+      cairo_set_line_join (cr,
+                           sc->join == GIMP_JOIN_MITER ? CAIRO_LINE_JOIN_MITER :
+                           sc->join == GIMP_JOIN_ROUND ? CAIRO_LINE_JOIN_ROUND :
+                           CAIRO_LINE_JOIN_BEVEL);
+
+      cairo_set_line_width (cr, sc->width);
+
+      if (sc->dash_info)
+        cairo_set_dash (cr,
+                        (double *) sc->dash_info->data,
+                        sc->dash_info->len,
+                        sc->dash_offset);
+
+      cairo_scale (cr, 1.0, sc->ratio_xy);
+    }
+  else
+    {
+      cairo_set_fill_rule (cr, CAIRO_FILL_RULE_EVEN_ODD);
+    }
+}
+
+static void
+gimp_scan_convert_draw (GimpScanConvert *sc,
+                        cairo_t         *cr)
+{
+  if (sc->do_stroke)
+    cairo_stroke (cr);
+  else
+    cairo_fill (cr);
+}
+
+/*  renders the path at one pixel per tile of @grid, into a map whose
+ *  pixels are nonzero for the tiles it may cover.  each point of the
+ *  path's coverage is grown to a disc of more than a tile's diagonal,
+ *  which covers its whole tile, so that no covered tile is missed,
+ *  however little of it is covered.  stroked outlines are bounded by a
+ *  round stroke, without dashes, of the largest distance a miter or a
+ *  square cap reaches from the path.
+ */
+static cairo_surface_t *
+gimp_scan_convert_tile_map (GimpScanConvert     *sc,
+                            cairo_path_t        *path,
+                            gint                 off_x,
+                            gint                 off_y,
+                            const GeglRectangle *grid,
+                            gint                 tile_width,
+                            gint                 tile_height)
+{
+  cairo_surface_t *surface;
+  cairo_t         *cr;
+  gdouble          margin     = 2.0 * MAX (tile_width, tile_height);
+  gdouble          half_width = 0.0;
+
+  surface = cairo_image_surface_create (CAIRO_FORMAT_A8,
+                                        grid->width  / tile_width,
+                                        grid->height / tile_height);
+
+  cr = cairo_create (surface);
+
+  cairo_scale (cr, 1.0 / tile_width, 1.0 / tile_height);
+  cairo_translate (cr, -off_x - grid->x, -off_y - grid->y);
+
+  cairo_append_path (cr, path);
+
+  if (sc->do_stroke)
+    {
+      half_width = sc->width / 2.0 *
+                   MAX (G_SQRT2,
+                        sc->join == GIMP_JOIN_MITER ? sc->miter : 1.0);
+
+      /*  the pen is scaled like in gimp_scan_convert_setup()  */
+      cairo_scale (cr, 1.0, sc->ratio_xy);
+
+      margin /= MIN (1.0, sc->ratio_xy);
+    }
+  else
+    {
+      cairo_set_fill_rule (cr, CAIRO_FILL_RULE_EVEN_ODD);
+      cairo_fill_preserve (cr);
+    }
+
+  cairo_set_line_cap   (cr, CAIRO_LINE_CAP_ROUND);
+  cairo_set_line_join  (cr, CAIRO_LINE_JOIN_ROUND);
+  cairo_set_line_width (cr, 2.0 * (half_width + margin));
+  cairo_stroke (cr);
+
+  cairo_destroy (cr);
+
+  cairo_surface_flush (surface);
+
+  return surface;
+}
+
+static void
+gimp_scan_convert_render_tiles (gsize       offset,
+                                gsize       size,
+                                RenderData *data)
+{
+  gsize i;
+
+  for (i = offset; i < offset + size; i++)
+    {
+      gimp_scan_convert_render_area (&g_array_index (data->tiles,
+                                                     GeglRectangle, i),
+                                     data);
+    }
+}
 
-  iter = gegl_buffer_iterator_new (buffer, NULL, 0, format,
+static void
+gimp_scan_convert_render_area (const GeglRectangle *area,
+                               RenderData          *data)
+{
+  const Babl         *format          = babl_format ("Y u8");
+  gint                bpp             = babl_format_get_bytes_per_pixel (format);
+  guchar             *shared_buf      = NULL;
+  gsize               shared_buf_size = 0;
+  GeglBufferIterator *iter;
+  GeglRectangle      *roi;
+
+  iter = gegl_buffer_iterator_new (data->buffer, area, 0, format,
                                    GEGL_ACCESS_READWRITE, GEGL_ABYSS_NONE, 1);
   roi = &iter->items[0].roi;
 
   while (gegl_buffer_iterator_next (iter))
     {
-      guchar     *data    = iter->items[0].data;
-      guchar     *tmp_buf = NULL;
-      const gint  stride  = cairo_format_stride_for_width (CAIRO_FORMAT_A8,
-                                                           roi->width);
+      guchar          *tile_data = iter->items[0].data;
+      guchar          *tmp_buf   = NULL;
+      cairo_t         *cr;
+      cairo_surface_t *surface;
+      const gint       stride    = cairo_format_stride_for_width (CAIRO_FORMAT_A8,
+                                                                  roi->width);
 
       /*  cairo rowstrides are always multiples of 4, whereas
        *  maskPR.rowstride can be anything, so to be able to create an
@@ -555,9 +825,9 @@ gimp_scan_convert_render_full (GimpScanConvert *sc,
             }
           tmp_buf = shared_buf;
 
-          if (! replace)
+          if (! data->replace)
             {
-              const guchar *src  = data;
+              const guchar *src  = tile_data;
               guchar       *dest = tmp_buf;
               gint          i;
 
@@ -572,57 +842,26 @@ gimp_scan_convert_render_full (GimpScanConvert *sc,
         }
 
       surface = cairo_image_surface_create_for_data (tmp_buf ?
-                                                     tmp_buf : data,
+                                                     tmp_buf : tile_data,
                                                      CAIRO_FORMAT_A8,
                                                      roi->width, roi->height,
                                                      stride);
 
       cairo_surface_set_device_offset (surface,
-                                       -off_x - roi->x,
-                                       -off_y - roi->y);
+                                       -data->off_x - roi->x,
+                                       -data->off_y - roi->y);
       cr = cairo_create (surface);
       cairo_set_operator (cr, CAIRO_OPERATOR_SOURCE);
 
-      if (replace)
+      if (data->replace)
         {
           cairo_set_source_rgba (cr, 0, 0, 0, 0);
           cairo_paint (cr);
         }
 
-      cairo_set_source_rgba (cr, 0, 0, 0, value);
-      cairo_append_path (cr, &path);
-
-      cairo_set_antialias (cr, antialias ?
-                           CAIRO_ANTIALIAS_GRAY : CAIRO_ANTIALIAS_NONE);
-      cairo_set_miter_limit (cr, sc->miter);
-
-      if (sc->do_stroke)
-        {
-          cairo_set_line_cap (cr,
-                              sc->cap == GIMP_CAP_BUTT ? CAIRO_LINE_CAP_BUTT :
-                              sc->cap == GIMP_CAP_ROUND ? CAIRO_LINE_CAP_ROUND :
-                              CAIRO_LINE_CAP_SQUARE);
-          cairo_set_line_join (cr,
-                               sc->join == GIMP_JOIN_MITER ? CAIRO_LINE_JOIN_MITER :
-                               sc->join == GIMP_JOIN_ROUND ? CAIRO_LINE_JOIN_ROUND :
-                               CAIRO_LINE_JOIN_BEVEL);
-
-          cairo_set_line_width (cr, sc->width);
-
-          if (sc->dash_info)
-            cairo_set_dash (cr,
-                            (double *) sc->dash_info->data,
-                            sc->dash_info->len,
-                            sc->dash_offset);
-
-          cairo_scale (cr, 1.0, sc->ratio_xy);
-          cairo_stroke (cr);
-        }
-      else
-        {
-          cairo_set_fill_rule (cr, CAIRO_FILL_RULE_EVEN_ODD);
-          cairo_fill (cr);
-        }
+      gimp_scan_convert_setup (data->sc, cr, data->path,
+                               data->antialias, data->value);
+      gimp_scan_convert_draw (data->sc, cr);
 
       cairo_destroy (cr);
       cairo_surface_destroy (surface);
@@ -630,7 +869,7 @@ gimp_scan_convert_render_full (GimpScanConvert *sc,
       if (tmp_buf)
         {
           const guchar *src  = tmp_buf;
-          guchar       *dest = data;
+          guchar       *dest = tile_data;
           gint          i;
 
           for (i = 0; i < roi->height; i++)
@@ -59,6 +59,8 @@ struct _GimpUndo
 
   GimpTempBuf      *preview;
   guint             preview_idle_id;
+
+  gint64            memsize;        /* size accounted for by its undo stack */
 };
 
 struct _GimpUndoClass
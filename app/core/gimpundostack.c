@@ -39,12 +39,22 @@ static void    gimp_undo_stack_pop         (GimpUndo            *undo,
 static void    gimp_undo_stack_free        (GimpUndo            *undo,
                                             GimpUndoMode         undo_mode);
 
+static void    gimp_undo_stack_add_undo    (GimpUndoStack       *stack,
+                                            GimpUndo            *undo);
+static void    gimp_undo_stack_remove_undo (GimpUndoStack       *stack,
+                                            GimpUndo            *undo);
+static void    gimp_undo_stack_add_memsize (GimpUndoStack       *stack,
+                                            gint64               memsize);
+
 
 G_DEFINE_TYPE (GimpUndoStack, gimp_undo_stack, GIMP_TYPE_UNDO)
 
 #define parent_class gimp_undo_stack_parent_class
 
 
+static guintptr gimp_undo_stack_total_memsize = 0;
+
+
 static void
 gimp_undo_stack_class_init (GimpUndoStackClass *klass)
 {
@@ -104,6 +114,10 @@ gimp_undo_stack_pop (GimpUndo            *undo,
       GimpUndo *child = list->data;
 
       gimp_undo_pop (child, undo_mode, accum);
+
+      /*  popping may have restored a compressed undo  */
+      if (! GIMP_IS_UNDO_STACK (child))
+        gimp_undo_stack_update_undo (stack, child);
     }
 }
 
@@ -120,11 +134,19 @@ gimp_undo_stack_free (GimpUndo     *undo,
     {
       GimpUndo *child = list->data;
 
+      if (GIMP_IS_UNDO_STACK (child))
+        GIMP_UNDO_STACK (child)->parent = NULL;
+      else
+        g_atomic_pointer_add (&gimp_undo_stack_total_memsize,
+                              -child->memsize);
+
       gimp_undo_free (child, undo_mode);
       g_object_unref (child);
     }
 
   gimp_container_clear (stack->undos);
+
+  gimp_undo_stack_add_memsize (stack, -stack->memsize);
 }
 
 GimpUndoStack *
@@ -145,6 +167,53 @@ gimp_undo_stack_push_undo (GimpUndoStack *stack,
   g_return_if_fail (GIMP_IS_UNDO (undo));
 
   gimp_container_add (stack->undos, GIMP_OBJECT (undo));
+
+  gimp_undo_stack_add_undo (stack, undo);
+}
+
+/**
+ * gimp_undo_stack_update_undo:
+ * @stack: a #GimpUndoStack
+ * @undo:  a #GimpUndo on @stack
+ *
+ * Updates @stack's size after the memsize of @undo changed, for
+ * example because it has been compressed, or because an item it
+ * holds has been removed from the image after it was pushed.  If
+ * @undo is an undo group, all of its undos are updated.
+ **/
+void
+gimp_undo_stack_update_undo (GimpUndoStack *stack,
+                             GimpUndo      *undo)
+{
+  gint64 memsize;
+
+  g_return_if_fail (GIMP_IS_UNDO_STACK (stack));
+  g_return_if_fail (GIMP_IS_UNDO (undo));
+
+  if (GIMP_IS_UNDO_STACK (undo))
+    {
+      GimpUndoStack *group = GIMP_UNDO_STACK (undo);
+      GList         *list;
+
+      /*  the group's size follows through gimp_undo_stack_add_memsize()  */
+      for (list = GIMP_LIST (group->undos)->queue->head;
+           list;
+           list = g_list_next (list))
+        {
+          gimp_undo_stack_update_undo (group, list->data);
+        }
+
+      return;
+    }
+
+  memsize = gimp_object_get_memsize (GIMP_OBJECT (undo), NULL);
+
+  g_atomic_pointer_add (&gimp_undo_stack_total_memsize,
+                        memsize - undo->memsize);
+
+  gimp_undo_stack_add_memsize (stack, memsize - undo->memsize);
+
+  undo->memsize = memsize;
 }
 
 GimpUndo *
@@ -162,6 +231,8 @@ gimp_undo_stack_pop_undo (GimpUndoStack       *stack,
   if (undo)
     {
       gimp_container_remove (stack->undos, GIMP_OBJECT (undo));
+      gimp_undo_stack_remove_undo (stack, undo);
+
       gimp_undo_pop (undo, undo_mode, accum);
 
       return undo;
@@ -183,6 +254,8 @@ gimp_undo_stack_free_bottom (GimpUndoStack *stack,
   if (undo)
     {
       gimp_container_remove (stack->undos, GIMP_OBJECT (undo));
+      gimp_undo_stack_remove_undo (stack, undo);
+
       gimp_undo_free (undo, undo_mode);
 
       return undo;
@@ -206,3 +279,86 @@ gimp_undo_stack_get_depth (GimpUndoStack *stack)
 
   return gimp_container_get_n_children (stack->undos);
 }
+
+/**
+ * gimp_undo_stack_get_size:
+ * @stack: a #GimpUndoStack
+ *
+ * Returns the memory used by the undo steps on @stack, not counting
+ * GUI-only data such as undo previews.  The size is accounted for as
+ * undos are pushed to and removed from the stack, so unlike
+ * gimp_object_get_memsize() this does not walk the undo history.
+ *
+ * Returns: the memory used by @stack's undo steps, in bytes.
+ **/
+gint64
+gimp_undo_stack_get_size (GimpUndoStack *stack)
+{
+  g_return_val_if_fail (GIMP_IS_UNDO_STACK (stack), 0);
+
+  return stack->memsize;
+}
+
+guint64
+gimp_undo_stack_get_total_memsize (void)
+{
+  return gimp_undo_stack_total_memsize;
+}
+
+
+/*  private functions  */
+
+static void
+gimp_undo_stack_add_undo (GimpUndoStack *stack,
+                          GimpUndo      *undo)
+{
+  if (GIMP_IS_UNDO_STACK (undo))
+    {
+      GimpUndoStack *child = GIMP_UNDO_STACK (undo);
+
+      /*  an undo group keeps growing while it is open, so it reports
+       *  its size changes to the stack it is pushed to
+       */
+      child->parent = stack;
+      undo->memsize = child->memsize;
+    }
+  else
+    {
+      undo->memsize = gimp_object_get_memsize (GIMP_OBJECT (undo), NULL);
+
+      g_atomic_pointer_add (&gimp_undo_stack_total_memsize, +undo->memsize);
+    }
+
+  gimp_undo_stack_add_memsize (stack, undo->memsize);
+}
+
+static void
+gimp_undo_stack_remove_undo (GimpUndoStack *stack,
+                             GimpUndo      *undo)
+{
+  if (GIMP_IS_UNDO_STACK (undo))
+    {
+      GIMP_UNDO_STACK (undo)->parent = NULL;
+    }
+  else
+    {
+      g_atomic_pointer_add (&gimp_undo_stack_total_memsize, -undo->memsize);
+    }
+
+  gimp_undo_stack_add_memsize (stack, -undo->memsize);
+
+  undo->memsize = 0;
+}
+
+static void
+gimp_undo_stack_add_memsize (GimpUndoStack *stack,
+                             gint64         memsize)
+{
+  for (; stack; stack = stack->parent)
+    {
+      stack->memsize += memsize;
+
+      if (stack->parent)
+        GIMP_UNDO (stack)->memsize += memsize;
+    }
+}
@@ -35,6 +35,9 @@ struct _GimpUndoStack
   GimpUndo       parent_instance;
 
   GimpContainer *undos;
+
+  GimpUndoStack *parent;   /* the stack this stack is pushed to, if any  */
+  gint64         memsize;  /* running total of the memsize of all undos  */
 };
 
 struct _GimpUndoStackClass
@@ -49,6 +52,8 @@ GimpUndoStack * gimp_undo_stack_new         (GimpImage           *image);
 
 void            gimp_undo_stack_push_undo   (GimpUndoStack       *stack,
                                              GimpUndo            *undo);
+void            gimp_undo_stack_update_undo (GimpUndoStack       *stack,
+                                             GimpUndo            *undo);
 GimpUndo      * gimp_undo_stack_pop_undo    (GimpUndoStack       *stack,
                                              GimpUndoMode         undo_mode,
                                              GimpUndoAccumulator *accum);
@@ -57,3 +62,6 @@ GimpUndo      * gimp_undo_stack_free_bottom (GimpUndoStack       *stack,
                                              GimpUndoMode         undo_mode);
 GimpUndo      * gimp_undo_stack_peek        (GimpUndoStack       *stack);
 gint            gimp_undo_stack_get_depth   (GimpUndoStack       *stack);
+gint64          gimp_undo_stack_get_size    (GimpUndoStack       *stack);
+
+guint64         gimp_undo_stack_get_total_memsize (void);
@@ -67,7 +67,7 @@ static void      selection_undraw         (Selection          *selection);
 
 static void      selection_render_mask    (Selection          *selection);
 
-static void      selection_zoom_segs      (Selection          *selection,
+static gint      selection_zoom_segs      (Selection          *selection,
                                            const GimpBoundSeg *src_segs,
                                            GimpSegment        *dest_segs,
                                            gint                n_segs,
@@ -344,7 +344,7 @@ selection_render_mask (Selection *selection)
   cairo_surface_destroy (surface);
 }
 
-static void
+static gint
 selection_zoom_segs (Selection          *selection,
                      const GimpBoundSeg *src_segs,
                      GimpSegment        *dest_segs,
@@ -354,21 +354,34 @@ selection_zoom_segs (Selection          *selection,
 {
   const gint xclamp = selection->shell->disp_width + 1;
   const gint yclamp = selection->shell->disp_height + 1;
-  gint       i;
+  gint       i, j;
 
   gimp_display_shell_zoom_segments (selection->shell,
                                     src_segs, dest_segs, n_segs,
                                     0.0, 0.0);
 
-  for (i = 0; i < n_segs; i++)
+  for (i = 0, j = 0; i < n_segs; i++)
     {
       if (! selection->shell->rotate_transform)
         {
-          dest_segs[i].x1 = CLAMP (dest_segs[i].x1, -1, xclamp) + canvas_offset_x;
-          dest_segs[i].y1 = CLAMP (dest_segs[i].y1, -1, yclamp) + canvas_offset_y;
-
-          dest_segs[i].x2 = CLAMP (dest_segs[i].x2, -1, xclamp) + canvas_offset_x;
-          dest_segs[i].y2 = CLAMP (dest_segs[i].y2, -1, yclamp) + canvas_offset_y;
+          /*  Drop the segments lying entirely outside the viewport,
+           *  clamping would only move them onto its invisible border
+           */
+          if ((dest_segs[i].x1 < -1     && dest_segs[i].x2 < -1)     ||
+              (dest_segs[i].x1 > xclamp && dest_segs[i].x2 > xclamp) ||
+              (dest_segs[i].y1 < -1     && dest_segs[i].y2 < -1)     ||
+              (dest_segs[i].y1 > yclamp && dest_segs[i].y2 > yclamp))
+            continue;
+
+          dest_segs[j].x1 = CLAMP (dest_segs[i].x1, -1, xclamp) + canvas_offset_x;
+          dest_segs[j].y1 = CLAMP (dest_segs[i].y1, -1, yclamp) + canvas_offset_y;
+
+          dest_segs[j].x2 = CLAMP (dest_segs[i].x2, -1, xclamp) + canvas_offset_x;
+          dest_segs[j].y2 = CLAMP (dest_segs[i].y2, -1, yclamp) + canvas_offset_y;
+        }
+      else
+        {
+          dest_segs[j] = dest_segs[i];
         }
 
       /*  If this segment is a closing segment && the segments lie inside
@@ -379,18 +392,22 @@ selection_zoom_segs (Selection          *selection,
       if (! src_segs[i].open)
         {
           /*  If it is vertical  */
-          if (dest_segs[i].x1 == dest_segs[i].x2)
+          if (dest_segs[j].x1 == dest_segs[j].x2)
             {
-              dest_segs[i].x1 -= 1;
-              dest_segs[i].x2 -= 1;
+              dest_segs[j].x1 -= 1;
+              dest_segs[j].x2 -= 1;
             }
           else
             {
-              dest_segs[i].y1 -= 1;
-              dest_segs[i].y2 -= 1;
+              dest_segs[j].y1 -= 1;
+              dest_segs[j].y2 -= 1;
             }
         }
+
+      j++;
     }
+
+  return j;
 }
 
 static void
@@ -415,9 +432,10 @@ selection_generate_segs (Selection *selection)
   if (selection->n_segs_in)
     {
       selection->segs_in = g_new (GimpSegment, selection->n_segs_in);
-      selection_zoom_segs (selection, segs_in,
-                           selection->segs_in, selection->n_segs_in,
-                           canvas_offset_x, canvas_offset_y);
+      selection->n_segs_in =
+        selection_zoom_segs (selection, segs_in,
+                             selection->segs_in, selection->n_segs_in,
+                             canvas_offset_x, canvas_offset_y);
 
       selection_render_mask (selection);
     }
@@ -426,9 +444,10 @@ selection_generate_segs (Selection *selection)
   if (selection->n_segs_out)
     {
       selection->segs_out = g_new (GimpSegment, selection->n_segs_out);
-      selection_zoom_segs (selection, segs_out,
-                           selection->segs_out, selection->n_segs_out,
-                           canvas_offset_x, canvas_offset_y);
+      selection->n_segs_out =
+        selection_zoom_segs (selection, segs_out,
+                             selection->segs_out, selection->n_segs_out,
+                             canvas_offset_x, canvas_offset_y);
     }
 }
 
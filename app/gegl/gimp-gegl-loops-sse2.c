@@ -124,4 +124,243 @@ gimp_gegl_smudge_with_paint_process_sse2 (gfloat       *accum,
     }
 }
 
+/* helper function of gimp_gegl_convolve()
+ *
+ * dest[i] += weight * src[i], the buffers don't need to be aligned
+ */
+void
+gimp_gegl_convolve_accumulate_sse2 (gfloat       *dest,
+                                    const gfloat *src,
+                                    gfloat        weight,
+                                    gint          count)
+{
+  const __m128 v_weight = _mm_set1_ps (weight);
+
+  for (; count >= 8; count -= 8)
+    {
+      __m128 v_dest0 = _mm_loadu_ps (dest);
+      __m128 v_dest1 = _mm_loadu_ps (dest + 4);
+
+      v_dest0 = _mm_add_ps (v_dest0, _mm_mul_ps (_mm_loadu_ps (src),     v_weight));
+      v_dest1 = _mm_add_ps (v_dest1, _mm_mul_ps (_mm_loadu_ps (src + 4), v_weight));
+
+      _mm_storeu_ps (dest,     v_dest0);
+      _mm_storeu_ps (dest + 4, v_dest1);
+
+      dest += 8;
+      src  += 8;
+    }
+
+  for (; count >= 4; count -= 4)
+    {
+      _mm_storeu_ps (dest, _mm_add_ps (_mm_loadu_ps (dest),
+                                       _mm_mul_ps (_mm_loadu_ps (src), v_weight)));
+
+      dest += 4;
+      src  += 4;
+    }
+
+  while (count--)
+    *dest++ += weight * *src++;
+}
+
+
+/* helper function of gimp_gegl_mask_combine_buffer()
+ *
+ * combines count values of add_on into mask using op, and clamps the
+ * result to [0, 1], the buffers don't need to be aligned
+ */
+void
+gimp_gegl_mask_combine_buffer_process_sse2 (gfloat         *mask,
+                                            const gfloat   *add_on,
+                                            gint            count,
+                                            GimpChannelOps  op)
+{
+  const __m128 v_zero = _mm_setzero_ps ();
+  const __m128 v_one  = _mm_set1_ps (1.0f);
+
+  for (; count >= 4; count -= 4)
+    {
+      __m128 v_mask   = _mm_loadu_ps (mask);
+      __m128 v_add_on = _mm_loadu_ps (add_on);
+
+      switch (op)
+        {
+        case GIMP_CHANNEL_OP_REPLACE:
+          v_mask = v_add_on;
+          break;
+
+        case GIMP_CHANNEL_OP_ADD:
+          v_mask = _mm_add_ps (v_mask, v_add_on);
+          break;
+
+        case GIMP_CHANNEL_OP_SUBTRACT:
+          v_mask = _mm_sub_ps (v_mask, v_add_on);
+          break;
+
+        case GIMP_CHANNEL_OP_INTERSECT:
+          v_mask = _mm_min_ps (v_mask, v_add_on);
+          break;
+        }
+
+      _mm_storeu_ps (mask, _mm_min_ps (_mm_max_ps (v_mask, v_zero), v_one));
+
+      mask   += 4;
+      add_on += 4;
+    }
+
+  while (count--)
+    {
+      gfloat val = *add_on;
+
+      switch (op)
+        {
+        case GIMP_CHANNEL_OP_REPLACE:                          break;
+        case GIMP_CHANNEL_OP_ADD:       val = *mask + val;     break;
+        case GIMP_CHANNEL_OP_SUBTRACT:  val = *mask - val;     break;
+        case GIMP_CHANNEL_OP_INTERSECT: val = MIN (*mask, val); break;
+        }
+
+      *mask = CLAMP (val, 0.0f, 1.0f);
+
+      mask++;
+      add_on++;
+    }
+}
+
+/* helper function of gimp_gegl_apply_mask_process_sse2()
+ *
+ * multiplies the alpha of the RGBA pixel at dest by the value
+ * broadcast in v_value
+ */
+static inline void
+gimp_gegl_apply_mask_pixel_sse2 (gfloat *dest,
+                                 __m128  v_value)
+{
+  const __m128 v_one   = _mm_set1_ps (1.0f);
+  const __m128 v_alpha = _mm_castsi128_ps (_mm_set_epi32 (-1, 0, 0, 0));
+  __m128       v_factor;
+
+  /*  { 1, 1, 1, value }  */
+  v_factor = _mm_or_ps (_mm_and_ps    (v_alpha, v_value),
+                        _mm_andnot_ps (v_alpha, v_one));
+
+  _mm_storeu_ps (dest, _mm_mul_ps (_mm_loadu_ps (dest), v_factor));
+}
+
+/* helper function of gimp_gegl_apply_mask()
+ *
+ * dest is RGBA, dest[3] *= mask[i] * opacity, the buffers don't need
+ * to be aligned
+ */
+void
+gimp_gegl_apply_mask_process_sse2 (const gfloat *mask,
+                                   gfloat       *dest,
+                                   gint          count,
+                                   gfloat        opacity)
+{
+  const __m128 v_opacity = _mm_set1_ps (opacity);
+
+  for (; count >= 4; count -= 4)
+    {
+      __m128 v_mask = _mm_mul_ps (_mm_loadu_ps (mask), v_opacity);
+
+      gimp_gegl_apply_mask_pixel_sse2 (dest,
+                                       _mm_shuffle_ps (v_mask, v_mask,
+                                                       _MM_SHUFFLE (0, 0, 0, 0)));
+      gimp_gegl_apply_mask_pixel_sse2 (dest + 4,
+                                       _mm_shuffle_ps (v_mask, v_mask,
+                                                       _MM_SHUFFLE (1, 1, 1, 1)));
+      gimp_gegl_apply_mask_pixel_sse2 (dest + 8,
+                                       _mm_shuffle_ps (v_mask, v_mask,
+                                                       _MM_SHUFFLE (2, 2, 2, 2)));
+      gimp_gegl_apply_mask_pixel_sse2 (dest + 12,
+                                       _mm_shuffle_ps (v_mask, v_mask,
+                                                       _MM_SHUFFLE (3, 3, 3, 3)));
+
+      mask += 4;
+      dest += 16;
+    }
+
+  while (count--)
+    {
+      dest[3] *= *mask * opacity;
+
+      mask += 1;
+      dest += 4;
+    }
+}
+
+/* helper function of gimp_gegl_combine_mask()
+ *
+ * dest[i] *= mask[i] * opacity, the buffers don't need to be aligned
+ */
+void
+gimp_gegl_combine_mask_process_sse2 (const gfloat *mask,
+                                     gfloat       *dest,
+                                     gint          count,
+                                     gfloat        opacity)
+{
+  const __m128 v_opacity = _mm_set1_ps (opacity);
+
+  for (; count >= 4; count -= 4)
+    {
+      __m128 v_mask = _mm_mul_ps (_mm_loadu_ps (mask), v_opacity);
+
+      _mm_storeu_ps (dest, _mm_mul_ps (_mm_loadu_ps (dest), v_mask));
+
+      mask += 4;
+      dest += 4;
+    }
+
+  while (count--)
+    *dest++ *= *mask++ * opacity;
+}
+
+/* helper function of gimp_gegl_combine_mask_weird()
+ *
+ * see there for what it does, the buffers don't need to be aligned
+ */
+void
+gimp_gegl_combine_mask_weird_process_sse2 (const gfloat *mask,
+                                           gfloat       *dest,
+                                           gint          count,
+                                           gfloat        opacity,
+                                           gboolean      stipple)
+{
+  const __m128 v_opacity = _mm_set1_ps (opacity);
+  const __m128 v_target  = stipple ? _mm_set1_ps (1.0f) : v_opacity;
+
+  for (; count >= 4; count -= 4)
+    {
+      __m128 v_dest = _mm_loadu_ps (dest);
+      __m128 v_delta;
+
+      /*  dest += (target - dest) * mask * opacity  */
+      v_delta = _mm_mul_ps (_mm_mul_ps (_mm_sub_ps (v_target, v_dest),
+                                        _mm_loadu_ps (mask)),
+                            v_opacity);
+
+      /*  without stipple, only where opacity > dest  */
+      if (! stipple)
+        v_delta = _mm_and_ps (_mm_cmpgt_ps (v_opacity, v_dest), v_delta);
+
+      _mm_storeu_ps (dest, _mm_add_ps (v_dest, v_delta));
+
+      mask += 4;
+      dest += 4;
+    }
+
+  while (count--)
+    {
+      if (stipple)
+        dest[0] += (1.0 - dest[0]) * *mask * opacity;
+      else if (opacity > dest[0])
+        dest[0] += (opacity - dest[0]) * *mask * opacity;
+
+      mask += 1;
+      dest += 1;
+    }
+}
+
 #endif /* COMPILE_SSE2_INTRINISICS */
@@ -33,4 +33,28 @@ void   gimp_gegl_smudge_with_paint_process_sse2 (gfloat       *accum,
                                                  gfloat        flow,
                                                  gfloat        rate);
 
+void   gimp_gegl_convolve_accumulate_sse2       (gfloat       *dest,
+                                                 const gfloat *src,
+                                                 gfloat        weight,
+                                                 gint          count);
+
+void   gimp_gegl_mask_combine_buffer_process_sse2 (gfloat         *mask,
+                                                   const gfloat   *add_on,
+                                                   gint            count,
+                                                   GimpChannelOps  op);
+
+void   gimp_gegl_apply_mask_process_sse2        (const gfloat *mask,
+                                                 gfloat       *dest,
+                                                 gint          count,
+                                                 gfloat        opacity);
+void   gimp_gegl_combine_mask_process_sse2      (const gfloat *mask,
+                                                 gfloat       *dest,
+                                                 gint          count,
+                                                 gfloat        opacity);
+void   gimp_gegl_combine_mask_weird_process_sse2 (const gfloat *mask,
+                                                  gfloat       *dest,
+                                                  gint          count,
+                                                  gfloat        opacity,
+                                                  gboolean      stipple);
+
 #endif /* COMPILE_SSE2_INTRINISICS */
@@ -48,6 +48,8 @@ extern "C"
 #define PIXELS_PER_THREAD \
   (/* each thread costs as much as */ 64.0 * 64.0 /* pixels */)
 
+#define CONVOLVE_STRIP_HEIGHT 64
+
 #define SHIFTED_AREA(dest, src)                                                \
   const GeglRectangle dest##_area_ = {                                         \
     src##_area->x + (dest##_rect->x - src##_rect->x),                          \
@@ -192,6 +194,85 @@ gimp_gegl_clear (GeglBuffer          *buffer,
     });
 }
 
+/*  tries to write @kernel as the outer product of a vertical @col and a
+ *  horizontal @row kernel, so that it can be applied in two 1D passes.
+ */
+static gboolean
+gimp_gegl_convolve_separate_kernel (const gfloat *kernel,
+                                    gint          kernel_size,
+                                    gfloat       *row,
+                                    gfloat       *col)
+{
+  gfloat max_value = 0.0f;
+  gint   max_i     = 0;
+  gint   max_j     = 0;
+  gint   i, j;
+
+  for (i = 0; i < kernel_size; i++)
+    {
+      for (j = 0; j < kernel_size; j++)
+        {
+          gfloat value = fabsf (kernel[i * kernel_size + j]);
+
+          if (value > max_value)
+            {
+              max_value = value;
+              max_i     = i;
+              max_j     = j;
+            }
+        }
+    }
+
+  if (max_value == 0.0f)
+    return FALSE;
+
+  for (j = 0; j < kernel_size; j++)
+    row[j] = kernel[max_i * kernel_size + j];
+
+  for (i = 0; i < kernel_size; i++)
+    col[i] = kernel[i * kernel_size + max_j] / row[max_j];
+
+  for (i = 0; i < kernel_size; i++)
+    {
+      for (j = 0; j < kernel_size; j++)
+        {
+          if (fabsf (col[i] * row[j] - kernel[i * kernel_size + j]) >
+              1e-6f * max_value)
+            {
+              return FALSE;
+            }
+        }
+    }
+
+  return TRUE;
+}
+
+/*  dest[i] += weight * src[i], the inner loop of both the generic and
+ *  the separable paths of gimp_gegl_convolve()
+ */
+static inline void
+gimp_gegl_convolve_accumulate (gfloat       *dest,
+                               const gfloat *src,
+                               gfloat        weight,
+                               gint          count,
+                               gboolean      sse2)
+{
+  if (weight == 0.0f)
+    return;
+
+#if COMPILE_SSE2_INTRINISICS
+  if (sse2)
+    {
+      gimp_gegl_convolve_accumulate_sse2 (dest, src, weight, count);
+
+      return;
+    }
+#endif
+
+  while (count--)
+    *dest++ += weight * *src++;
+}
+
 void
 gimp_gegl_convolve (GeglBuffer          *src_buffer,
                     const GeglRectangle *src_rect,
@@ -209,8 +290,15 @@ gimp_gegl_convolve (GeglBuffer          *src_buffer,
   const Babl *src_format;
   const Babl *dest_format;
   gint        src_components;
-  gint        dest_components;
   gfloat      offset;
+  gfloat     *row;
+  gfloat     *col;
+  gboolean    separable;
+  gboolean    sse2 = FALSE;
+
+#if COMPILE_SSE2_INTRINISICS
+  sse2 = (gimp_cpu_accel_get_support () & GIMP_CPU_ACCEL_X86_SSE2) != 0;
+#endif
 
   if (! src_rect)
     src_rect = gegl_buffer_get_extent (src_buffer);
@@ -244,8 +332,7 @@ gimp_gegl_convolve (GeglBuffer          *src_buffer,
                                     babl_format_has_alpha (dest_format),
                                     babl_format_get_space (dest_format));
 
-  src_components  = babl_format_get_n_components (src_format);
-  dest_components = babl_format_get_n_components (dest_format);
+  src_components = babl_format_get_n_components (src_format);
 
   /* Get source pixel data */
   src_rowstride = src_components * src_rect->width;
@@ -253,6 +340,32 @@ gimp_gegl_convolve (GeglBuffer          *src_buffer,
   gegl_buffer_get (src_buffer, src_rect, 1.0, src_format, src,
                    GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
 
+  /*  With alpha weighting, each color is weighted by the kernel times
+   *  its alpha, and divided by the sum of these weights, which is the
+   *  convolved alpha itself.  Premultiplying the source lets all the
+   *  components go through the same convolution.
+   */
+  if (alpha_weighting)
+    {
+      gegl_parallel_distribute_range (
+        src_rect->height, PIXELS_PER_THREAD / src_rect->width,
+        [=] (gint y0, gint height)
+        {
+          const gint  a_component = src_components - 1;
+          gfloat     *s           = src + y0 * src_rowstride;
+          gint        n           = height * src_rect->width;
+          gint        b;
+
+          while (n--)
+            {
+              for (b = 0; b < a_component; b++)
+                s[b] *= s[a_component];
+
+              s += src_components;
+            }
+        });
+    }
+
   /*  If the mode is NEGATIVE_CONVOL, the offset should be 0.5  */
   if (mode == GIMP_NEGATIVE_CONVOL)
     {
@@ -264,128 +377,169 @@ gimp_gegl_convolve (GeglBuffer          *src_buffer,
       offset = 0.0;
     }
 
+  row = g_new (gfloat, kernel_size);
+  col = g_new (gfloat, kernel_size);
+
+  separable = kernel_size > 1 &&
+              gimp_gegl_convolve_separate_kernel (kernel, kernel_size,
+                                                  row, col);
+
   gegl_parallel_distribute_area (
     dest_rect, PIXELS_PER_THREAD,
     [=] (const GeglRectangle *dest_area)
     {
-      const gint          components  = src_components;
-      const gint          a_component = components - 1;
-      const gint          margin      = kernel_size / 2;
-      GeglBufferIterator *dest_iter;
-
-      /* Set up dest iterator */
-      dest_iter = gegl_buffer_iterator_new (dest_buffer, dest_area, 0, dest_format,
-                                            GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE, 1);
-
-      while (gegl_buffer_iterator_next (dest_iter))
+      /*  Convolve the src image using the convolution kernel, writing
+       *  to dest.  Convolve is not tile-enabled--use accordingly.
+       *
+       *  The area is processed in strips of rows.  The source rows
+       *  covered by the kernel for a strip are first copied to a buffer
+       *  padded by repeating the edge pixels, so that the kernel is
+       *  applied to whole, contiguous rows.  The temporary buffers only
+       *  hold a strip, regardless of the size of the area.
+       */
+      const gint  components   = src_components;
+      const gint  a_component  = components - 1;
+      const gint  margin       = kernel_size / 2;
+      const gint  x2           = src_rect->width  - 1;
+      const gint  y2           = src_rect->height - 1;
+      const gint  row_len      = dest_area->width * components;
+      const gint  pad_len      = (dest_area->width + 2 * margin) * components;
+      const gint  strip_height = MIN (dest_area->height,
+                                      MAX (CONVOLVE_STRIP_HEIGHT,
+                                           kernel_size));
+      gfloat     *pad;
+      gfloat     *total;
+      gfloat     *horz = NULL;
+      gint        strip_y;
+
+      pad   = g_new (gfloat, pad_len * (strip_height + 2 * margin));
+      total = g_new (gfloat, row_len * strip_height);
+
+      if (separable)
+        horz = g_new (gfloat, row_len * (strip_height + 2 * margin));
+
+      for (strip_y = 0; strip_y < dest_area->height; strip_y += strip_height)
         {
-          /*  Convolve the src image using the convolution kernel, writing
-           *  to dest Convolve is not tile-enabled--use accordingly
-           */
-          gfloat     *dest    = (gfloat *) dest_iter->items[0].data;
-          const gint  x1      = 0;
-          const gint  y1      = 0;
-          const gint  x2      = src_rect->width  - 1;
-          const gint  y2      = src_rect->height - 1;
-          const gint  dest_x1 = dest_iter->items[0].roi.x;
-          const gint  dest_y1 = dest_iter->items[0].roi.y;
-          const gint  dest_x2 = dest_iter->items[0].roi.x + dest_iter->items[0].roi.width;
-          const gint  dest_y2 = dest_iter->items[0].roi.y + dest_iter->items[0].roi.height;
-          gint        x, y;
-
-          for (y = dest_y1; y < dest_y2; y++)
+          const GeglRectangle strip = {
+            dest_area->x,
+            dest_area->y + strip_y,
+            dest_area->width,
+            MIN (strip_height, dest_area->height - strip_y)
+          };
+          const gint  pad_height = strip.height + 2 * margin;
+          gfloat     *t;
+          gint        x, y, i, j, b;
+
+          for (y = 0; y < pad_height; y++)
             {
-              gfloat *d = dest;
+              const gint    yy = CLAMP (strip.y - margin + y, 0, y2);
+              const gfloat *s  = src + yy * src_rowstride;
+              gfloat       *p  = pad + y * pad_len;
 
-              if (alpha_weighting)
+              for (x = 0; x < strip.width + 2 * margin; x++)
                 {
-                  for (x = dest_x1; x < dest_x2; x++)
-                    {
-                      const gfloat *m                = kernel;
-                      gdouble       total[4]         = { 0.0, 0.0, 0.0, 0.0 };
-                      gdouble       weighted_divisor = 0.0;
-                      gint          i, j, b;
-
-                      for (j = y - margin; j <= y + margin; j++)
-                        {
-                          for (i = x - margin; i <= x + margin; i++, m++)
-                            {
-                              gint          xx = CLAMP (i, x1, x2);
-                              gint          yy = CLAMP (j, y1, y2);
-                              const gfloat *s  = src + yy * src_rowstride + xx * components;
-                              const gfloat  a  = s[a_component];
+                  const gint xx = CLAMP (strip.x - margin + x, 0, x2);
 
-                              if (a)
-                                {
-                                  gdouble mult_alpha = *m * a;
+                  memcpy (p, s + xx * components,
+                          components * sizeof (gfloat));
 
-                                  weighted_divisor += mult_alpha;
+                  p += components;
+                }
+            }
 
-                                  for (b = 0; b < a_component; b++)
-                                    total[b] += mult_alpha * s[b];
+          memset (total, 0, row_len * strip.height * sizeof (gfloat));
 
-                                  total[a_component] += mult_alpha;
-                                }
-                            }
-                        }
+          if (separable)
+            {
+              memset (horz, 0, row_len * pad_height * sizeof (gfloat));
 
-                      if (weighted_divisor == 0.0)
-                        weighted_divisor = divisor;
+              for (y = 0; y < pad_height; y++)
+                {
+                  for (j = 0; j < kernel_size; j++)
+                    {
+                      gimp_gegl_convolve_accumulate (horz + y * row_len,
+                                                     pad  + y * pad_len +
+                                                            j * components,
+                                                     row[j], row_len, sse2);
+                    }
+                }
 
-                      for (b = 0; b < a_component; b++)
-                        total[b] /= weighted_divisor;
+              for (y = 0; y < strip.height; y++)
+                {
+                  for (i = 0; i < kernel_size; i++)
+                    {
+                      gimp_gegl_convolve_accumulate (total + y * row_len,
+                                                     horz  + (y + i) * row_len,
+                                                     col[i], row_len, sse2);
+                    }
+                }
+            }
+          else
+            {
+              for (y = 0; y < strip.height; y++)
+                {
+                  const gfloat *m = kernel;
 
-                      total[a_component] /= divisor;
+                  for (i = 0; i < kernel_size; i++)
+                    {
+                      const gfloat *p = pad + (y + i) * pad_len;
 
-                      for (b = 0; b < components; b++)
+                      for (j = 0; j < kernel_size; j++, m++)
                         {
-                          total[b] += offset;
-
-                          if (mode != GIMP_NORMAL_CONVOL && total[b] < 0.0)
-                            total[b] = - total[b];
-
-                          *d++ = CLAMP (total[b], 0.0, 1.0);
+                          gimp_gegl_convolve_accumulate (total + y * row_len,
+                                                         p + j * components,
+                                                         *m, row_len, sse2);
                         }
                     }
                 }
-              else
+            }
+
+          t = total;
+
+          for (i = 0; i < strip.width * strip.height; i++)
+            {
+              if (alpha_weighting)
                 {
-                  for (x = dest_x1; x < dest_x2; x++)
-                    {
-                      const gfloat *m        = kernel;
-                      gdouble       total[4] = { 0.0, 0.0, 0.0, 0.0 };
-                      gint          i, j, b;
+                  gfloat weighted_divisor = t[a_component];
 
-                      for (j = y - margin; j <= y + margin; j++)
-                        {
-                          for (i = x - margin; i <= x + margin; i++, m++)
-                            {
-                              gint          xx = CLAMP (i, x1, x2);
-                              gint          yy = CLAMP (j, y1, y2);
-                              const gfloat *s  = src + yy * src_rowstride + xx * components;
-
-                              for (b = 0; b < components; b++)
-                                total[b] += *m * s[b];
-                            }
-                        }
+                  if (weighted_divisor == 0.0f)
+                    weighted_divisor = divisor;
 
-                      for (b = 0; b < components; b++)
-                        {
-                          total[b] = total[b] / divisor + offset;
+                  for (b = 0; b < a_component; b++)
+                    t[b] /= weighted_divisor;
 
-                          if (mode != GIMP_NORMAL_CONVOL && total[b] < 0.0)
-                            total[b] = - total[b];
+                  t[a_component] /= divisor;
+                }
+              else
+                {
+                  for (b = 0; b < components; b++)
+                    t[b] /= divisor;
+                }
 
-                          *d++ = CLAMP (total[b], 0.0, 1.0);
-                        }
-                    }
+              for (b = 0; b < components; b++)
+                {
+                  t[b] += offset;
+
+                  if (mode != GIMP_NORMAL_CONVOL && t[b] < 0.0f)
+                    t[b] = - t[b];
+
+                  t[b] = CLAMP (t[b], 0.0f, 1.0f);
                 }
 
-              dest += dest_iter->items[0].roi.width * dest_components;
+              t += components;
             }
+
+          gegl_buffer_set (dest_buffer, &strip, 0, dest_format,
+                           total, GEGL_AUTO_ROWSTRIDE);
         }
+
+      g_free (horz);
+      g_free (total);
+      g_free (pad);
     });
 
+  g_free (row);
+  g_free (col);
   g_free (src);
 }
 
@@ -713,6 +867,11 @@ gimp_gegl_apply_mask (GeglBuffer          *mask_buffer,
                       const GeglRectangle *dest_rect,
                       gdouble              opacity)
 {
+#if COMPILE_SSE2_INTRINISICS
+  gboolean sse2 = (gimp_cpu_accel_get_support () &
+                   GIMP_CPU_ACCEL_X86_SSE2) != 0;
+#endif
+
   if (! mask_rect)
     mask_rect = gegl_buffer_get_extent (mask_buffer);
 
@@ -741,6 +900,16 @@ gimp_gegl_apply_mask (GeglBuffer          *mask_buffer,
           gfloat       *dest  = (gfloat *)       iter->items[1].data;
           gint          count = iter->length;
 
+#if COMPILE_SSE2_INTRINISICS
+          if (sse2)
+            {
+              gimp_gegl_apply_mask_process_sse2 (mask, dest, count,
+                                                 opacity);
+
+              continue;
+            }
+#endif
+
           while (count--)
             {
               dest[3] *= *mask * opacity;
@@ -759,6 +928,11 @@ gimp_gegl_combine_mask (GeglBuffer          *mask_buffer,
                         const GeglRectangle *dest_rect,
                         gdouble              opacity)
 {
+#if COMPILE_SSE2_INTRINISICS
+  gboolean sse2 = (gimp_cpu_accel_get_support () &
+                   GIMP_CPU_ACCEL_X86_SSE2) != 0;
+#endif
+
   if (! mask_rect)
     mask_rect = gegl_buffer_get_extent (mask_buffer);
 
@@ -787,6 +961,16 @@ gimp_gegl_combine_mask (GeglBuffer          *mask_buffer,
           gfloat       *dest  = (gfloat *)       iter->items[1].data;
           gint          count = iter->length;
 
+#if COMPILE_SSE2_INTRINISICS
+          if (sse2)
+            {
+              gimp_gegl_combine_mask_process_sse2 (mask, dest, count,
+                                                   opacity);
+
+              continue;
+            }
+#endif
+
           while (count--)
             {
               *dest *= *mask * opacity;
@@ -806,6 +990,11 @@ gimp_gegl_combine_mask_weird (GeglBuffer          *mask_buffer,
                               gdouble              opacity,
                               gboolean             stipple)
 {
+#if COMPILE_SSE2_INTRINISICS
+  gboolean sse2 = (gimp_cpu_accel_get_support () &
+                   GIMP_CPU_ACCEL_X86_SSE2) != 0;
+#endif
+
   if (! mask_rect)
     mask_rect = gegl_buffer_get_extent (mask_buffer);
 
@@ -834,6 +1023,16 @@ gimp_gegl_combine_mask_weird (GeglBuffer          *mask_buffer,
           gfloat       *dest  = (gfloat *)       iter->items[1].data;
           gint          count = iter->length;
 
+#if COMPILE_SSE2_INTRINISICS
+          if (sse2)
+            {
+              gimp_gegl_combine_mask_weird_process_sse2 (mask, dest, count,
+                                                         opacity, stipple);
+
+              continue;
+            }
+#endif
+
           if (stipple)
             {
               while (count--)
@@ -32,6 +32,7 @@ extern "C"
 
 #include "gimp-babl.h"
 #include "gimp-gegl-loops.h"
+#include "gimp-gegl-loops-sse2.h"
 #include "gimp-gegl-mask-combine.h"
 
 
@@ -510,6 +511,10 @@ gimp_gegl_mask_combine_buffer (GeglBuffer     *mask,
   GeglRectangle  add_on_rect;
   const Babl    *mask_format;
   const Babl    *add_on_format;
+#if COMPILE_SSE2_INTRINISICS
+  gboolean       sse2 = (gimp_cpu_accel_get_support () &
+                         GIMP_CPU_ACCEL_X86_SSE2) != 0;
+#endif
 
   g_return_val_if_fail (GEGL_IS_BUFFER (mask), FALSE);
   g_return_val_if_fail (GEGL_IS_BUFFER (add_on), FALSE);
@@ -591,6 +596,21 @@ gimp_gegl_mask_combine_buffer (GeglBuffer     *mask,
                                 add_on_format,
                                 GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
 
+#if COMPILE_SSE2_INTRINISICS
+      if (sse2)
+        {
+          while (gegl_buffer_iterator_next (iter))
+            {
+              gimp_gegl_mask_combine_buffer_process_sse2 (
+                (gfloat       *) iter->items[0].data,
+                (const gfloat *) iter->items[1].data,
+                iter->length, op);
+            }
+
+          return;
+        }
+#endif
+
       auto process = [=] (auto value)
       {
         while (gegl_buffer_iterator_next (iter))
@@ -337,6 +337,54 @@ gimp_gegl_buffer_dup (GeglBuffer *buffer)
   return new_buffer;
 }
 
+/*  returns a copy of @rect of @buffer, as a new buffer whose extent is
+ *  (0, 0, width, height).  @rect is grown to whole tiles, so that with
+ *  the same tile size as @buffer, the new buffer's tile grid lines up
+ *  with it, and all of its tiles are shared copy-on-write with @buffer
+ *  rather than copied.  only tiles later written to, in
+ *  either buffer, are actually duplicated.  copying the snapshot back
+ *  to @snapshot_rect of @buffer shares its tiles the same way.
+ */
+GeglBuffer *
+gimp_gegl_buffer_snapshot (GeglBuffer          *buffer,
+                           const GeglRectangle *rect,
+                           GeglRectangle       *snapshot_rect)
+{
+  GeglBuffer    *new_buffer;
+  GeglRectangle  aligned;
+  gint           tile_width;
+  gint           tile_height;
+
+  g_return_val_if_fail (GEGL_IS_BUFFER (buffer), NULL);
+  g_return_val_if_fail (rect != NULL, NULL);
+
+  gegl_rectangle_align_to_buffer (&aligned, rect, buffer,
+                                  GEGL_RECTANGLE_ALIGNMENT_SUPERSET);
+
+  g_object_get (buffer,
+                "tile-width",  &tile_width,
+                "tile-height", &tile_height,
+                NULL);
+
+  new_buffer = g_object_new (GEGL_TYPE_BUFFER,
+                             "format",      gegl_buffer_get_format (buffer),
+                             "x",           0,
+                             "y",           0,
+                             "width",       aligned.width,
+                             "height",      aligned.height,
+                             "tile-width",  tile_width,
+                             "tile-height", tile_height,
+                             NULL);
+
+  gegl_buffer_copy (buffer, &aligned, GEGL_ABYSS_NONE,
+                    new_buffer, GEGL_RECTANGLE (0, 0, 0, 0));
+
+  if (snapshot_rect)
+    *snapshot_rect = aligned;
+
+  return new_buffer;
+}
+
 GeglBuffer *
 gimp_gegl_buffer_resize (GeglBuffer   *buffer,
                          gint          new_width,
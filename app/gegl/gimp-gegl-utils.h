@@ -53,6 +53,9 @@ gboolean      gimp_gegl_param_spec_has_key            (GParamSpec          *pspe
                                                        const gchar         *value);
 
 GeglBuffer  * gimp_gegl_buffer_dup                    (GeglBuffer          *buffer);
+GeglBuffer  * gimp_gegl_buffer_snapshot               (GeglBuffer          *buffer,
+                                                       const GeglRectangle *rect,
+                                                       GeglRectangle       *snapshot_rect);
 GeglBuffer  * gimp_gegl_buffer_resize                 (GeglBuffer          *buffer,
                                                        gint                 new_width,
                                                        gint                 new_height,
@@ -60,7 +60,8 @@ gimp_console_app_new (Gimp        *gimp,
                       gboolean     as_new,
                       const char **filenames,
                       const char  *batch_interpreter,
-                      const char **batch_commands)
+                      const char **batch_commands,
+                      gint         batch_jobs)
 {
   GimpConsoleApp *app;
 
@@ -78,6 +79,7 @@ gimp_console_app_new (Gimp        *gimp,
                       "quit",              quit,
                       "batch-interpreter", batch_interpreter,
                       "batch-commands",    batch_commands,
+                      "batch-jobs",        batch_jobs,
                       NULL);
 
   return G_APPLICATION (app);
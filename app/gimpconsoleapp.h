@@ -29,4 +29,5 @@ GApplication * gimp_console_app_new (Gimp         *gimp,
                                          gboolean      as_new,
                                          const char  **filenames,
                                          const char   *batch_interpreter,
-                                         const char  **batch_commands);
+                                         const char  **batch_commands,
+                                         gint          batch_jobs);
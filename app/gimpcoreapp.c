@@ -40,6 +40,7 @@ struct _GimpCoreAppPrivate
   gboolean    quit;
   gchar      *batch_interpreter;
   gchar     **batch_commands;
+  gint        batch_jobs;
   gint        exit_status;
 };
 
@@ -93,6 +94,13 @@ gimp_core_app_default_init (GimpCoreAppInterface *iface)
                                                            "Batch commands to run",
                                                            G_TYPE_STRV,
                                                            GIMP_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY));
+
+  g_object_interface_install_property (iface,
+                                       g_param_spec_int ("batch-jobs",
+                                                         "Batch jobs",
+                                                         "Number of batch commands to run concurrently, at least 1, or 0 for one per processor (--batch-jobs=auto)",
+                                                         0, G_MAXINT, 1,
+                                                         GIMP_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY));
 }
 
 
@@ -116,6 +124,7 @@ gimp_core_app_install_properties (GObjectClass *klass)
   g_object_class_override_property (klass, GIMP_CORE_APP_PROP_QUIT, "quit");
   g_object_class_override_property (klass, GIMP_CORE_APP_PROP_BATCH_INTERPRETER, "batch-interpreter");
   g_object_class_override_property (klass, GIMP_CORE_APP_PROP_BATCH_COMMANDS, "batch-commands");
+  g_object_class_override_property (klass, GIMP_CORE_APP_PROP_BATCH_JOBS, "batch-jobs");
 }
 
 void
@@ -148,6 +157,9 @@ gimp_core_app_set_property (GObject      *object,
     case GIMP_CORE_APP_PROP_BATCH_COMMANDS:
       private->batch_commands = g_value_dup_boxed (value);
       break;
+    case GIMP_CORE_APP_PROP_BATCH_JOBS:
+      private->batch_jobs = g_value_get_int (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -184,6 +196,9 @@ gimp_core_app_get_property (GObject    *object,
     case GIMP_CORE_APP_PROP_BATCH_COMMANDS:
       g_value_set_static_boxed (value, private->batch_commands);
       break;
+    case GIMP_CORE_APP_PROP_BATCH_JOBS:
+      g_value_set_int (value, private->batch_jobs);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -265,6 +280,18 @@ gimp_core_app_get_batch_commands (GimpCoreApp *self)
   return (const gchar **) private->batch_commands;
 }
 
+gint
+gimp_core_app_get_batch_jobs (GimpCoreApp *self)
+{
+  GimpCoreAppPrivate *private;
+
+  g_return_val_if_fail (GIMP_IS_CORE_APP (self), 1);
+
+  private = GIMP_CORE_APP_GET_PRIVATE (self);
+
+  return private->batch_jobs;
+}
+
 void
 gimp_core_app_set_exit_status (GimpCoreApp *self, gint exit_status)
 {
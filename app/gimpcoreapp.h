@@ -30,8 +30,9 @@ enum
   GIMP_CORE_APP_PROP_QUIT,
   GIMP_CORE_APP_PROP_BATCH_INTERPRETER,
   GIMP_CORE_APP_PROP_BATCH_COMMANDS,
+  GIMP_CORE_APP_PROP_BATCH_JOBS,
 
-  GIMP_CORE_APP_PROP_LAST = GIMP_CORE_APP_PROP_BATCH_COMMANDS,
+  GIMP_CORE_APP_PROP_LAST = GIMP_CORE_APP_PROP_BATCH_JOBS,
 };
 
 #define GIMP_TYPE_CORE_APP gimp_core_app_get_type()
@@ -61,6 +62,8 @@ const gchar *      gimp_core_app_get_batch_interpreter (GimpCoreApp *self);
 
 const gchar **     gimp_core_app_get_batch_commands    (GimpCoreApp *self);
 
+gint               gimp_core_app_get_batch_jobs        (GimpCoreApp *self);
+
 void               gimp_core_app_set_exit_status       (GimpCoreApp *self,
                                                         gint         exit_status);
 
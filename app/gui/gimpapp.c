@@ -125,7 +125,8 @@ gimp_app_new (Gimp        *gimp,
               gboolean     as_new,
               const char **filenames,
               const char  *batch_interpreter,
-              const char **batch_commands)
+              const char **batch_commands,
+              gint         batch_jobs)
 {
   GimpApp *app;
 
@@ -154,6 +155,7 @@ gimp_app_new (Gimp        *gimp,
                       "quit",              quit,
                       "batch-interpreter", batch_interpreter,
                       "batch-commands",    batch_commands,
+                      "batch-jobs",        batch_jobs,
 
                       "no-splash",         no_splash,
                       NULL);
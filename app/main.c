@@ -99,6 +99,10 @@ static gboolean  gimp_option_pdb_compat_mode  (const gchar  *option_name,
                                                const gchar  *value,
                                                gpointer      data,
                                                GError      **error);
+static gboolean  gimp_option_batch_jobs       (const gchar  *option_name,
+                                               const gchar  *value,
+                                               gpointer      data,
+                                               GError      **error);
 static gboolean  gimp_option_dump_gimprc      (const gchar  *option_name,
                                                const gchar  *value,
                                                gpointer      data,
@@ -126,6 +130,7 @@ static const gchar        *user_gimprc       = NULL;
 static const gchar        *session_name      = NULL;
 static const gchar        *batch_interpreter = NULL;
 static const gchar       **batch_commands    = NULL;
+static gint                batch_jobs        = 1;
 static const gchar       **filenames         = NULL;
 static gboolean            quit              = FALSE;
 static gboolean            as_new            = FALSE;
@@ -238,6 +243,12 @@ static const GOptionEntry main_entries[] =
     G_OPTION_ARG_STRING, &batch_interpreter,
     N_("The procedure to process batch commands with"), "<proc>"
   },
+  {
+    "batch-jobs", 0, 0,
+    G_OPTION_ARG_CALLBACK, gimp_option_batch_jobs,
+    /*  don't translate "auto"  */
+    N_("Number of batch commands to run concurrently (auto for one per processor)"), "<n|auto>"
+  },
   {
     "quit", 0, 0,
     G_OPTION_ARG_NONE, &quit,
@@ -877,6 +888,7 @@ main (int    argc,
                     session_name,
                     batch_interpreter,
                     batch_commands,
+                    batch_jobs,
                     quit,
                     as_new,
                     no_interface,
@@ -1019,6 +1031,37 @@ gimp_option_pdb_compat_mode (const gchar  *option_name,
   return TRUE;
 }
 
+static gboolean
+gimp_option_batch_jobs (const gchar  *option_name,
+                        const gchar  *value,
+                        gpointer      data,
+                        GError      **error)
+{
+  gint64 n_jobs;
+
+  /*  batch_jobs == 0 means one job per processor from here on  */
+  if (! strcmp (value, "auto"))
+    {
+      batch_jobs = 0;
+
+      return TRUE;
+    }
+
+  if (! g_ascii_string_to_signed (value, 10, 1, G_MAXINT, &n_jobs, NULL))
+    {
+      g_set_error (error, G_OPTION_ERROR, G_OPTION_ERROR_BAD_VALUE,
+                   _("Invalid value '%s' for %s: expected a number of "
+                     "jobs of at least 1, or 'auto'"),
+                   value, option_name);
+
+      return FALSE;
+    }
+
+  batch_jobs = n_jobs;
+
+  return TRUE;
+}
+
 static gboolean
 gimp_option_dump_gimprc (const gchar  *option_name,
                          const gchar  *value,
@@ -43,6 +43,7 @@
 #include "gimpoperationhistogramsink.h"
 #include "gimpoperationmaskcomponents.h"
 #include "gimpoperationoffset.h"
+#include "gimpoperationpointfilterchain.h"
 #include "gimpoperationprofiletransform.h"
 #include "gimpoperationscalarmultiply.h"
 #include "gimpoperationsemiflatten.h"
@@ -139,6 +140,7 @@ gimp_operations_init (Gimp *gimp)
   g_type_class_ref (GIMP_TYPE_OPERATION_HISTOGRAM_SINK);
   g_type_class_ref (GIMP_TYPE_OPERATION_MASK_COMPONENTS);
   g_type_class_ref (GIMP_TYPE_OPERATION_OFFSET);
+  g_type_class_ref (GIMP_TYPE_OPERATION_POINT_FILTER_CHAIN);
   g_type_class_ref (GIMP_TYPE_OPERATION_PROFILE_TRANSFORM);
   g_type_class_ref (GIMP_TYPE_OPERATION_SCALAR_MULTIPLY);
   g_type_class_ref (GIMP_TYPE_OPERATION_SEMI_FLATTEN);
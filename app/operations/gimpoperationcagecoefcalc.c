@@ -19,6 +19,8 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include <gdk-pixbuf/gdk-pixbuf.h>
 #include <gegl.h>
 
@@ -32,6 +34,43 @@
 #include "gimp-intl.h"
 
 
+#define PIXELS_PER_THREAD \
+  (/* each thread costs as much as */ 32.0 * 32.0 /* pixels */)
+
+/*  beyond this many moved edges, updating the reference coefficients
+ *  costs more than computing them from scratch
+ */
+#define MAX_INCREMENTAL_RATIO 0.5
+
+
+typedef struct
+{
+  GimpVector2  v1;   /* start point                 */
+  GimpVector2  a;    /* from start to end point     */
+  GimpVector2  dir;  /* a, normalized               */
+  gdouble      absa; /* length of a                 */
+  gdouble      Q;    /* squared length of a         */
+} CageEdge;
+
+typedef struct
+{
+  gint         n_points;
+  GimpVector2 *points;
+  CageEdge    *edges;  /* edge j goes from points[j] to points[j + 1] */
+} Cage;
+
+typedef struct
+{
+  GeglBuffer  *output;
+  GeglBuffer  *reference;
+  const Babl  *format;
+  Cage         cage;
+  Cage         old_cage;
+  gboolean    *changed;
+  gint         grid_size;
+} CoefCalcData;
+
+
 static void           gimp_operation_cage_coef_calc_finalize         (GObject              *object);
 static void           gimp_operation_cage_coef_calc_get_property     (GObject              *object,
                                                                       guint                 property_id,
@@ -49,6 +88,9 @@ static gboolean       gimp_operation_cage_coef_calc_process          (GeglOperat
                                                                       const GeglRectangle  *roi,
                                                                       gint                  level);
 
+static void           gimp_operation_cage_coef_calc_area             (const GeglRectangle  *area,
+                                                                      CoefCalcData         *data);
+
 
 G_DEFINE_TYPE (GimpOperationCageCoefCalc, gimp_operation_cage_coef_calc,
                GEGL_TYPE_OPERATION_SOURCE)
@@ -73,6 +115,8 @@ gimp_operation_cage_coef_calc_class_init (GimpOperationCageCoefCalcClass *klass)
   operation_class->get_bounding_box   = gimp_operation_cage_coef_calc_get_bounding_box;
   operation_class->cache_policy       = GEGL_CACHE_POLICY_ALWAYS;
   operation_class->get_cached_region  = NULL;
+  /* process() distributes the work itself */
+  operation_class->threaded           = FALSE;
 
   source_class->process               = gimp_operation_cage_coef_calc_process;
 
@@ -88,6 +132,31 @@ gimp_operation_cage_coef_calc_class_init (GimpOperationCageCoefCalcClass *klass)
                                                         GIMP_TYPE_CAGE_CONFIG,
                                                         G_PARAM_READWRITE |
                                                         G_PARAM_CONSTRUCT));
+
+  g_object_class_install_property (object_class,
+                                   GIMP_OPERATION_CAGE_COEF_CALC_PROP_REFERENCE_CONFIG,
+                                   g_param_spec_object ("reference-config",
+                                                        "Reference Config",
+                                                        "The cage the reference coefficients were computed for",
+                                                        GIMP_TYPE_CAGE_CONFIG,
+                                                        G_PARAM_READWRITE));
+
+  g_object_class_install_property (object_class,
+                                   GIMP_OPERATION_CAGE_COEF_CALC_PROP_REFERENCE,
+                                   g_param_spec_object ("reference",
+                                                        "Reference",
+                                                        "Previously computed coefficients, updated for the edges that moved",
+                                                        GEGL_TYPE_BUFFER,
+                                                        G_PARAM_READWRITE));
+
+  g_object_class_install_property (object_class,
+                                   GIMP_OPERATION_CAGE_COEF_CALC_PROP_GRID_SIZE,
+                                   g_param_spec_int ("grid-size",
+                                                     "Grid Size",
+                                                     "Compute the coefficients on a grid of this spacing, and interpolate in between",
+                                                     1, 64, 1,
+                                                     G_PARAM_READWRITE |
+                                                     G_PARAM_CONSTRUCT));
 }
 
 static void
@@ -101,6 +170,8 @@ gimp_operation_cage_coef_calc_finalize (GObject *object)
   GimpOperationCageCoefCalc *self = GIMP_OPERATION_CAGE_COEF_CALC (object);
 
   g_clear_object (&self->config);
+  g_clear_object (&self->reference_config);
+  g_clear_object (&self->reference);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -119,6 +190,18 @@ gimp_operation_cage_coef_calc_get_property (GObject    *object,
       g_value_set_object (value, self->config);
       break;
 
+    case GIMP_OPERATION_CAGE_COEF_CALC_PROP_REFERENCE_CONFIG:
+      g_value_set_object (value, self->reference_config);
+      break;
+
+    case GIMP_OPERATION_CAGE_COEF_CALC_PROP_REFERENCE:
+      g_value_set_object (value, self->reference);
+      break;
+
+    case GIMP_OPERATION_CAGE_COEF_CALC_PROP_GRID_SIZE:
+      g_value_set_int (value, self->grid_size);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -139,31 +222,22 @@ gimp_operation_cage_coef_calc_set_property (GObject      *object,
       g_set_object (&self->config, g_value_get_object (value));
       break;
 
-   default:
-      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+    case GIMP_OPERATION_CAGE_COEF_CALC_PROP_REFERENCE_CONFIG:
+      g_set_object (&self->reference_config, g_value_get_object (value));
       break;
-    }
-}
-
-static gboolean
-gimp_operation_cage_coef_calc_is_on_straight (GimpVector2 *d1,
-                                              GimpVector2 *d2,
-                                              GimpVector2 *p)
-{
-  GimpVector2 v1, v2;
-  gfloat      deter;
-
-  v1.x = p->x - d1->x;
-  v1.y = p->y - d1->y;
-  v2.x = d2->x - d1->x;
-  v2.y = d2->y - d1->y;
 
-  gimp_vector2_normalize (&v1);
-  gimp_vector2_normalize (&v2);
+    case GIMP_OPERATION_CAGE_COEF_CALC_PROP_REFERENCE:
+      g_set_object (&self->reference, g_value_get_object (value));
+      break;
 
-  deter = v1.x * v2.y - v2.x * v1.y;
+    case GIMP_OPERATION_CAGE_COEF_CALC_PROP_GRID_SIZE:
+      self->grid_size = g_value_get_int (value);
+      break;
 
-  return (deter < 0.000000001) && (deter > -0.000000001);
+   default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+    }
 }
 
 static void
@@ -194,6 +268,222 @@ gimp_operation_cage_coef_calc_get_bounding_box (GeglOperation *operation)
   return rect;
 }
 
+static void
+gimp_operation_cage_coef_calc_init_cage (Cage           *cage,
+                                         GimpCageConfig *config)
+{
+  gint n = gimp_cage_config_get_n_points (config);
+  gint j;
+
+  cage->n_points = n;
+  cage->points   = g_new (GimpVector2, n);
+  cage->edges    = g_new (CageEdge, n);
+
+  for (j = 0; j < n; j++)
+    cage->points[j] = g_array_index (config->cage_points, GimpCagePoint, j).src_point;
+
+  for (j = 0; j < n; j++)
+    {
+      CageEdge          *edge = &cage->edges[j];
+      const GimpVector2 *v2   = &cage->points[(j + 1) % n];
+
+      edge->v1   = cage->points[j];
+      edge->a.x  = v2->x - edge->v1.x;
+      edge->a.y  = v2->y - edge->v1.y;
+      edge->dir  = edge->a;
+      edge->absa = gimp_vector2_length (&edge->a);
+      edge->Q    = edge->a.x * edge->a.x + edge->a.y * edge->a.y;
+
+      gimp_vector2_normalize (&edge->dir);
+    }
+}
+
+static void
+gimp_operation_cage_coef_calc_clear_cage (Cage *cage)
+{
+  g_clear_pointer (&cage->points, g_free);
+  g_clear_pointer (&cage->edges,  g_free);
+}
+
+/*  Collects the x coordinates where the row y crosses the cage, sorted.
+ *  A point of the row is inside the cage iff an odd number of them lie
+ *  to its right, which is the same test as gimp_cage_config_point_inside()
+ *  does for every single pixel.
+ */
+static gint
+gimp_operation_cage_coef_calc_crossings (const Cage *cage,
+                                         gdouble     y,
+                                         gdouble    *crossings)
+{
+  gint n_crossings = 0;
+  gint j;
+
+  for (j = 0; j < cage->n_points; j++)
+    {
+      const GimpVector2 *p0 = &cage->points[j];
+      const GimpVector2 *p1 = &cage->points[(j + 1) % cage->n_points];
+
+      if ((p1->y <= y && y < p0->y) ||
+          (p0->y <= y && y < p1->y))
+        {
+          gdouble x = (p0->x - p1->x) * (y - p1->y) / (p0->y - p1->y) + p1->x;
+          gint    k;
+
+          for (k = n_crossings; k > 0 && crossings[k - 1] > x; k--)
+            crossings[k] = crossings[k - 1];
+
+          crossings[k] = x;
+          n_crossings++;
+        }
+    }
+
+  return n_crossings;
+}
+
+static inline gdouble
+gimp_operation_cage_coef_calc_log_distance (const GimpVector2 *v,
+                                            gdouble            x,
+                                            gdouble            y)
+{
+  gdouble dx = v->x - x;
+  gdouble dy = v->y - y;
+
+  return log (dx * dx + dy * dy);
+}
+
+/*  The contribution of one edge to the Green coordinates of (x, y).  L0
+ *  and L1 are the logs of the squared distances to the edge's start and
+ *  end point, which are shared with the neighbor edges.  Returns FALSE
+ *  when (x, y) lies on the edge's straight line, where the edge doesn't
+ *  contribute to the vertex coefficients.
+ */
+static inline gboolean
+gimp_operation_cage_coef_calc_edge (const CageEdge *edge,
+                                    gdouble         x,
+                                    gdouble         y,
+                                    gdouble         L0,
+                                    gdouble         L1,
+                                    gdouble        *edge_coef,
+                                    gdouble        *v1_coef,
+                                    gdouble        *v2_coef)
+{
+  gdouble bx  = edge->v1.x - x;
+  gdouble by  = edge->v1.y - y;
+  gdouble Q   = edge->Q;
+  gdouble S   = bx * bx + by * by;
+  gdouble R   = 2.0 * (edge->a.x * bx + edge->a.y * by);
+  gdouble BA  = bx * edge->a.y - by * edge->a.x;
+  gdouble SRT = sqrt (4.0 * S * Q - R * R);
+  gdouble L10 = L1 - L0;
+  gdouble A10;
+  gfloat  deter;
+
+  /*  atan2 (2Q + R, SRT) - atan2 (R, SRT), folded into a single atan2  */
+  A10 = atan2 (SRT, 2.0 * S + R) / SRT;
+
+  *edge_coef = (-edge->absa / (4.0 * G_PI)) *
+               ((4.0 * S - (R * R) / Q) * A10 + (R / (2.0 * Q)) * L10 + L1 - 2.0);
+
+  if (isnan (*edge_coef))
+    *edge_coef = 0.0;
+
+  /*  (x, y) is the edge's start, the vector to it can't be normalized  */
+  if (S == 0.0)
+    return FALSE;
+
+  /*  the cross product of the normalized edge and the normalized vector
+   *  from its start to (x, y)
+   */
+  deter = (edge->dir.x * by - edge->dir.y * bx) / sqrt (S);
+
+  if ((deter < 0.000000001) && (deter > -0.000000001))
+    return FALSE;
+
+  *v1_coef = (BA / (2.0 * G_PI)) * (L10 / (2.0 * Q) - A10 * (2.0 + R / Q));
+  *v2_coef = (BA / (2.0 * G_PI)) * (L10 / (2.0 * Q) - A10 * (R / Q));
+
+  return TRUE;
+}
+
+/*  computes all the coefficients of (x, y), coef must be zeroed  */
+static void
+gimp_operation_cage_coef_calc_pixel (const Cage *cage,
+                                     gdouble     x,
+                                     gdouble     y,
+                                     gdouble    *logs,
+                                     gfloat     *coef)
+{
+  gint n = cage->n_points;
+  gint j;
+
+  for (j = 0; j < n; j++)
+    logs[j] = gimp_operation_cage_coef_calc_log_distance (&cage->points[j], x, y);
+
+  for (j = 0; j < n; j++)
+    {
+      gint    k = (j + 1) % n;
+      gdouble edge_coef, v1_coef, v2_coef;
+
+      if (gimp_operation_cage_coef_calc_edge (&cage->edges[j], x, y,
+                                              logs[j], logs[k],
+                                              &edge_coef, &v1_coef, &v2_coef))
+        {
+          coef[j] += v1_coef;
+          coef[k] -= v2_coef;
+        }
+
+      coef[j + n] = edge_coef;
+    }
+}
+
+/*  updates the coefficients of (x, y), computed for old_cage, by
+ *  replacing the contribution of the changed edges
+ */
+static void
+gimp_operation_cage_coef_calc_pixel_update (const Cage     *cage,
+                                            const Cage     *old_cage,
+                                            const gboolean *changed,
+                                            gdouble         x,
+                                            gdouble         y,
+                                            gfloat         *coef)
+{
+  gint n = cage->n_points;
+  gint j;
+
+  for (j = 0; j < n; j++)
+    {
+      gint    k;
+      gdouble edge_coef, v1_coef, v2_coef;
+
+      if (! changed[j])
+        continue;
+
+      k = (j + 1) % n;
+
+      if (gimp_operation_cage_coef_calc_edge (
+            &old_cage->edges[j], x, y,
+            gimp_operation_cage_coef_calc_log_distance (&old_cage->points[j], x, y),
+            gimp_operation_cage_coef_calc_log_distance (&old_cage->points[k], x, y),
+            &edge_coef, &v1_coef, &v2_coef))
+        {
+          coef[j] -= v1_coef;
+          coef[k] += v2_coef;
+        }
+
+      if (gimp_operation_cage_coef_calc_edge (
+            &cage->edges[j], x, y,
+            gimp_operation_cage_coef_calc_log_distance (&cage->points[j], x, y),
+            gimp_operation_cage_coef_calc_log_distance (&cage->points[k], x, y),
+            &edge_coef, &v1_coef, &v2_coef))
+        {
+          coef[j] += v1_coef;
+          coef[k] -= v2_coef;
+        }
+
+      coef[j + n] = edge_coef;
+    }
+}
+
 static gboolean
 gimp_operation_cage_coef_calc_process (GeglOperation       *operation,
                                        GeglBuffer          *output,
@@ -202,98 +492,236 @@ gimp_operation_cage_coef_calc_process (GeglOperation       *operation,
 {
   GimpOperationCageCoefCalc *occc   = GIMP_OPERATION_CAGE_COEF_CALC (operation);
   GimpCageConfig            *config = GIMP_CAGE_CONFIG (occc->config);
-
-  const Babl *format;
-
-  GeglBufferIterator *it;
-  guint               n_cage_vertices;
-  GimpCagePoint      *current, *last;
+  CoefCalcData               data   = { 0, };
+  gint                       n;
 
   if (! config)
     return FALSE;
 
-  format = babl_format_n (babl_type ("float"), 2 * gimp_cage_config_get_n_points (config));
+  n = gimp_cage_config_get_n_points (config);
 
-  n_cage_vertices = gimp_cage_config_get_n_points (config);
+  data.output    = output;
+  data.format    = babl_format_n (babl_type ("float"), 2 * n);
+  data.grid_size = occc->grid_size;
 
-  it = gegl_buffer_iterator_new (output, roi, 0, format,
-                                 GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE, 1);
+  gimp_operation_cage_coef_calc_init_cage (&data.cage, config);
 
-  while (gegl_buffer_iterator_next (it))
+  if (occc->reference        &&
+      occc->reference_config &&
+      occc->grid_size == 1   &&
+      gimp_cage_config_get_n_points (occc->reference_config) == n)
     {
-      /* iterate inside the roi */
-      gfloat *coef     = it->items[0].data;
-      gint    n_pixels = it->length;
-      gint    x        = it->items[0].roi.x; /* initial x         */
-      gint    y        = it->items[0].roi.y; /* and y coordinates */
-      gint    j;
-
-      memset (coef, 0, sizeof * coef * n_pixels * 2 * n_cage_vertices);
-      while(n_pixels--)
+      gint n_changed = 0;
+      gint j;
+
+      gimp_operation_cage_coef_calc_init_cage (&data.old_cage,
+                                               occc->reference_config);
+
+      data.changed = g_new0 (gboolean, n);
+
+      for (j = 0; j < n; j++)
         {
-          if (gimp_cage_config_point_inside(config, x, y))
+          const GimpVector2 *v1     = &data.cage.points[j];
+          const GimpVector2 *v2     = &data.cage.points[(j + 1) % n];
+          const GimpVector2 *old_v1 = &data.old_cage.points[j];
+          const GimpVector2 *old_v2 = &data.old_cage.points[(j + 1) % n];
+
+          if (v1->x != old_v1->x || v1->y != old_v1->y ||
+              v2->x != old_v2->x || v2->y != old_v2->y)
             {
-              last = &(g_array_index (config->cage_points, GimpCagePoint, 0));
+              data.changed[j] = TRUE;
+              n_changed++;
+            }
+        }
+
+      if (n_changed <= MAX_INCREMENTAL_RATIO * n)
+        data.reference = occc->reference;
+    }
+
+  gegl_parallel_distribute_area (
+    roi, PIXELS_PER_THREAD, GEGL_SPLIT_STRATEGY_AUTO,
+    (GeglParallelDistributeAreaFunc) gimp_operation_cage_coef_calc_area,
+    &data);
+
+  gimp_operation_cage_coef_calc_clear_cage (&data.cage);
+  gimp_operation_cage_coef_calc_clear_cage (&data.old_cage);
+  g_free (data.changed);
 
-              for( j = 0; j < n_cage_vertices; j++)
+  return TRUE;
+}
+
+static void
+gimp_operation_cage_coef_calc_area (const GeglRectangle *area,
+                                    CoefCalcData        *data)
+{
+  const Cage         *cage          = &data->cage;
+  gint                n_channels    = 2 * cage->n_points;
+  gint                g             = data->grid_size;
+  gboolean            incremental   = data->reference != NULL;
+  gdouble            *logs;
+  gdouble            *crossings;
+  gdouble            *old_crossings = NULL;
+  gfloat             *nodes         = NULL;
+  gboolean           *node_inside   = NULL;
+  GeglBufferIterator *iter;
+
+  iter = gegl_buffer_iterator_new (data->output, area, 0, data->format,
+                                   GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE,
+                                   incremental ? 2 : 1);
+
+  if (incremental)
+    {
+      gegl_buffer_iterator_add (iter, data->reference, area, 0, data->format,
+                                GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
+
+      old_crossings = g_new (gdouble, cage->n_points);
+    }
+
+  logs      = g_new (gdouble, cage->n_points);
+  crossings = g_new (gdouble, cage->n_points);
+
+  while (gegl_buffer_iterator_next (iter))
+    {
+      const GeglRectangle *roi    = &iter->items[0].roi;
+      gfloat              *coef   = iter->items[0].data;
+      const gfloat        *ref    = incremental ? iter->items[1].data : NULL;
+      gint                 gx0    = 0;
+      gint                 gy0    = 0;
+      gint                 nx     = 0;
+      gint                 offset = 0;
+      gint                 x, y;
+
+      memset (coef, 0, sizeof (gfloat) * n_channels * roi->width * roi->height);
+
+      if (g > 1)
+        {
+          gint ny;
+          gint i, j;
+
+          /*  the grid is aligned to the image, so that neighbor chunks
+           *  interpolate between the same nodes
+           */
+          gx0 = (gint) floor ((gdouble) roi->x / g) * g;
+          gy0 = (gint) floor ((gdouble) roi->y / g) * g;
+          nx  = (roi->x + roi->width  - 1 - gx0) / g + 2;
+          ny  = (roi->y + roi->height - 1 - gy0) / g + 2;
+
+          nodes       = g_renew (gfloat,   nodes,       nx * ny * n_channels);
+          node_inside = g_renew (gboolean, node_inside, nx * ny);
+
+          memset (nodes, 0, sizeof (gfloat) * nx * ny * n_channels);
+
+          for (j = 0; j < ny; j++)
+            {
+              gdouble yy = gy0 + j * g;
+              gint    n_crossings;
+              gint    k = 0;
+
+              n_crossings = gimp_operation_cage_coef_calc_crossings (cage, yy,
+                                                                     crossings);
+
+              for (i = 0; i < nx; i++)
                 {
-                  GimpVector2 v1,v2,a,b,p;
-                  gdouble BA,SRT,L0,L1,A0,A1,A10,L10, Q,S,R, absa;
-
-                  current = &(g_array_index (config->cage_points, GimpCagePoint, (j+1) % n_cage_vertices));
-                  v1 = last->src_point;
-                  v2 = current->src_point;
-                  p.x = x;
-                  p.y = y;
-                  a.x = v2.x - v1.x;
-                  a.y = v2.y - v1.y;
-                  absa = gimp_vector2_length (&a);
-
-                  b.x = v1.x - x;
-                  b.y = v1.y - y;
-                  Q = a.x * a.x + a.y * a.y;
-                  S = b.x * b.x + b.y * b.y;
-                  R = 2.0 * (a.x * b.x + a.y * b.y);
-                  BA = b.x * a.y - b.y * a.x;
-                  SRT = sqrt(4.0 * S * Q - R * R);
-
-                  L0 = log(S);
-                  L1 = log(S + Q + R);
-                  A0 = atan2(R, SRT) / SRT;
-                  A1 = atan2(2.0 * Q + R, SRT) / SRT;
-                  A10 = A1 - A0;
-                  L10 = L1 - L0;
-
-                  /* edge coef */
-                  coef[j + n_cage_vertices] = (-absa / (4.0 * G_PI)) * ((4.0*S-(R*R)/Q) * A10 + (R / (2.0 * Q)) * L10 + L1 - 2.0);
-
-                  if (isnan(coef[j + n_cage_vertices]))
-                    {
-                      coef[j + n_cage_vertices] = 0.0;
-                    }
+                  gdouble xx   = gx0 + i * g;
+                  gint    node = j * nx + i;
 
-                  /* vertice coef */
-                  if (!gimp_operation_cage_coef_calc_is_on_straight (&v1, &v2, &p))
-                    {
-                      coef[j] += (BA / (2.0 * G_PI)) * (L10 /(2.0*Q) - A10 * (2.0 + R / Q));
-                      coef[(j+1)%n_cage_vertices] -= (BA / (2.0 * G_PI)) * (L10 / (2.0 * Q) - A10 * (R / Q));
-                    }
+                  while (k < n_crossings && crossings[k] <= xx)
+                    k++;
 
-                  last = current;
+                  node_inside[node] = (n_crossings - k) & 1;
+
+                  if (node_inside[node])
+                    gimp_operation_cage_coef_calc_pixel (cage, xx, yy, logs,
+                                                         nodes + node * n_channels);
                 }
             }
+        }
 
-          coef += 2 * n_cage_vertices;
-
-          /* update x and y coordinates */
-          x++;
-          if (x >= (it->items[0].roi.x + it->items[0].roi.width))
+      for (y = roi->y; y < roi->y + roi->height; y++)
+        {
+          gint n_crossings;
+          gint n_old_crossings = 0;
+          gint k               = 0;
+          gint old_k           = 0;
+
+          n_crossings = gimp_operation_cage_coef_calc_crossings (cage, y,
+                                                                 crossings);
+
+          if (incremental)
+            n_old_crossings =
+              gimp_operation_cage_coef_calc_crossings (&data->old_cage, y,
+                                                       old_crossings);
+
+          for (x = roi->x;
+               x < roi->x + roi->width;
+               x++, offset += n_channels)
             {
-              x = it->items[0].roi.x;
-              y++;
+              while (k < n_crossings && crossings[k] <= x)
+                k++;
+
+              if (! ((n_crossings - k) & 1))
+                continue;
+
+              if (incremental)
+                {
+                  while (old_k < n_old_crossings && old_crossings[old_k] <= x)
+                    old_k++;
+
+                  /*  inside both cages, reuse the reference coefficients  */
+                  if ((n_old_crossings - old_k) & 1)
+                    {
+                      memcpy (coef + offset, ref + offset,
+                              sizeof (gfloat) * n_channels);
+
+                      gimp_operation_cage_coef_calc_pixel_update (cage,
+                                                                  &data->old_cage,
+                                                                  data->changed,
+                                                                  x, y,
+                                                                  coef + offset);
+                      continue;
+                    }
+                }
+              else if (g > 1)
+                {
+                  gint i    = (x - gx0) / g;
+                  gint j    = (y - gy0) / g;
+                  gint node = j * nx + i;
+
+                  if (node_inside[node]      &&
+                      node_inside[node + 1]  &&
+                      node_inside[node + nx] &&
+                      node_inside[node + nx + 1])
+                    {
+                      const gfloat *n00 = nodes + node * n_channels;
+                      const gfloat *n10 = n00 + n_channels;
+                      const gfloat *n01 = n00 + nx * n_channels;
+                      const gfloat *n11 = n01 + n_channels;
+                      gfloat        fx  = (gfloat) (x - gx0 - i * g) / g;
+                      gfloat        fy  = (gfloat) (y - gy0 - j * g) / g;
+                      gfloat       *c   = coef + offset;
+                      gint          b;
+
+                      for (b = 0; b < n_channels; b++)
+                        {
+                          gfloat top    = n00[b] + fx * (n10[b] - n00[b]);
+                          gfloat bottom = n01[b] + fx * (n11[b] - n01[b]);
+
+                          c[b] = top + fy * (bottom - top);
+                        }
+
+                      continue;
+                    }
+                }
+
+              gimp_operation_cage_coef_calc_pixel (cage, x, y, logs,
+                                                   coef + offset);
             }
         }
     }
 
-  return TRUE;
+  g_free (logs);
+  g_free (crossings);
+  g_free (old_crossings);
+  g_free (nodes);
+  g_free (node_inside);
 }
@@ -26,7 +26,10 @@
 enum
 {
   GIMP_OPERATION_CAGE_COEF_CALC_PROP_0,
-  GIMP_OPERATION_CAGE_COEF_CALC_PROP_CONFIG
+  GIMP_OPERATION_CAGE_COEF_CALC_PROP_CONFIG,
+  GIMP_OPERATION_CAGE_COEF_CALC_PROP_REFERENCE_CONFIG,
+  GIMP_OPERATION_CAGE_COEF_CALC_PROP_REFERENCE,
+  GIMP_OPERATION_CAGE_COEF_CALC_PROP_GRID_SIZE
 };
 
 
@@ -46,6 +49,10 @@ struct _GimpOperationCageCoefCalc
   GeglOperationSource  parent_instance;
 
   GimpCageConfig      *config;
+
+  GimpCageConfig      *reference_config;
+  GeglBuffer          *reference;
+  gint                 grid_size;
 };
 
 struct _GimpOperationCageCoefCalcClass
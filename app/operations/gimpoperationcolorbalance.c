@@ -35,13 +35,14 @@
 #include "gimp-intl.h"
 
 
-static void     gimp_operation_color_balance_prepare (GeglOperation       *operation);
-static gboolean gimp_operation_color_balance_process (GeglOperation       *operation,
-                                                      void                *in_buf,
-                                                      void                *out_buf,
-                                                      glong                samples,
-                                                      const GeglRectangle *roi,
-                                                      gint                 level);
+static const Babl * gimp_operation_color_balance_get_format (GimpOperationPointFilter *filter,
+                                                             const Babl               *space);
+static gboolean     gimp_operation_color_balance_process    (GeglOperation            *operation,
+                                                             void                     *in_buf,
+                                                             void                     *out_buf,
+                                                             glong                     samples,
+                                                             const GeglRectangle      *roi,
+                                                             gint                      level);
 
 
 G_DEFINE_TYPE (GimpOperationColorBalance, gimp_operation_color_balance,
@@ -56,6 +57,7 @@ gimp_operation_color_balance_class_init (GimpOperationColorBalanceClass *klass)
   GObjectClass                  *object_class    = G_OBJECT_CLASS (klass);
   GeglOperationClass            *operation_class = GEGL_OPERATION_CLASS (klass);
   GeglOperationPointFilterClass *point_class     = GEGL_OPERATION_POINT_FILTER_CLASS (klass);
+  GimpOperationPointFilterClass *filter_class    = GIMP_OPERATION_POINT_FILTER_CLASS (klass);
 
   object_class->set_property   = gimp_operation_point_filter_set_property;
   object_class->get_property   = gimp_operation_point_filter_get_property;
@@ -66,10 +68,10 @@ gimp_operation_color_balance_class_init (GimpOperationColorBalanceClass *klass)
                                  "description", _("Adjust color distribution"),
                                  NULL);
 
-  operation_class->prepare = gimp_operation_color_balance_prepare;
-
   point_class->process     = gimp_operation_color_balance_process;
 
+  filter_class->get_format = gimp_operation_color_balance_get_format;
+
   g_object_class_install_property (object_class,
                                    GIMP_OPERATION_POINT_FILTER_PROP_CONFIG,
                                    g_param_spec_object ("config",
@@ -126,18 +128,16 @@ gimp_operation_color_balance_map (gfloat value,
   return value;
 }
 
-static void
-gimp_operation_color_balance_prepare (GeglOperation *operation)
+static const Babl *
+gimp_operation_color_balance_get_format (GimpOperationPointFilter *filter,
+                                         const Babl               *space)
 {
   /* HSV conversion is much faster from sRGB. This version of the
    * algorithm will work on sRGB to its respective HSL space.
    * TODO: in the future, when babl will have fast conversion for other
    * HSV spaces, let's study if we should work in the source space.
    */
-  const Babl *format = babl_format_with_space ("R'G'B'A float", NULL);
-
-  gegl_operation_set_format (operation, "input", format);
-  gegl_operation_set_format (operation, "output", format);
+  return babl_format_with_space ("R'G'B'A float", NULL);
 }
 
 static gboolean
@@ -34,7 +34,8 @@
 
 #include "gimp-intl.h"
 
-static void gimp_operation_hue_saturation_prepare (GeglOperation *operation);
+static const Babl * gimp_operation_hue_saturation_get_format (GimpOperationPointFilter *filter,
+                                                              const Babl               *space);
 
 static gboolean gimp_operation_hue_saturation_process (GeglOperation       *operation,
                                                        void                *in_buf,
@@ -56,6 +57,7 @@ gimp_operation_hue_saturation_class_init (GimpOperationHueSaturationClass *klass
   GObjectClass                  *object_class    = G_OBJECT_CLASS (klass);
   GeglOperationClass            *operation_class = GEGL_OPERATION_CLASS (klass);
   GeglOperationPointFilterClass *point_class     = GEGL_OPERATION_POINT_FILTER_CLASS (klass);
+  GimpOperationPointFilterClass *filter_class    = GIMP_OPERATION_POINT_FILTER_CLASS (klass);
 
   object_class->set_property   = gimp_operation_point_filter_set_property;
   object_class->get_property   = gimp_operation_point_filter_get_property;
@@ -66,8 +68,8 @@ gimp_operation_hue_saturation_class_init (GimpOperationHueSaturationClass *klass
                                  "description", _("Adjust hue, saturation, and lightness"),
                                  NULL);
 
-  point_class->process = gimp_operation_hue_saturation_process;
-  operation_class->prepare = gimp_operation_hue_saturation_prepare;
+  point_class->process     = gimp_operation_hue_saturation_process;
+  filter_class->get_format = gimp_operation_hue_saturation_get_format;
 
   g_object_class_install_property (object_class,
                                    GIMP_OPERATION_POINT_FILTER_PROP_CONFIG,
@@ -175,8 +177,9 @@ map_lightness_achromatic (GimpHueSaturationConfig *config, gfloat value)
     return value + (v * (1.0f - value));
 }
 
-static void
-gimp_operation_hue_saturation_prepare (GeglOperation *operation)
+static const Babl *
+gimp_operation_hue_saturation_get_format (GimpOperationPointFilter *filter,
+                                          const Babl               *space)
 {
   /* We work in HSLA within sRGB space which is much faster to convert
    * to than with specific spaces. Eventually though, I'm not sure if we
@@ -185,10 +188,7 @@ gimp_operation_hue_saturation_prepare (GeglOperation *operation)
    * from "R'G'B'" with space to HSL. TODO.
    * See: https://gitlab.gnome.org/GNOME/babl/-/issues/103
    */
-  const Babl *format = babl_format_with_space ("HSLA float", NULL);
-
-  gegl_operation_set_format (operation, "input", format);
-  gegl_operation_set_format (operation, "output", format);
+  return babl_format_with_space ("HSLA float", NULL);
 }
 
 static gboolean
@@ -27,8 +27,11 @@
 #include "gimpoperationpointfilter.h"
 
 
-static void   gimp_operation_point_filter_finalize (GObject       *object);
-static void   gimp_operation_point_filter_prepare  (GeglOperation *operation);
+static void         gimp_operation_point_filter_finalize        (GObject                  *object);
+static void         gimp_operation_point_filter_prepare         (GeglOperation            *operation);
+
+static const Babl * gimp_operation_point_filter_real_get_format (GimpOperationPointFilter *filter,
+                                                                 const Babl               *space);
 
 
 G_DEFINE_ABSTRACT_TYPE (GimpOperationPointFilter, gimp_operation_point_filter,
@@ -46,6 +49,8 @@ gimp_operation_point_filter_class_init (GimpOperationPointFilterClass *klass)
   object_class->finalize = gimp_operation_point_filter_finalize;
 
   operation_class->prepare = gimp_operation_point_filter_prepare;
+
+  klass->get_format        = gimp_operation_point_filter_real_get_format;
 }
 
 static void
@@ -114,27 +119,58 @@ gimp_operation_point_filter_set_property (GObject      *object,
 static void
 gimp_operation_point_filter_prepare (GeglOperation *operation)
 {
-  GimpOperationPointFilter *self = GIMP_OPERATION_POINT_FILTER (operation);
+  GimpOperationPointFilter *self  = GIMP_OPERATION_POINT_FILTER (operation);
   const Babl               *space = gegl_operation_get_source_space (operation,
                                                                      "input");
   const Babl               *format;
 
-  switch (self->trc)
+  format = gimp_operation_point_filter_get_format (self, space);
+
+  gegl_operation_set_format (operation, "input",  format);
+  gegl_operation_set_format (operation, "output", format);
+}
+
+static const Babl *
+gimp_operation_point_filter_real_get_format (GimpOperationPointFilter *filter,
+                                             const Babl               *space)
+{
+  switch (filter->trc)
     {
     default:
     case GIMP_TRC_LINEAR:
-      format = babl_format_with_space ("RGBA float", space);
-      break;
+      return babl_format_with_space ("RGBA float", space);
 
     case GIMP_TRC_NON_LINEAR:
-      format = babl_format_with_space ("R'G'B'A float", space);
-      break;
+      return babl_format_with_space ("R'G'B'A float", space);
 
     case GIMP_TRC_PERCEPTUAL:
-      format = babl_format_with_space ("R~G~B~A float", space);
-      break;
+      return babl_format_with_space ("R~G~B~A float", space);
     }
+}
 
-  gegl_operation_set_format (operation, "input",  format);
-  gegl_operation_set_format (operation, "output", format);
+
+/*  public functions  */
+
+gboolean
+gimp_operation_point_filter_can_chain (GimpOperationPointFilter *filter)
+{
+  g_return_val_if_fail (GIMP_IS_OPERATION_POINT_FILTER (filter), FALSE);
+
+  return GIMP_OPERATION_POINT_FILTER_GET_CLASS (filter)->get_format != NULL;
+}
+
+const Babl *
+gimp_operation_point_filter_get_format (GimpOperationPointFilter *filter,
+                                        const Babl               *space)
+{
+  GimpOperationPointFilterClass *klass;
+
+  g_return_val_if_fail (GIMP_IS_OPERATION_POINT_FILTER (filter), NULL);
+
+  klass = GIMP_OPERATION_POINT_FILTER_GET_CLASS (filter);
+
+  /*  operations without get_format() do their own prepare()  */
+  g_return_val_if_fail (klass->get_format != NULL, NULL);
+
+  return klass->get_format (filter, space);
 }
@@ -53,16 +53,26 @@ struct _GimpOperationPointFilter
 struct _GimpOperationPointFilterClass
 {
   GeglOperationPointFilterClass  parent_class;
+
+  /*  the format process() works in, for the given source space; NULL
+   *  if the operation can't be run outside of its own node
+   */
+  const Babl * (* get_format) (GimpOperationPointFilter *filter,
+                               const Babl               *space);
 };
 
 
-GType   gimp_operation_point_filter_get_type     (void) G_GNUC_CONST;
+GType        gimp_operation_point_filter_get_type     (void) G_GNUC_CONST;
+
+void         gimp_operation_point_filter_get_property (GObject                  *object,
+                                                       guint                     property_id,
+                                                       GValue                   *value,
+                                                       GParamSpec               *pspec);
+void         gimp_operation_point_filter_set_property (GObject                  *object,
+                                                       guint                     property_id,
+                                                       const GValue             *value,
+                                                       GParamSpec               *pspec);
 
-void    gimp_operation_point_filter_get_property (GObject      *object,
-                                                  guint         property_id,
-                                                  GValue       *value,
-                                                  GParamSpec   *pspec);
-void    gimp_operation_point_filter_set_property (GObject      *object,
-                                                  guint         property_id,
-                                                  const GValue *value,
-                                                  GParamSpec   *pspec);
+gboolean     gimp_operation_point_filter_can_chain    (GimpOperationPointFilter *filter);
+const Babl * gimp_operation_point_filter_get_format   (GimpOperationPointFilter *filter,
+                                                       const Babl               *space);
@@ -0,0 +1,340 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimpoperationpointfilterchain.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*  Runs the operations of several GimpOperationPointFilter nodes over
+ *  each chunk of pixels in turn, so a stack of adjustments costs a
+ *  single pass over the buffer instead of one pass, one applicator and
+ *  one cache per adjustment.  The nodes stay owned by their own graphs,
+ *  which may render meanwhile, so the chain runs its own copies of their
+ *  operations, and keeps their properties in sync.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <gegl.h>
+
+#include "operations-types.h"
+
+#include "gimpoperationpointfilter.h"
+#include "gimpoperationpointfilterchain.h"
+
+
+static void       gimp_operation_point_filter_chain_dispose     (GObject                       *object);
+static void       gimp_operation_point_filter_chain_finalize    (GObject                       *object);
+
+static void       gimp_operation_point_filter_chain_prepare     (GeglOperation                 *operation);
+static gboolean   gimp_operation_point_filter_chain_process     (GeglOperation                 *operation,
+                                                                 void                          *in_buf,
+                                                                 void                          *out_buf,
+                                                                 glong                          samples,
+                                                                 const GeglRectangle           *roi,
+                                                                 gint                           level);
+
+static void       gimp_operation_point_filter_chain_clear_nodes (GimpOperationPointFilterChain *chain);
+static void       gimp_operation_point_filter_chain_sync        (GeglNode                      *node,
+                                                                 GeglNode                      *copy);
+static void       gimp_operation_point_filter_chain_invalidated (GeglNode                      *node,
+                                                                 const GeglRectangle           *rect,
+                                                                 GimpOperationPointFilterChain *chain);
+
+
+G_DEFINE_TYPE (GimpOperationPointFilterChain, gimp_operation_point_filter_chain,
+               GEGL_TYPE_OPERATION_POINT_FILTER)
+
+#define parent_class gimp_operation_point_filter_chain_parent_class
+
+
+static void
+gimp_operation_point_filter_chain_class_init (GimpOperationPointFilterChainClass *klass)
+{
+  GObjectClass                  *object_class    = G_OBJECT_CLASS (klass);
+  GeglOperationClass            *operation_class = GEGL_OPERATION_CLASS (klass);
+  GeglOperationPointFilterClass *point_class     = GEGL_OPERATION_POINT_FILTER_CLASS (klass);
+
+  object_class->dispose    = gimp_operation_point_filter_chain_dispose;
+  object_class->finalize   = gimp_operation_point_filter_chain_finalize;
+
+  operation_class->prepare = gimp_operation_point_filter_chain_prepare;
+
+  point_class->process     = gimp_operation_point_filter_chain_process;
+
+  gegl_operation_class_set_keys (operation_class,
+                                 "name",        "gimp:point-filter-chain",
+                                 "categories",  "hidden",
+                                 "description", "Run a chain of point filters in one pass",
+                                 NULL);
+}
+
+static void
+gimp_operation_point_filter_chain_init (GimpOperationPointFilterChain *self)
+{
+}
+
+static void
+gimp_operation_point_filter_chain_dispose (GObject *object)
+{
+  GimpOperationPointFilterChain *chain = GIMP_OPERATION_POINT_FILTER_CHAIN (object);
+
+  gimp_operation_point_filter_chain_clear_nodes (chain);
+
+  G_OBJECT_CLASS (parent_class)->dispose (object);
+}
+
+static void
+gimp_operation_point_filter_chain_finalize (GObject *object)
+{
+  GimpOperationPointFilterChain *chain = GIMP_OPERATION_POINT_FILTER_CHAIN (object);
+
+  g_clear_pointer (&chain->fishes, g_free);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gimp_operation_point_filter_chain_prepare (GeglOperation *operation)
+{
+  GimpOperationPointFilterChain *chain = GIMP_OPERATION_POINT_FILTER_CHAIN (operation);
+  const Babl                    *space = gegl_operation_get_source_space (operation,
+                                                                          "input");
+  const Babl                    *format;
+  const Babl                    *prev_format;
+  gint                           i;
+
+  format = babl_format_with_space ("RGBA float", space);
+
+  gegl_operation_set_format (operation, "input",  format);
+  gegl_operation_set_format (operation, "output", format);
+
+  g_free (chain->fishes);
+  chain->fishes = g_new0 (const Babl *, chain->n_nodes + 1);
+
+  prev_format = format;
+
+  for (i = 0; i < chain->n_nodes; i++)
+    {
+      GeglOperation *sub_op = gegl_node_get_gegl_operation (chain->copies[i]);
+      const Babl    *sub_format;
+
+      sub_format =
+        gimp_operation_point_filter_get_format (GIMP_OPERATION_POINT_FILTER (sub_op),
+                                                space);
+
+      /*  process() of some filters looks up their own formats  */
+      gegl_operation_set_format (sub_op, "input",  sub_format);
+      gegl_operation_set_format (sub_op, "output", sub_format);
+
+      if (sub_format != prev_format)
+        chain->fishes[i] = babl_fish (prev_format, sub_format);
+
+      prev_format = sub_format;
+    }
+
+  if (prev_format != format)
+    chain->fishes[chain->n_nodes] = babl_fish (prev_format, format);
+}
+
+static gboolean
+gimp_operation_point_filter_chain_process (GeglOperation       *operation,
+                                           void                *in_buf,
+                                           void                *out_buf,
+                                           glong                samples,
+                                           const GeglRectangle *roi,
+                                           gint                 level)
+{
+  GimpOperationPointFilterChain *chain   = GIMP_OPERATION_POINT_FILTER_CHAIN (operation);
+  gfloat                        *scratch = NULL;
+  gfloat                        *src     = in_buf;
+  gfloat                        *dest;
+  gint                           i;
+
+  /*  all the formats involved are 4 x float, so the pixels can bounce
+   *  between out_buf and a single scratch buffer
+   */
+  if (chain->n_nodes > 0)
+    scratch = gegl_scratch_new (gfloat, 4 * samples);
+
+#define NEXT_DEST(src) ((src) == (gfloat *) out_buf ? scratch : (gfloat *) out_buf)
+
+  for (i = 0; i < chain->n_nodes; i++)
+    {
+      GeglOperation                 *sub_op = gegl_node_get_gegl_operation (chain->copies[i]);
+      GeglOperationPointFilterClass *sub_class;
+
+      if (chain->fishes[i])
+        {
+          dest = NEXT_DEST (src);
+
+          babl_process (chain->fishes[i], src, dest, samples);
+
+          src = dest;
+        }
+
+      sub_class = GEGL_OPERATION_POINT_FILTER_GET_CLASS (sub_op);
+      dest      = NEXT_DEST (src);
+
+      sub_class->process (sub_op, src, dest, samples, roi, level);
+
+      src = dest;
+    }
+
+  if (chain->fishes && chain->fishes[chain->n_nodes])
+    {
+      dest = NEXT_DEST (src);
+
+      babl_process (chain->fishes[chain->n_nodes], src, dest, samples);
+
+      src = dest;
+    }
+
+  if (src != out_buf)
+    memcpy (out_buf, src, sizeof (gfloat) * 4 * samples);
+
+#undef NEXT_DEST
+
+  if (scratch)
+    gegl_scratch_free (scratch);
+
+  return TRUE;
+}
+
+
+/*  public functions  */
+
+void
+gimp_operation_point_filter_chain_set_nodes (GimpOperationPointFilterChain  *chain,
+                                             GeglNode                      **nodes,
+                                             gint                            n_nodes)
+{
+  gint i;
+
+  g_return_if_fail (GIMP_IS_OPERATION_POINT_FILTER_CHAIN (chain));
+  g_return_if_fail (nodes != NULL || n_nodes == 0);
+
+  for (i = 0; i < n_nodes; i++)
+    {
+      GeglOperation *sub_op = gegl_node_get_gegl_operation (nodes[i]);
+
+      g_return_if_fail (GIMP_IS_OPERATION_POINT_FILTER (sub_op) &&
+                        gimp_operation_point_filter_can_chain (
+                          GIMP_OPERATION_POINT_FILTER (sub_op)));
+    }
+
+  gimp_operation_point_filter_chain_clear_nodes (chain);
+
+  chain->nodes   = g_new (GeglNode *, n_nodes);
+  chain->copies  = g_new (GeglNode *, n_nodes);
+  chain->n_nodes = n_nodes;
+
+  for (i = 0; i < n_nodes; i++)
+    {
+      chain->nodes[i]  = g_object_ref (nodes[i]);
+      chain->copies[i] = gegl_node_new_child (NULL,
+                                              "operation",
+                                              gegl_node_get_operation (nodes[i]),
+                                              NULL);
+
+      gimp_operation_point_filter_chain_sync (chain->nodes[i],
+                                              chain->copies[i]);
+
+      g_signal_connect (nodes[i], "invalidated",
+                        G_CALLBACK (gimp_operation_point_filter_chain_invalidated),
+                        chain);
+    }
+}
+
+
+/*  private functions  */
+
+static void
+gimp_operation_point_filter_chain_clear_nodes (GimpOperationPointFilterChain *chain)
+{
+  gint i;
+
+  for (i = 0; i < chain->n_nodes; i++)
+    {
+      g_signal_handlers_disconnect_by_func (chain->nodes[i],
+                                            gimp_operation_point_filter_chain_invalidated,
+                                            chain);
+      g_object_unref (chain->nodes[i]);
+      g_object_unref (chain->copies[i]);
+    }
+
+  g_clear_pointer (&chain->nodes,  g_free);
+  g_clear_pointer (&chain->copies, g_free);
+  chain->n_nodes = 0;
+}
+
+/*  copies the properties of node's operation to the one of copy  */
+static void
+gimp_operation_point_filter_chain_sync (GeglNode *node,
+                                        GeglNode *copy)
+{
+  GObject     *operation      = G_OBJECT (gegl_node_get_gegl_operation (node));
+  GObject     *copy_operation = G_OBJECT (gegl_node_get_gegl_operation (copy));
+  GParamSpec **pspecs;
+  guint        n_pspecs;
+  guint        i;
+
+  pspecs = g_object_class_list_properties (G_OBJECT_GET_CLASS (operation),
+                                           &n_pspecs);
+
+  for (i = 0; i < n_pspecs; i++)
+    {
+      GParamSpec *pspec = pspecs[i];
+      GValue      value = G_VALUE_INIT;
+
+      if ((pspec->flags & G_PARAM_READWRITE) != G_PARAM_READWRITE ||
+          (pspec->flags & G_PARAM_CONSTRUCT_ONLY)                 ||
+          ! g_type_is_a (pspec->owner_type,
+                         GIMP_TYPE_OPERATION_POINT_FILTER))
+        {
+          continue;
+        }
+
+      g_value_init (&value, pspec->value_type);
+
+      g_object_get_property (operation,      pspec->name, &value);
+      g_object_set_property (copy_operation, pspec->name, &value);
+
+      g_value_unset (&value);
+    }
+
+  g_free (pspecs);
+}
+
+static void
+gimp_operation_point_filter_chain_invalidated (GeglNode                      *node,
+                                               const GeglRectangle           *rect,
+                                               GimpOperationPointFilterChain *chain)
+{
+  gint i;
+
+  /*  a changed config of one of the filters, take it over and forward
+   *  it downstream
+   */
+  for (i = 0; i < chain->n_nodes; i++)
+    {
+      if (chain->nodes[i] == node)
+        gimp_operation_point_filter_chain_sync (node, chain->copies[i]);
+    }
+
+  gegl_operation_invalidate (GEGL_OPERATION (chain), rect, FALSE);
+}
@@ -51,7 +51,8 @@ static void     gimp_operation_posterize_set_property (GObject             *obje
                                                        const GValue        *value,
                                                        GParamSpec          *pspec);
 
-static void gimp_operation_posterize_prepare (GeglOperation *operation);
+static const Babl * gimp_operation_posterize_get_format (GimpOperationPointFilter *filter,
+                                                         const Babl               *space);
 
 static gboolean gimp_operation_posterize_process      (GeglOperation       *operation,
                                                        void                *in_buf,
@@ -73,11 +74,12 @@ gimp_operation_posterize_class_init (GimpOperationPosterizeClass *klass)
   GObjectClass                  *object_class    = G_OBJECT_CLASS (klass);
   GeglOperationClass            *operation_class = GEGL_OPERATION_CLASS (klass);
   GeglOperationPointFilterClass *point_class     = GEGL_OPERATION_POINT_FILTER_CLASS (klass);
+  GimpOperationPointFilterClass *filter_class    = GIMP_OPERATION_POINT_FILTER_CLASS (klass);
 
   object_class->set_property = gimp_operation_posterize_set_property;
   object_class->get_property = gimp_operation_posterize_get_property;
-  operation_class->prepare   = gimp_operation_posterize_prepare;
   point_class->process       = gimp_operation_posterize_process;
+  filter_class->get_format   = gimp_operation_posterize_get_format;
 
   gegl_operation_class_set_keys (operation_class,
                                  "name",        "gimp:posterize",
@@ -138,14 +140,11 @@ gimp_operation_posterize_set_property (GObject      *object,
     }
 }
 
-static void
-gimp_operation_posterize_prepare (GeglOperation *operation)
+static const Babl *
+gimp_operation_posterize_get_format (GimpOperationPointFilter *filter,
+                                     const Babl               *space)
 {
-  const Babl *format = babl_format_with_space ("R~G~B~A float",
-                                               gegl_operation_get_format (operation, "input"));
-
-  gegl_operation_set_format (operation, "input", format);
-  gegl_operation_set_format (operation, "output", format);
+  return babl_format_with_space ("R~G~B~A float", space);
 }
 
 
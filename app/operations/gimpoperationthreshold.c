@@ -61,7 +61,8 @@ static gboolean gimp_operation_threshold_process (GeglOperation       *operation
                                                   const GeglRectangle *roi,
                                                   gint                 level);
 
-static void gimp_operation_threshold_prepare (GeglOperation *operation);
+static const Babl * gimp_operation_threshold_get_format (GimpOperationPointFilter *filter,
+                                                         const Babl               *space);
 
 G_DEFINE_TYPE (GimpOperationThreshold, gimp_operation_threshold,
                GIMP_TYPE_OPERATION_POINT_FILTER)
@@ -75,14 +76,15 @@ gimp_operation_threshold_class_init (GimpOperationThresholdClass *klass)
   GObjectClass                  *object_class    = G_OBJECT_CLASS (klass);
   GeglOperationClass            *operation_class = GEGL_OPERATION_CLASS (klass);
   GeglOperationPointFilterClass *point_class     = GEGL_OPERATION_POINT_FILTER_CLASS (klass);
+  GimpOperationPointFilterClass *filter_class    = GIMP_OPERATION_POINT_FILTER_CLASS (klass);
 
   object_class->set_property = gimp_operation_threshold_set_property;
   object_class->get_property = gimp_operation_threshold_get_property;
 
-  operation_class->prepare   = gimp_operation_threshold_prepare;
-
   point_class->process       = gimp_operation_threshold_process;
 
+  filter_class->get_format   = gimp_operation_threshold_get_format;
+
   gegl_operation_class_set_keys (operation_class,
                                  "name",        "gimp:threshold",
                                  "categories",  "color",
@@ -173,14 +175,11 @@ gimp_operation_threshold_set_property (GObject      *object,
     }
 }
 
-static void
-gimp_operation_threshold_prepare (GeglOperation *operation)
+static const Babl *
+gimp_operation_threshold_get_format (GimpOperationPointFilter *filter,
+                                     const Babl               *space)
 {
-  const Babl *format = babl_format_with_space (
-      "R'G'B'A float", gegl_operation_get_format (operation, "input"));
-
-  gegl_operation_set_format (operation, "input", format);
-  gegl_operation_set_format (operation, "output", format);
+  return babl_format_with_space ("R'G'B'A float", space);
 }
 
 static gboolean
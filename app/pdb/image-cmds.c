@@ -1879,6 +1879,109 @@ image_thumbnail_invoker (GimpProcedure         *procedure,
   return return_vals;
 }
 
+static GimpValueArray *
+image_get_merged_format_invoker (GimpProcedure         *procedure,
+                                 Gimp                  *gimp,
+                                 GimpContext           *context,
+                                 GimpProgress          *progress,
+                                 const GimpValueArray  *args,
+                                 GError               **error)
+{
+  gboolean success = TRUE;
+  GimpValueArray *return_vals;
+  GimpImage *image;
+  gboolean flatten;
+  gchar *format = NULL;
+
+  image = g_value_get_object (gimp_value_array_index (args, 0));
+  flatten = g_value_get_boolean (gimp_value_array_index (args, 1));
+
+  if (success)
+    {
+      if (gimp_pdb_image_is_not_base_type (image, GIMP_INDEXED, error))
+        {
+          /* this only transfers the encoding, losing the space, see the
+           * code in libgimp/gimptilebackendplugin.c which reconstructs the
+           * actual format in the plug-in process
+           */
+          format = g_strdup (babl_format_get_encoding (gimp_image_get_merged_format (image, flatten)));
+        }
+      else
+        success = FALSE;
+    }
+
+  return_vals = gimp_procedure_get_return_values (procedure, success,
+                                                  error ? *error : NULL);
+
+  if (success)
+    g_value_take_string (gimp_value_array_index (return_vals, 1), format);
+
+  return return_vals;
+}
+
+static GimpValueArray *
+image_get_merged_region_invoker (GimpProcedure         *procedure,
+                                 Gimp                  *gimp,
+                                 GimpContext           *context,
+                                 GimpProgress          *progress,
+                                 const GimpValueArray  *args,
+                                 GError               **error)
+{
+  gboolean success = TRUE;
+  GimpValueArray *return_vals;
+  GimpImage *image;
+  gboolean flatten;
+  gint x;
+  gint y;
+  gint width;
+  gint height;
+  GBytes *region_data = NULL;
+
+  image = g_value_get_object (gimp_value_array_index (args, 0));
+  flatten = g_value_get_boolean (gimp_value_array_index (args, 1));
+  x = g_value_get_int (gimp_value_array_index (args, 2));
+  y = g_value_get_int (gimp_value_array_index (args, 3));
+  width = g_value_get_int (gimp_value_array_index (args, 4));
+  height = g_value_get_int (gimp_value_array_index (args, 5));
+
+  if (success)
+    {
+      if (gimp_pdb_image_is_not_base_type (image, GIMP_INDEXED, error) &&
+          x + width  <= gimp_image_get_width  (image)                  &&
+          y + height <= gimp_image_get_height (image))
+        {
+          GeglRectangle  rect   = { x, y, width, height };
+          const Babl    *format = gimp_image_get_merged_format (image, flatten);
+          gsize          size;
+          guchar        *data;
+
+          size = (gsize) width * height * babl_format_get_bytes_per_pixel (format);
+          data = g_try_malloc (size);
+
+          if (data)
+            {
+              gimp_pickable_flush (GIMP_PICKABLE (image));
+
+              gimp_image_get_merged_region (image, context, flatten, &rect, data);
+
+              region_data = g_bytes_new_take (data, size);
+            }
+          else
+            success = FALSE;
+        }
+      else
+        success = FALSE;
+    }
+
+  return_vals = gimp_procedure_get_return_values (procedure, success,
+                                                  error ? *error : NULL);
+
+  if (success)
+    g_value_take_boxed (gimp_value_array_index (return_vals, 1), region_data);
+
+  return return_vals;
+}
+
 static GimpValueArray *
 image_get_selected_layers_invoker (GimpProcedure         *procedure,
                                    Gimp                  *gimp,
@@ -4738,6 +4841,102 @@ register_image_procs (GimpPDB *pdb)
   gimp_pdb_register_procedure (pdb, procedure);
   g_object_unref (procedure);
 
+  /*
+   * gimp-image-get-merged-format
+   */
+  procedure = gimp_procedure_new (image_get_merged_format_invoker, TRUE);
+  gimp_object_set_static_name (GIMP_OBJECT (procedure),
+                               "gimp-image-get-merged-format");
+  gimp_procedure_set_static_help (procedure,
+                                  "Returns the Babl format of the image's merged pixels.",
+                                  "This procedure returns the Babl format of the pixels returned by 'gimp-image-get-merged-region', which is the format of the layer that merging or flattening the image's visible layers would create.\n"
+                                  "Note that the actual PDB procedure only transfers the format's encoding. In order to get to the real format, the libgimp C wrapper must be used.",
+                                  NULL);
+  gimp_procedure_set_static_attribution (procedure,
+                                         "Spencer Kimball & Peter Mattis",
+                                         "Spencer Kimball & Peter Mattis",
+                                         "1995-1996");
+  gimp_procedure_add_argument (procedure,
+                               gimp_param_spec_image ("image",
+                                                      "image",
+                                                      "The image",
+                                                      FALSE,
+                                                      GIMP_PARAM_READWRITE));
+  gimp_procedure_add_argument (procedure,
+                               g_param_spec_boolean ("flatten",
+                                                     "flatten",
+                                                     "Whether the merged pixels are flattened",
+                                                     FALSE,
+                                                     GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   gimp_param_spec_string ("format",
+                                                           "format",
+                                                           "The merged pixels' Babl format",
+                                                           FALSE, FALSE, FALSE,
+                                                           NULL,
+                                                           GIMP_PARAM_READWRITE));
+  gimp_pdb_register_procedure (pdb, procedure);
+  g_object_unref (procedure);
+
+  /*
+   * gimp-image-get-merged-region
+   */
+  procedure = gimp_procedure_new (image_get_merged_region_invoker, TRUE);
+  gimp_object_set_static_name (GIMP_OBJECT (procedure),
+                               "gimp-image-get-merged-region");
+  gimp_procedure_set_static_help (procedure,
+                                  "Returns a region of the image's merged visible layers.",
+                                  "This procedure renders the given region of the image's visible layers, merged, or flattened onto the context's background color, without creating a merged layer. The pixels are returned in the format returned by 'gimp-image-get-merged-format'.",
+                                  NULL);
+  gimp_procedure_set_static_attribution (procedure,
+                                         "Spencer Kimball & Peter Mattis",
+                                         "Spencer Kimball & Peter Mattis",
+                                         "1995-1996");
+  gimp_procedure_add_argument (procedure,
+                               gimp_param_spec_image ("image",
+                                                      "image",
+                                                      "The image",
+                                                      FALSE,
+                                                      GIMP_PARAM_READWRITE));
+  gimp_procedure_add_argument (procedure,
+                               g_param_spec_boolean ("flatten",
+                                                     "flatten",
+                                                     "Whether to flatten the merged pixels",
+                                                     FALSE,
+                                                     GIMP_PARAM_READWRITE));
+  gimp_procedure_add_argument (procedure,
+                               g_param_spec_int ("x",
+                                                 "x",
+                                                 "The x coordinate of the region",
+                                                 0, G_MAXINT32, 0,
+                                                 GIMP_PARAM_READWRITE));
+  gimp_procedure_add_argument (procedure,
+                               g_param_spec_int ("y",
+                                                 "y",
+                                                 "The y coordinate of the region",
+                                                 0, G_MAXINT32, 0,
+                                                 GIMP_PARAM_READWRITE));
+  gimp_procedure_add_argument (procedure,
+                               g_param_spec_int ("width",
+                                                 "width",
+                                                 "The width of the region",
+                                                 1, G_MAXINT32, 1,
+                                                 GIMP_PARAM_READWRITE));
+  gimp_procedure_add_argument (procedure,
+                               g_param_spec_int ("height",
+                                                 "height",
+                                                 "The height of the region",
+                                                 1, G_MAXINT32, 1,
+                                                 GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   g_param_spec_boxed ("region-data",
+                                                       "region data",
+                                                       "The region data",
+                                                       G_TYPE_BYTES,
+                                                       GIMP_PARAM_READWRITE));
+  gimp_pdb_register_procedure (pdb, procedure);
+  g_object_unref (procedure);
+
   /*
    * gimp-image-get-selected-layers
    */
@@ -0,0 +1,505 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <gegl.h>
+
+#include "libgimpbase/gimpbase.h"
+#include "libgimpbase/gimpbase-private.h"
+#include "libgimpmath/gimpmath.h"
+
+#include "core/core-types.h"
+
+#include "gegl/gimp-babl.h"
+#include "gegl/gimp-gegl-loops.h"
+#include "gegl/gimp-gegl-mask-combine.h"
+
+
+/*  Checks the vectorized loops of app/gegl against their scalar
+ *  versions, by running each loop once with CPU acceleration disabled
+ *  and once with it enabled.  The results of the convolution are
+ *  compared to a straightforward implementation instead, since both
+ *  versions sum up the kernel in a different order.
+ *
+ *  When run in performance mode (-m perf), also times both versions of
+ *  each loop on a large buffer: the convolution is what the
+ *  Blur/Sharpen tool does with large brushes, the mask combining is
+ *  what building a complex selection does many times in a row, and
+ *  combining a rounded rectangle is what the rectangle and ellipse
+ *  selection tools do.
+ */
+
+#define TEST_WIDTH    67
+#define TEST_HEIGHT   53
+#define BENCH_SIZE    2048
+#define BENCH_RUNS    4
+#define OPACITY       0.75
+
+
+typedef enum
+{
+  CONVOLVE,
+  MASK_COMBINE_ELLIPSE_RECT,
+  MASK_COMBINE_BUFFER,
+  COMBINE_MASK,
+  COMBINE_MASK_WEIRD,
+  APPLY_MASK
+} LoopKind;
+
+typedef struct
+{
+  const gchar     *name;
+  LoopKind         kind;
+
+  /*  CONVOLVE  */
+  gint             kernel_size;
+  gboolean         separable;
+  gboolean         alpha_weighting;
+
+  /*  MASK_COMBINE_BUFFER, MASK_COMBINE_ELLIPSE_RECT  */
+  GimpChannelOps   op;
+
+  /*  COMBINE_MASK_WEIRD  */
+  gboolean         stipple;
+
+  /*  MASK_COMBINE_ELLIPSE_RECT  */
+  gboolean         antialias;
+} LoopTest;
+
+
+static const LoopTest loop_tests[] =
+{
+  { "convolve/generic-3x3",             CONVOLVE,  3, FALSE, FALSE },
+  { "convolve/generic-3x3-alpha",       CONVOLVE,  3, FALSE, TRUE  },
+  { "convolve/separable-3x3",           CONVOLVE,  3, TRUE,  FALSE },
+  { "convolve/separable-3x3-alpha",     CONVOLVE,  3, TRUE,  TRUE  },
+  { "convolve/generic-5x5",             CONVOLVE,  5, FALSE, FALSE },
+  { "convolve/generic-5x5-alpha",       CONVOLVE,  5, FALSE, TRUE  },
+  { "convolve/separable-5x5",           CONVOLVE,  5, TRUE,  FALSE },
+  { "convolve/separable-5x5-alpha",     CONVOLVE,  5, TRUE,  TRUE  },
+  { "convolve/generic-15x15",           CONVOLVE, 15, FALSE, FALSE },
+  { "convolve/generic-15x15-alpha",     CONVOLVE, 15, FALSE, TRUE  },
+  { "convolve/separable-15x15",         CONVOLVE, 15, TRUE,  FALSE },
+  { "convolve/separable-15x15-alpha",   CONVOLVE, 15, TRUE,  TRUE  },
+
+  { "ellipse-rect/replace",             MASK_COMBINE_ELLIPSE_RECT, .op = GIMP_CHANNEL_OP_REPLACE,  .antialias = FALSE },
+  { "ellipse-rect/replace-antialias",   MASK_COMBINE_ELLIPSE_RECT, .op = GIMP_CHANNEL_OP_REPLACE,  .antialias = TRUE  },
+  { "ellipse-rect/add-antialias",       MASK_COMBINE_ELLIPSE_RECT, .op = GIMP_CHANNEL_OP_ADD,      .antialias = TRUE  },
+  { "ellipse-rect/subtract-antialias",  MASK_COMBINE_ELLIPSE_RECT, .op = GIMP_CHANNEL_OP_SUBTRACT, .antialias = TRUE  },
+
+  { "mask-combine/replace",             MASK_COMBINE_BUFFER, .op = GIMP_CHANNEL_OP_REPLACE   },
+  { "mask-combine/add",                 MASK_COMBINE_BUFFER, .op = GIMP_CHANNEL_OP_ADD       },
+  { "mask-combine/subtract",            MASK_COMBINE_BUFFER, .op = GIMP_CHANNEL_OP_SUBTRACT  },
+  { "mask-combine/intersect",           MASK_COMBINE_BUFFER, .op = GIMP_CHANNEL_OP_INTERSECT },
+  { "combine-mask",                     COMBINE_MASK                                         },
+  { "combine-mask-weird",               COMBINE_MASK_WEIRD,  .stipple = FALSE                },
+  { "combine-mask-weird-stipple",       COMBINE_MASK_WEIRD,  .stipple = TRUE                 },
+  { "apply-mask",                       APPLY_MASK                                           }
+};
+
+
+static GeglBuffer *
+gimp_test_loops_source (gint        width,
+                        gint        height,
+                        const Babl *format,
+                        guint32     seed)
+{
+  GeglBuffer *buffer;
+  GRand      *rand       = g_rand_new_with_seed (seed);
+  gint        components = babl_format_get_n_components (format);
+  gint        n          = width * height * components;
+  gfloat     *data       = g_new (gfloat, n);
+  gint        i;
+
+  for (i = 0; i < n; i++)
+    {
+      /*  make some values exactly 0 or 1, like most of a real mask, and
+       *  the fully transparent pixels the convolution treats specially
+       */
+      switch (g_rand_int_range (rand, 0, 4))
+        {
+        case 0:  data[i] = 0.0f;                   break;
+        case 1:  data[i] = 1.0f;                   break;
+        default: data[i] = g_rand_double (rand);   break;
+        }
+    }
+
+  buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, width, height), format);
+  gegl_buffer_set (buffer, NULL, 0, NULL, data, GEGL_AUTO_ROWSTRIDE);
+
+  g_free (data);
+  g_rand_free (rand);
+
+  return buffer;
+}
+
+static const Babl *
+gimp_test_loops_src_format (const LoopTest *test)
+{
+  if (test->kind == CONVOLVE)
+    return babl_format ("RGBA float");
+
+  return babl_format ("Y float");
+}
+
+static const Babl *
+gimp_test_loops_dest_format (const LoopTest *test)
+{
+  if (test->kind == CONVOLVE || test->kind == APPLY_MASK)
+    return babl_format ("RGBA float");
+
+  return babl_format ("Y float");
+}
+
+static gdouble
+gimp_test_loops_tolerance (const LoopTest *test)
+{
+  /*  the convolution sums up to 225 products  */
+  if (test->kind == CONVOLVE)
+    return 1e-4;
+
+  return 1e-6;
+}
+
+static gfloat *
+gimp_test_loops_kernel (const LoopTest *test,
+                        gdouble        *divisor)
+{
+  gint    size   = test->kernel_size;
+  gfloat *kernel = g_new (gfloat, size * size);
+  gint    i, j;
+
+  *divisor = 0.0;
+
+  for (i = 0; i < size; i++)
+    {
+      for (j = 0; j < size; j++)
+        {
+          if (test->separable)
+            {
+              /*  a gaussian  */
+              gfloat di = i - size / 2;
+              gfloat dj = j - size / 2;
+
+              kernel[i * size + j] = expf (-di * di / size) *
+                                     expf (-dj * dj / size);
+            }
+          else
+            {
+              /*  a blur with a stronger center, like the convolve tool  */
+              kernel[i * size + j] = (i == size / 2 && j == size / 2) ?
+                                     size * size : 1.0f + (i * 7 + j * 3) % 5;
+            }
+
+          *divisor += kernel[i * size + j];
+        }
+    }
+
+  return kernel;
+}
+
+static void
+gimp_test_loops_run (const LoopTest *test,
+                     GeglBuffer     *src,
+                     GeglBuffer     *dest)
+{
+  switch (test->kind)
+    {
+    case CONVOLVE:
+      {
+        gfloat  *kernel;
+        gdouble  divisor;
+
+        kernel = gimp_test_loops_kernel (test, &divisor);
+
+        gimp_gegl_convolve (src, NULL, dest, NULL,
+                            kernel, test->kernel_size, divisor,
+                            GIMP_NORMAL_CONVOL, test->alpha_weighting);
+
+        g_free (kernel);
+      }
+      break;
+
+    case MASK_COMBINE_ELLIPSE_RECT:
+      {
+        gint width  = gegl_buffer_get_width  (dest);
+        gint height = gegl_buffer_get_height (dest);
+
+        /*  a rectangle with large rounded corners, inset from the
+         *  edges, so that all the cases of the loop are covered
+         */
+        gimp_gegl_mask_combine_ellipse_rect (dest, test->op,
+                                             width / 8, height / 8,
+                                             width * 3 / 4, height * 3 / 4,
+                                             width / 5.0, height / 5.0,
+                                             test->antialias);
+      }
+      break;
+
+    case MASK_COMBINE_BUFFER:
+      gimp_gegl_mask_combine_buffer (dest, src, test->op, 0, 0);
+      break;
+
+    case COMBINE_MASK:
+      gimp_gegl_combine_mask (src, NULL, dest, NULL, OPACITY);
+      break;
+
+    case COMBINE_MASK_WEIRD:
+      gimp_gegl_combine_mask_weird (src, NULL, dest, NULL, OPACITY,
+                                    test->stipple);
+      break;
+
+    case APPLY_MASK:
+      gimp_gegl_apply_mask (src, NULL, dest, NULL, OPACITY);
+      break;
+    }
+}
+
+static void
+gimp_test_loops_convolve_reference (const LoopTest *test,
+                                    const gfloat   *src,
+                                    gfloat         *dest)
+{
+  const gint  margin = test->kernel_size / 2;
+  gfloat     *kernel;
+  gdouble     divisor;
+  gint        x, y, i, j, b;
+
+  kernel = gimp_test_loops_kernel (test, &divisor);
+
+  for (y = 0; y < TEST_HEIGHT; y++)
+    {
+      for (x = 0; x < TEST_WIDTH; x++)
+        {
+          const gfloat *m                = kernel;
+          gdouble       total[4]         = { 0.0, 0.0, 0.0, 0.0 };
+          gdouble       weighted_divisor = 0.0;
+
+          for (j = y - margin; j <= y + margin; j++)
+            {
+              for (i = x - margin; i <= x + margin; i++, m++)
+                {
+                  gint          xx = CLAMP (i, 0, TEST_WIDTH  - 1);
+                  gint          yy = CLAMP (j, 0, TEST_HEIGHT - 1);
+                  const gfloat *s  = src + (yy * TEST_WIDTH + xx) * 4;
+                  gdouble       w  = *m;
+
+                  if (test->alpha_weighting)
+                    {
+                      w *= s[3];
+
+                      weighted_divisor += w;
+                    }
+
+                  for (b = 0; b < 3; b++)
+                    total[b] += w * s[b];
+
+                  total[3] += test->alpha_weighting ? w : w * s[3];
+                }
+            }
+
+          if (weighted_divisor == 0.0)
+            weighted_divisor = divisor;
+
+          for (b = 0; b < 4; b++)
+            {
+              if (test->alpha_weighting && b < 3)
+                total[b] /= weighted_divisor;
+              else
+                total[b] /= divisor;
+
+              *dest++ = CLAMP (total[b], 0.0, 1.0);
+            }
+        }
+    }
+
+  g_free (kernel);
+}
+
+/*  Returns the result of the loop on the test buffers, and the source
+ *  it was run on in *source, if not NULL.
+ */
+static gfloat *
+gimp_test_loops_result (const LoopTest  *test,
+                        gboolean         use_cpu_accel,
+                        gfloat         **source)
+{
+  const Babl *src_format  = gimp_test_loops_src_format (test);
+  const Babl *dest_format = gimp_test_loops_dest_format (test);
+  GeglBuffer *src;
+  GeglBuffer *dest;
+  gfloat     *result;
+
+  src  = gimp_test_loops_source (TEST_WIDTH, TEST_HEIGHT, src_format,  42);
+  dest = gimp_test_loops_source (TEST_WIDTH, TEST_HEIGHT, dest_format, 23);
+
+  gimp_cpu_accel_set_use (use_cpu_accel);
+
+  gimp_test_loops_run (test, src, dest);
+
+  gimp_cpu_accel_set_use (TRUE);
+
+  result = g_new (gfloat, TEST_WIDTH * TEST_HEIGHT *
+                          babl_format_get_n_components (dest_format));
+
+  gegl_buffer_get (dest, NULL, 1.0, dest_format, result,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  if (source)
+    {
+      *source = g_new (gfloat, TEST_WIDTH * TEST_HEIGHT *
+                               babl_format_get_n_components (src_format));
+
+      gegl_buffer_get (src, NULL, 1.0, src_format, *source,
+                       GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+    }
+
+  g_object_unref (dest);
+  g_object_unref (src);
+
+  return result;
+}
+
+static void
+gimp_test_loops_check (const LoopTest *test)
+{
+  const Babl *format    = gimp_test_loops_dest_format (test);
+  gdouble     tolerance = gimp_test_loops_tolerance (test);
+  gfloat     *source;
+  gfloat     *scalar;
+  gfloat     *simd;
+  gint        n;
+  gint        i;
+
+  n = TEST_WIDTH * TEST_HEIGHT * babl_format_get_n_components (format);
+
+  scalar = gimp_test_loops_result (test, FALSE, &source);
+  simd   = gimp_test_loops_result (test, TRUE,  NULL);
+
+  if (test->kind == CONVOLVE)
+    {
+      gfloat *expected = g_new (gfloat, n);
+
+      gimp_test_loops_convolve_reference (test, source, expected);
+
+      for (i = 0; i < n; i++)
+        {
+          g_assert_cmpfloat_with_epsilon (scalar[i], expected[i], tolerance);
+          g_assert_cmpfloat_with_epsilon (simd[i],   expected[i], tolerance);
+        }
+
+      g_free (expected);
+    }
+  else
+    {
+      for (i = 0; i < n; i++)
+        g_assert_cmpfloat_with_epsilon (simd[i], scalar[i], tolerance);
+    }
+
+  g_free (simd);
+  g_free (scalar);
+  g_free (source);
+}
+
+static gdouble
+gimp_test_loops_time (const LoopTest *test,
+                      GeglBuffer     *src,
+                      GeglBuffer     *dest,
+                      gboolean        use_cpu_accel)
+{
+  gdouble elapsed;
+  gint    i;
+
+  gimp_cpu_accel_set_use (use_cpu_accel);
+
+  g_test_timer_start ();
+
+  for (i = 0; i < BENCH_RUNS; i++)
+    gimp_test_loops_run (test, src, dest);
+
+  elapsed = g_test_timer_elapsed () / BENCH_RUNS;
+
+  gimp_cpu_accel_set_use (TRUE);
+
+  return elapsed;
+}
+
+static void
+gimp_test_loops_bench (const LoopTest *test)
+{
+  GeglBuffer *src;
+  GeglBuffer *dest;
+  gdouble     scalar;
+  gdouble     simd;
+
+  src  = gimp_test_loops_source (BENCH_SIZE, BENCH_SIZE,
+                                 gimp_test_loops_src_format (test),  42);
+  dest = gimp_test_loops_source (BENCH_SIZE, BENCH_SIZE,
+                                 gimp_test_loops_dest_format (test), 23);
+
+  scalar = gimp_test_loops_time (test, src, dest, FALSE);
+  simd   = gimp_test_loops_time (test, src, dest, TRUE);
+
+  g_test_minimized_result (simd,
+                           "%s, %dx%d: scalar %.3f s, SIMD %.3f s",
+                           test->name, BENCH_SIZE, BENCH_SIZE,
+                           scalar, simd);
+
+  g_object_unref (dest);
+  g_object_unref (src);
+}
+
+static void
+gimp_test_loops (gconstpointer data)
+{
+  const LoopTest *test = data;
+
+  gimp_test_loops_check (test);
+
+  if (g_test_perf ())
+    gimp_test_loops_bench (test);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  gint result;
+  gint i;
+
+  g_test_init (&argc, &argv, NULL);
+
+  gegl_init (&argc, &argv);
+  gimp_babl_init ();
+
+  for (i = 0; i < G_N_ELEMENTS (loop_tests); i++)
+    {
+      gchar *path = g_strconcat ("/gimp-gegl-loops/",
+                                 loop_tests[i].name, NULL);
+
+      g_test_add_data_func (path, &loop_tests[i], gimp_test_loops);
+
+      g_free (path);
+    }
+
+  result = g_test_run ();
+
+  gegl_exit ();
+
+  return result;
+}
@@ -30,6 +30,7 @@
 #include "libgimpbase/gimpbase.h"
 #include "libgimpcolor/gimpcolor.h"
 #include "libgimpconfig/gimpconfig.h"
+#include "libgimpmath/gimpmath.h"
 
 #include "text-types.h"
 
@@ -59,6 +60,10 @@
 #include "gimp-intl.h"
 
 
+/*  above this many dirty rectangles, their bounding box is rendered  */
+#define MAX_DIRTY_RECTS 8
+
+
 enum
 {
   PROP_0,
@@ -67,9 +72,21 @@ enum
   PROP_MODIFIED
 };
 
+typedef struct
+{
+  guint                 hash;
+  cairo_rectangle_int_t rect;
+} GimpTextLayerLine;
+
 struct _GimpTextLayerPrivate
 {
-  GimpTextDirection base_dir;
+  GimpTextDirection  base_dir;
+
+  /*  the state of the last rendering, used to only re-render the
+   *  lines which changed since
+   */
+  GimpText          *rendered_text;
+  GArray            *rendered_lines;
 };
 
 static void       gimp_text_layer_finalize       (GObject           *object);
@@ -121,6 +138,23 @@ static void       gimp_text_layer_text_changed   (GimpTextLayer     *layer);
 static gboolean   gimp_text_layer_render         (GimpTextLayer     *layer);
 static void       gimp_text_layer_render_layout  (GimpTextLayer     *layer,
                                                   GimpTextLayout    *layout);
+static gboolean   gimp_text_layer_render_rect    (GimpTextLayer     *layer,
+                                                  GimpTextLayout    *layout,
+                                                  const cairo_rectangle_int_t *rect);
+
+static void       gimp_text_layer_invalidate_rendering
+                                                 (GimpTextLayer     *layer);
+static gboolean   gimp_text_layer_is_same_style  (GimpText          *text,
+                                                  GimpText          *rendered_text);
+static GArray   * gimp_text_layer_get_lines      (GimpTextLayer     *layer,
+                                                  GimpTextLayout    *layout);
+static guint      gimp_text_layer_line_hash      (PangoLayoutLine   *line);
+static cairo_region_t *
+                  gimp_text_layer_get_dirty_region
+                                                 (GArray            *old_lines,
+                                                  GArray            *new_lines,
+                                                  gint               width,
+                                                  gint               height);
 
 
 G_DEFINE_TYPE_WITH_PRIVATE (GimpTextLayer, gimp_text_layer, GIMP_TYPE_LAYER)
@@ -204,6 +238,8 @@ gimp_text_layer_finalize (GObject *object)
 {
   GimpTextLayer *layer = GIMP_TEXT_LAYER (object);
 
+  gimp_text_layer_invalidate_rendering (layer);
+
   g_clear_object (&layer->text);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
@@ -253,6 +289,9 @@ gimp_text_layer_set_property (GObject      *object,
       break;
     case PROP_MODIFIED:
       text_layer->modified = g_value_get_boolean (value);
+
+      /*  the pixels may no longer match the last rendering  */
+      gimp_text_layer_invalidate_rendering (text_layer);
       break;
 
     default:
@@ -357,6 +396,8 @@ gimp_text_layer_set_buffer (GimpDrawable        *drawable,
     gimp_image_undo_group_start (image, GIMP_UNDO_GROUP_DRAWABLE_MOD,
                                  undo_desc);
 
+  gimp_text_layer_invalidate_rendering (layer);
+
   GIMP_DRAWABLE_CLASS (parent_class)->set_buffer (drawable,
                                                   push_undo, undo_desc,
                                                   buffer, bounds);
@@ -496,6 +537,8 @@ gimp_text_layer_set_text (GimpTextLayer *layer,
   if (layer->text == text)
     return;
 
+  gimp_text_layer_invalidate_rendering (layer);
+
   if (layer->text)
     {
       g_signal_handlers_disconnect_by_func (layer->text,
@@ -939,6 +982,82 @@ gimp_temp_buf_create_cairo_surface (GimpTempBuf *temp_buf)
 static void
 gimp_text_layer_render_layout (GimpTextLayer  *layer,
                                GimpTextLayout *layout)
+{
+  GimpTextLayerPrivate  *private  = layer->private;
+  GimpDrawable          *drawable = GIMP_DRAWABLE (layer);
+  GimpItem              *item     = GIMP_ITEM (layer);
+  GArray                *lines;
+  cairo_region_t        *dirty    = NULL;
+  cairo_rectangle_int_t  rect;
+  gboolean               success  = TRUE;
+
+  g_return_if_fail (gimp_drawable_has_alpha (drawable));
+
+  rect.x      = 0;
+  rect.y      = 0;
+  rect.width  = gimp_item_get_width  (item);
+  rect.height = gimp_item_get_height (item);
+
+  lines = gimp_text_layer_get_lines (layer, layout);
+
+  /*  if only the text changed since the last rendering, and the pixels
+   *  still match it, only re-render the lines which changed
+   */
+  if (private->rendered_lines &&
+      (layer->text->base_dir == GIMP_TEXT_DIRECTION_LTR ||
+       layer->text->base_dir == GIMP_TEXT_DIRECTION_RTL) &&
+      gimp_text_layer_is_same_style (layer->text, private->rendered_text))
+    {
+      dirty = gimp_text_layer_get_dirty_region (private->rendered_lines, lines,
+                                                rect.width, rect.height);
+    }
+
+  if (dirty)
+    {
+      gint n_rects = cairo_region_num_rectangles (dirty);
+      gint i;
+
+      if (n_rects > MAX_DIRTY_RECTS)
+        {
+          cairo_region_get_extents (dirty, &rect);
+
+          success = gimp_text_layer_render_rect (layer, layout, &rect);
+        }
+      else
+        {
+          for (i = 0; success && i < n_rects; i++)
+            {
+              cairo_region_get_rectangle (dirty, i, &rect);
+
+              success = gimp_text_layer_render_rect (layer, layout, &rect);
+            }
+        }
+
+      cairo_region_destroy (dirty);
+    }
+  else
+    {
+      success = gimp_text_layer_render_rect (layer, layout, &rect);
+    }
+
+  gimp_text_layer_invalidate_rendering (layer);
+
+  if (success)
+    {
+      private->rendered_text  = gimp_config_duplicate (GIMP_CONFIG (layer->text));
+      private->rendered_lines = lines;
+    }
+  else
+    {
+      g_array_unref (lines);
+    }
+}
+
+/*  renders @rect of the layout, in layer coordinates, into the drawable  */
+static gboolean
+gimp_text_layer_render_rect (GimpTextLayer               *layer,
+                             GimpTextLayout              *layout,
+                             const cairo_rectangle_int_t *rect)
 {
   GimpDrawable       *drawable = GIMP_DRAWABLE (layer);
   GimpItem           *item     = GIMP_ITEM (layer);
@@ -946,19 +1065,14 @@ gimp_text_layer_render_layout (GimpTextLayer  *layer,
   GeglBuffer         *buffer;
   cairo_t            *cr;
   cairo_surface_t    *surface;
-  gint                width;
-  gint                height;
   cairo_status_t      status;
 
-  g_return_if_fail (gimp_drawable_has_alpha (drawable));
-
-  width  = gimp_item_get_width  (item);
-  height = gimp_item_get_height (item);
-
 #if CAIRO_VERSION >= CAIRO_VERSION_ENCODE(1, 17, 2)
-  surface = cairo_image_surface_create (CAIRO_FORMAT_RGBA128F, width, height);
+  surface = cairo_image_surface_create (CAIRO_FORMAT_RGBA128F,
+                                        rect->width, rect->height);
 #else
-  surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, width, height);
+  surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
+                                        rect->width, rect->height);
 #endif
   status = cairo_surface_status (surface);
 
@@ -970,10 +1084,12 @@ gimp_text_layer_render_layout (GimpTextLayer  *layer,
                             _("Your text cannot be rendered. It is likely too big. "
                               "Please make it shorter or use a smaller font."));
       cairo_surface_destroy (surface);
-      return;
+      return FALSE;
     }
 
   cr = cairo_create (surface);
+  cairo_translate (cr, -rect->x, -rect->y);
+
   if (layer->text->outline != GIMP_TEXT_OUTLINE_STROKE_ONLY)
     {
       cairo_save (cr);
@@ -1083,10 +1199,256 @@ gimp_text_layer_render_layout (GimpTextLayer  *layer,
   buffer = gimp_cairo_surface_create_buffer (surface, format);
 
   gimp_gegl_buffer_copy (buffer, NULL, GEGL_ABYSS_NONE,
-                         gimp_drawable_get_buffer (drawable), NULL);
+                         gimp_drawable_get_buffer (drawable),
+                         GEGL_RECTANGLE (rect->x, rect->y, 0, 0));
 
   g_object_unref (buffer);
   cairo_surface_destroy (surface);
 
-  gimp_drawable_update (drawable, 0, 0, width, height);
+  gimp_drawable_update (drawable, rect->x, rect->y, rect->width, rect->height);
+
+  return TRUE;
+}
+
+static void
+gimp_text_layer_invalidate_rendering (GimpTextLayer *layer)
+{
+  GimpTextLayerPrivate *private = layer->private;
+
+  g_clear_object  (&private->rendered_text);
+  g_clear_pointer (&private->rendered_lines, g_array_unref);
+}
+
+/*  returns whether @text differs from @rendered_text in nothing but
+ *  its text or markup
+ */
+static gboolean
+gimp_text_layer_is_same_style (GimpText *text,
+                               GimpText *rendered_text)
+{
+  GimpText *copy;
+  gboolean  same;
+
+  copy = gimp_config_duplicate (GIMP_CONFIG (text));
+
+  g_object_set (copy,
+                "text",   rendered_text->text,
+                "markup", rendered_text->markup,
+                NULL);
+
+  same = gimp_config_is_equal_to (GIMP_CONFIG (copy),
+                                  GIMP_CONFIG (rendered_text));
+
+  g_object_unref (copy);
+
+  return same;
+}
+
+/*  returns the hash and the bounding box, in layer coordinates, of
+ *  each line of the layout
+ */
+static GArray *
+gimp_text_layer_get_lines (GimpTextLayer  *layer,
+                           GimpTextLayout *layout)
+{
+  GimpText        *text = layer->text;
+  PangoLayoutIter *iter;
+  GArray          *lines;
+  cairo_matrix_t   trafo;
+  gdouble          margin;
+  gint             offset_x;
+  gint             offset_y;
+
+  lines = g_array_new (FALSE, FALSE, sizeof (GimpTextLayerLine));
+
+  gimp_text_layout_get_offsets (layout, &offset_x, &offset_y);
+  gimp_text_layout_get_transform (layout, &trafo);
+
+  /*  leave room for antialiasing and, when stroking, for the outline
+   *  and its miter joins
+   */
+  margin = 1.0;
+
+  if (text->outline != GIMP_TEXT_OUTLINE_NONE)
+    margin += text->outline_width * MAX (text->outline_miter_limit, 1.0);
+
+  iter = pango_layout_get_iter (gimp_text_layout_get_pango_layout (layout));
+
+  do
+    {
+      GimpTextLayerLine line;
+      PangoRectangle    ink;
+      PangoRectangle    logical;
+      gdouble           x1, y1;
+      gdouble           x2, y2;
+      gint              i;
+
+      pango_layout_iter_get_line_extents (iter, &ink, &logical);
+
+      if (ink.width > 0 && ink.height > 0)
+        {
+          gint right  = MAX (ink.x + ink.width,  logical.x + logical.width);
+          gint bottom = MAX (ink.y + ink.height, logical.y + logical.height);
+
+          logical.x      = MIN (ink.x, logical.x);
+          logical.y      = MIN (ink.y, logical.y);
+          logical.width  = right  - logical.x;
+          logical.height = bottom - logical.y;
+        }
+
+      x1 = y1 = G_MAXDOUBLE;
+      x2 = y2 = -G_MAXDOUBLE;
+
+      for (i = 0; i < 4; i++)
+        {
+          gdouble x = (logical.x + (i & 1 ? logical.width  : 0)) /
+                      (gdouble) PANGO_SCALE;
+          gdouble y = (logical.y + (i & 2 ? logical.height : 0)) /
+                      (gdouble) PANGO_SCALE;
+
+          cairo_matrix_transform_point (&trafo, &x, &y);
+
+          x1 = MIN (x1, x);
+          y1 = MIN (y1, y);
+          x2 = MAX (x2, x);
+          y2 = MAX (y2, y);
+        }
+
+      line.hash        = gimp_text_layer_line_hash (
+                           pango_layout_iter_get_line_readonly (iter));
+      line.rect.x      = floor (offset_x + x1 - margin);
+      line.rect.y      = floor (offset_y + y1 - margin);
+      line.rect.width  = ceil  (offset_x + x2 + margin) - line.rect.x;
+      line.rect.height = ceil  (offset_y + y2 + margin) - line.rect.y;
+
+      g_array_append_val (lines, line);
+    }
+  while (pango_layout_iter_next_line (iter));
+
+  pango_layout_iter_free (iter);
+
+  return lines;
+}
+
+/*  hashes what gets drawn for a line: its fonts, glyphs and glyph
+ *  positions, and the attributes which affect drawing
+ */
+static guint
+gimp_text_layer_line_hash (PangoLayoutLine *line)
+{
+  GSList *list;
+  guint   hash = 0;
+
+  for (list = line->runs; list; list = g_slist_next (list))
+    {
+      PangoGlyphItem       *run    = list->data;
+      PangoGlyphString     *glyphs = run->glyphs;
+      PangoFontDescription *desc;
+      gchar                *str;
+      GSList               *attrs;
+      gint                  i;
+
+      desc = pango_font_describe (run->item->analysis.font);
+      str  = pango_font_description_to_string (desc);
+
+      hash = hash * 31 + g_str_hash (str);
+
+      g_free (str);
+      pango_font_description_free (desc);
+
+      for (i = 0; i < glyphs->num_glyphs; i++)
+        {
+          const PangoGlyphInfo *info = &glyphs->glyphs[i];
+
+          hash = hash * 31 + info->glyph;
+          hash = hash * 31 + info->geometry.width;
+          hash = hash * 31 + info->geometry.x_offset;
+          hash = hash * 31 + info->geometry.y_offset;
+        }
+
+      for (attrs = run->item->analysis.extra_attrs;
+           attrs;
+           attrs = g_slist_next (attrs))
+        {
+          PangoAttribute *attr = attrs->data;
+
+          hash = hash * 31 + attr->klass->type;
+
+          switch (attr->klass->type)
+            {
+            case PANGO_ATTR_FOREGROUND:
+            case PANGO_ATTR_BACKGROUND:
+            case PANGO_ATTR_UNDERLINE_COLOR:
+            case PANGO_ATTR_STRIKETHROUGH_COLOR:
+              {
+                const PangoColor *color = &((PangoAttrColor *) attr)->color;
+
+                hash = hash * 31 + color->red;
+                hash = hash * 31 + color->green;
+                hash = hash * 31 + color->blue;
+              }
+              break;
+
+            case PANGO_ATTR_UNDERLINE:
+            case PANGO_ATTR_STRIKETHROUGH:
+            case PANGO_ATTR_FOREGROUND_ALPHA:
+            case PANGO_ATTR_BACKGROUND_ALPHA:
+              hash = hash * 31 + ((PangoAttrInt *) attr)->value;
+              break;
+
+            default:
+              break;
+            }
+        }
+    }
+
+  return hash;
+}
+
+/*  returns the region covered by the lines which differ between
+ *  @old_lines and @new_lines, clipped to the layer
+ */
+static cairo_region_t *
+gimp_text_layer_get_dirty_region (GArray *old_lines,
+                                  GArray *new_lines,
+                                  gint    width,
+                                  gint    height)
+{
+  cairo_region_t        *region;
+  cairo_rectangle_int_t  layer_rect = { 0, 0, width, height };
+  guint                  i;
+
+  region = cairo_region_create ();
+
+  for (i = 0; i < MAX (old_lines->len, new_lines->len); i++)
+    {
+      const GimpTextLayerLine *old_line = NULL;
+      const GimpTextLayerLine *new_line = NULL;
+
+      if (i < old_lines->len)
+        old_line = &g_array_index (old_lines, GimpTextLayerLine, i);
+
+      if (i < new_lines->len)
+        new_line = &g_array_index (new_lines, GimpTextLayerLine, i);
+
+      if (old_line && new_line                             &&
+          old_line->hash        == new_line->hash        &&
+          old_line->rect.x      == new_line->rect.x      &&
+          old_line->rect.y      == new_line->rect.y      &&
+          old_line->rect.width  == new_line->rect.width  &&
+          old_line->rect.height == new_line->rect.height)
+        {
+          continue;
+        }
+
+      if (old_line)
+        cairo_region_union_rectangle (region, &old_line->rect);
+
+      if (new_line)
+        cairo_region_union_rectangle (region, &new_line->rect);
+    }
+
+  cairo_region_intersect_rectangle (region, &layer_rect);
+
+  return region;
 }
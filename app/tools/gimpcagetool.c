@@ -78,6 +78,14 @@ enum
 };
 
 
+/*  for cages larger than this, the preview interpolates coefficients
+ *  computed on a coarse grid, and the exact ones are only computed
+ *  when the transform is committed
+ */
+#define COARSE_COEF_AREA (1024 * 1024)
+#define COARSE_COEF_GRID 4
+
+
 static gboolean   gimp_cage_tool_initialize         (GimpTool              *tool,
                                                      GimpDisplay           *display,
                                                      GError               **error);
@@ -137,7 +145,8 @@ static gint       gimp_cage_tool_is_on_edge         (GimpCageTool          *ct,
 
 static gboolean   gimp_cage_tool_is_complete        (GimpCageTool          *ct);
 static void       gimp_cage_tool_remove_last_handle (GimpCageTool          *ct);
-static void       gimp_cage_tool_compute_coef       (GimpCageTool          *ct);
+static void       gimp_cage_tool_compute_coef       (GimpCageTool          *ct,
+                                                     gboolean               exact);
 static void       gimp_cage_tool_create_filter      (GimpCageTool          *ct);
 static void       gimp_cage_tool_filter_flush       (GimpDrawableFilter    *filter,
                                                      GimpTool              *tool);
@@ -614,7 +623,7 @@ gimp_cage_tool_key_press (GimpTool    *tool,
               ct->tool_state = CAGE_STATE_WAIT;
             }
 
-          gimp_cage_tool_compute_coef (ct);
+          gimp_cage_tool_compute_coef (ct, FALSE);
           gimp_cage_tool_render_node_update (ct);
         }
       return TRUE;
@@ -773,7 +782,7 @@ gimp_cage_tool_options_notify (GimpTool         *tool,
 
               if (ct->dirty_coef)
                 {
-                  gimp_cage_tool_compute_coef (ct);
+                  gimp_cage_tool_compute_coef (ct, FALSE);
                   gimp_cage_tool_render_node_update (ct);
                 }
 
@@ -960,6 +969,7 @@ gimp_cage_tool_start (GimpCageTool *ct,
   g_clear_object (&ct->config);
 
   g_clear_object (&ct->coef);
+  g_clear_object (&ct->coef_config);
   ct->dirty_coef = TRUE;
 
   if (ct->filter)
@@ -996,6 +1006,7 @@ gimp_cage_tool_halt (GimpCageTool *ct)
 
   g_clear_object (&ct->config);
   g_clear_object (&ct->coef);
+  g_clear_object (&ct->coef_config);
   g_clear_object (&ct->render_node);
   ct->coef_node = NULL;
   ct->cage_node = NULL;
@@ -1031,6 +1042,12 @@ gimp_cage_tool_commit (GimpCageTool *ct)
 
       gimp_tool_control_push_preserve (tool->control, TRUE);
 
+      if (ct->coef_grid > 1)
+        {
+          gimp_cage_tool_compute_coef (ct, TRUE);
+          gimp_cage_tool_render_node_update (ct);
+        }
+
       gimp_drawable_filter_commit (ct->filter, FALSE,
                                    GIMP_PROGRESS (tool), FALSE);
       g_clear_object (&ct->filter);
@@ -1156,34 +1173,51 @@ gimp_cage_tool_remove_last_handle (GimpCageTool *ct)
 }
 
 static void
-gimp_cage_tool_compute_coef (GimpCageTool *ct)
+gimp_cage_tool_compute_coef (GimpCageTool *ct,
+                             gboolean      exact)
 {
   GimpCageConfig *config = ct->config;
   GimpProgress   *progress;
   const Babl     *format;
+  GeglRectangle   bounds;
   GeglNode       *gegl;
   GeglNode       *input;
   GeglNode       *output;
   GeglProcessor  *processor;
   GeglBuffer     *buffer;
+  gint            grid_size = 1;
   gdouble         value;
 
   progress = gimp_progress_start (GIMP_PROGRESS (ct), FALSE,
                                   _("Computing Cage Coefficients"));
 
-  g_clear_object (&ct->coef);
-
   format = babl_format_n (babl_type ("float"),
                           gimp_cage_config_get_n_points (config) * 2);
 
+  bounds = gimp_cage_config_get_bounding_box (config);
+
+  if (! exact && (gint64) bounds.width * bounds.height > COARSE_COEF_AREA)
+    grid_size = COARSE_COEF_GRID;
 
   gegl = gegl_node_new ();
 
   input = gegl_node_new_child (gegl,
                                "operation", "gimp:cage-coef-calc",
                                "config",    ct->config,
+                               "grid-size", grid_size,
                                NULL);
 
+  /*  only recompute the edges that moved since the last exact
+   *  coefficients
+   */
+  if (grid_size == 1 && ct->coef && ct->coef_grid == 1)
+    {
+      gegl_node_set (input,
+                     "reference-config", ct->coef_config,
+                     "reference",        ct->coef,
+                     NULL);
+    }
+
   output = gegl_node_new_child (gegl,
                                 "operation", "gegl:buffer-sink",
                                 "buffer",    &buffer,
@@ -1204,10 +1238,19 @@ gimp_cage_tool_compute_coef (GimpCageTool *ct)
     gimp_progress_end (progress);
 
   g_object_unref (processor);
-
-  ct->coef = buffer;
   g_object_unref (gegl);
 
+  g_clear_object (&ct->coef);
+  ct->coef      = buffer;
+  ct->coef_grid = grid_size;
+
+  /*  remember the cage the coefficients belong to  */
+  g_clear_object (&ct->coef_config);
+  ct->coef_config = g_object_new (GIMP_TYPE_CAGE_CONFIG, NULL);
+  g_array_append_vals (ct->coef_config->cage_points,
+                       config->cage_points->data,
+                       config->cage_points->len);
+
   ct->dirty_coef = FALSE;
 }
 
@@ -64,7 +64,9 @@
 #include "core/gimp-parallel.h"
 #include "core/gimpasync.h"
 #include "core/gimpbacktrace.h"
+#include "core/gimpbrushcache.h"
 #include "core/gimptempbuf.h"
+#include "core/gimpundostack.h"
 #include "core/gimpwaitable.h"
 
 #include "gimpactiongroup.h"
@@ -155,6 +157,9 @@ typedef enum
   VARIABLE_TILE_ALLOC_TOTAL,
   VARIABLE_SCRATCH_TOTAL,
   VARIABLE_TEMP_BUF_TOTAL,
+  VARIABLE_UNDO_TOTAL,
+  VARIABLE_BRUSH_CACHE_TOTAL,
+  VARIABLE_BRUSH_CACHE_HIT_MISS,
 
 
   N_VARIABLES,
@@ -372,6 +377,8 @@ static void       gimp_dashboard_sample_variable_rate_of_change (GimpDashboard
                                                                  Variable             variable);
 static void       gimp_dashboard_sample_swap_limit              (GimpDashboard       *dashboard,
                                                                  Variable             variable);
+static void       gimp_dashboard_sample_brush_cache_hit_miss    (GimpDashboard       *dashboard,
+                                                                 Variable             variable);
 #ifdef HAVE_CPU_GROUP
 static void       gimp_dashboard_sample_cpu_usage               (GimpDashboard       *dashboard,
                                                                  Variable             variable);
@@ -764,6 +771,32 @@ static const VariableInfo variables[] =
     .type             = VARIABLE_TYPE_SIZE,
     .sample_func      = gimp_dashboard_sample_function,
     .data             = gimp_temp_buf_get_total_memsize
+  },
+
+  [VARIABLE_UNDO_TOTAL] =
+  { .name             = "undo-total",
+    .title            = NC_("dashboard-variable", "Undo"),
+    .description      = N_("Total size of undo history"),
+    .type             = VARIABLE_TYPE_SIZE,
+    .sample_func      = gimp_dashboard_sample_function,
+    .data             = gimp_undo_stack_get_total_memsize
+  },
+
+  [VARIABLE_BRUSH_CACHE_TOTAL] =
+  { .name             = "brush-cache-total",
+    .title            = NC_("dashboard-variable", "Brush cache"),
+    .description      = N_("Total size of transformed brush caches"),
+    .type             = VARIABLE_TYPE_SIZE,
+    .sample_func      = gimp_dashboard_sample_function,
+    .data             = gimp_brush_cache_get_total_memsize
+  },
+
+  [VARIABLE_BRUSH_CACHE_HIT_MISS] =
+  { .name             = "brush-cache-hit-miss",
+    .title            = NC_("dashboard-variable", "Brush hit/miss"),
+    .description      = N_("Transformed brush cache hit/miss ratio"),
+    .type             = VARIABLE_TYPE_INT_RATIO,
+    .sample_func      = gimp_dashboard_sample_brush_cache_hit_miss
   }
 };
 
@@ -981,6 +1014,15 @@ static const GroupInfo groups[] =
                           { .variable       = VARIABLE_TEMP_BUF_TOTAL,
                             .default_active = TRUE
                           },
+                          { .variable       = VARIABLE_UNDO_TOTAL,
+                            .default_active = TRUE
+                          },
+                          { .variable       = VARIABLE_BRUSH_CACHE_TOTAL,
+                            .default_active = FALSE
+                          },
+                          { .variable       = VARIABLE_BRUSH_CACHE_HIT_MISS,
+                            .default_active = FALSE
+                          },
 
                           {}
                         }
@@ -2221,6 +2263,18 @@ gimp_dashboard_sample_swap_limit (GimpDashboard *dashboard,
     }
 }
 
+static void
+gimp_dashboard_sample_brush_cache_hit_miss (GimpDashboard *dashboard,
+                                            Variable       variable)
+{
+  GimpDashboardPrivate *priv          = dashboard->priv;
+  VariableData         *variable_data = &priv->variables[variable];
+
+  variable_data->available                  = TRUE;
+  variable_data->value.int_ratio.antecedent = gimp_brush_cache_get_hits ();
+  variable_data->value.int_ratio.consequent = gimp_brush_cache_get_misses ();
+}
+
 #ifdef HAVE_CPU_GROUP
 
 #ifdef HAVE_SYS_TIMES_H
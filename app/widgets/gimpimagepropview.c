@@ -391,11 +391,10 @@ gimp_image_prop_view_label_set_undo (GtkWidget     *label,
 
   if (steps > 0)
     {
-      GimpObject *object = GIMP_OBJECT (stack);
-      gchar      *str;
-      gchar       buf[256];
+      gchar *str;
+      gchar  buf[256];
 
-      str = g_format_size (gimp_object_get_memsize (object, NULL));
+      str = g_format_size (gimp_undo_stack_get_size (stack));
       g_snprintf (buf, sizeof (buf), "%d (%s)", steps, str);
       g_free (str);
 
@@ -34,11 +34,9 @@
 #include "core/gimpcontext.h"
 #include "core/gimpimagefile.h"
 #include "core/gimpprogress.h"
-#include "core/gimpsubprogress.h"
 
 #include "plug-in/gimppluginmanager-file.h"
 
-#include "gimpfiledialog.h" /* eek */
 #include "gimpthumbbox.h"
 #include "gimpview.h"
 #include "gimpviewrenderer-frame.h"
@@ -87,8 +85,8 @@ static void gimp_thumb_box_create_thumbnails      (GimpThumbBox      *box,
 static void gimp_thumb_box_create_thumbnail       (GimpThumbBox      *box,
                                                    GFile             *file,
                                                    GimpThumbnailSize  size,
-                                                   gboolean           force,
-                                                   GimpProgress      *progress);
+                                                   gboolean           force);
+static void gimp_thumb_box_cancel_thumbnails      (GimpThumbBox      *box);
 static gboolean gimp_thumb_box_auto_thumbnail     (GimpThumbBox      *box);
 
 
@@ -154,6 +152,9 @@ gimp_thumb_box_finalize (GObject *object)
 
   gimp_thumb_box_take_files (box, NULL);
 
+  if (box->imagefile)
+    gimp_imagefile_cancel_thumbnail (box->imagefile);
+
   g_clear_object (&box->imagefile);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
@@ -443,6 +444,11 @@ gimp_thumb_box_take_file (GimpThumbBox *box,
       box->idle_id = 0;
     }
 
+  /*  the previous file is no longer shown, don't bother creating its
+   *  thumbnail
+   */
+  gimp_imagefile_cancel_thumbnail (box->imagefile);
+
   gimp_imagefile_set_file (box->imagefile, file);
 
   if (file)
@@ -480,6 +486,8 @@ gimp_thumb_box_take_files (GimpThumbBox *box,
 {
   g_return_if_fail (GIMP_IS_THUMB_BOX (box));
 
+  gimp_thumb_box_cancel_thumbnails (box);
+
   if (box->files)
     {
       g_slist_free_full (box->files, (GDestroyNotify) g_object_unref);
@@ -554,131 +562,50 @@ gimp_thumb_box_thumb_state_notify (GimpThumbnail *thumb,
     }
 }
 
+/*  Queues thumbnails for all selected files.  The one shown in the box
+ *  goes first, the others are created in the background and dropped
+ *  again when the selection changes.
+ */
 static void
 gimp_thumb_box_create_thumbnails (GimpThumbBox *box,
                                   gboolean      force)
 {
-  Gimp           *gimp     = box->context->gimp;
-  GimpProgress   *progress = GIMP_PROGRESS (box);
-  GimpFileDialog *dialog   = NULL;
-  GtkWidget      *toplevel;
-  GSList         *list;
-  gint            n_files;
-  gint            i;
+  Gimp   *gimp = box->context->gimp;
+  GSList *list;
 
   if (gimp->config->thumbnail_size == GIMP_THUMBNAIL_SIZE_NONE)
     return;
 
-  toplevel = gtk_widget_get_toplevel (GTK_WIDGET (box));
-
-  if (GIMP_IS_FILE_DIALOG (toplevel))
-    dialog = GIMP_FILE_DIALOG (toplevel);
-
-  gimp_set_busy (gimp);
-
-  if (dialog)
-    gimp_file_dialog_set_sensitive (dialog, FALSE);
-  else
-    gtk_widget_set_sensitive (toplevel, FALSE);
-
-  if (box->files)
-    {
-      gtk_widget_hide (box->info);
-      gtk_widget_show (box->progress);
-    }
-
-  n_files = g_slist_length (box->files);
-
-  if (n_files > 1)
-    {
-      gchar *str;
-
-      gimp_progress_start (GIMP_PROGRESS (box), TRUE, "%s", "");
-
-      progress = gimp_sub_progress_new (GIMP_PROGRESS (box));
-
-      gimp_sub_progress_set_step (GIMP_SUB_PROGRESS (progress), 0, n_files);
-
-      for (list = box->files->next, i = 1;
-           list;
-           list = g_slist_next (list), i++)
-        {
-          str = g_strdup_printf (_("Thumbnail %d of %d"), i, n_files);
-          gtk_progress_bar_set_text (GTK_PROGRESS_BAR (box->progress), str);
-          g_free (str);
-
-          gimp_progress_set_value (progress, 0.0);
-
-          while (g_main_context_pending (NULL))
-            g_main_context_iteration (NULL, FALSE);
-
-          gimp_thumb_box_create_thumbnail (box,
-                                           list->data,
-                                           gimp->config->thumbnail_size,
-                                           force,
-                                           progress);
-
-          if (dialog && dialog->canceled)
-            goto canceled;
-
-          gimp_sub_progress_set_step (GIMP_SUB_PROGRESS (progress), i, n_files);
-        }
+  gimp_thumb_box_cancel_thumbnails (box);
 
-      str = g_strdup_printf (_("Thumbnail %d of %d"), n_files, n_files);
-      gtk_progress_bar_set_text (GTK_PROGRESS_BAR (box->progress), str);
-      g_free (str);
-
-      gimp_progress_set_value (progress, 0.0);
-
-      while (g_main_context_pending (NULL))
-        g_main_context_iteration (NULL, FALSE);
-    }
-
-  if (box->files)
-    {
-      gimp_thumb_box_create_thumbnail (box,
-                                       box->files->data,
-                                       gimp->config->thumbnail_size,
-                                       force,
-                                       progress);
-
-      gimp_progress_set_value (progress, 1.0);
-    }
+  if (! box->files)
+    return;
 
- canceled:
+  gimp_thumb_box_create_thumbnail (box,
+                                   box->files->data,
+                                   gimp->config->thumbnail_size,
+                                   force);
 
-  if (n_files > 1)
+  for (list = box->files->next; list; list = g_slist_next (list))
     {
-      g_object_unref (progress);
+      GimpImagefile *imagefile = gimp_imagefile_new (gimp, list->data);
 
-      gimp_progress_end (GIMP_PROGRESS (box));
-      gtk_progress_bar_set_text (GTK_PROGRESS_BAR (box->progress), "");
-    }
+      gimp_imagefile_queue_thumbnail (imagefile, box->context,
+                                      gimp->config->thumbnail_size,
+                                      force, FALSE);
 
-  if (box->files)
-    {
-      gtk_widget_hide (box->progress);
-      gtk_widget_show (box->info);
+      box->queued = g_slist_prepend (box->queued, imagefile);
     }
-
-  if (dialog)
-    gimp_file_dialog_set_sensitive (dialog, TRUE);
-  else
-    gtk_widget_set_sensitive (toplevel, TRUE);
-
-  gimp_unset_busy (gimp);
 }
 
 static void
 gimp_thumb_box_create_thumbnail (GimpThumbBox      *box,
                                  GFile             *file,
                                  GimpThumbnailSize  size,
-                                 gboolean           force,
-                                 GimpProgress      *progress)
+                                 gboolean           force)
 {
-  GimpThumbnail *thumb = gimp_imagefile_get_thumbnail (box->imagefile);
-  GFileInfo     *info;
-  gchar         *basename;
+  GFileInfo *info;
+  gchar     *basename;
 
   info = g_file_query_info (file,
                                 G_FILE_ATTRIBUTE_STANDARD_DISPLAY_NAME,
@@ -697,22 +624,22 @@ gimp_thumb_box_create_thumbnail (GimpThumbBox      *box,
 
   gimp_imagefile_set_file (box->imagefile, file);
 
-  if (force ||
-      (gimp_thumbnail_peek_thumb (thumb, (GimpThumbSize) size) < GIMP_THUMB_STATE_FAILED &&
-       ! gimp_thumbnail_has_failed (thumb)))
-    {
-      GError *error = NULL;
+  gtk_label_set_text (GTK_LABEL (box->info), _("Creating preview..."));
 
-      if (! gimp_imagefile_create_thumbnail (box->imagefile, box->context,
-                                             progress,
-                                             size, ! force, &error))
-        {
-          gimp_message_literal (box->context->gimp,
-                                G_OBJECT (progress), GIMP_MESSAGE_ERROR,
-                                error->message);
-          g_clear_error (&error);
-        }
-    }
+  gimp_imagefile_queue_thumbnail (box->imagefile, box->context,
+                                  size, force, TRUE);
+}
+
+static void
+gimp_thumb_box_cancel_thumbnails (GimpThumbBox *box)
+{
+  GSList *list;
+
+  for (list = box->queued; list; list = g_slist_next (list))
+    gimp_imagefile_cancel_thumbnail (list->data);
+
+  g_slist_free_full (box->queued, (GDestroyNotify) g_object_unref);
+  box->queued = NULL;
 }
 
 static gboolean
@@ -766,10 +693,9 @@ gimp_thumb_box_auto_thumbnail (GimpThumbBox *box)
                                   _("Creating preview..."));
             }
 
-          gimp_imagefile_create_thumbnail_weak (box->imagefile, box->context,
-                                                GIMP_PROGRESS (box),
-                                                gimp->config->thumbnail_size,
-                                                TRUE);
+          gimp_imagefile_queue_thumbnail (box->imagefile, box->context,
+                                          gimp->config->thumbnail_size,
+                                          FALSE, TRUE);
         }
       break;
 
@@ -35,6 +35,7 @@ struct _GimpThumbBox
   GimpContext   *context;
   GimpImagefile *imagefile;
   GSList        *files;
+  GSList        *queued;
 
   GtkWidget     *preview;
   GtkWidget     *filename;
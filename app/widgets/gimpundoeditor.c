@@ -66,6 +66,7 @@ static void   gimp_undo_editor_set_context    (GimpDocked        *docked,
 
 static void   gimp_undo_editor_fill           (GimpUndoEditor    *editor);
 static void   gimp_undo_editor_clear          (GimpUndoEditor    *editor);
+static void   gimp_undo_editor_update_size    (GimpUndoEditor    *editor);
 
 static void   gimp_undo_editor_undo_event     (GimpImage         *image,
                                                GimpUndoEvent      event,
@@ -137,6 +138,15 @@ gimp_undo_editor_constructed (GObject *object)
   gtk_box_pack_start (GTK_BOX (undo_editor), undo_editor->view, TRUE, TRUE, 0);
   gtk_widget_show (undo_editor->view);
 
+  undo_editor->size_label = gtk_label_new (NULL);
+  gtk_label_set_xalign (GTK_LABEL (undo_editor->size_label), 0.0);
+  gimp_label_set_attributes (GTK_LABEL (undo_editor->size_label),
+                             PANGO_ATTR_SCALE, PANGO_SCALE_SMALL,
+                             -1);
+  gtk_box_pack_start (GTK_BOX (undo_editor), undo_editor->size_label,
+                      FALSE, FALSE, 0);
+  gtk_widget_show (undo_editor->size_label);
+
   g_signal_connect (undo_editor->view, "selection-changed",
                     G_CALLBACK (gimp_undo_editor_selection_changed),
                     undo_editor);
@@ -199,6 +209,8 @@ gimp_undo_editor_set_image (GimpImageEditor *image_editor,
                         G_CALLBACK (gimp_undo_editor_undo_event),
                         editor);
     }
+
+  gimp_undo_editor_update_size (editor);
 }
 
 static void
@@ -401,6 +413,39 @@ gimp_undo_editor_undo_event (GimpImage      *image,
       gimp_undo_editor_fill (editor);
       break;
     }
+
+  gimp_undo_editor_update_size (editor);
+}
+
+static void
+gimp_undo_editor_update_size (GimpUndoEditor *editor)
+{
+  GimpImage *image = GIMP_IMAGE_EDITOR (editor)->image;
+
+  if (image && gimp_image_undo_is_enabled (image))
+    {
+      gint64  memsize;
+      gchar  *str;
+      gchar  *text;
+
+      /*  the undo stacks keep their size up to date, so this is cheap
+       *  enough to do on every undo event
+       */
+      memsize = (gimp_undo_stack_get_size (gimp_image_get_undo_stack (image)) +
+                 gimp_undo_stack_get_size (gimp_image_get_redo_stack (image)));
+
+      str  = g_format_size (memsize);
+      text = g_strdup_printf (_("Undo memory: %s"), str);
+
+      gtk_label_set_text (GTK_LABEL (editor->size_label), text);
+
+      g_free (text);
+      g_free (str);
+    }
+  else
+    {
+      gtk_label_set_text (GTK_LABEL (editor->size_label), NULL);
+    }
 }
 
 static void
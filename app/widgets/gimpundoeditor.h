@@ -38,6 +38,7 @@ struct _GimpUndoEditor
   GimpContainer   *container;
   GtkWidget       *view;
   GimpViewSize     view_size;
+  GtkWidget       *size_label;
 
   GimpUndo        *base_item;
 
@@ -24,6 +24,7 @@
 #include "gimp.h"
 
 #include "gimpexportoptions.h"
+#include "gimptilebackendplugin.h"
 
 #include "libgimp-intl.h"
 
@@ -532,36 +533,9 @@ export_action_perform (const ExportAction *action,
   export_action_get_func (action) (image, drawables);
 }
 
-/**
- * gimp_export_options_get_image:
- * @options: (transfer none): The #GimpExportOptions object.
- * @image: (inout) (transfer none): the image.
- *
- * Takes an image to be exported, possibly creating a temporary copy
- * modified according to export settings in @options (such as the
- * capabilities of the export format).
- *
- * If necessary, a copy is created, converted and modified, @image
- * changed to point to the new image and the procedure returns
- * [enum@Gimp.ExportReturn.EXPORT].
- * In this case, you must take care of deleting the created image using
- * [method@Image.delete] once the image has been exported, unless you
- * were planning to display it with [ctor@Display.new], or you will leak
- * memory.
- *
- * If [enum@Gimp.ExportReturn.IGNORE] is returned, then @image is still the
- * original image. You should neither modify it, nor should you delete
- * it in the end. If you wish to temporarily modify the image before
- * export anyway, call [method@Image.duplicate] when
- * [enum@Gimp.ExportReturn.IGNORE] was returned.
- *
- * Returns: An enum of #GimpExportReturn.
- *
- * Since: 3.0
- **/
-GimpExportReturn
-gimp_export_options_get_image (GimpExportOptions  *options,
-                               GimpImage         **image)
+static GSList *
+export_options_get_actions (GimpExportOptions *options,
+                            GimpImage         *image)
 {
   GSList                 *actions = NULL;
   GimpImageBaseType       type;
@@ -572,10 +546,6 @@ gimp_export_options_get_image (GimpExportOptions  *options,
   gboolean                added_flatten        = FALSE;
   gboolean                has_layer_masks      = FALSE;
   gboolean                background_has_alpha = TRUE;
-  GimpExportReturn        retval               = GIMP_EXPORT_IGNORE;
-
-  g_return_val_if_fail (image && gimp_image_is_valid (*image), GIMP_EXPORT_IGNORE);
-  g_return_val_if_fail (GIMP_IS_EXPORT_OPTIONS (options), GIMP_EXPORT_IGNORE);
 
   /* Get capabilities from ExportOptions */
   g_object_get (options, "capabilities", &capabilities, NULL);
@@ -584,7 +554,7 @@ gimp_export_options_get_image (GimpExportOptions  *options,
                                         GIMP_EXPORT_CAN_HANDLE_GRAY |
                                         GIMP_EXPORT_CAN_HANDLE_INDEXED |
                                         GIMP_EXPORT_CAN_HANDLE_BITMAP),
-                        GIMP_EXPORT_IGNORE);
+                        NULL);
 
 
   /* do some sanity checks */
@@ -602,13 +572,14 @@ gimp_export_options_get_image (GimpExportOptions  *options,
     actions = g_slist_prepend (actions, &export_action_merge_layer_effects);
 
   /* check alpha and layer masks */
-  layers   = gimp_image_list_layers (*image);
+  layers   = gimp_image_list_layers (image);
   n_layers = g_list_length (layers);
 
   if (n_layers < 1)
     {
       g_list_free (layers);
-      return FALSE;
+      g_slist_free (actions);
+      return NULL;
     }
 
   for (iter = layers; iter; iter = iter->next)
@@ -672,8 +643,8 @@ gimp_export_options_get_image (GimpExportOptions  *options,
 
           image_bounds.x      = 0;
           image_bounds.y      = 0;
-          image_bounds.width  = gimp_image_get_width  (*image);
-          image_bounds.height = gimp_image_get_height (*image);
+          image_bounds.width  = gimp_image_get_width  (image);
+          image_bounds.height = gimp_image_get_height (image);
 
           for (iter = layers; iter; iter = iter->next)
             {
@@ -713,9 +684,9 @@ gimp_export_options_get_image (GimpExportOptions  *options,
           gimp_drawable_get_offsets (drawable, &offset_x, &offset_y);
 
           if ((gimp_layer_get_opacity (GIMP_LAYER (drawable)) < 100.0) ||
-              (gimp_image_get_width (*image) !=
+              (gimp_image_get_width (image) !=
                gimp_drawable_get_width (drawable))            ||
-              (gimp_image_get_height (*image) !=
+              (gimp_image_get_height (image) !=
                gimp_drawable_get_height (drawable))           ||
               offset_x || offset_y)
             {
@@ -779,7 +750,7 @@ gimp_export_options_get_image (GimpExportOptions  *options,
   g_list_free (layers);
 
   /* check the image type */
-  type = gimp_image_get_base_type (*image);
+  type = gimp_image_get_base_type (image);
   switch (type)
     {
     case GIMP_RGB:
@@ -837,7 +808,7 @@ gimp_export_options_get_image (GimpExportOptions  *options,
             {
               gint n_colors;
 
-              n_colors = gimp_palette_get_color_count (gimp_image_get_palette (*image));
+              n_colors = gimp_palette_get_color_count (gimp_image_get_palette (image));
 
               if (n_colors > 2)
                 actions = g_slist_prepend (actions,
@@ -847,16 +818,50 @@ gimp_export_options_get_image (GimpExportOptions  *options,
       break;
     }
 
-  if (actions)
-    {
-      actions = g_slist_reverse (actions);
+  return g_slist_reverse (actions);
+}
 
-      retval = GIMP_EXPORT_EXPORT;
-    }
-  else
-    {
-      retval = GIMP_EXPORT_IGNORE;
-    }
+/**
+ * gimp_export_options_get_image:
+ * @options: (transfer none): The #GimpExportOptions object.
+ * @image: (inout) (transfer none): the image.
+ *
+ * Takes an image to be exported, possibly creating a temporary copy
+ * modified according to export settings in @options (such as the
+ * capabilities of the export format).
+ *
+ * If necessary, a copy is created, converted and modified, @image
+ * changed to point to the new image and the procedure returns
+ * [enum@Gimp.ExportReturn.EXPORT].
+ * In this case, you must take care of deleting the created image using
+ * [method@Image.delete] once the image has been exported, unless you
+ * were planning to display it with [ctor@Display.new], or you will leak
+ * memory.
+ *
+ * If [enum@Gimp.ExportReturn.IGNORE] is returned, then @image is still the
+ * original image. You should neither modify it, nor should you delete
+ * it in the end. If you wish to temporarily modify the image before
+ * export anyway, call [method@Image.duplicate] when
+ * [enum@Gimp.ExportReturn.IGNORE] was returned.
+ *
+ * Returns: An enum of #GimpExportReturn.
+ *
+ * Since: 3.0
+ **/
+GimpExportReturn
+gimp_export_options_get_image (GimpExportOptions  *options,
+                               GimpImage         **image)
+{
+  GSList           *actions;
+  GimpExportReturn  retval = GIMP_EXPORT_IGNORE;
+
+  g_return_val_if_fail (image && gimp_image_is_valid (*image), GIMP_EXPORT_IGNORE);
+  g_return_val_if_fail (GIMP_IS_EXPORT_OPTIONS (options), GIMP_EXPORT_IGNORE);
+
+  actions = export_options_get_actions (options, *image);
+
+  if (actions)
+    retval = GIMP_EXPORT_EXPORT;
 
   if (retval == GIMP_EXPORT_EXPORT)
     {
@@ -888,3 +893,86 @@ gimp_export_options_get_image (GimpExportOptions  *options,
 
   return retval;
 }
+
+/**
+ * gimp_export_options_get_merged_buffer:
+ * @options: (transfer none): The #GimpExportOptions object.
+ * @image: (transfer none): the image.
+ *
+ * Checks whether the only transforms [method@ExportOptions.get_image]
+ * would apply to @image are merging or flattening its visible layers,
+ * and if so, returns a read-only buffer of the merged (or flattened)
+ * pixels, without duplicating the image.
+ *
+ * The pixels of the returned buffer are rendered by the core on
+ * demand, one band of tile rows at a time, so an exporter that reads
+ * the buffer in bands only ever needs a bounded amount of memory,
+ * whatever the size of the image or the number of its layers.
+ *
+ * If %NULL is returned, the export must go through
+ * [method@ExportOptions.get_image] as usual.
+ *
+ * Returns: (transfer full) (nullable): a #GeglBuffer of the image's
+ *          merged pixels, or %NULL.
+ *
+ * Since: 3.2
+ **/
+GeglBuffer *
+gimp_export_options_get_merged_buffer (GimpExportOptions *options,
+                                       GimpImage         *image)
+{
+  GeglTileBackend *backend;
+  GeglBuffer      *buffer;
+  GSList          *actions;
+  GSList          *list;
+  gboolean         merge   = FALSE;
+  gboolean         flatten = FALSE;
+
+  g_return_val_if_fail (GIMP_IS_EXPORT_OPTIONS (options), NULL);
+  g_return_val_if_fail (gimp_image_is_valid (image), NULL);
+
+  if (gimp_image_get_base_type (image) == GIMP_INDEXED)
+    return NULL;
+
+  actions = export_options_get_actions (options, image);
+
+  /*  merging in the core renders layer effects and layer masks, so
+   *  any other transform must go through a copy of the image
+   */
+  for (list = actions; list; list = list->next)
+    {
+      ExportFunc func = export_action_get_func (list->data);
+
+      if (func == export_merge)
+        {
+          merge = TRUE;
+        }
+      else if (func == export_flatten)
+        {
+          flatten = TRUE;
+        }
+      else if (func != export_merge_layer_effects &&
+               func != export_apply_masks         &&
+               func != export_void)
+        {
+          merge   = FALSE;
+          flatten = FALSE;
+          break;
+        }
+    }
+
+  g_slist_free (actions);
+
+  if (! merge && ! flatten)
+    return NULL;
+
+  backend = _gimp_tile_backend_plugin_new_merged (image, flatten);
+
+  if (! backend)
+    return NULL;
+
+  buffer = gegl_buffer_new_for_backend (NULL, backend);
+  g_object_unref (backend);
+
+  return buffer;
+}
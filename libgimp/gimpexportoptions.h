@@ -45,8 +45,10 @@ typedef enum
 } GimpExportReturn;
 
 
-GimpExportReturn    gimp_export_options_get_image     (GimpExportOptions  *options,
-                                                       GimpImage         **image) G_GNUC_WARN_UNUSED_RESULT;
+GimpExportReturn    gimp_export_options_get_image         (GimpExportOptions  *options,
+                                                           GimpImage         **image) G_GNUC_WARN_UNUSED_RESULT;
+GeglBuffer        * gimp_export_options_get_merged_buffer (GimpExportOptions  *options,
+                                                           GimpImage          *image);
 
 
 G_END_DECLS
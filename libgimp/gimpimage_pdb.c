@@ -2167,6 +2167,101 @@ _gimp_image_thumbnail (GimpImage  *image,
   return success;
 }
 
+/**
+ * _gimp_image_get_merged_format:
+ * @image: The image.
+ * @flatten: Whether the merged pixels are flattened.
+ *
+ * Returns the Babl format of the image's merged pixels.
+ *
+ * This procedure returns the Babl format of the pixels returned by
+ * gimp_image_get_merged_region(), which is the format of the layer
+ * that merging or flattening the image's visible layers would create.
+ * Note that the actual PDB procedure only transfers the format's
+ * encoding. In order to get to the real format, the libgimp C wrapper
+ * must be used.
+ *
+ * Returns: (transfer full): The merged pixels' Babl format.
+ *          The returned value must be freed with g_free().
+ **/
+gchar *
+_gimp_image_get_merged_format (GimpImage *image,
+                               gboolean   flatten)
+{
+  GimpValueArray *args;
+  GimpValueArray *return_vals;
+  gchar *format = NULL;
+
+  args = gimp_value_array_new_from_types (NULL,
+                                          GIMP_TYPE_IMAGE, image,
+                                          G_TYPE_BOOLEAN, flatten,
+                                          G_TYPE_NONE);
+
+  return_vals = _gimp_pdb_run_procedure_array (gimp_get_pdb (),
+                                               "gimp-image-get-merged-format",
+                                               args);
+  gimp_value_array_unref (args);
+
+  if (GIMP_VALUES_GET_ENUM (return_vals, 0) == GIMP_PDB_SUCCESS)
+    format = GIMP_VALUES_DUP_STRING (return_vals, 1);
+
+  gimp_value_array_unref (return_vals);
+
+  return format;
+}
+
+/**
+ * _gimp_image_get_merged_region:
+ * @image: The image.
+ * @flatten: Whether to flatten the merged pixels.
+ * @x: The x coordinate of the region.
+ * @y: The y coordinate of the region.
+ * @width: The width of the region.
+ * @height: The height of the region.
+ *
+ * Returns a region of the image's merged visible layers.
+ *
+ * This procedure renders the given region of the image's visible
+ * layers, merged, or flattened onto the context's background color,
+ * without creating a merged layer. The pixels are returned in the
+ * format returned by gimp_image_get_merged_format().
+ *
+ * Returns: (transfer full): The region data.
+ **/
+GBytes *
+_gimp_image_get_merged_region (GimpImage *image,
+                               gboolean   flatten,
+                               gint       x,
+                               gint       y,
+                               gint       width,
+                               gint       height)
+{
+  GimpValueArray *args;
+  GimpValueArray *return_vals;
+  GBytes *region_data = NULL;
+
+  args = gimp_value_array_new_from_types (NULL,
+                                          GIMP_TYPE_IMAGE, image,
+                                          G_TYPE_BOOLEAN, flatten,
+                                          G_TYPE_INT, x,
+                                          G_TYPE_INT, y,
+                                          G_TYPE_INT, width,
+                                          G_TYPE_INT, height,
+                                          G_TYPE_NONE);
+
+  return_vals = _gimp_pdb_run_procedure_array (gimp_get_pdb (),
+                                               "gimp-image-get-merged-region",
+                                               args);
+  gimp_value_array_unref (args);
+
+  if (GIMP_VALUES_GET_ENUM (return_vals, 0) == GIMP_PDB_SUCCESS)
+    region_data = GIMP_VALUES_DUP_BYTES (return_vals, 1);
+
+  gimp_value_array_unref (return_vals);
+
+  return region_data;
+}
+
 /**
  * gimp_image_get_selected_layers:
  * @image: The image.
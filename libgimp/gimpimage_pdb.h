@@ -140,6 +140,14 @@ G_GNUC_INTERNAL gboolean _gimp_image_thumbnail                 (GimpImage
                                                                 gint                 *actual_height,
                                                                 gint                 *bpp,
                                                                 GBytes              **thumbnail_data);
+G_GNUC_INTERNAL gchar*   _gimp_image_get_merged_format         (GimpImage            *image,
+                                                                gboolean              flatten);
+G_GNUC_INTERNAL GBytes*  _gimp_image_get_merged_region         (GimpImage            *image,
+                                                                gboolean              flatten,
+                                                                gint                  x,
+                                                                gint                  y,
+                                                                gint                  width,
+                                                                gint                  height);
 GimpLayer**              gimp_image_get_selected_layers        (GimpImage            *image);
 gboolean                 gimp_image_set_selected_layers        (GimpImage            *image,
                                                                 const GimpLayer     **layers);
@@ -60,15 +60,25 @@ struct _GimpTileBackendPluginPrivate
   gint     bpp;
   gint     ntile_rows;
   gint     ntile_cols;
+
+  /*  merged image mode: tiles are cut from whole bands of tile rows,
+   *  rendered by the core, and only the current band is kept
+   */
+  gint32   image_id;
+  gboolean flatten;
+  gint     band_row;
+  GBytes  *band;
 };
 
 
-static gpointer   gimp_tile_backend_plugin_command (GeglTileSource  *tile_store,
-                                                    GeglTileCommand  command,
-                                                    gint             x,
-                                                    gint             y,
-                                                    gint             z,
-                                                    gpointer         data);
+static void       gimp_tile_backend_plugin_finalize (GObject         *object);
+
+static gpointer   gimp_tile_backend_plugin_command  (GeglTileSource  *tile_store,
+                                                     GeglTileCommand  command,
+                                                     gint             x,
+                                                     gint             y,
+                                                     gint             z,
+                                                     gpointer         data);
 
 static gboolean   gimp_tile_write (GimpTileBackendPlugin *backend_plugin,
                                    gint                   x,
@@ -88,6 +98,10 @@ static void       gimp_tile_get   (GimpTileBackendPlugin *backend_plugin,
                                    GimpTile              *tile);
 static void       gimp_tile_put   (GimpTileBackendPlugin *backend_plugin,
                                    GimpTile              *tile);
+static void       gimp_tile_band  (GimpTileBackendPlugin *backend_plugin,
+                                   GimpTile              *tile,
+                                   gint                   row,
+                                   gint                   col);
 
 
 G_DEFINE_TYPE_WITH_PRIVATE (GimpTileBackendPlugin, _gimp_tile_backend_plugin,
@@ -102,6 +116,9 @@ static GMutex backend_plugin_mutex;
 static void
 _gimp_tile_backend_plugin_class_init (GimpTileBackendPluginClass *klass)
 {
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = gimp_tile_backend_plugin_finalize;
 }
 
 static void
@@ -111,9 +128,23 @@ _gimp_tile_backend_plugin_init (GimpTileBackendPlugin *backend)
 
   backend->priv = _gimp_tile_backend_plugin_get_instance_private (backend);
 
+  backend->priv->drawable_id = -1;
+  backend->priv->image_id    = -1;
+  backend->priv->band_row    = -1;
+
   source->command = gimp_tile_backend_plugin_command;
 }
 
+static void
+gimp_tile_backend_plugin_finalize (GObject *object)
+{
+  GimpTileBackendPlugin *backend_plugin = GIMP_TILE_BACKEND_PLUGIN (object);
+
+  g_clear_pointer (&backend_plugin->priv->band, g_bytes_unref);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
 static gpointer
 gimp_tile_backend_plugin_command (GeglTileSource  *tile_store,
                                   GeglTileCommand  command,
@@ -202,6 +233,82 @@ _gimp_tile_backend_plugin_new (GimpDrawable *drawable,
   return backend;
 }
 
+/*  Returns a read-only backend for the image's visible layers, merged,
+ *  or flattened, as gimp_image_merge_visible_layers() or
+ *  gimp_image_flatten() would create them, but without changing the
+ *  image.  Pixels are rendered by the core one band of tile rows at a
+ *  time, so reading the buffer row by row never needs more than one
+ *  band in memory.
+ */
+GeglTileBackend *
+_gimp_tile_backend_plugin_new_merged (GimpImage *image,
+                                      gboolean   flatten)
+{
+  GeglTileBackend       *backend;
+  GimpTileBackendPlugin *backend_plugin;
+  const Babl            *format = NULL;
+  const Babl            *space  = NULL;
+  GimpColorProfile      *profile;
+  gchar                 *format_str;
+  gint                   width  = gimp_image_get_width  (image);
+  gint                   height = gimp_image_get_height (image);
+
+  /* _gimp_image_get_merged_format() only returns the encoding, so we
+   * create the actual space from the image's profile, like
+   * gimp_drawable_get_format() does for layers
+   */
+  format_str = _gimp_image_get_merged_format (image, flatten);
+
+  if (! format_str)
+    return NULL;
+
+  profile = gimp_image_get_color_profile (image);
+
+  if (profile)
+    {
+      GError *error = NULL;
+
+      space = gimp_color_profile_get_space
+        (profile,
+         GIMP_COLOR_RENDERING_INTENT_RELATIVE_COLORIMETRIC,
+         &error);
+
+      if (! space)
+        {
+          g_printerr ("%s: failed to create Babl space from "
+                      "profile: %s\n",
+                      G_STRFUNC, error->message);
+          g_clear_error (&error);
+        }
+
+      g_object_unref (profile);
+    }
+
+  format = babl_format_with_space (format_str, space);
+  g_free (format_str);
+
+  backend = g_object_new (GIMP_TYPE_TILE_BACKEND_PLUGIN,
+                          "tile-width",  TILE_WIDTH,
+                          "tile-height", TILE_HEIGHT,
+                          "format",      format,
+                          NULL);
+
+  backend_plugin = GIMP_TILE_BACKEND_PLUGIN (backend);
+
+  backend_plugin->priv->image_id    = gimp_image_get_id (image);
+  backend_plugin->priv->flatten     = flatten;
+  backend_plugin->priv->width       = width;
+  backend_plugin->priv->height      = height;
+  backend_plugin->priv->bpp         = babl_format_get_bytes_per_pixel (format);
+  backend_plugin->priv->ntile_rows  = (height + TILE_HEIGHT - 1) / TILE_HEIGHT;
+  backend_plugin->priv->ntile_cols  = (width  + TILE_WIDTH  - 1) / TILE_WIDTH;
+
+  gegl_tile_backend_set_extent (backend,
+                                GEGL_RECTANGLE (0, 0, width, height));
+
+  return backend;
+}
+
 
 /*  private functions  */
 
@@ -224,7 +331,20 @@ gimp_tile_read (GimpTileBackendPlugin *backend_plugin,
   tile       = gegl_tile_new (tile_size);
   tile_data  = gegl_tile_get_data (tile);
 
-  gimp_tile_get (backend_plugin, &gimp_tile);
+  if (priv->image_id != -1)
+    gimp_tile_band (backend_plugin, &gimp_tile, y, x);
+  else
+    gimp_tile_get (backend_plugin, &gimp_tile);
+
+  if (! gimp_tile.data)
+    {
+      /*  the band could not be rendered, return a transparent tile
+       *  rather than garbage
+       */
+      memset (tile_data, 0, tile_size);
+
+      return tile;
+    }
 
   if (gimp_tile.ewidth * gimp_tile.eheight * priv->bpp == tile_size)
     {
@@ -261,6 +381,10 @@ gimp_tile_write (GimpTileBackendPlugin *backend_plugin,
   gint                          tile_size;
   guchar                       *tile_data;
 
+  /*  merged image backends are read-only  */
+  if (priv->image_id != -1)
+    return FALSE;
+
   if (! gimp_tile_init (backend_plugin, &gimp_tile, y, x))
     return FALSE;
 
@@ -455,3 +579,48 @@ gimp_tile_put (GimpTileBackendPlugin *backend_plugin,
 
   gimp_wire_destroy (&msg);
 }
+
+static void
+gimp_tile_band (GimpTileBackendPlugin *backend_plugin,
+                GimpTile              *tile,
+                gint                   row,
+                gint                   col)
+{
+  GimpTileBackendPluginPrivate *priv = backend_plugin->priv;
+  const guchar                 *band_data;
+  gsize                         band_size;
+  gint                          band_stride;
+  gint                          tile_stride;
+  guint                         y;
+
+  if (priv->band_row != row)
+    {
+      g_clear_pointer (&priv->band, g_bytes_unref);
+
+      priv->band_row = row;
+      priv->band     = _gimp_image_get_merged_region (gimp_image_get_by_id (priv->image_id),
+                                                      priv->flatten,
+                                                      0, row * TILE_HEIGHT,
+                                                      priv->width,
+                                                      tile->eheight);
+    }
+
+  if (! priv->band)
+    return;
+
+  band_data   = g_bytes_get_data (priv->band, &band_size);
+  band_stride = priv->width  * priv->bpp;
+  tile_stride = tile->ewidth * priv->bpp;
+
+  if (band_size != (gsize) band_stride * tile->eheight)
+    return;
+
+  tile->data = g_new (guchar, tile_stride * tile->eheight);
+
+  for (y = 0; y < tile->eheight; y++)
+    {
+      memcpy (tile->data + y * tile_stride,
+              band_data  + y * band_stride + col * TILE_WIDTH * priv->bpp,
+              tile_stride);
+    }
+}
@@ -50,10 +50,12 @@ struct _GimpTileBackendPluginClass
   GeglTileBackendClass parent_class;
 };
 
-GType             _gimp_tile_backend_plugin_get_type (void) G_GNUC_CONST;
+GType             _gimp_tile_backend_plugin_get_type   (void) G_GNUC_CONST;
 
-GeglTileBackend * _gimp_tile_backend_plugin_new      (GimpDrawable *drawable,
-                                                      gint          shadow);
+GeglTileBackend * _gimp_tile_backend_plugin_new        (GimpDrawable *drawable,
+                                                        gint          shadow);
+GeglTileBackend * _gimp_tile_backend_plugin_new_merged (GimpImage    *image,
+                                                        gboolean      flatten);
 
 G_END_DECLS
 
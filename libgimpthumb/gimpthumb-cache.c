@@ -0,0 +1,772 @@
+/* LIBGIMP - The GIMP Library
+ * Copyright (C) 1995-1997 Peter Mattis and Spencer Kimball
+ *
+ * gimpthumb-cache.c
+ *
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+/*  The packed thumbnail cache keeps a copy of the thumbnails of the
+ *  global repository in two files, so looking up many thumbnails
+ *  doesn't take one file open and one PNG decode each:
+ *
+ *  - the pack, to which the thumbnails are appended, each as the
+ *    image URI, MIME type and type description followed by the
+ *    zlib-compressed pixels;
+ *
+ *  - the index, a header followed by an array of entries sorted by
+ *    the MD5 of the URI and the thumbnail size, which is memory-mapped
+ *    and binary searched.
+ *
+ *  The index is replaced atomically on every change.  Blobs which are
+ *  no longer referenced are dropped by rewriting the pack once they
+ *  take more space than the live ones.  It is only a cache: whenever
+ *  something doesn't look right, both files are thrown away.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include <gio/gio.h>
+#include <glib/gstdio.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+#ifdef G_OS_WIN32
+#include "libgimpbase/gimpwin32-io.h"
+#endif
+
+#include "gimpthumb-types.h"
+#include "gimpthumb-cache.h"
+#include "gimpthumb-utils.h"
+
+
+#define CACHE_DIRNAME     "thumbnail-cache"
+#define CACHE_INDEX_NAME  "index"
+#define CACHE_PACK_NAME   "pack"
+
+#define CACHE_MAGIC       0x47545049  /* 'GTPI' */
+#define CACHE_VERSION     1
+
+/*  don't bother compacting the pack for less garbage than this  */
+#define COMPACT_MIN_DEAD  (4 << 20)
+
+
+typedef struct
+{
+  guint32  magic;
+  guint32  version;
+  guint64  n_entries;
+  guint64  pack_size;
+} CacheHeader;
+
+typedef struct
+{
+  guint8   key[16];
+  gint32   size;
+  gint32   width;
+  gint32   height;
+  gint32   n_channels;
+  gint64   image_mtime;
+  gint64   image_filesize;
+  gint32   image_width;
+  gint32   image_height;
+  gint32   image_num_layers;
+  guint32  strings_length;
+  guint64  offset;
+  guint64  length;
+} CacheEntry;
+
+
+static gchar            * cache_filename      (const gchar       *name);
+static void               cache_key           (const gchar       *uri,
+                                               guint8            *key);
+static gint               cache_entry_compare (const CacheEntry  *entry,
+                                               const guint8      *key,
+                                               gint               size);
+static const CacheEntry * cache_get_entries   (guint64           *n_entries,
+                                               guint64           *pack_size);
+static const guint8     * cache_get_pack      (gsize             *length);
+static void               cache_unmap         (void);
+static void               cache_reset         (void);
+static gboolean           cache_write_index   (const CacheEntry  *entries,
+                                               guint64            n_entries,
+                                               guint64            pack_size);
+static void               cache_maybe_compact (const CacheEntry  *entries,
+                                               guint64            n_entries,
+                                               guint64            pack_size);
+static GBytes           * cache_convert       (GConverter        *converter,
+                                               const guint8      *data,
+                                               gsize              length);
+
+
+static GMutex       cache_mutex;
+static gchar       *cache_dir  = NULL;
+static GMappedFile *index_map  = NULL;
+static GMappedFile *pack_map   = NULL;
+
+
+/*  Enables the cache in @basedir, or disables it if @basedir is NULL.  */
+void
+_gimp_thumb_cache_init (const gchar *basedir)
+{
+  g_mutex_lock (&cache_mutex);
+
+  cache_unmap ();
+  g_clear_pointer (&cache_dir, g_free);
+
+  if (basedir)
+    {
+      cache_dir = g_build_filename (basedir, CACHE_DIRNAME, NULL);
+
+      if (g_mkdir_with_parents (cache_dir, S_IRUSR | S_IWUSR | S_IXUSR) != 0)
+        g_clear_pointer (&cache_dir, g_free);
+    }
+
+  g_mutex_unlock (&cache_mutex);
+}
+
+void
+_gimp_thumb_cache_add (const gchar              *uri,
+                       const GimpThumbCacheInfo *info,
+                       GdkPixbuf                *pixbuf)
+{
+  const CacheEntry *entries;
+  CacheEntry       *new_entries;
+  CacheEntry        entry = { 0, };
+  GConverter       *compressor;
+  GBytes           *compressed;
+  GString          *strings;
+  guint8           *pixels;
+  const guint8     *src;
+  gint              rowstride;
+  gint              row_length;
+  guint64           n_entries;
+  guint64           pack_size;
+  guint64           i, j;
+  FILE             *pack;
+  gchar            *filename;
+  gboolean          inserted = FALSE;
+  gint              y;
+
+  if (! cache_dir                                          ||
+      gdk_pixbuf_get_colorspace (pixbuf) != GDK_COLORSPACE_RGB ||
+      gdk_pixbuf_get_bits_per_sample (pixbuf) != 8)
+    return;
+
+  cache_key (uri, entry.key);
+
+  entry.size             = info->size;
+  entry.width            = gdk_pixbuf_get_width (pixbuf);
+  entry.height           = gdk_pixbuf_get_height (pixbuf);
+  entry.n_channels       = gdk_pixbuf_get_n_channels (pixbuf);
+  entry.image_mtime      = info->image_mtime;
+  entry.image_filesize   = info->image_filesize;
+  entry.image_width      = info->image_width;
+  entry.image_height     = info->image_height;
+  entry.image_num_layers = info->image_num_layers;
+
+  /*  compress outside of the lock, the pixels without row padding  */
+  rowstride  = gdk_pixbuf_get_rowstride (pixbuf);
+  row_length = entry.width * entry.n_channels;
+  pixels     = g_malloc ((gsize) row_length * entry.height);
+  src        = gdk_pixbuf_read_pixels (pixbuf);
+
+  for (y = 0; y < entry.height; y++)
+    memcpy (pixels + (gsize) y * row_length, src + (gsize) y * rowstride,
+            row_length);
+
+  compressor = G_CONVERTER (g_zlib_compressor_new (G_ZLIB_COMPRESSOR_FORMAT_RAW,
+                                                   1));
+  compressed = cache_convert (compressor, pixels,
+                              (gsize) row_length * entry.height);
+  g_object_unref (compressor);
+  g_free (pixels);
+
+  if (! compressed)
+    return;
+
+  strings = g_string_new (uri);
+  g_string_append_c (strings, '\0');
+  g_string_append (strings, info->image_mimetype ? info->image_mimetype : "");
+  g_string_append_c (strings, '\0');
+  g_string_append (strings, info->image_type ? info->image_type : "");
+  g_string_append_c (strings, '\0');
+
+  entry.strings_length = strings->len;
+  entry.length         = strings->len + g_bytes_get_size (compressed);
+
+  g_mutex_lock (&cache_mutex);
+
+  if (! cache_dir)
+    goto out;
+
+  entries = cache_get_entries (&n_entries, &pack_size);
+
+  /*  the mapped pack is going to be stale  */
+  g_clear_pointer (&pack_map, g_mapped_file_unref);
+
+  filename = cache_filename (CACHE_PACK_NAME);
+  pack     = g_fopen (filename, "ab");
+  g_free (filename);
+
+  if (! pack)
+    goto out;
+
+  fseek (pack, 0, SEEK_END);
+  entry.offset = ftell (pack);
+
+  if (fwrite (strings->str, 1, strings->len, pack) != strings->len ||
+      fwrite (g_bytes_get_data (compressed, NULL), 1,
+              g_bytes_get_size (compressed), pack) !=
+      g_bytes_get_size (compressed))
+    {
+      fclose (pack);
+      goto out;
+    }
+
+  if (fclose (pack) != 0)
+    goto out;
+
+  pack_size = entry.offset + entry.length;
+
+  /*  merge the new entry into the sorted entries, it replaces an
+   *  existing one of the same URI and size
+   */
+  new_entries = g_new (CacheEntry, n_entries + 1);
+
+  for (i = 0, j = 0; i < n_entries; i++)
+    {
+      gint cmp = cache_entry_compare (&entries[i], entry.key, entry.size);
+
+      if (cmp == 0)
+        continue;
+
+      if (cmp > 0 && ! inserted)
+        {
+          new_entries[j++] = entry;
+          inserted         = TRUE;
+        }
+
+      new_entries[j++] = entries[i];
+    }
+
+  if (! inserted)
+    new_entries[j++] = entry;
+
+  if (cache_write_index (new_entries, j, pack_size))
+    cache_maybe_compact (new_entries, j, pack_size);
+
+  g_free (new_entries);
+
+ out:
+  g_mutex_unlock (&cache_mutex);
+
+  g_string_free (strings, TRUE);
+  g_bytes_unref (compressed);
+}
+
+/*  Returns the cached thumbnail for @uri closest to @size, in the same
+ *  order the spec's repository is searched, but only if it was created
+ *  for the image's current @image_mtime and @image_filesize.
+ */
+GdkPixbuf *
+_gimp_thumb_cache_lookup (const gchar        *uri,
+                          GimpThumbSize       size,
+                          gint64              image_mtime,
+                          gint64              image_filesize,
+                          GimpThumbCacheInfo *info)
+{
+  const CacheEntry *entries;
+  const CacheEntry *entry = NULL;
+  const guint8     *pack;
+  const gchar      *strings;
+  GConverter       *decompressor;
+  GBytes           *pixels;
+  GdkPixbuf        *pixbuf = NULL;
+  guint8            key[16];
+  guint64           n_entries;
+  guint64           lo, hi;
+  gsize             pack_length;
+  gsize             row_length;
+  gsize             uri_length;
+
+  if (! cache_dir)
+    return NULL;
+
+  cache_key (uri, key);
+  size = _gimp_thumb_size_round (size);
+
+  g_mutex_lock (&cache_mutex);
+
+  entries = cache_get_entries (&n_entries, NULL);
+
+  /*  the first entry for the URI  */
+  lo = 0;
+  hi = n_entries;
+
+  while (lo < hi)
+    {
+      guint64 mid = lo + (hi - lo) / 2;
+
+      if (cache_entry_compare (&entries[mid], key, 0) < 0)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+  /*  entries are sorted by size, pick the smallest one that is at
+   *  least @size, or else the largest one
+   */
+  for (; lo < n_entries && memcmp (entries[lo].key, key, 16) == 0; lo++)
+    {
+      entry = &entries[lo];
+
+      if (entry->size >= size)
+        break;
+    }
+
+  if (! entry                               ||
+      entry->image_mtime    != image_mtime  ||
+      entry->image_filesize != image_filesize)
+    goto out;
+
+  pack = cache_get_pack (&pack_length);
+
+  if (! pack                                    ||
+      entry->offset > pack_length               ||
+      entry->length > pack_length - entry->offset ||
+      entry->strings_length > entry->length)
+    goto out;
+
+  /*  make sure it's not an MD5 collision  */
+  strings    = (const gchar *) pack + entry->offset;
+  uri_length = strlen (uri) + 1;
+
+  if (entry->strings_length < uri_length ||
+      memcmp (strings, uri, uri_length) != 0)
+    goto out;
+
+  row_length = (gsize) entry->width * entry->n_channels;
+
+  decompressor = G_CONVERTER (g_zlib_decompressor_new (G_ZLIB_COMPRESSOR_FORMAT_RAW));
+  pixels = cache_convert (decompressor,
+                          pack + entry->offset + entry->strings_length,
+                          entry->length - entry->strings_length);
+  g_object_unref (decompressor);
+
+  if (! pixels)
+    goto out;
+
+  if (g_bytes_get_size (pixels) != row_length * entry->height)
+    {
+      g_bytes_unref (pixels);
+      goto out;
+    }
+
+  pixbuf = gdk_pixbuf_new_from_bytes (pixels,
+                                      GDK_COLORSPACE_RGB,
+                                      entry->n_channels == 4,
+                                      8,
+                                      entry->width,
+                                      entry->height,
+                                      row_length);
+  g_bytes_unref (pixels);
+
+  info->size             = entry->size;
+  info->image_mtime      = entry->image_mtime;
+  info->image_filesize   = entry->image_filesize;
+  info->image_width      = entry->image_width;
+  info->image_height     = entry->image_height;
+  info->image_num_layers = entry->image_num_layers;
+
+  strings += uri_length;
+  info->image_mimetype = *strings ? g_strdup (strings) : NULL;
+
+  strings += strlen (strings) + 1;
+  info->image_type = *strings ? g_strdup (strings) : NULL;
+
+ out:
+  g_mutex_unlock (&cache_mutex);
+
+  return pixbuf;
+}
+
+/*  Removes the cached thumbnails for @uri, except for @keep_size.  */
+void
+_gimp_thumb_cache_remove (const gchar   *uri,
+                          GimpThumbSize  keep_size)
+{
+  const CacheEntry *entries;
+  CacheEntry       *new_entries;
+  guint8            key[16];
+  guint64           n_entries;
+  guint64           pack_size;
+  guint64           i, j;
+
+  if (! cache_dir)
+    return;
+
+  cache_key (uri, key);
+
+  if (keep_size > GIMP_THUMB_SIZE_FAIL)
+    keep_size = _gimp_thumb_size_round (keep_size);
+
+  g_mutex_lock (&cache_mutex);
+
+  entries = cache_get_entries (&n_entries, &pack_size);
+
+  new_entries = g_new (CacheEntry, MAX (n_entries, 1));
+
+  for (i = 0, j = 0; i < n_entries; i++)
+    {
+      if (memcmp (entries[i].key, key, 16) == 0 &&
+          entries[i].size != keep_size)
+        continue;
+
+      new_entries[j++] = entries[i];
+    }
+
+  if (j != n_entries && cache_write_index (new_entries, j, pack_size))
+    cache_maybe_compact (new_entries, j, pack_size);
+
+  g_free (new_entries);
+
+  g_mutex_unlock (&cache_mutex);
+}
+
+void
+_gimp_thumb_cache_info_clear (GimpThumbCacheInfo *info)
+{
+  g_clear_pointer (&info->image_mimetype, g_free);
+  g_clear_pointer (&info->image_type,     g_free);
+}
+
+
+/*  private functions, called with the cache locked  */
+
+static gchar *
+cache_filename (const gchar *name)
+{
+  return g_build_filename (cache_dir, name, NULL);
+}
+
+static void
+cache_key (const gchar *uri,
+           guint8      *key)
+{
+  GChecksum *checksum;
+  gsize      len = 16;
+
+  checksum = g_checksum_new (G_CHECKSUM_MD5);
+  g_checksum_update (checksum, (const guchar *) uri, -1);
+  g_checksum_get_digest (checksum, key, &len);
+  g_checksum_free (checksum);
+}
+
+static gint
+cache_entry_compare (const CacheEntry *entry,
+                     const guint8     *key,
+                     gint              size)
+{
+  gint cmp = memcmp (entry->key, key, 16);
+
+  if (cmp)
+    return cmp;
+
+  return (entry->size > size) - (entry->size < size);
+}
+
+static const CacheEntry *
+cache_get_entries (guint64 *n_entries,
+                   guint64 *pack_size)
+{
+  const CacheHeader *header;
+  gsize              length;
+
+  *n_entries = 0;
+
+  if (pack_size)
+    *pack_size = 0;
+
+  if (! index_map)
+    {
+      gchar  *filename = cache_filename (CACHE_INDEX_NAME);
+      GError *error    = NULL;
+
+      index_map = g_mapped_file_new (filename, FALSE, &error);
+      g_free (filename);
+
+      if (! index_map)
+        {
+          /*  no cache yet  */
+          if (! g_error_matches (error, G_FILE_ERROR, G_FILE_ERROR_NOENT))
+            cache_reset ();
+
+          g_clear_error (&error);
+
+          return NULL;
+        }
+
+      header = (const CacheHeader *) g_mapped_file_get_contents (index_map);
+      length = g_mapped_file_get_length (index_map);
+
+      if (length < sizeof (CacheHeader)                                   ||
+          header->magic   != CACHE_MAGIC                                  ||
+          header->version != CACHE_VERSION                                ||
+          header->n_entries > (length - sizeof (CacheHeader)) / sizeof (CacheEntry) ||
+          length != sizeof (CacheHeader) + header->n_entries * sizeof (CacheEntry))
+        {
+          cache_reset ();
+
+          return NULL;
+        }
+      else
+        {
+          gchar   *filename = cache_filename (CACHE_PACK_NAME);
+          gint64   size     = 0;
+
+          gimp_thumb_file_test (filename, NULL, &size, NULL);
+          g_free (filename);
+
+          /*  a shorter pack than the index knows about, someone messed
+           *  with it, or compacting it got interrupted
+           */
+          if (size < header->pack_size)
+            {
+              cache_reset ();
+
+              return NULL;
+            }
+        }
+    }
+
+  header = (const CacheHeader *) g_mapped_file_get_contents (index_map);
+
+  *n_entries = header->n_entries;
+
+  if (pack_size)
+    *pack_size = header->pack_size;
+
+  return (const CacheEntry *) (header + 1);
+}
+
+static const guint8 *
+cache_get_pack (gsize *length)
+{
+  if (! pack_map)
+    {
+      gchar *filename = cache_filename (CACHE_PACK_NAME);
+
+      pack_map = g_mapped_file_new (filename, FALSE, NULL);
+      g_free (filename);
+
+      if (! pack_map)
+        return NULL;
+    }
+
+  *length = g_mapped_file_get_length (pack_map);
+
+  return (const guint8 *) g_mapped_file_get_contents (pack_map);
+}
+
+static void
+cache_unmap (void)
+{
+  g_clear_pointer (&index_map, g_mapped_file_unref);
+  g_clear_pointer (&pack_map,  g_mapped_file_unref);
+}
+
+static void
+cache_reset (void)
+{
+  gchar *filename;
+
+  cache_unmap ();
+
+  filename = cache_filename (CACHE_INDEX_NAME);
+  g_unlink (filename);
+  g_free (filename);
+
+  filename = cache_filename (CACHE_PACK_NAME);
+  g_unlink (filename);
+  g_free (filename);
+}
+
+static gboolean
+cache_write_index (const CacheEntry *entries,
+                   guint64           n_entries,
+                   guint64           pack_size)
+{
+  CacheHeader  header;
+  GByteArray  *data;
+  gchar       *filename;
+  gboolean     success;
+
+  header.magic     = CACHE_MAGIC;
+  header.version   = CACHE_VERSION;
+  header.n_entries = n_entries;
+  header.pack_size = pack_size;
+
+  data = g_byte_array_sized_new (sizeof (CacheHeader) +
+                                 n_entries * sizeof (CacheEntry));
+
+  g_byte_array_append (data, (const guint8 *) &header, sizeof (CacheHeader));
+  g_byte_array_append (data, (const guint8 *) entries,
+                       n_entries * sizeof (CacheEntry));
+
+  /*  @entries may point into the old index, which we can only unmap
+   *  after copying it.  Windows can't replace a mapped file.
+   */
+  g_clear_pointer (&index_map, g_mapped_file_unref);
+
+  filename = cache_filename (CACHE_INDEX_NAME);
+  success  = g_file_set_contents (filename,
+                                  (const gchar *) data->data, data->len,
+                                  NULL);
+  g_free (filename);
+
+  g_byte_array_free (data, TRUE);
+
+  if (! success)
+    cache_reset ();
+
+  return success;
+}
+
+static void
+cache_maybe_compact (const CacheEntry *entries,
+                     guint64           n_entries,
+                     guint64           pack_size)
+{
+  CacheEntry   *new_entries;
+  const guint8 *pack;
+  gsize         pack_length;
+  guint64       live = 0;
+  guint64       offset;
+  guint64       i;
+  gchar        *filename;
+  gchar        *tmpname;
+  FILE         *tmp;
+
+  for (i = 0; i < n_entries; i++)
+    live += entries[i].length;
+
+  if (live > pack_size)
+    return;
+
+  if (pack_size - live < COMPACT_MIN_DEAD || pack_size - live < live)
+    return;
+
+  pack = cache_get_pack (&pack_length);
+
+  if (! pack || pack_length < pack_size)
+    {
+      cache_reset ();
+      return;
+    }
+
+  filename = cache_filename (CACHE_PACK_NAME);
+  tmpname  = g_strconcat (filename, ".tmp", NULL);
+
+  tmp = g_fopen (tmpname, "wb");
+
+  if (! tmp)
+    goto out;
+
+  new_entries = g_new (CacheEntry, MAX (n_entries, 1));
+  offset      = 0;
+
+  for (i = 0; i < n_entries; i++)
+    {
+      new_entries[i]        = entries[i];
+      new_entries[i].offset = offset;
+
+      if (fwrite (pack + entries[i].offset, 1, entries[i].length, tmp) !=
+          entries[i].length)
+        break;
+
+      offset += entries[i].length;
+    }
+
+  if (fclose (tmp) != 0 || i < n_entries)
+    {
+      g_unlink (tmpname);
+    }
+  else
+    {
+      g_clear_pointer (&pack_map, g_mapped_file_unref);
+
+      /*  if we are interrupted between the two, the old index refers
+       *  to more of the pack than there is, and the cache is reset
+       */
+      if (g_rename (tmpname, filename) != 0)
+        {
+          g_unlink (tmpname);
+        }
+      else
+        {
+          cache_write_index (new_entries, n_entries, offset);
+        }
+    }
+
+  g_free (new_entries);
+
+ out:
+  g_free (tmpname);
+  g_free (filename);
+}
+
+static GBytes *
+cache_convert (GConverter   *converter,
+               const guint8 *data,
+               gsize         length)
+{
+  GByteArray *output = g_byte_array_new ();
+  guint8      buffer[16384];
+
+  while (TRUE)
+    {
+      GConverterResult result;
+      gsize            bytes_read;
+      gsize            bytes_written;
+
+      result = g_converter_convert (converter,
+                                    data, length,
+                                    buffer, sizeof (buffer),
+                                    G_CONVERTER_INPUT_AT_END,
+                                    &bytes_read, &bytes_written,
+                                    NULL);
+
+      if (result == G_CONVERTER_ERROR)
+        {
+          g_byte_array_free (output, TRUE);
+
+          return NULL;
+        }
+
+      data   += bytes_read;
+      length -= bytes_read;
+
+      g_byte_array_append (output, buffer, bytes_written);
+
+      if (result == G_CONVERTER_FINISHED)
+        break;
+    }
+
+  return g_byte_array_free_to_bytes (output);
+}
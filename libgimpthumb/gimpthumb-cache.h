@@ -0,0 +1,65 @@
+/* LIBGIMP - The GIMP Library
+ * Copyright (C) 1995-1997 Peter Mattis and Spencer Kimball
+ *
+ * gimpthumb-cache.h
+ *
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#if !defined (GIMP_THUMB_COMPILATION)
+#error "gimpthumb-cache.h is private to libgimpthumb."
+#endif
+
+#ifndef __GIMP_THUMB_CACHE_H__
+#define __GIMP_THUMB_CACHE_H__
+
+G_BEGIN_DECLS
+
+
+/*  everything the packed cache stores about a thumbnail, besides
+ *  its pixels
+ */
+typedef struct
+{
+  GimpThumbSize  size;
+  gint64         image_mtime;
+  gint64         image_filesize;
+  gchar         *image_mimetype;
+  gint           image_width;
+  gint           image_height;
+  gchar         *image_type;
+  gint           image_num_layers;
+} GimpThumbCacheInfo;
+
+
+G_GNUC_INTERNAL void        _gimp_thumb_cache_init       (const gchar              *basedir);
+
+G_GNUC_INTERNAL void        _gimp_thumb_cache_add        (const gchar              *uri,
+                                                          const GimpThumbCacheInfo *info,
+                                                          GdkPixbuf                *pixbuf);
+G_GNUC_INTERNAL GdkPixbuf * _gimp_thumb_cache_lookup     (const gchar              *uri,
+                                                          GimpThumbSize             size,
+                                                          gint64                    image_mtime,
+                                                          gint64                    image_filesize,
+                                                          GimpThumbCacheInfo       *info);
+G_GNUC_INTERNAL void        _gimp_thumb_cache_remove     (const gchar              *uri,
+                                                          GimpThumbSize             keep_size);
+
+G_GNUC_INTERNAL void        _gimp_thumb_cache_info_clear (GimpThumbCacheInfo       *info);
+
+
+G_END_DECLS
+
+#endif /* __GIMP_THUMB_CACHE_H__ */
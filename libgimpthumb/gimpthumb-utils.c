@@ -34,6 +34,7 @@
 
 #include <gio/gio.h>
 #include <glib/gstdio.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
 
 #ifdef G_OS_WIN32
 #include "libgimpbase/gimpwin32-io.h"
@@ -41,6 +42,7 @@
 
 #include "gimpthumb-error.h"
 #include "gimpthumb-types.h"
+#include "gimpthumb-cache.h"
 #include "gimpthumb-utils.h"
 
 #include "libgimp/libgimp-intl.h"
@@ -186,6 +188,41 @@ gimp_thumb_init (const gchar *creator,
   return gimp_thumb_initialized;
 }
 
+/**
+ * gimp_thumb_use_cache:
+ * @use_cache: whether to use the packed thumbnail cache
+ *
+ * Enables or disables a cache of the thumbnails in the user's
+ * thumbnail repository, which keeps all of them in one memory-mapped
+ * index and one pack file.  The cache is private to GIMP and kept in
+ * the "gimp" folder of the user's cache directory, not in the shared
+ * thumbnail repository.  With the cache enabled,
+ * gimp_thumbnail_load_thumb() doesn't need to open and decode a PNG
+ * file for every thumbnail that is still valid.
+ *
+ * The thumbnails are still saved as PNG files as defined in the
+ * spec, so other applications can use them.
+ *
+ * The cache is disabled by default, and again each time
+ * gimp_thumb_init() is called.
+ *
+ * Since: 3.2
+ **/
+void
+gimp_thumb_use_cache (gboolean use_cache)
+{
+  gchar *cache_dir = NULL;
+
+  g_return_if_fail (gimp_thumb_initialized);
+
+  if (use_cache)
+    cache_dir = g_build_filename (g_get_user_cache_dir (), "gimp", NULL);
+
+  _gimp_thumb_cache_init (cache_dir);
+
+  g_free (cache_dir);
+}
+
 /**
  * gimp_thumb_get_thumb_base_dir:
  *
@@ -608,6 +645,8 @@ gimp_thumbs_delete_for_uri (const gchar *uri)
   g_return_if_fail (gimp_thumb_initialized);
   g_return_if_fail (uri != NULL);
 
+  _gimp_thumb_cache_remove (uri, GIMP_THUMB_SIZE_FAIL);
+
   for (i = 0; i < thumb_num_sizes; i++)
     {
       gchar *filename = gimp_thumb_name_from_uri (uri, thumb_sizes[i]);
@@ -658,6 +697,8 @@ _gimp_thumbs_delete_others (const gchar   *uri,
   g_return_if_fail (gimp_thumb_initialized);
   g_return_if_fail (uri != NULL);
 
+  _gimp_thumb_cache_remove (uri, size);
+
   size = gimp_thumb_size (size);
 
   for (i = 0; i < thumb_num_sizes; i++)
@@ -711,11 +752,21 @@ _gimp_thumb_filename_from_uri (const gchar *uri)
   return filename;
 }
 
+GimpThumbSize
+_gimp_thumb_size_round (GimpThumbSize size)
+{
+  g_return_val_if_fail (gimp_thumb_initialized, size);
+
+  return thumb_sizes[gimp_thumb_size (size)];
+}
+
 static void
 gimp_thumb_exit (void)
 {
   gint i;
 
+  _gimp_thumb_cache_init (NULL);
+
   g_free (thumb_dir);
   g_free (thumb_sizes);
   g_free (thumb_sizenames);
@@ -37,6 +37,8 @@ gboolean            gimp_thumb_init                   (const gchar    *creator,
 
 const gchar       * gimp_thumb_get_thumb_base_dir     (void);
 
+void                gimp_thumb_use_cache              (gboolean        use_cache);
+
 gchar             * gimp_thumb_find_thumb             (const gchar    *uri,
                                                        GimpThumbSize  *size) G_GNUC_MALLOC;
 
@@ -66,6 +68,8 @@ void                gimp_thumbs_delete_for_uri_local  (const gchar    *uri);
 G_GNUC_INTERNAL void    _gimp_thumbs_delete_others    (const gchar    *uri,
                                                        GimpThumbSize   size);
 G_GNUC_INTERNAL gchar * _gimp_thumb_filename_from_uri (const gchar    *uri);
+G_GNUC_INTERNAL GimpThumbSize
+                        _gimp_thumb_size_round        (GimpThumbSize   size);
 
 
 G_END_DECLS
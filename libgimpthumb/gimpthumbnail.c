@@ -44,6 +44,7 @@
 #endif
 
 #include "gimpthumb-types.h"
+#include "gimpthumb-cache.h"
 #include "gimpthumb-error.h"
 #include "gimpthumb-utils.h"
 #include "gimpthumbnail.h"
@@ -147,6 +148,8 @@ static gboolean  gimp_thumbnail_save         (GimpThumbnail  *thumbnail,
                                               GdkPixbuf      *pixbuf,
                                               const gchar    *software,
                                               GError        **error);
+static GdkPixbuf * gimp_thumbnail_load_cached (GimpThumbnail *thumbnail,
+                                               GimpThumbSize  size);
 #ifdef GIMP_THUMB_DEBUG
 static void      gimp_thumbnail_debug_notify (GObject        *object,
                                               GParamSpec     *pspec);
@@ -954,6 +957,71 @@ gimp_thumbnail_save (GimpThumbnail  *thumbnail,
   return success;
 }
 
+/*  Looks @thumbnail up in the packed cache, and sets the thumbnail
+ *  state and image info as if the thumbnail PNG had been loaded and
+ *  found to be up to date.
+ */
+static GdkPixbuf *
+gimp_thumbnail_load_cached (GimpThumbnail *thumbnail,
+                            GimpThumbSize  size)
+{
+  GimpThumbCacheInfo  info = { 0, };
+  GdkPixbuf          *pixbuf;
+
+  if (size <= GIMP_THUMB_SIZE_FAIL)
+    return NULL;
+
+  g_object_freeze_notify (G_OBJECT (thumbnail));
+
+  gimp_thumbnail_update_image (thumbnail);
+
+  if (thumbnail->image_state != GIMP_THUMB_STATE_EXISTS)
+    {
+      g_object_thaw_notify (G_OBJECT (thumbnail));
+      return NULL;
+    }
+
+  pixbuf = _gimp_thumb_cache_lookup (thumbnail->image_uri, size,
+                                     thumbnail->image_mtime,
+                                     thumbnail->image_filesize,
+                                     &info);
+
+  if (pixbuf)
+    {
+#ifdef GIMP_THUMB_DEBUG
+      g_printerr ("thumbnail loaded from cache for %s\n",
+                  thumbnail->image_uri);
+#endif
+
+      /*  the state update_thumb() would find for the exported PNG  */
+      g_free (thumbnail->thumb_filename);
+      thumbnail->thumb_filename = gimp_thumb_name_from_uri (thumbnail->image_uri,
+                                                            info.size);
+      thumbnail->thumb_size     = info.size;
+      thumbnail->thumb_filesize = 0;
+      thumbnail->thumb_mtime    = 0;
+
+      gimp_thumbnail_reset_info (thumbnail);
+
+      g_free (thumbnail->image_mimetype);
+      thumbnail->image_mimetype   = g_steal_pointer (&info.image_mimetype);
+      thumbnail->image_width      = info.image_width;
+      thumbnail->image_height     = info.image_height;
+      thumbnail->image_type       = g_steal_pointer (&info.image_type);
+      thumbnail->image_num_layers = info.image_num_layers;
+
+      g_object_set (thumbnail,
+                    "thumb-state", GIMP_THUMB_STATE_OK,
+                    NULL);
+    }
+
+  _gimp_thumb_cache_info_clear (&info);
+
+  g_object_thaw_notify (G_OBJECT (thumbnail));
+
+  return pixbuf;
+}
+
 #ifdef GIMP_THUMB_DEBUG
 static void
 gimp_thumbnail_debug_notify (GObject    *object,
@@ -1034,6 +1102,10 @@ gimp_thumbnail_load_thumb (GimpThumbnail  *thumbnail,
   if (! thumbnail->image_uri)
     return NULL;
 
+  pixbuf = gimp_thumbnail_load_cached (thumbnail, size);
+  if (pixbuf)
+    return pixbuf;
+
   state = gimp_thumbnail_peek_thumb (thumbnail, size);
 
   if (state < GIMP_THUMB_STATE_EXISTS || state == GIMP_THUMB_STATE_FAILED)
@@ -1165,6 +1237,22 @@ gimp_thumbnail_save_thumb (GimpThumbnail  *thumbnail,
                                  error);
   g_free (name);
 
+  if (success)
+    {
+      GimpThumbCacheInfo info;
+
+      info.size             = _gimp_thumb_size_round (size);
+      info.image_mtime      = thumbnail->image_mtime;
+      info.image_filesize   = thumbnail->image_filesize;
+      info.image_mimetype   = thumbnail->image_mimetype;
+      info.image_width      = thumbnail->image_width;
+      info.image_height     = thumbnail->image_height;
+      info.image_type       = thumbnail->image_type;
+      info.image_num_layers = thumbnail->image_num_layers;
+
+      _gimp_thumb_cache_add (thumbnail->image_uri, &info, pixbuf);
+    }
+
   return success;
 }
 
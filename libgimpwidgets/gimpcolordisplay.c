@@ -145,10 +145,13 @@ gimp_color_display_class_init (GimpColorDisplayClass *klass)
   klass->help_id         = NULL;
   klass->icon_name       = GIMP_ICON_DISPLAY_FILTER;
 
-  klass->convert_buffer  = NULL;
-  klass->configure       = NULL;
+  klass->convert_buffer   = NULL;
+  klass->configure        = NULL;
 
-  klass->changed         = NULL;
+  klass->changed          = NULL;
+
+  klass->get_curve_format = NULL;
+  klass->map_curve_value  = NULL;
 }
 
 static void
@@ -334,6 +337,66 @@ gimp_color_display_convert_buffer (GimpColorDisplay *display,
     }
 }
 
+/**
+ * gimp_color_display_get_curve_format:
+ * @display: a #GimpColorDisplay
+ *
+ * Returns the format in which @display is a pure per-channel curve,
+ * if it is one with its current settings: the red, green and blue
+ * components of each pixel in this format are mapped independently,
+ * and in the same way, by gimp_color_display_map_curve_value(), and
+ * alpha is left alone.
+ *
+ * Such displays can be folded into a lookup table, instead of calling
+ * gimp_color_display_convert_buffer() on every pixel.
+ *
+ * Returns: (nullable) (transfer none): an RGBA float format, or %NULL
+ *          if @display is not a per-channel curve.
+ *
+ * Since: 3.2
+ **/
+const Babl *
+gimp_color_display_get_curve_format (GimpColorDisplay *display)
+{
+  GimpColorDisplayClass *klass;
+
+  g_return_val_if_fail (GIMP_IS_COLOR_DISPLAY (display), NULL);
+
+  klass = GIMP_COLOR_DISPLAY_GET_CLASS (display);
+
+  if (klass->get_curve_format && klass->map_curve_value)
+    return klass->get_curve_format (display);
+
+  return NULL;
+}
+
+/**
+ * gimp_color_display_map_curve_value:
+ * @display: a #GimpColorDisplay
+ * @value:   a component value
+ *
+ * Maps a single color component through @display, which must be a
+ * per-channel curve, see gimp_color_display_get_curve_format().
+ *
+ * Returns: the mapped value.
+ *
+ * Since: 3.2
+ **/
+gfloat
+gimp_color_display_map_curve_value (GimpColorDisplay *display,
+                                    gfloat            value)
+{
+  GimpColorDisplayClass *klass;
+
+  g_return_val_if_fail (GIMP_IS_COLOR_DISPLAY (display), value);
+
+  klass = GIMP_COLOR_DISPLAY_GET_CLASS (display);
+
+  g_return_val_if_fail (klass->map_curve_value != NULL, value);
+
+  return klass->map_curve_value (display, value);
+}
+
 /**
  * gimp_color_display_load_state:
  * @display: a #GimpColorDisplay
@@ -52,9 +52,12 @@ struct _GimpColorDisplayClass
   /*  signals  */
   void        (* changed)        (GimpColorDisplay *display);
 
+  /*  virtual functions  */
+  const Babl * (* get_curve_format) (GimpColorDisplay *display);
+  gfloat       (* map_curve_value)  (GimpColorDisplay *display,
+                                     gfloat            value);
+
   /* Padding for future expansion */
-  void (* _gimp_reserved0) (void);
-  void (* _gimp_reserved1) (void);
   void (* _gimp_reserved2) (void);
   void (* _gimp_reserved3) (void);
   void (* _gimp_reserved4) (void);
@@ -71,6 +74,9 @@ GimpColorDisplay * gimp_color_display_clone           (GimpColorDisplay *display
 void               gimp_color_display_convert_buffer  (GimpColorDisplay *display,
                                                        GeglBuffer       *buffer,
                                                        GeglRectangle    *area);
+const Babl       * gimp_color_display_get_curve_format (GimpColorDisplay *display);
+gfloat             gimp_color_display_map_curve_value  (GimpColorDisplay *display,
+                                                        gfloat            value);
 void               gimp_color_display_load_state      (GimpColorDisplay *display,
                                                        GimpParasite     *state);
 GimpParasite     * gimp_color_display_save_state      (GimpColorDisplay *display);
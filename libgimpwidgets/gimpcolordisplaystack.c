@@ -43,6 +43,14 @@
  **/
 
 
+/*  curves are read from a lookup table in [CURVE_LUT_MIN, 1], and
+ *  computed exactly elsewhere, which includes the steep start of
+ *  gamma curves
+ */
+#define CURVE_LUT_SIZE 4096
+#define CURVE_LUT_MIN  (1.0f / 64.0f)
+
+
 enum
 {
   CHANGED,
@@ -53,11 +61,23 @@ enum
 };
 
 
+typedef struct
+{
+  GimpColorDisplay *display; /* a filter which is not a curve, or NULL */
+
+  const Babl       *format;  /* otherwise, consecutive curves in the   */
+  GList            *curves;  /* same format, folded into one table     */
+  gfloat           *lut;
+} ConvertStep;
+
+
 struct _GimpColorDisplayStack
 {
   GObject  parent;
 
   GList   *filters;
+
+  GList   *steps;
 };
 
 
@@ -71,6 +91,12 @@ static void   gimp_color_display_stack_display_enabled (GimpColorDisplay      *d
 static void   gimp_color_display_stack_disconnect      (GimpColorDisplayStack *stack,
                                                         GimpColorDisplay      *display);
 
+static void   gimp_color_display_stack_update_steps    (GimpColorDisplayStack *stack);
+static void   gimp_color_display_stack_clear_steps     (GimpColorDisplayStack *stack);
+static void   gimp_color_display_stack_apply_curve     (ConvertStep           *step,
+                                                        GeglBuffer            *buffer,
+                                                        GeglRectangle         *area);
+
 
 G_DEFINE_TYPE (GimpColorDisplayStack, gimp_color_display_stack, G_TYPE_OBJECT)
 
@@ -152,6 +178,8 @@ gimp_color_display_stack_dispose (GObject *object)
       stack->filters = NULL;
     }
 
+  gimp_color_display_stack_clear_steps (stack);
+
   G_OBJECT_CLASS (parent_class)->dispose (object);
 }
 
@@ -220,6 +248,8 @@ gimp_color_display_stack_changed (GimpColorDisplayStack *stack)
 {
   g_return_if_fail (GIMP_IS_COLOR_DISPLAY_STACK (stack));
 
+  gimp_color_display_stack_clear_steps (stack);
+
   g_signal_emit (stack, stack_signals[CHANGED], 0);
 }
 
@@ -380,6 +410,10 @@ gimp_color_display_stack_reorder_down (GimpColorDisplayStack *stack,
  *
  * Runs all the stack's filters on all pixels in @area of @buffer.
  *
+ * Consecutive filters which are per-channel curves, see
+ * gimp_color_display_get_curve_format(), are applied together
+ * through a single lookup table.
+ *
  * Since: 2.10
  **/
 void
@@ -392,11 +426,17 @@ gimp_color_display_stack_convert_buffer (GimpColorDisplayStack *stack,
   g_return_if_fail (GIMP_IS_COLOR_DISPLAY_STACK (stack));
   g_return_if_fail (GEGL_IS_BUFFER (buffer));
 
-  for (list = stack->filters; list; list = g_list_next (list))
+  if (! stack->steps)
+    gimp_color_display_stack_update_steps (stack);
+
+  for (list = stack->steps; list; list = g_list_next (list))
     {
-      GimpColorDisplay *display = list->data;
+      ConvertStep *step = list->data;
 
-      gimp_color_display_convert_buffer (display, buffer, area);
+      if (step->display)
+        gimp_color_display_convert_buffer (step->display, buffer, area);
+      else
+        gimp_color_display_stack_apply_curve (step, buffer, area);
     }
 }
 
@@ -430,3 +470,149 @@ gimp_color_display_stack_disconnect (GimpColorDisplayStack *stack,
                                         gimp_color_display_stack_display_enabled,
                                         stack);
 }
+
+static gfloat
+gimp_color_display_stack_map_curves (ConvertStep *step,
+                                     gfloat       value)
+{
+  GList *list;
+
+  for (list = step->curves; list; list = g_list_next (list))
+    value = gimp_color_display_map_curve_value (list->data, value);
+
+  return value;
+}
+
+static void
+gimp_color_display_stack_update_steps (GimpColorDisplayStack *stack)
+{
+  ConvertStep *curve_step = NULL;
+  GList       *list;
+
+  gimp_color_display_stack_clear_steps (stack);
+
+  for (list = stack->filters; list; list = g_list_next (list))
+    {
+      GimpColorDisplay *display = list->data;
+      const Babl       *format;
+
+      if (! gimp_color_display_get_enabled (display))
+        continue;
+
+      format = gimp_color_display_get_curve_format (display);
+
+      if (format)
+        {
+          if (! curve_step || curve_step->format != format)
+            {
+              curve_step = g_slice_new0 (ConvertStep);
+
+              curve_step->format = format;
+
+              stack->steps = g_list_prepend (stack->steps, curve_step);
+            }
+
+          curve_step->curves = g_list_append (curve_step->curves, display);
+        }
+      else
+        {
+          ConvertStep *step = g_slice_new0 (ConvertStep);
+
+          step->display = display;
+
+          stack->steps = g_list_prepend (stack->steps, step);
+
+          curve_step = NULL;
+        }
+    }
+
+  stack->steps = g_list_reverse (stack->steps);
+
+  for (list = stack->steps; list; list = g_list_next (list))
+    {
+      ConvertStep *step = list->data;
+      gint         i;
+
+      if (step->display)
+        continue;
+
+      step->lut = g_new (gfloat, CURVE_LUT_SIZE + 1);
+
+      for (i = 0; i <= CURVE_LUT_SIZE; i++)
+        {
+          step->lut[i] =
+            gimp_color_display_stack_map_curves (step,
+                                                 (gfloat) i / CURVE_LUT_SIZE);
+        }
+    }
+}
+
+static void
+gimp_color_display_stack_clear_steps (GimpColorDisplayStack *stack)
+{
+  GList *list;
+
+  for (list = stack->steps; list; list = g_list_next (list))
+    {
+      ConvertStep *step = list->data;
+
+      g_list_free (step->curves);
+      g_free (step->lut);
+
+      g_slice_free (ConvertStep, step);
+    }
+
+  g_clear_pointer (&stack->steps, g_list_free);
+}
+
+static void
+gimp_color_display_stack_apply_curve (ConvertStep   *step,
+                                      GeglBuffer    *buffer,
+                                      GeglRectangle *area)
+{
+  GeglBufferIterator *iter;
+  const gfloat       *lut = step->lut;
+
+  iter = gegl_buffer_iterator_new (buffer, area, 0, step->format,
+                                   GEGL_ACCESS_READWRITE, GEGL_ABYSS_NONE, 1);
+
+  while (gegl_buffer_iterator_next (iter))
+    {
+      gfloat *data  = iter->items[0].data;
+      gint    count = iter->length;
+
+      while (count--)
+        {
+          gint c;
+
+          for (c = 0; c < 3; c++)
+            {
+              gfloat value = data[c];
+
+              /*  also false for nan  */
+              if (value >= CURVE_LUT_MIN && value <= 1.0f)
+                {
+                  gfloat f = value * CURVE_LUT_SIZE;
+                  gint   i = (gint) f;
+
+                  if (i < CURVE_LUT_SIZE)
+                    {
+                      f -= i;
+
+                      data[c] = lut[i] + f * (lut[i + 1] - lut[i]);
+                    }
+                  else
+                    {
+                      data[c] = lut[CURVE_LUT_SIZE];
+                    }
+                }
+              else
+                {
+                  data[c] = gimp_color_display_stack_map_curves (step, value);
+                }
+            }
+
+          data += 4;
+        }
+    }
+}
@@ -20,6 +20,7 @@
 #include <gegl.h>
 #include <gtk/gtk.h>
 
+#include "libgimpbase/gimpbase.h"
 #include "libgimpcolor/gimpcolor.h"
 #include "libgimpconfig/gimpconfig.h"
 #include "libgimpmath/gimpmath.h"
@@ -28,6 +29,8 @@
 
 #include "libgimp/libgimp-intl.h"
 
+#include "display-filter-simd.h"
+
 #define DEFAULT_EXPOSURE 0.0
 
 #define CDISPLAY_TYPE_ACES_RRT            (cdisplay_aces_rrt_get_type ())
@@ -60,22 +63,25 @@ enum
 };
 
 
-GType              cdisplay_aces_rrt_get_type        (void);
+GType              cdisplay_aces_rrt_get_type         (void);
 
-static void        cdisplay_aces_rrt_set_property    (GObject            *object,
-                                                      guint               property_id,
-                                                      const GValue       *value,
-                                                      GParamSpec         *pspec);
-static void        cdisplay_aces_rrt_get_property    (GObject            *object,
-                                                      guint               property_id,
-                                                      GValue             *value,
-                                                      GParamSpec         *pspec);
+static void        cdisplay_aces_rrt_set_property     (GObject            *object,
+                                                       guint               property_id,
+                                                       const GValue       *value,
+                                                       GParamSpec         *pspec);
+static void        cdisplay_aces_rrt_get_property     (GObject            *object,
+                                                       guint               property_id,
+                                                       GValue             *value,
+                                                       GParamSpec         *pspec);
 
-static void        cdisplay_aces_rrt_convert_buffer  (GimpColorDisplay   *display,
-                                                      GeglBuffer         *buffer,
-                                                      GeglRectangle      *area);
-static void        cdisplay_aces_rrt_set_exposure    (CdisplayAcesRRT      *aces_rrt,
-                                                      gdouble             value);
+static void        cdisplay_aces_rrt_convert_buffer   (GimpColorDisplay   *display,
+                                                       GeglBuffer         *buffer,
+                                                       GeglRectangle      *area);
+static const Babl *cdisplay_aces_rrt_get_curve_format (GimpColorDisplay   *display);
+static gfloat      cdisplay_aces_rrt_map_curve_value  (GimpColorDisplay   *display,
+                                                       gfloat              value);
+static void        cdisplay_aces_rrt_set_exposure     (CdisplayAcesRRT    *aces_rrt,
+                                                       gdouble             value);
 
 
 static const GimpModuleInfo cdisplay_aces_rrt_info =
@@ -127,7 +133,9 @@ cdisplay_aces_rrt_class_init (CdisplayAcesRRTClass *klass)
   display_class->help_id         = "gimp-colordisplay-aces-rrt";
   display_class->icon_name       = GIMP_ICON_DISPLAY_FILTER_GAMMA;
 
-  display_class->convert_buffer  = cdisplay_aces_rrt_convert_buffer;
+  display_class->convert_buffer   = cdisplay_aces_rrt_convert_buffer;
+  display_class->get_curve_format = cdisplay_aces_rrt_get_curve_format;
+  display_class->map_curve_value  = cdisplay_aces_rrt_map_curve_value;
 }
 
 static void
@@ -207,6 +215,14 @@ cdisplay_aces_rrt_convert_buffer (GimpColorDisplay *display,
       gfloat *data  = iter->items[0].data;
       gint    count = iter->length;
 
+#if COMPILE_SSE2_INTRINISICS
+      if (cdisplay_simd_get_support () & CDISPLAY_SIMD_SSE2)
+        {
+          cdisplay_aces_rrt_process_sse2 (data, count, gain);
+          continue;
+        }
+#endif
+
       while (count--)
         {
           *data = aces_aces_rrt (*data * gain); data++;
@@ -217,6 +233,22 @@ cdisplay_aces_rrt_convert_buffer (GimpColorDisplay *display,
     }
 }
 
+static const Babl *
+cdisplay_aces_rrt_get_curve_format (GimpColorDisplay *display)
+{
+  return babl_format ("RGBA float");
+}
+
+static gfloat
+cdisplay_aces_rrt_map_curve_value (GimpColorDisplay *display,
+                                   gfloat            value)
+{
+  CdisplayAcesRRT *filter = CDISPLAY_ACES_RRT (display);
+  gfloat           gain   = 1.0f / exp2f (-filter->exposure);
+
+  return aces_aces_rrt (value * gain);
+}
+
 static void
 cdisplay_aces_rrt_set_exposure (CdisplayAcesRRT *aces_rrt,
                                 gdouble          value)
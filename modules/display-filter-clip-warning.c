@@ -32,6 +32,8 @@
 
 #include "libgimp/libgimp-intl.h"
 
+#include "display-filter-simd.h"
+
 
 #define DEFAULT_SHADOWS_COLOR    ((gdouble[]) {0.25, 0.25, 1.00, 1.00})
 #define DEFAULT_HIGHLIGHTS_COLOR ((gdouble[]) {1.00, 0.25, 0.25, 1.00})
@@ -47,9 +49,9 @@
 
 typedef enum
 {
-  WARNING_SHADOW    = 1 << 0,
-  WARNING_HIGHLIGHT = 1 << 1,
-  WARNING_BOGUS     = 1 << 2
+  WARNING_SHADOW    = CDISPLAY_CLIP_WARNING_SHADOW,
+  WARNING_HIGHLIGHT = CDISPLAY_CLIP_WARNING_HIGHLIGHT,
+  WARNING_BOGUS     = CDISPLAY_CLIP_WARNING_BOGUS
 } Warning;
 
 
@@ -94,26 +96,30 @@ enum
 
 GType          cdisplay_clip_warning_get_type       (void);
 
-static void    cdisplay_clip_warning_finalize       (GObject             *object);
-static void    cdisplay_clip_warning_set_property   (GObject             *object,
-                                                     guint                property_id,
-                                                     const GValue        *value,
-                                                     GParamSpec          *pspec);
-static void    cdisplay_clip_warning_get_property   (GObject             *object,
-                                                     guint                property_id,
-                                                     GValue              *value,
-                                                     GParamSpec          *pspec);
-
-static void    cdisplay_clip_warning_convert_buffer (GimpColorDisplay    *display,
-                                                     GeglBuffer          *buffer,
-                                                     GeglRectangle       *area);
-
-static void    cdisplay_clip_warning_set_member     (CdisplayClipWarning *clip_warning,
-                                                     const gchar         *property_name,
-                                                     gpointer             member,
-                                                     gconstpointer        value,
-                                                     gsize                size);
-static void    cdisplay_clip_warning_update_colors  (CdisplayClipWarning *clip_warning);
+static void    cdisplay_clip_warning_finalize       (GObject                         *object);
+static void    cdisplay_clip_warning_set_property   (GObject                         *object,
+                                                     guint                            property_id,
+                                                     const GValue                    *value,
+                                                     GParamSpec                      *pspec);
+static void    cdisplay_clip_warning_get_property   (GObject                         *object,
+                                                     guint                            property_id,
+                                                     GValue                          *value,
+                                                     GParamSpec                      *pspec);
+
+static void    cdisplay_clip_warning_convert_buffer (GimpColorDisplay                *display,
+                                                     GeglBuffer                      *buffer,
+                                                     GeglRectangle                   *area);
+
+static void    cdisplay_clip_warning_classify       (const gfloat                    *data,
+                                                     guint8                          *warnings,
+                                                     gint                             n_pixels,
+                                                     const CdisplayClipWarningParams *params);
+static void    cdisplay_clip_warning_set_member     (CdisplayClipWarning             *clip_warning,
+                                                     const gchar                     *property_name,
+                                                     gpointer                         member,
+                                                     gconstpointer                    value,
+                                                     gsize                            size);
+static void    cdisplay_clip_warning_update_colors  (CdisplayClipWarning             *clip_warning);
 
 
 static const GimpModuleInfo cdisplay_clip_warning_info =
@@ -393,13 +399,66 @@ cdisplay_clip_warning_set_property (GObject      *object,
 #undef SET_MEMBER_VAL
 }
 
+static void
+cdisplay_clip_warning_classify (const gfloat                    *data,
+                                guint8                          *warnings,
+                                gint                             n_pixels,
+                                const CdisplayClipWarningParams *params)
+{
+  while (n_pixels--)
+    {
+      guint8 warning = 0;
+
+      if (params->include_transparent ||
+          ! (data[3] <= 0.0f) /* include nan */)
+        {
+          if (params->show_bogus                                                &&
+              (! isfinite (data[0]) || ! isfinite (data[1]) || ! isfinite (data[2]) ||
+               (params->include_alpha && ! isfinite (data[3]))))
+            {
+              /* don't combine warning color of pixels with a bogus
+               * component with other warnings
+               */
+              warning = WARNING_BOGUS;
+            }
+          else
+            {
+              if (params->show_shadows                                &&
+                  (data[0] < 0.0f || data[1] < 0.0f || data[2] < 0.0f ||
+                   (params->include_alpha && data[3] < 0.0f)))
+                {
+                  warning |= WARNING_SHADOW;
+                }
+
+              if (params->show_highlights                             &&
+                  (data[0] > 1.0f || data[1] > 1.0f || data[2] > 1.0f ||
+                   (params->include_alpha && data[3] > 1.0f)))
+                {
+                  warning |= WARNING_HIGHLIGHT;
+                }
+            }
+        }
+
+      *warnings++ = warning;
+
+      data += 4;
+    }
+}
+
 static void
 cdisplay_clip_warning_convert_buffer (GimpColorDisplay *display,
                                       GeglBuffer       *buffer,
                                       GeglRectangle    *area)
 {
-  CdisplayClipWarning *clip_warning = CDISPLAY_CLIP_WARNING (display);
-  GeglBufferIterator  *iter;
+  CdisplayClipWarning       *clip_warning = CDISPLAY_CLIP_WARNING (display);
+  CdisplayClipWarningParams  params;
+  GeglBufferIterator        *iter;
+
+  params.show_shadows        = clip_warning->show_shadows;
+  params.show_highlights     = clip_warning->show_highlights;
+  params.show_bogus          = clip_warning->show_bogus;
+  params.include_alpha       = clip_warning->include_alpha;
+  params.include_transparent = clip_warning->include_transparent;
 
   iter = gegl_buffer_iterator_new (buffer, area, 0,
                                    babl_format ("R'G'B'A float"),
@@ -407,50 +466,30 @@ cdisplay_clip_warning_convert_buffer (GimpColorDisplay *display,
 
   while (gegl_buffer_iterator_next (iter))
     {
-      gfloat *data  = iter->items[0].data;
-      gint    count = iter->length;
-      gint    x     = iter->items[0].roi.x;
-      gint    y     = iter->items[0].roi.y;
+      gfloat *data     = iter->items[0].data;
+      gint    count    = iter->length;
+      gint    x        = iter->items[0].roi.x;
+      gint    y        = iter->items[0].roi.y;
+      guint8 *warnings = gegl_scratch_new (guint8, count);
+      gint    i;
+
+      /*  find the warnings of the whole chunk first, so that the
+       *  tests can run on several components at once
+       */
+#if COMPILE_SSE2_INTRINISICS
+      if (cdisplay_simd_get_support () & CDISPLAY_SIMD_SSE2)
+        cdisplay_clip_warning_classify_sse2 (data, warnings, count, &params);
+      else
+#endif
+        cdisplay_clip_warning_classify (data, warnings, count, &params);
 
-      while (count--)
+      for (i = 0; i < count; i++)
         {
-          gint warning = 0;
-
-          if (clip_warning->include_transparent ||
-              ! (data[3] <= 0.0f) /* include nan */)
-            {
-              if (clip_warning->show_bogus                                              &&
-                  (! isfinite (data[0]) || ! isfinite (data[1]) || ! isfinite (data[2]) ||
-                   (clip_warning->include_alpha && ! isfinite (data[3]))))
-                {
-                  /* don't combine warning color of pixels with a bogus
-                   * component with other warnings
-                   */
-                  warning = WARNING_BOGUS;
-                }
-              else
-                {
-                  if (clip_warning->show_shadows                          &&
-                      (data[0] < 0.0f || data[1] < 0.0f || data[2] < 0.0f ||
-                       (clip_warning->include_alpha && data[3] < 0.0f)))
-                    {
-                      warning |= WARNING_SHADOW;
-                    }
-
-                  if (clip_warning->show_highlights                       &&
-                      (data[0] > 1.0f || data[1] > 1.0f || data[2] > 1.0f ||
-                       (clip_warning->include_alpha && data[3] > 1.0f)))
-                    {
-                      warning |= WARNING_HIGHLIGHT;
-                    }
-                }
-            }
-
-          if (warning)
+          if (warnings[i])
             {
               gboolean alt = ((x + y) >> 3) & 1;
 
-              memcpy (data, clip_warning->colors[warning][alt],
+              memcpy (data, clip_warning->colors[warnings[i]][alt],
                       4 * sizeof (gfloat));
             }
 
@@ -462,6 +501,8 @@ cdisplay_clip_warning_convert_buffer (GimpColorDisplay *display,
               y++;
             }
         }
+
+      gegl_scratch_free (warnings);
     }
 }
 
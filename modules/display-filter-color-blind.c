@@ -32,6 +32,7 @@
 #include <gegl.h>
 #include <gtk/gtk.h>
 
+#include "libgimpbase/gimpbase.h"
 #include "libgimpcolor/gimpcolor.h"
 #include "libgimpconfig/gimpconfig.h"
 #include "libgimpmath/gimpmath.h"
@@ -40,6 +41,8 @@
 
 #include "libgimp/libgimp-intl.h"
 
+#include "display-filter-simd.h"
+
 
 typedef enum
 {
@@ -327,6 +330,54 @@ cdisplay_colorblind_convert_buffer (GimpColorDisplay *display,
   const gfloat        a2         = colorblind->a2;
   const gfloat        b2         = colorblind->b2;
   const gfloat        c2         = colorblind->c2;
+#if COMPILE_SSE2_INTRINISICS
+  CdisplayColorblindParams params;
+  gboolean                 use_sse2;
+
+  params.rgb2lms    = rgb2lms;
+  params.lms2rgb    = lms2rgb;
+  params.inflection = colorblind->inflection;
+
+  params.plane1[0] = a1;
+  params.plane1[1] = b1;
+  params.plane1[2] = c1;
+  params.plane2[0] = a2;
+  params.plane2[1] = b2;
+  params.plane2[2] = c2;
+
+  switch (colorblind->type)
+    {
+    case COLORBLIND_DEFICIENCY_DEUTERANOPIA:
+      params.replace     = 1;
+      params.other1      = 0;
+      params.other2      = 2;
+      params.numerator   = 2;
+      params.denominator = 0;
+      break;
+
+    case COLORBLIND_DEFICIENCY_PROTANOPIA:
+      params.replace     = 0;
+      params.other1      = 1;
+      params.other2      = 2;
+      params.numerator   = 2;
+      params.denominator = 1;
+      break;
+
+    case COLORBLIND_DEFICIENCY_TRITANOPIA:
+      params.replace     = 2;
+      params.other1      = 0;
+      params.other2      = 1;
+      params.numerator   = 1;
+      params.denominator = 0;
+      break;
+
+    default:
+      params.replace     = -1;
+      break;
+    }
+
+  use_sse2 = (cdisplay_simd_get_support () & CDISPLAY_SIMD_SSE2) != 0;
+#endif
 
   iter = gegl_buffer_iterator_new (buffer, area, 0,
                                    babl_format ("RGBA float") /* linear! */,
@@ -337,6 +388,21 @@ cdisplay_colorblind_convert_buffer (GimpColorDisplay *display,
       gfloat *data  = iter->items[0].data;
       gint    count = iter->length;
 
+#if COMPILE_SSE2_INTRINISICS
+      if (use_sse2)
+        {
+          gint n_done;
+
+          /*  the vector kernel leaves the last few pixels to the
+           *  loop below
+           */
+          n_done = cdisplay_colorblind_process_sse2 (data, count, &params);
+
+          data  += 4 * n_done;
+          count -= n_done;
+        }
+#endif
+
       while (count--)
         {
           gfloat tmp;
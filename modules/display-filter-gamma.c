@@ -62,22 +62,25 @@ enum
 };
 
 
-GType              cdisplay_gamma_get_type        (void);
-
-static void        cdisplay_gamma_set_property    (GObject            *object,
-                                                   guint               property_id,
-                                                   const GValue       *value,
-                                                   GParamSpec         *pspec);
-static void        cdisplay_gamma_get_property    (GObject            *object,
-                                                   guint               property_id,
-                                                   GValue             *value,
-                                                   GParamSpec         *pspec);
-
-static void        cdisplay_gamma_convert_buffer  (GimpColorDisplay   *display,
-                                                   GeglBuffer         *buffer,
-                                                   GeglRectangle      *area);
-static void        cdisplay_gamma_set_gamma       (CdisplayGamma      *gamma,
-                                                   gdouble             value);
+GType              cdisplay_gamma_get_type         (void);
+
+static void        cdisplay_gamma_set_property     (GObject            *object,
+                                                    guint               property_id,
+                                                    const GValue       *value,
+                                                    GParamSpec         *pspec);
+static void        cdisplay_gamma_get_property     (GObject            *object,
+                                                    guint               property_id,
+                                                    GValue             *value,
+                                                    GParamSpec         *pspec);
+
+static void        cdisplay_gamma_convert_buffer   (GimpColorDisplay   *display,
+                                                    GeglBuffer         *buffer,
+                                                    GeglRectangle      *area);
+static const Babl *cdisplay_gamma_get_curve_format (GimpColorDisplay   *display);
+static gfloat      cdisplay_gamma_map_curve_value  (GimpColorDisplay   *display,
+                                                    gfloat              value);
+static void        cdisplay_gamma_set_gamma        (CdisplayGamma      *gamma,
+                                                    gdouble             value);
 
 
 static const GimpModuleInfo cdisplay_gamma_info =
@@ -129,7 +132,9 @@ cdisplay_gamma_class_init (CdisplayGammaClass *klass)
   display_class->help_id         = "gimp-colordisplay-gamma";
   display_class->icon_name       = GIMP_ICON_DISPLAY_FILTER_GAMMA;
 
-  display_class->convert_buffer  = cdisplay_gamma_convert_buffer;
+  display_class->convert_buffer   = cdisplay_gamma_convert_buffer;
+  display_class->get_curve_format = cdisplay_gamma_get_curve_format;
+  display_class->map_curve_value  = cdisplay_gamma_map_curve_value;
 }
 
 static void
@@ -211,6 +216,21 @@ cdisplay_gamma_convert_buffer (GimpColorDisplay *display,
     }
 }
 
+static const Babl *
+cdisplay_gamma_get_curve_format (GimpColorDisplay *display)
+{
+  return babl_format ("R'G'B'A float");
+}
+
+static gfloat
+cdisplay_gamma_map_curve_value (GimpColorDisplay *display,
+                                gfloat            value)
+{
+  CdisplayGamma *gamma = CDISPLAY_GAMMA (display);
+
+  return pow (value, 1.0 / gamma->gamma);
+}
+
 static void
 cdisplay_gamma_set_gamma (CdisplayGamma *gamma,
                           gdouble        value)
@@ -62,22 +62,25 @@ enum
 };
 
 
-GType              cdisplay_contrast_get_type        (void);
-
-static void        cdisplay_contrast_set_property    (GObject          *object,
-                                                      guint             property_id,
-                                                      const GValue     *value,
-                                                      GParamSpec       *pspec);
-static void        cdisplay_contrast_get_property    (GObject          *object,
-                                                      guint             property_id,
-                                                      GValue           *value,
-                                                      GParamSpec       *pspec);
-
-static void        cdisplay_contrast_convert_buffer  (GimpColorDisplay *display,
-                                                      GeglBuffer       *buffer,
-                                                      GeglRectangle    *area);
-static void        cdisplay_contrast_set_contrast    (CdisplayContrast *contrast,
-                                                      gdouble           value);
+GType              cdisplay_contrast_get_type         (void);
+
+static void        cdisplay_contrast_set_property     (GObject          *object,
+                                                       guint             property_id,
+                                                       const GValue     *value,
+                                                       GParamSpec       *pspec);
+static void        cdisplay_contrast_get_property     (GObject          *object,
+                                                       guint             property_id,
+                                                       GValue           *value,
+                                                       GParamSpec       *pspec);
+
+static void        cdisplay_contrast_convert_buffer   (GimpColorDisplay *display,
+                                                       GeglBuffer       *buffer,
+                                                       GeglRectangle    *area);
+static const Babl *cdisplay_contrast_get_curve_format (GimpColorDisplay *display);
+static gfloat      cdisplay_contrast_map_curve_value  (GimpColorDisplay *display,
+                                                       gfloat            value);
+static void        cdisplay_contrast_set_contrast     (CdisplayContrast *contrast,
+                                                       gdouble           value);
 
 
 static const GimpModuleInfo cdisplay_contrast_info =
@@ -129,7 +132,9 @@ cdisplay_contrast_class_init (CdisplayContrastClass *klass)
   display_class->help_id         = "gimp-colordisplay-contrast";
   display_class->icon_name       = GIMP_ICON_DISPLAY_FILTER_CONTRAST;
 
-  display_class->convert_buffer  = cdisplay_contrast_convert_buffer;
+  display_class->convert_buffer   = cdisplay_contrast_convert_buffer;
+  display_class->get_curve_format = cdisplay_contrast_get_curve_format;
+  display_class->map_curve_value  = cdisplay_contrast_map_curve_value;
 }
 
 static void
@@ -211,6 +216,22 @@ cdisplay_contrast_convert_buffer (GimpColorDisplay *display,
     }
 }
 
+static const Babl *
+cdisplay_contrast_get_curve_format (GimpColorDisplay *display)
+{
+  return babl_format ("R'G'B'A float");
+}
+
+static gfloat
+cdisplay_contrast_map_curve_value (GimpColorDisplay *display,
+                                   gfloat            value)
+{
+  CdisplayContrast *contrast = CDISPLAY_CONTRAST (display);
+  gfloat            c        = contrast->contrast * 2 * G_PI;
+
+  return 0.5 * (1.0 + sin (c * value));
+}
+
 static void
 cdisplay_contrast_set_contrast (CdisplayContrast *contrast,
                                 gdouble           value)
@@ -0,0 +1,108 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * display-filter-simd.h
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+/*  Vectorized kernels of the display filter modules, each of them is
+ *  only called when cdisplay_simd_get_support() reports the instruction
+ *  set it was compiled for.
+ */
+
+
+typedef enum
+{
+  CDISPLAY_SIMD_NONE = 0,
+  CDISPLAY_SIMD_SSE2 = 1 << 0
+} CdisplaySimdSupport;
+
+typedef enum
+{
+  CDISPLAY_CLIP_WARNING_SHADOW    = 1 << 0,
+  CDISPLAY_CLIP_WARNING_HIGHLIGHT = 1 << 1,
+  CDISPLAY_CLIP_WARNING_BOGUS     = 1 << 2
+} CdisplayClipWarningFlags;
+
+typedef struct
+{
+  gboolean show_shadows;
+  gboolean show_highlights;
+  gboolean show_bogus;
+  gboolean include_alpha;
+  gboolean include_transparent;
+} CdisplayClipWarningParams;
+
+typedef struct
+{
+  const gfloat *rgb2lms;
+  const gfloat *lms2rgb;
+
+  /*  the LMS component which is projected onto the plane, or -1, the
+   *  two components it is computed from, and the ratio of components
+   *  which chooses between the two half-planes
+   */
+  gint          replace;
+  gint          other1;
+  gint          other2;
+  gint          numerator;
+  gint          denominator;
+  gfloat        inflection;
+  gfloat        plane1[3];
+  gfloat        plane2[3];
+} CdisplayColorblindParams;
+
+
+static inline CdisplaySimdSupport
+cdisplay_simd_get_support (void)
+{
+  static gint support = -1;
+
+  if (support < 0)
+    {
+      GimpCpuAccelFlags accel = gimp_cpu_accel_get_support ();
+
+      support = CDISPLAY_SIMD_NONE;
+
+#if COMPILE_SSE2_INTRINISICS
+      if (accel & GIMP_CPU_ACCEL_X86_SSE2)
+        support |= CDISPLAY_SIMD_SSE2;
+#endif
+
+      (void) accel;
+    }
+
+  return support;
+}
+
+
+#if COMPILE_SSE2_INTRINISICS
+
+void   cdisplay_aces_rrt_process_sse2      (gfloat                          *data,
+                                            gint                             n_pixels,
+                                            gfloat                           gain);
+
+void   cdisplay_clip_warning_classify_sse2 (const gfloat                    *data,
+                                            guint8                          *warnings,
+                                            gint                             n_pixels,
+                                            const CdisplayClipWarningParams *params);
+
+gint   cdisplay_colorblind_process_sse2    (gfloat                          *data,
+                                            gint                             n_pixels,
+                                            const CdisplayColorblindParams  *params);
+
+#endif /* COMPILE_SSE2_INTRINISICS */
@@ -0,0 +1,236 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * display-filter-sse2.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <glib.h>
+
+#include "libgimpbase/gimpbase.h"
+
+#include "display-filter-simd.h"
+
+
+#if COMPILE_SSE2_INTRINISICS
+
+#include <emmintrin.h>
+
+
+/*  the lanes of an RGBA pixel which are not alpha  */
+#define COLOR_MASK() _mm_castsi128_ps (_mm_set_epi32 (0, -1, -1, -1))
+
+
+static inline __m128
+blend_sse2 (__m128 mask,
+            __m128 a,
+            __m128 b)
+{
+  return _mm_or_ps (_mm_and_ps (mask, a), _mm_andnot_ps (mask, b));
+}
+
+static inline __m128
+negate_sse2 (__m128 v)
+{
+  return _mm_xor_ps (v, _mm_set1_ps (-0.0f));
+}
+
+
+/*  display-filter-aces-rrt  */
+
+void
+cdisplay_aces_rrt_process_sse2 (gfloat *data,
+                                gint    n_pixels,
+                                gfloat  gain)
+{
+  const __m128 color_mask = COLOR_MASK ();
+  const __m128 v_gain     = _mm_set1_ps (gain);
+  const __m128 a0         = _mm_set1_ps (0.0245786f);
+  const __m128 a1         = _mm_set1_ps (0.000090537f);
+  const __m128 b0         = _mm_set1_ps (0.983729f);
+  const __m128 b1         = _mm_set1_ps (0.4329510f);
+  const __m128 b2         = _mm_set1_ps (0.238081f);
+
+  while (n_pixels--)
+    {
+      __m128 v = _mm_loadu_ps (data);
+      __m128 x = _mm_mul_ps (v, v_gain);
+      __m128 a;
+      __m128 b;
+
+      /*  the same approximation as aces_aces_rrt(), on all the
+       *  components of the pixel at once
+       */
+      a = _mm_sub_ps (_mm_mul_ps (x, _mm_add_ps (x, a0)), a1);
+      b = _mm_add_ps (_mm_mul_ps (x, _mm_add_ps (_mm_mul_ps (b0, x), b1)), b2);
+
+      _mm_storeu_ps (data, blend_sse2 (color_mask, _mm_div_ps (a, b), v));
+
+      data += 4;
+    }
+}
+
+
+/*  display-filter-clip-warning  */
+
+void
+cdisplay_clip_warning_classify_sse2 (const gfloat                    *data,
+                                     guint8                          *warnings,
+                                     gint                             n_pixels,
+                                     const CdisplayClipWarningParams *params)
+{
+  const __m128 zero = _mm_setzero_ps ();
+  const __m128 one  = _mm_set1_ps (1.0f);
+  __m128       mask;
+
+  mask = params->include_alpha ? _mm_castsi128_ps (_mm_set1_epi32 (-1)) :
+                                 COLOR_MASK ();
+
+  while (n_pixels--)
+    {
+      guint8 warning = 0;
+
+      if (params->include_transparent || ! (data[3] <= 0.0f) /* include nan */)
+        {
+          __m128 v = _mm_loadu_ps (data);
+
+          /*  x - x is 0 for finite x, and nan for inf and nan  */
+          if (params->show_bogus &&
+              _mm_movemask_ps (_mm_andnot_ps (_mm_cmpeq_ps (_mm_sub_ps (v, v),
+                                                            zero),
+                                              mask)))
+            {
+              warning = CDISPLAY_CLIP_WARNING_BOGUS;
+            }
+          else
+            {
+              if (params->show_shadows &&
+                  _mm_movemask_ps (_mm_and_ps (_mm_cmplt_ps (v, zero), mask)))
+                {
+                  warning |= CDISPLAY_CLIP_WARNING_SHADOW;
+                }
+
+              if (params->show_highlights &&
+                  _mm_movemask_ps (_mm_and_ps (_mm_cmpgt_ps (v, one), mask)))
+                {
+                  warning |= CDISPLAY_CLIP_WARNING_HIGHLIGHT;
+                }
+            }
+        }
+
+      *warnings++ = warning;
+
+      data += 4;
+    }
+}
+
+
+/*  display-filter-color-blind  */
+
+static inline void
+colorblind_transform_sse2 (const gfloat *matrix,
+                           __m128       *c)
+{
+  __m128 c0 = c[0];
+  __m128 c1 = c[1];
+  __m128 c2 = c[2];
+  gint   i;
+
+  for (i = 0; i < 3; i++)
+    {
+      c[i] = _mm_add_ps (_mm_add_ps (_mm_mul_ps (c0, _mm_set1_ps (matrix[3 * i + 0])),
+                                     _mm_mul_ps (c1, _mm_set1_ps (matrix[3 * i + 1]))),
+                         _mm_mul_ps (c2, _mm_set1_ps (matrix[3 * i + 2])));
+    }
+}
+
+static inline __m128
+colorblind_project_sse2 (const gfloat *plane,
+                         const __m128 *c,
+                         gint          replace,
+                         gint          other1,
+                         gint          other2)
+{
+  __m128 sum;
+
+  sum = _mm_add_ps (_mm_mul_ps (_mm_set1_ps (plane[other1]), c[other1]),
+                    _mm_mul_ps (_mm_set1_ps (plane[other2]), c[other2]));
+
+  return _mm_div_ps (negate_sse2 (sum), _mm_set1_ps (plane[replace]));
+}
+
+/*  processes four pixels at a time, with one component of all four
+ *  pixels in each register, and returns the number of pixels done
+ */
+gint
+cdisplay_colorblind_process_sse2 (gfloat                         *data,
+                                  gint                            n_pixels,
+                                  const CdisplayColorblindParams *params)
+{
+  const __m128 inflection = _mm_set1_ps (params->inflection);
+  gint         n_done     = 0;
+
+  while (n_pixels - n_done >= 4)
+    {
+      __m128 c[4];
+
+      c[0] = _mm_loadu_ps (data + 0);
+      c[1] = _mm_loadu_ps (data + 4);
+      c[2] = _mm_loadu_ps (data + 8);
+      c[3] = _mm_loadu_ps (data + 12);
+
+      _MM_TRANSPOSE4_PS (c[0], c[1], c[2], c[3]);
+
+      colorblind_transform_sse2 (params->rgb2lms, c);
+
+      if (params->replace >= 0)
+        {
+          __m128 ratio;
+          __m128 side;
+
+          ratio = _mm_div_ps (c[params->numerator], c[params->denominator]);
+          side  = _mm_cmplt_ps (ratio, inflection);
+
+          c[params->replace] =
+            blend_sse2 (side,
+                        colorblind_project_sse2 (params->plane1, c,
+                                                 params->replace,
+                                                 params->other1,
+                                                 params->other2),
+                        colorblind_project_sse2 (params->plane2, c,
+                                                 params->replace,
+                                                 params->other1,
+                                                 params->other2));
+        }
+
+      colorblind_transform_sse2 (params->lms2rgb, c);
+
+      _MM_TRANSPOSE4_PS (c[0], c[1], c[2], c[3]);
+
+      _mm_storeu_ps (data + 0,  c[0]);
+      _mm_storeu_ps (data + 4,  c[1]);
+      _mm_storeu_ps (data + 8,  c[2]);
+      _mm_storeu_ps (data + 12, c[3]);
+
+      data   += 16;
+      n_done += 4;
+    }
+
+  return n_done;
+}
+
+#endif /* COMPILE_SSE2_INTRINISICS */
@@ -168,6 +168,7 @@ static GimpImage      * load_image           (GFile                  *file,
 static gint             export_image         (GFile                  *file,
                                               GimpImage              *image,
                                               GimpDrawable           *drawable,
+                                              GeglBuffer             *buffer,
                                               FileType                file_type,
                                               GObject                *config,
                                               GError                **error);
@@ -635,7 +636,8 @@ pnm_export (GimpProcedure        *procedure,
   FileType           file_type = GPOINTER_TO_INT (run_data);
   GimpPDBStatusType  status    = GIMP_PDB_SUCCESS;
   GimpExportReturn   export    = GIMP_EXPORT_IGNORE;
-  GList             *drawables;
+  GList             *drawables = NULL;
+  GeglBuffer        *buffer;
   GError            *error     = NULL;
 
   gegl_init (NULL, NULL);
@@ -650,18 +652,29 @@ pnm_export (GimpProcedure        *procedure,
         status = GIMP_PDB_CANCEL;
     }
 
-  export    = gimp_export_options_get_image (options, &image);
-  drawables = gimp_image_list_layers (image);
+  /* If the image only needs to be merged or flattened, stream the
+   * merged pixels from the core instead of exporting a merged copy.
+   */
+  buffer = gimp_export_options_get_merged_buffer (options, image);
+
+  if (! buffer)
+    {
+      export    = gimp_export_options_get_image (options, &image);
+      drawables = gimp_image_list_layers (image);
+      buffer    = gimp_drawable_get_buffer (drawables->data);
+    }
 
   if (status == GIMP_PDB_SUCCESS)
     {
-      if (! export_image (file, image, drawables->data, file_type,
-                          G_OBJECT (config), &error))
+      if (! export_image (file, image, drawables ? drawables->data : NULL,
+                          buffer, file_type, G_OBJECT (config), &error))
         {
           status = GIMP_PDB_EXECUTION_ERROR;
         }
     }
 
+  g_object_unref (buffer);
+
   if (export == GIMP_EXPORT_EXPORT)
     gimp_image_delete (image);
 
@@ -1584,13 +1597,13 @@ static gboolean
 export_image (GFile         *file,
               GimpImage     *image,
               GimpDrawable  *drawable,
+              GeglBuffer    *buffer,
               FileType       file_type,
               GObject       *config,
               GError       **error)
 {
   gboolean         status = FALSE;
   GOutputStream   *output = NULL;
-  GeglBuffer      *buffer = NULL;
   const Babl      *format = NULL;
   const gchar     *header_string = NULL;
   GimpImageType    drawable_type;
@@ -1614,7 +1627,8 @@ export_image (GFile         *file,
 
   /*  Make sure we're not saving an image with an alpha channel
    *  unless we're exporting a PAM file  */
-  if (file_type != FILE_TYPE_PAM && gimp_drawable_has_alpha (drawable))
+  if (file_type != FILE_TYPE_PAM &&
+      babl_format_has_alpha (gegl_buffer_get_format (buffer)))
     {
       g_message (_("Cannot export images with alpha channel."));
       goto out;
@@ -1630,12 +1644,17 @@ export_image (GFile         *file,
   if (! output)
     goto out;
 
-  buffer = gimp_drawable_get_buffer (drawable);
-
   xres = gegl_buffer_get_width  (buffer);
   yres = gegl_buffer_get_height (buffer);
 
-  drawable_type = gimp_drawable_type (drawable);
+  if (drawable)
+    drawable_type = gimp_drawable_type (drawable);
+  else if (gimp_image_get_base_type (image) == GIMP_GRAY)
+    drawable_type = babl_format_has_alpha (gegl_buffer_get_format (buffer)) ?
+                    GIMP_GRAYA_IMAGE : GIMP_GRAY_IMAGE;
+  else
+    drawable_type = babl_format_has_alpha (gegl_buffer_get_format (buffer)) ?
+                    GIMP_RGBA_IMAGE : GIMP_RGB_IMAGE;
 
   switch (gimp_image_get_precision (image))
     {
@@ -1991,8 +2010,6 @@ export_image (GFile         *file,
 
   if (comment)
     g_free (comment);
-  if (buffer)
-    g_object_unref (buffer);
   if (output)
     g_object_unref (output);
 
@@ -28,6 +28,9 @@
 #define PLUG_IN_BINARY  "file-exr"
 #define PLUG_IN_VERSION "0.0.0"
 
+/* upper bound for the memory of one band of scanlines */
+#define MAX_BAND_SIZE   (64 * 1024 * 1024)
+
 
 typedef struct _Exr      Exr;
 typedef struct _ExrClass ExrClass;
@@ -184,6 +187,7 @@ load_image (GFile                 *file,
   const Babl       *format;
   gint              bpp;
   gint              tile_height;
+  gint              band_height;
   gchar            *pixels = NULL;
   gint              begin;
   gint32            success = FALSE;
@@ -197,6 +201,8 @@ load_image (GFile                 *file,
   gimp_progress_init_printf (_("Opening '%s'"),
                              gimp_file_get_utf8_name (file));
 
+  exr_loader_set_num_threads (gimp_get_num_processors ());
+
   loader = exr_loader_new (g_file_peek_path (file));
 
   if (! loader)
@@ -313,31 +319,37 @@ load_image (GFile                 *file,
       format = gimp_drawable_get_format (GIMP_DRAWABLE (layer));
       bpp = babl_format_get_bytes_per_pixel (format);
 
+      /* read bands of whole tile rows, as many as there are threads,
+       * so that OpenEXR can decode the scanline blocks or tiles of a
+       * band in parallel, and each band is a tile-aligned GEGL write
+       */
       tile_height = gimp_tile_height ();
-      pixels = g_new0 (gchar, tile_height * width * bpp);
+      band_height = tile_height * MAX (gimp_get_num_processors (), 1);
+      band_height = MIN (band_height,
+                         MAX_BAND_SIZE / ((gsize) width * bpp) /
+                         tile_height * tile_height);
+      band_height = CLAMP (band_height, tile_height, height);
+
+      pixels = g_new0 (gchar, (gsize) band_height * width * bpp);
 
-      for (begin = 0; begin < height; begin += tile_height)
+      for (begin = 0; begin < height; begin += band_height)
         {
           gint end;
           gint num;
+          gint retval;
 
-          end = MIN (begin + tile_height, height);
+          end = MIN (begin + band_height, height);
           num = end - begin;
 
-          for (gint j = 0; j < num; j++)
+          retval = exr_loader_read_pixel_rows (loader, pixels, bpp,
+                                               begin, num, i);
+          if (retval < 0)
             {
-              gint retval;
-
-              retval = exr_loader_read_pixel_row (loader,
-                                                  pixels + (j * width * bpp),
-                                                  bpp, begin + j, i);
-              if (retval < 0)
-                {
-                  g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
-                               _("Error reading pixel data from '%s'"),
-                               gimp_file_get_utf8_name (file));
-                  goto out;
-                }
+              g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
+                           _("Error reading pixel data from '%s'"),
+                           gimp_file_get_utf8_name (file));
+              g_clear_object (&buffer);
+              goto out;
             }
 
           gegl_buffer_set (buffer, GEGL_RECTANGLE (0, begin, width, num),
@@ -411,6 +423,7 @@ load_image (GFile                 *file,
   success = TRUE;
 
  out:
+  g_clear_pointer (&pixels, g_free);
   g_clear_object (&profile);
   g_clear_pointer (&comment, g_free);
   g_clear_pointer (&loader, exr_loader_unref);
@@ -56,6 +56,7 @@
 #include <ImfRgbaFile.h>
 #include <ImfRgbaYca.h>
 #include <ImfStandardAttributes.h>
+#include <ImfThreading.h>
 #pragma GCC diagnostic pop
 
 #include "exr-attribute-blob.h"
@@ -212,19 +213,22 @@ struct _EXRLoader
     return can_load_;
   }
 
-  int readPixelRow(char *pixels,
-                   int   bpp,
-                   int   row,
-                   int   layer_index)
+  int readPixelRows(char *pixels,
+                    int   bpp,
+                    int   row,
+                    int   n_rows,
+                    int   layer_index)
   {
     const int        actual_row = data_window_.min.y + row;
+    const ptrdiff_t  rowstride  = (ptrdiff_t) getWidth() * bpp;
     FrameBuffer      fb;
     std::set<string> layerNames;
     std::string      prefix     = "";
     // This is necessary because OpenEXR expects the buffer to begin at
     // (0, 0). Though it probably results in some unmapped address,
     // hopefully OpenEXR will not make use of it. :/
-    char* base = pixels - (data_window_.min.x * bpp);
+    char* base = pixels - ((ptrdiff_t) data_window_.min.x * bpp)
+                        - ((ptrdiff_t) actual_row * rowstride);
 
     if (layer_index > -1)
       {
@@ -236,31 +240,33 @@ struct _EXRLoader
     switch (image_type_)
       {
       case IMAGE_TYPE_UNKNOWN_1_CHANNEL:
-        fb.insert(unknown_channel_name_, Slice(pt_, base, bpp, 0, 1, 1, 0.5));
+        fb.insert(unknown_channel_name_, Slice(pt_, base, bpp, rowstride, 1, 1, 0.5));
         break;
 
       case IMAGE_TYPE_YUV:
       case IMAGE_TYPE_GRAY:
-        fb.insert(prefix + "Y", Slice(pt_, base, bpp, 0, 1, 1, 0.5));
+        fb.insert(prefix + "Y", Slice(pt_, base, bpp, rowstride, 1, 1, 0.5));
         if (hasAlpha())
           {
-            fb.insert(prefix + "A", Slice(pt_, base + bpc_, bpp, 0, 1, 1, 1.0));
+            fb.insert(prefix + "A", Slice(pt_, base + bpc_, bpp, rowstride, 1, 1, 1.0));
           }
         break;
 
       case IMAGE_TYPE_RGB:
       default:
-        fb.insert(prefix + "R", Slice(pt_, base + (bpc_ * 0), bpp, 0, 1, 1, 0.0));
-        fb.insert(prefix + "G", Slice(pt_, base + (bpc_ * 1), bpp, 0, 1, 1, 0.0));
-        fb.insert(prefix + "B", Slice(pt_, base + (bpc_ * 2), bpp, 0, 1, 1, 0.0));
+        fb.insert(prefix + "R", Slice(pt_, base + (bpc_ * 0), bpp, rowstride, 1, 1, 0.0));
+        fb.insert(prefix + "G", Slice(pt_, base + (bpc_ * 1), bpp, rowstride, 1, 1, 0.0));
+        fb.insert(prefix + "B", Slice(pt_, base + (bpc_ * 2), bpp, rowstride, 1, 1, 0.0));
         if (hasAlpha())
           {
-            fb.insert(prefix + "A", Slice(pt_, base + (bpc_ * 3), bpp, 0, 1, 1, 1.0));
+            fb.insert(prefix + "A", Slice(pt_, base + (bpc_ * 3), bpp, rowstride, 1, 1, 1.0));
           }
       }
 
+    // Reading the whole band in one call lets OpenEXR decompress its
+    // line buffers or tiles in parallel, using the global thread pool.
     file_.setFrameBuffer(fb);
-    file_.readPixels(actual_row);
+    file_.readPixels(actual_row, actual_row + n_rows - 1);
 
     return 0;
   }
@@ -497,6 +503,20 @@ struct _EXRLoader
   std::string unknown_channel_name_;
 };
 
+void
+exr_loader_set_num_threads (int n_threads)
+{
+  // Must be called before exr_loader_new(), the thread count is
+  // picked up when the file is opened.
+  try
+    {
+      Imf::setGlobalThreadCount (n_threads > 1 ? n_threads : 0);
+    }
+  catch (...)
+    {
+    }
+}
+
 EXRLoader*
 exr_loader_new (const char *filename)
 {
@@ -635,17 +655,18 @@ exr_loader_get_layer_info (EXRLoader *loader,
 }
 
 int
-exr_loader_read_pixel_row (EXRLoader *loader,
-                           char      *pixels,
-                           int        bpp,
-                           int        row,
-                           int        layer_index)
+exr_loader_read_pixel_rows (EXRLoader *loader,
+                            char      *pixels,
+                            int        bpp,
+                            int        row,
+                            int        n_rows,
+                            int        layer_index)
 {
   int retval = -1;
   // Don't let any exceptions propagate to the C layer.
   try
     {
-      retval = loader->readPixelRow(pixels, bpp, row, layer_index);
+      retval = loader->readPixelRows(pixels, bpp, row, n_rows, layer_index);
     }
   catch (...)
     {
@@ -41,36 +41,39 @@ typedef enum
 } EXRImageType;
 
 
-EXRLoader        * exr_loader_new            (const char *filename);
-
-EXRLoader        * exr_loader_ref            (EXRLoader  *loader);
-void               exr_loader_unref          (EXRLoader  *loader);
-
-int                exr_loader_get_width      (EXRLoader  *loader);
-int                exr_loader_get_height     (EXRLoader  *loader);
-
-EXRPrecision       exr_loader_get_precision  (EXRLoader  *loader);
-EXRImageType       exr_loader_get_image_type (EXRLoader  *loader);
-int                exr_loader_has_alpha      (EXRLoader  *loader);
-
-GimpColorProfile * exr_loader_get_profile    (EXRLoader  *loader);
-gchar            * exr_loader_get_comment    (EXRLoader  *loader);
-guchar           * exr_loader_get_exif       (EXRLoader  *loader,
-                                              guint      *size);
-guchar           * exr_loader_get_xmp        (EXRLoader  *loader,
-                                              guint      *size);
-
-gchar            * exr_loader_get_layer_name (EXRLoader  *loader,
-                                              gint        index);
-int                exr_loader_get_layer_info (EXRLoader  *loader,
-                                              gint       *num_layers,
-                                              gboolean   *layers_only);
-
-int                exr_loader_read_pixel_row (EXRLoader *loader,
-                                              char      *pixels,
-                                              int        bpp,
-                                              int        row,
-                                              int        layer_index);
+void               exr_loader_set_num_threads (int         n_threads);
+
+EXRLoader        * exr_loader_new             (const char *filename);
+
+EXRLoader        * exr_loader_ref             (EXRLoader  *loader);
+void               exr_loader_unref           (EXRLoader  *loader);
+
+int                exr_loader_get_width       (EXRLoader  *loader);
+int                exr_loader_get_height      (EXRLoader  *loader);
+
+EXRPrecision       exr_loader_get_precision   (EXRLoader  *loader);
+EXRImageType       exr_loader_get_image_type  (EXRLoader  *loader);
+int                exr_loader_has_alpha       (EXRLoader  *loader);
+
+GimpColorProfile * exr_loader_get_profile     (EXRLoader  *loader);
+gchar            * exr_loader_get_comment     (EXRLoader  *loader);
+guchar           * exr_loader_get_exif        (EXRLoader  *loader,
+                                               guint      *size);
+guchar           * exr_loader_get_xmp         (EXRLoader  *loader,
+                                               guint      *size);
+
+gchar            * exr_loader_get_layer_name  (EXRLoader  *loader,
+                                               gint        index);
+int                exr_loader_get_layer_info  (EXRLoader  *loader,
+                                               gint       *num_layers,
+                                               gboolean   *layers_only);
+
+int                exr_loader_read_pixel_rows (EXRLoader *loader,
+                                               char      *pixels,
+                                               int        bpp,
+                                               int        row,
+                                               int        n_rows,
+                                               int        layer_index);
 
 G_END_DECLS
 
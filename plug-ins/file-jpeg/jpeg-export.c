@@ -66,6 +66,8 @@ typedef struct
 } PreviewPersistent;
 
 
+static GimpImageType buffer_image_type (GeglBuffer          *buffer);
+
 static void  make_preview              (GimpProcedureConfig *config);
 
 static void  quality_changed           (GimpProcedureConfig *config);
@@ -192,11 +194,27 @@ background_jpeg_save (PreviewPersistent *pp)
     }
 }
 
+static GimpImageType
+buffer_image_type (GeglBuffer *buffer)
+{
+  const Babl *format = gegl_buffer_get_format (buffer);
+  gboolean    alpha  = babl_format_has_alpha (format);
+
+  if (babl_format_is_palette (format))
+    return alpha ? GIMP_INDEXEDA_IMAGE : GIMP_INDEXED_IMAGE;
+
+  if (babl_format_get_n_components (format) - (alpha ? 1 : 0) == 1)
+    return alpha ? GIMP_GRAYA_IMAGE : GIMP_GRAY_IMAGE;
+
+  return alpha ? GIMP_RGBA_IMAGE : GIMP_RGB_IMAGE;
+}
+
 gboolean
 export_image (GFile                *file,
               GimpProcedureConfig  *config,
               GimpImage            *image,
               GimpDrawable         *drawable,
+              GeglBuffer           *buffer,
               GimpImage            *orig_image,
               gboolean              preview,
               GError              **error)
@@ -205,7 +223,6 @@ export_image (GFile                *file,
   static struct my_error_mgr         jerr;
 
   GimpImageType     drawable_type;
-  GeglBuffer       *buffer;
   const gchar      *encoding;
   const Babl       *format;
   const Babl       *space;
@@ -264,9 +281,14 @@ export_image (GFile                *file,
 
   quality = (gint) (dquality * 100.0 + 0.5);
 
-  drawable_type = gimp_drawable_type (drawable);
-  buffer = gimp_drawable_get_buffer (drawable);
-  space = gimp_drawable_get_format (drawable);
+  /* drawable is NULL when buffer holds the image's merged pixels */
+  if (drawable)
+    drawable_type = gimp_drawable_type (drawable);
+  else
+    drawable_type = buffer_image_type (buffer);
+
+  buffer = g_object_ref (buffer);
+  space  = gegl_buffer_get_format (buffer);
 
   if (! preview)
     gimp_progress_init_printf (_("Exporting '%s'"),
@@ -371,7 +393,7 @@ export_image (GFile                *file,
           g_printerr ("%s: error getting the profile space: %s",
                      G_STRFUNC, (*error)->message);
           g_clear_error (error);
-          space = gimp_drawable_get_format (drawable);
+          space = gegl_buffer_get_format (buffer);
         }
     }
 
@@ -527,7 +549,8 @@ export_image (GFile                *file,
   cinfo.optimize_coding = optimize;
 #endif
 
-  subsampling = (gimp_drawable_is_rgb (drawable) ?
+  subsampling = ((drawable_type == GIMP_RGB_IMAGE ||
+                  drawable_type == GIMP_RGBA_IMAGE) ?
                  subsmp : JPEG_SUBSAMPLING_1x1_1x1_1x1);
 
   /*  smoothing is not supported with nonstandard sampling ratios  */
@@ -780,7 +803,8 @@ make_preview (GimpProcedureConfig *config)
 
   if (show_preview)
     {
-      GFile *file = gimp_temp_file ("jpeg");
+      GFile      *file = gimp_temp_file ("jpeg");
+      GeglBuffer *buffer;
 
       if (! undo_touched)
         {
@@ -791,12 +815,17 @@ make_preview (GimpProcedureConfig *config)
           undo_touched = TRUE;
         }
 
+      buffer = gimp_drawable_get_buffer (drawable_global);
+
       export_image (file, config,
                     preview_image,
                     drawable_global,
+                    buffer,
                     orig_image_global,
                     TRUE, NULL);
 
+      g_object_unref (buffer);
+
       g_object_unref (file);
 
       if (separate_display && ! display)
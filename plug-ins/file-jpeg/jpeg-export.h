@@ -27,6 +27,7 @@ gboolean    export_image       (GFile                *file,
                                 GimpProcedureConfig *config,
                                 GimpImage            *image,
                                 GimpDrawable         *drawable,
+                                GeglBuffer           *buffer,
                                 GimpImage            *orig_image,
                                 gboolean              preview,
                                 GError              **error);
@@ -46,6 +46,12 @@ static gboolean  jpeg_load_resolution       (GimpImage *image,
 
 static void      jpeg_load_sanitize_comment (gchar    *comment);
 
+static gint      jpeg_load_thumbnail_denom  (struct jpeg_decompress_struct
+                                                       *cinfo,
+                                             gint       size);
+static void      jpeg_load_thumbnail_rotate (GimpImage *image,
+                                             GFile     *file);
+
 
 GimpImage * volatile  preview_image;
 GimpLayer *           preview_layer;
@@ -441,10 +447,14 @@ load_image (GFile        *file,
           goto set_buffer;
         }
 
+      /*  read as many scanlines per call as libjpeg can give us,
+       *  that's up to a whole iMCU row
+       */
       if (cinfo.data_precision <= 8 || ! support_12_bit)
         {
-          for (i = 0; i < scanlines; i++)
-            jpeg_read_scanlines (&cinfo, (JSAMPARRAY) &rowbuf[i], 1);
+          for (i = 0; i < scanlines; )
+            i += jpeg_read_scanlines (&cinfo, (JSAMPARRAY) &rowbuf[i],
+                                      scanlines - i);
         }
 #if LIBJPEG_TURBO_VERSION_NUMBER >= 3000000
       else
@@ -456,15 +466,17 @@ load_image (GFile        *file,
 
           if (cinfo.data_precision <= 12)
             {
-              for (i = 0; i < scanlines; i++)
-                jpeg12_read_scanlines (&cinfo, (J12SAMPARRAY) &rowbuf_16[i],
-                                       1);
+              for (i = 0; i < scanlines; )
+                i += jpeg12_read_scanlines (&cinfo,
+                                            (J12SAMPARRAY) &rowbuf_16[i],
+                                            scanlines - i);
             }
           else
             {
-              for (i = 0; i < scanlines; i++)
-                jpeg16_read_scanlines (&cinfo, (J16SAMPARRAY) &rowbuf_16[i],
-                                       1);
+              for (i = 0; i < scanlines; )
+                i += jpeg16_read_scanlines (&cinfo,
+                                            (J16SAMPARRAY) &rowbuf_16[i],
+                                            scanlines - i);
             }
 
           /* Normalize to 16 bit range */
@@ -670,24 +682,103 @@ jpeg_load_sanitize_comment (gchar *comment)
     }
 }
 
+/*  Returns the largest reduction libjpeg can decode to directly, that
+ *  still leaves the image at least @size pixels on its longer side.
+ */
+static gint
+jpeg_load_thumbnail_denom (struct jpeg_decompress_struct *cinfo,
+                           gint                           size)
+{
+  gint longest = MAX (cinfo->image_width, cinfo->image_height);
+  gint denom;
+
+  for (denom = 8; denom > 1; denom /= 2)
+    {
+      if (longest / denom >= size)
+        break;
+    }
+
+  return denom;
+}
+
+/*  applies the Exif orientation to a decoded thumbnail, like the core
+ *  does for a full load, and gimp_image_metadata_load_thumbnail() does
+ *  for an Exif thumbnail
+ */
+static void
+jpeg_load_thumbnail_rotate (GimpImage *image,
+                            GFile     *file)
+{
+  GimpMetadata *metadata;
+
+  metadata = gimp_metadata_load_from_file (file, NULL);
+
+  if (! metadata)
+    return;
+
+  switch (gexiv2_metadata_try_get_orientation (GEXIV2_METADATA (metadata),
+                                               NULL))
+    {
+    case GEXIV2_ORIENTATION_HFLIP:
+      gimp_image_flip (image, GIMP_ORIENTATION_HORIZONTAL);
+      break;
+
+    case GEXIV2_ORIENTATION_ROT_180:
+      gimp_image_rotate (image, GIMP_ROTATE_DEGREES180);
+      break;
+
+    case GEXIV2_ORIENTATION_VFLIP:
+      gimp_image_flip (image, GIMP_ORIENTATION_VERTICAL);
+      break;
+
+    case GEXIV2_ORIENTATION_ROT_90_HFLIP:  /* flipped diagonally around '\' */
+      gimp_image_rotate (image, GIMP_ROTATE_DEGREES90);
+      gimp_image_flip (image, GIMP_ORIENTATION_HORIZONTAL);
+      break;
+
+    case GEXIV2_ORIENTATION_ROT_90:  /* 90 CW */
+      gimp_image_rotate (image, GIMP_ROTATE_DEGREES90);
+      break;
+
+    case GEXIV2_ORIENTATION_ROT_90_VFLIP:  /* flipped diagonally around '/' */
+      gimp_image_rotate (image, GIMP_ROTATE_DEGREES90);
+      gimp_image_flip (image, GIMP_ORIENTATION_VERTICAL);
+      break;
+
+    case GEXIV2_ORIENTATION_ROT_270:  /* 90 CCW */
+      gimp_image_rotate (image, GIMP_ROTATE_DEGREES270);
+      break;
+
+    default: /* normal or unspecified, nothing to do */
+      break;
+    }
+
+  g_object_unref (metadata);
+}
+
 GimpImage *
 load_thumbnail_image (GFile         *file,
+                      gint           size,
                       gint          *width,
                       gint          *height,
                       GimpImageType *type,
                       GError       **error)
 {
-  GimpImage * volatile          image = NULL;
+  GimpImage        * volatile   image   = NULL;
+  GeglBuffer       * volatile   buffer  = NULL;
+  GimpColorProfile * volatile   profile = NULL;
   struct jpeg_decompress_struct cinfo;
   struct my_error_mgr           jerr;
-  FILE                         *infile   = NULL;
+  FILE                         *infile  = NULL;
+  gboolean                      known   = TRUE;
 
   gimp_progress_init_printf (_("Opening thumbnail for '%s'"),
                              g_file_get_parse_name (file));
 
-  image = gimp_image_metadata_load_thumbnail (file, error);
-  if (! image)
-    return NULL;
+  /*  use the Exif thumbnail if there is one, otherwise decode a
+   *  reduced size version of the image below
+   */
+  image = gimp_image_metadata_load_thumbnail (file, NULL);
 
   cinfo.err = jpeg_std_error (&jerr.pub);
   jerr.pub.error_exit     = my_error_exit;
@@ -713,6 +804,13 @@ load_thumbnail_image (GFile         *file,
        * and return.
        */
       jpeg_destroy_decompress (&cinfo);
+      fclose (infile);
+
+      if (buffer)
+        g_object_unref (buffer);
+
+      if (profile)
+        g_object_unref (profile);
 
       if (image)
         gimp_image_delete (image);
@@ -727,14 +825,30 @@ load_thumbnail_image (GFile         *file,
 
   jpeg_stdio_src (&cinfo, infile);
 
+  /* - step 2.1: tell the lib to save APP2 data (ICC profiles) */
+  if (! image)
+    jpeg_save_markers (&cinfo, JPEG_APP0 + 2, 0xffff);
+
   /* Step 3: read file parameters with jpeg_read_header() */
 
   jpeg_read_header (&cinfo, TRUE);
 
-  jpeg_start_decompress (&cinfo);
+  *width  = cinfo.image_width;
+  *height = cinfo.image_height;
+
+  /* Step 4: set parameters for a fast, reduced size decompression;
+   * libjpeg then skips most of the IDCT work and the upsampling
+   */
+  if (! image)
+    {
+      cinfo.scale_num           = 1;
+      cinfo.scale_denom         = jpeg_load_thumbnail_denom (&cinfo, size);
+      cinfo.dct_method          = JDCT_IFAST;
+      cinfo.do_fancy_upsampling = FALSE;
+      cinfo.do_block_smoothing  = FALSE;
+    }
 
-  *width  = cinfo.output_width;
-  *height = cinfo.output_height;
+  jpeg_calc_output_dimensions (&cinfo);
 
   switch (cinfo.output_components)
     {
@@ -760,12 +874,116 @@ load_thumbnail_image (GFile         *file,
                  cinfo.output_components, cinfo.out_color_space,
                  cinfo.jpeg_color_space);
 
-      gimp_image_delete (image);
+      if (image)
+        gimp_image_delete (image);
       image = NULL;
+      known = FALSE;
       break;
     }
 
-  /* Step 4: Release JPEG decompression object */
+  /* Step 5: decode the reduced size image, if there is no Exif
+   * thumbnail.  Let the core do a full load for high bit depth files.
+   */
+  if (! image && known && cinfo.data_precision <= 8)
+    {
+      GimpLayer   *layer;
+      const Babl  *format;
+      const gchar *encoding;
+      JSAMPARRAY   rowbuf;
+      gint         tile_height = gimp_tile_height ();
+      guint8      *icc_data    = NULL;
+      guint        icc_length  = 0;
+
+      /* Step 5.1: use the embedded ICC profile, as load_image() does */
+      jpeg_icc_read_profile (&cinfo, &icc_data, &icc_length);
+
+      if (icc_data)
+        {
+          profile = gimp_color_profile_new_from_icc_profile (icc_data,
+                                                             icc_length,
+                                                             NULL);
+          g_free (icc_data);
+        }
+
+      jpeg_start_decompress (&cinfo);
+
+      image = gimp_image_new (cinfo.output_width, cinfo.output_height,
+                              *type == GIMP_GRAY_IMAGE ?
+                              GIMP_GRAY : GIMP_RGB);
+
+      gimp_image_undo_disable (image);
+
+      /*  a CMYK profile is only used to convert the pixels  */
+      if (profile && cinfo.out_color_space != JCS_CMYK)
+        gimp_image_set_color_profile (image, profile);
+
+      layer = gimp_layer_new (image, _("Background"),
+                              cinfo.output_width,
+                              cinfo.output_height,
+                              *type,
+                              100,
+                              gimp_image_get_default_new_layer_mode (image));
+      gimp_image_insert_layer (image, layer, NULL, 0);
+
+      buffer = gimp_drawable_get_buffer (GIMP_DRAWABLE (layer));
+
+      if (cinfo.out_color_space == JCS_CMYK)
+        {
+          const Babl *space = NULL;
+
+          if (profile)
+            space = gimp_color_profile_get_space (profile,
+                                                  GIMP_COLOR_RENDERING_INTENT_RELATIVE_COLORIMETRIC,
+                                                  NULL);
+
+          format = babl_format_with_space ("cmyk u8", space);
+        }
+      else
+        {
+          encoding = (*type == GIMP_GRAY_IMAGE) ? "Y' u8" : "R'G'B' u8";
+          format   = babl_format_with_space (encoding,
+                                             gimp_drawable_get_format (GIMP_DRAWABLE (layer)));
+        }
+
+      /* freed by jpeg_destroy_decompress(), also on errors */
+      rowbuf = (*cinfo.mem->alloc_sarray) ((j_common_ptr) &cinfo, JPOOL_IMAGE,
+                                           cinfo.output_width *
+                                           cinfo.output_components,
+                                           tile_height);
+
+      while (cinfo.output_scanline < cinfo.output_height)
+        {
+          gint start     = cinfo.output_scanline;
+          gint scanlines = MIN (tile_height,
+                                 (gint) cinfo.output_height - start);
+          gint i;
+
+          for (i = 0; i < scanlines; )
+            i += jpeg_read_scanlines (&cinfo, &rowbuf[i], scanlines - i);
+
+          for (i = 0; i < scanlines; i++)
+            gegl_buffer_set (buffer,
+                             GEGL_RECTANGLE (0, start + i,
+                                             cinfo.output_width, 1),
+                             0, format, rowbuf[i], GEGL_AUTO_ROWSTRIDE);
+        }
+
+      jpeg_finish_decompress (&cinfo);
+
+      g_clear_object (&buffer);
+      g_clear_object (&profile);
+
+      /* Step 5.2: rotate the thumbnail by the Exif orientation */
+      jpeg_load_thumbnail_rotate (image, file);
+    }
+  else if (! image && known)
+    {
+      g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
+                   _("Could not load thumbnail for '%s'"),
+                   g_file_get_parse_name (file));
+    }
+
+  /* Step 6: Release JPEG decompression object */
 
   /* This is an important step since it will release a good deal
    * of memory.
@@ -26,6 +26,7 @@ GimpImage * load_image           (GFile         *file,
                                   GError       **error);
 
 GimpImage * load_thumbnail_image (GFile         *file,
+                                  gint           size,
                                   gint          *width,
                                   gint          *height,
                                   GimpImageType *type,
@@ -161,8 +161,9 @@ jpeg_create_procedure (GimpPlugIn  *plug_in,
 
       gimp_procedure_set_documentation (procedure,
                                         _("Loads a thumbnail from a JPEG image"),
-                                        _("Loads a thumbnail from a JPEG image, "
-                                          "if one exists"),
+                                        _("Loads the Exif thumbnail of a JPEG "
+                                          "image, or decodes the image at a "
+                                          "reduced size if there is none"),
                                         name);
       gimp_procedure_set_attribution (procedure,
                                       "Mukund Sivaraman <muks@mukund.org>, "
@@ -394,7 +395,7 @@ jpeg_load_thumb (GimpProcedure       *procedure,
   preview_image = NULL;
   preview_layer = NULL;
 
-  image = load_thumbnail_image (file, &width, &height, &type,
+  image = load_thumbnail_image (file, size, &width, &height, &type,
                                 &error);
 
 
@@ -430,6 +431,7 @@ jpeg_export (GimpProcedure        *procedure,
   GimpImage         *orig_image;
   GimpExportReturn   export = GIMP_EXPORT_IGNORE;
   GList             *drawables;
+  GeglBuffer        *buffer = NULL;
   GError            *error  = NULL;
 
   gint                   orig_num_quant_tables = -1;
@@ -525,8 +527,23 @@ jpeg_export (GimpProcedure        *procedure,
                 "original-num-quant-tables", orig_num_quant_tables,
                 NULL);
 
-  export    = gimp_export_options_get_image (options, &image);
-  drawables = gimp_image_list_layers (image);
+  /* Without the dialog, whose preview is drawn on a layer of the
+   * exported image, stream the merged pixels from the core band by band
+   * if the image only needs to be merged or flattened.
+   */
+  if (run_mode != GIMP_RUN_INTERACTIVE)
+    buffer = gimp_export_options_get_merged_buffer (options, image);
+
+  if (buffer)
+    {
+      drawables = NULL;
+    }
+  else
+    {
+      export    = gimp_export_options_get_image (options, &image);
+      drawables = gimp_image_list_layers (image);
+      buffer    = gimp_drawable_get_buffer (drawables->data);
+    }
 
   if (run_mode == GIMP_RUN_INTERACTIVE)
     {
@@ -570,7 +587,8 @@ jpeg_export (GimpProcedure        *procedure,
   if (status == GIMP_PDB_SUCCESS)
     {
       if (! export_image (file, config,
-                          image, drawables->data, orig_image, FALSE,
+                          image, drawables ? drawables->data : NULL, buffer,
+                          orig_image, FALSE,
                           &error))
         {
           status = GIMP_PDB_EXECUTION_ERROR;
@@ -599,6 +617,8 @@ jpeg_export (GimpProcedure        *procedure,
         }
     }
 
+  g_object_unref (buffer);
+
   g_list_free (drawables);
   return gimp_procedure_new_return_values (procedure, status, error);
 }
@@ -45,6 +45,27 @@ typedef struct
   gint32  last_index;  /* last layer that will be part of the clipping group */
 } ClippingInfo;
 
+typedef struct
+{
+  PSDchannel *channel;      /* channel receiving the decoded data */
+  guint16     bps;
+  guint16     compression;
+  guint32    *rle_pack_len; /* RLE row lengths, or NULL */
+  gchar      *src;          /* compressed data read from the file */
+  gsize       src_len;
+  gboolean    failed;
+  GError     *error;
+  gboolean    done;         /* set under decode_mutex */
+} PSDChannelJob;
+
+/* Decoded channels take as much memory as the layers' pixels, so only
+ * this many layers are read ahead of the one being assembled.
+ */
+#define MAX_LAYERS_AHEAD 4
+
+static GMutex decode_mutex;
+static GCond  decode_cond;
+
 
 /*  Local function prototypes  */
 static gint             read_header_block          (PSDimage       *img_a,
@@ -126,10 +147,15 @@ static void             free_lyr_a                 (PSDlayer      **lyr_a,
 static void             free_lyr_chn               (PSDchannel    **lyr_chn,
                                                     gint            channel_count);
 
+static void             free_lyr_chn_all           (PSDchannel   ***layer_chn,
+                                                    PSDlayer      **lyr_a,
+                                                    gint            layer_count);
+
 static gboolean         read_RLE_channel           (PSDimage       *img_a,
                                                     PSDchannel     *lyr_chn,
                                                     guint64         channel_data_len,
                                                     GInputStream   *input,
+                                                    PSDChannelJob **job,
                                                     GError        **error);
 
 static gint             read_channel_data          (PSDchannel     *channel,
@@ -138,6 +164,30 @@ static gint             read_channel_data          (PSDchannel     *channel,
                                                     const guint32  *rle_pack_len,
                                                     GInputStream   *input,
                                                     guint32         comp_len,
+                                                    PSDChannelJob **job,
+                                                    GError        **error);
+
+static gint             decode_channel_data        (PSDchannel     *channel,
+                                                    guint16         bps,
+                                                    guint16         compression,
+                                                    const guint32  *rle_pack_len,
+                                                    gchar          *src,
+                                                    gsize           src_len,
+                                                    GError        **error);
+
+static void             decode_channel_job         (gpointer        data,
+                                                    gpointer        user_data);
+
+static gint             finish_channel_jobs        (GPtrArray      *jobs,
+                                                    GError        **error);
+
+static gboolean         read_layer_channels        (PSDimage       *img_a,
+                                                    PSDlayer       *lyr_a,
+                                                    GInputStream   *input,
+                                                    GThreadPool    *pool,
+                                                    GPtrArray      *jobs,
+                                                    PSDchannel   ***lyr_chn,
+                                                    gboolean       *empty_mask,
                                                     GError        **error);
 
 static void             decode_32_bit_predictor    (gchar          *src,
@@ -1782,11 +1832,12 @@ psd_convert_lab_to_srgb (PSDimage *img_a,
 }
 
 static gboolean
-read_RLE_channel (PSDimage      *img_a,
-                  PSDchannel    *lyr_chn,
-                  guint64        channel_data_len,
-                  GInputStream  *input,
-                  GError       **error)
+read_RLE_channel (PSDimage       *img_a,
+                  PSDchannel     *lyr_chn,
+                  guint64         channel_data_len,
+                  GInputStream   *input,
+                  PSDChannelJob **job,
+                  GError        **error)
 {
   gint      rle_count_size = (img_a->version == 1 ? 2 : 4);
   gint      rle_row_size   = lyr_chn->rows * rle_count_size;
@@ -1821,7 +1872,7 @@ read_RLE_channel (PSDimage      *img_a,
 
   if (read_channel_data (lyr_chn, img_a->bps,
                          PSD_COMP_RLE, rle_pack_len, input, 0,
-                         error) < 1)
+                         job, error) < 1)
     {
       psd_set_error (error);
       g_free (rle_pack_len);
@@ -1843,6 +1894,249 @@ free_lyr_chn (PSDchannel **lyr_chn, gint channel_count)
   g_free (lyr_chn);
 }
 
+static void
+free_lyr_chn_all (PSDchannel ***layer_chn,
+                  PSDlayer    **lyr_a,
+                  gint          layer_count)
+{
+  gint lidx;
+  gint cidx;
+
+  for (lidx = 0; lidx < layer_count; ++lidx)
+    {
+      if (! layer_chn[lidx])
+        continue;
+
+      for (cidx = 0; cidx < lyr_a[lidx]->num_channels; ++cidx)
+        if (layer_chn[lidx][cidx])
+          g_free (layer_chn[lidx][cidx]->data);
+
+      free_lyr_chn (layer_chn[lidx], lyr_a[lidx]->num_channels);
+    }
+  g_free (layer_chn);
+}
+
+static void
+decode_channel_job (gpointer data,
+                    gpointer user_data)
+{
+  PSDChannelJob *job = data;
+
+  if (decode_channel_data (job->channel, job->bps, job->compression,
+                           job->rle_pack_len, job->src, job->src_len,
+                           &job->error) < 1)
+    {
+      job->failed = TRUE;
+    }
+
+  /* decode_channel_data() took ownership of the source data */
+  job->src = NULL;
+
+  g_mutex_lock (&decode_mutex);
+  job->done = TRUE;
+  g_cond_broadcast (&decode_cond);
+  g_mutex_unlock (&decode_mutex);
+}
+
+/* Waits for the channel decodes in jobs to complete and frees the jobs.
+ * Returns -1, setting error from the first failed job, if any of them
+ * failed.
+ */
+static gint
+finish_channel_jobs (GPtrArray  *jobs,
+                     GError    **error)
+{
+  gint result = 0;
+  gint i;
+
+  for (i = 0; i < jobs->len; i++)
+    {
+      PSDChannelJob *job = g_ptr_array_index (jobs, i);
+
+      g_mutex_lock (&decode_mutex);
+      while (! job->done)
+        g_cond_wait (&decode_cond, &decode_mutex);
+      g_mutex_unlock (&decode_mutex);
+
+      if (job->failed && result == 0)
+        {
+          if (job->error)
+            g_propagate_error (error, g_steal_pointer (&job->error));
+
+          psd_set_error (error);
+
+          result = -1;
+        }
+
+      g_clear_error (&job->error);
+      g_free (job->rle_pack_len);
+      g_free (job->src);
+      g_free (job);
+    }
+  g_ptr_array_free (jobs, TRUE);
+
+  return result;
+}
+
+/* Reads the channel data of a layer, and queues it for decoding on
+ * pool, adding the jobs to jobs.  The channel records are returned in
+ * lyr_chn, also on failure.
+ */
+static gboolean
+read_layer_channels (PSDimage       *img_a,
+                     PSDlayer       *lyr_a,
+                     GInputStream   *input,
+                     GThreadPool    *pool,
+                     GPtrArray      *jobs,
+                     PSDchannel   ***lyr_chn,
+                     gboolean       *empty_mask,
+                     GError        **error)
+{
+  PSDchannel    **chn;
+  PSDChannelJob  *job;
+  gint            cidx;
+
+  /* Empty mask */
+  if (lyr_a->layer_mask.bottom - lyr_a->layer_mask.top == 0
+      || lyr_a->layer_mask.right - lyr_a->layer_mask.left == 0)
+      *empty_mask = TRUE;
+  else
+      *empty_mask = FALSE;
+
+  IFDBG(3) g_debug ("Empty mask %d, size %d %d", *empty_mask,
+                    lyr_a->layer_mask.bottom - lyr_a->layer_mask.top,
+                    lyr_a->layer_mask.right - lyr_a->layer_mask.left);
+
+  /* Load layer channel data */
+  IFDBG(2) g_debug ("Number of channels: %d", lyr_a->num_channels);
+  /* Create pointer array for the channel records */
+  chn = g_new0 (PSDchannel *, lyr_a->num_channels);
+  *lyr_chn = chn;
+  for (cidx = 0; cidx < lyr_a->num_channels; ++cidx)
+    {
+      guint16 comp_mode = PSD_COMP_RAW;
+
+      job = NULL;
+
+      /* Allocate channel record */
+      chn[cidx] = g_malloc (sizeof (PSDchannel) );
+
+      chn[cidx]->id = lyr_a->chn_info[cidx].channel_id;
+      chn[cidx]->rows = lyr_a->bottom - lyr_a->top;
+      chn[cidx]->columns = lyr_a->right - lyr_a->left;
+      chn[cidx]->data = NULL;
+
+      if (chn[cidx]->id == PSD_CHANNEL_EXTRA_MASK)
+        {
+          if (! psd_seek (input, lyr_a->chn_info[cidx].data_len,
+                          G_SEEK_CUR, error))
+            {
+              psd_set_error (error);
+              return FALSE;
+            }
+
+          continue;
+        }
+      else if (chn[cidx]->id == PSD_CHANNEL_MASK)
+        {
+          /* Works around a bug in panotools psd files where the layer mask
+             size is given as 0 but data exists. Set mask size to layer size.
+          */
+          if (*empty_mask && lyr_a->chn_info[cidx].data_len - 2 > 0)
+            {
+              *empty_mask = FALSE;
+              if (lyr_a->layer_mask.top == lyr_a->layer_mask.bottom)
+                {
+                  lyr_a->layer_mask.top = lyr_a->top;
+                  lyr_a->layer_mask.bottom = lyr_a->bottom;
+                }
+              if (lyr_a->layer_mask.right == lyr_a->layer_mask.left)
+                {
+                  lyr_a->layer_mask.right = lyr_a->right;
+                  lyr_a->layer_mask.left = lyr_a->left;
+                }
+            }
+          chn[cidx]->rows = (lyr_a->layer_mask.bottom -
+                             lyr_a->layer_mask.top);
+          chn[cidx]->columns = (lyr_a->layer_mask.right -
+                                lyr_a->layer_mask.left);
+        }
+
+      IFDBG(3) g_debug ("Channel id %d, %dx%d",
+                        chn[cidx]->id,
+                        chn[cidx]->columns,
+                        chn[cidx]->rows);
+
+      /* Only read channel data if there is any channel
+       * data. Note that the channel data can contain a
+       * compression method but no actual data.
+       */
+      if (lyr_a->chn_info[cidx].data_len >= COMP_MODE_SIZE)
+        {
+          if (psd_read (input, &comp_mode, COMP_MODE_SIZE, error) < COMP_MODE_SIZE)
+            {
+              psd_set_error (error);
+              return FALSE;
+            }
+
+          if (! img_a->ibm_pc_format)
+            comp_mode = GUINT16_FROM_BE (comp_mode);
+          else
+            comp_mode = GUINT16_FROM_LE (comp_mode);
+          IFDBG(3) g_debug ("Compression mode: %d", comp_mode);
+        }
+      if (lyr_a->chn_info[cidx].data_len > COMP_MODE_SIZE)
+        {
+          switch (comp_mode)
+            {
+              case PSD_COMP_RAW:        /* Planar raw data */
+                IFDBG(3) g_debug ("Raw data length: %" G_GSIZE_FORMAT,
+                                  lyr_a->chn_info[cidx].data_len - 2);
+                if (read_channel_data (chn[cidx], img_a->bps,
+                                       PSD_COMP_RAW, NULL, input, 0,
+                                       &job, error) < 1)
+                  {
+                    psd_set_error (error);
+                    return FALSE;
+                  }
+                break;
+
+              case PSD_COMP_RLE:        /* Packbits */
+                if (! read_RLE_channel (img_a, chn[cidx],
+                                        lyr_a->chn_info[cidx].data_len,
+                                        input, &job, error))
+                  {
+                    psd_set_error (error);
+                    return FALSE;
+                  }
+                break;
+
+              case PSD_COMP_ZIP:                 /* ? */
+              case PSD_COMP_ZIP_PRED:
+                if (read_channel_data (chn[cidx], img_a->bps,
+                                       comp_mode, NULL, input,
+                                       lyr_a->chn_info[cidx].data_len - 2,
+                                       &job, error) < 1)
+                  {
+                    psd_set_error (error);
+                    return FALSE;
+                  }
+                break;
+
+              default:
+                g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
+                             _("Unsupported compression mode: %d"), comp_mode);
+                return FALSE;
+            }
+
+          g_ptr_array_add (jobs, job);
+          g_thread_pool_push (pool, job, NULL);
+        }
+    }
+
+  return TRUE;
+}
+
 static void
 check_duplicate_clipping_group (PSDlayer     **lyr_a,
                                 gint16         num_layers,
@@ -2037,6 +2331,11 @@ add_layers (GimpImage     *image,
             GError       **error)
 {
   PSDchannel          **lyr_chn;
+  PSDchannel         ***layer_chn;
+  gboolean             *layer_empty_mask;
+  GPtrArray           **layer_jobs;
+  GThreadPool          *pool;
+  GPtrArray            *jobs;
   GArray               *parent_group_stack;
   GimpLayer            *parent_group = NULL;
   guint16               alpha_chn;
@@ -2056,6 +2355,7 @@ add_layers (GimpImage     *image,
   GimpLayerMask        *mask            = NULL;
   GList                *selected_layers = NULL;
   gint                  lidx;                  /* Layer index */
+  gint                  read_lidx;             /* Next layer to read */
   gint                  cidx;                  /* Channel index */
   gboolean              alpha;
   gboolean              user_mask;
@@ -2087,155 +2387,56 @@ add_layers (GimpImage     *image,
   parent_group_stack = g_array_new (FALSE, FALSE, sizeof (GimpLayer *));
   g_array_append_val (parent_group_stack, parent_group);
 
+  /* Channel data is read from the file ahead of the layer being
+   * assembled, and decoded (unpacked, inflated, byte swapped)
+   * concurrently on a thread pool while the reading goes on.  Each
+   * layer is assembled in stack order as soon as its own channels are
+   * decoded, and at most MAX_LAYERS_AHEAD layers are read ahead, so
+   * that only a few layers' channels are held in memory at once.
+   */
+  layer_chn        = g_new0 (PSDchannel **, img_a->num_layers);
+  layer_empty_mask = g_new0 (gboolean, img_a->num_layers);
+  layer_jobs       = g_new0 (GPtrArray *, img_a->num_layers);
+  pool             = g_thread_pool_new (decode_channel_job, NULL,
+                                        gimp_get_num_processors (),
+                                        FALSE, NULL);
+  read_lidx        = 0;
+
   for (lidx = 0; lidx < img_a->num_layers; ++lidx)
     {
-      IFDBG(2) g_debug ("Process Layer No %d (%s).", lidx, lyr_a[lidx]->name);
-
-      /* Empty layer */
-      if (lyr_a[lidx]->bottom - lyr_a[lidx]->top == 0
-          || lyr_a[lidx]->right - lyr_a[lidx]->left == 0)
-          empty = TRUE;
-      else
-          empty = FALSE;
-
-      /* Empty mask */
-      if (lyr_a[lidx]->layer_mask.bottom - lyr_a[lidx]->layer_mask.top == 0
-          || lyr_a[lidx]->layer_mask.right - lyr_a[lidx]->layer_mask.left == 0)
-          empty_mask = TRUE;
-      else
-          empty_mask = FALSE;
-
-      IFDBG(3) g_debug ("Empty mask %d, size %d %d", empty_mask,
-                        lyr_a[lidx]->layer_mask.bottom - lyr_a[lidx]->layer_mask.top,
-                        lyr_a[lidx]->layer_mask.right - lyr_a[lidx]->layer_mask.left);
-
-      /* Load layer channel data */
-      IFDBG(2) g_debug ("Number of channels: %d", lyr_a[lidx]->num_channels);
-      /* Create pointer array for the channel records */
-      lyr_chn = g_new0 (PSDchannel *, lyr_a[lidx]->num_channels);
-      for (cidx = 0; cidx < lyr_a[lidx]->num_channels; ++cidx)
+      for (; read_lidx < img_a->num_layers &&
+             read_lidx <= lidx + MAX_LAYERS_AHEAD; ++read_lidx)
         {
-          guint16 comp_mode = PSD_COMP_RAW;
-
-          /* Allocate channel record */
-          lyr_chn[cidx] = g_malloc (sizeof (PSDchannel) );
+          IFDBG(2) g_debug ("Read Layer No %d (%s).",
+                            read_lidx, lyr_a[read_lidx]->name);
 
-          lyr_chn[cidx]->id = lyr_a[lidx]->chn_info[cidx].channel_id;
-          lyr_chn[cidx]->rows = lyr_a[lidx]->bottom - lyr_a[lidx]->top;
-          lyr_chn[cidx]->columns = lyr_a[lidx]->right - lyr_a[lidx]->left;
-          lyr_chn[cidx]->data = NULL;
+          layer_jobs[read_lidx] = g_ptr_array_new ();
 
-          if (lyr_chn[cidx]->id == PSD_CHANNEL_EXTRA_MASK)
-            {
-              if (! psd_seek (input, lyr_a[lidx]->chn_info[cidx].data_len,
-                              G_SEEK_CUR, error))
-                {
-                  psd_set_error (error);
-                  free_lyr_chn (lyr_chn, lyr_a[lidx]->num_channels);
-                  return -1;
-                }
+          if (! read_layer_channels (img_a, lyr_a[read_lidx], input, pool,
+                                     layer_jobs[read_lidx],
+                                     &layer_chn[read_lidx],
+                                     &layer_empty_mask[read_lidx],
+                                     error))
+            goto read_error;
+        }
 
-              continue;
-            }
-          else if (lyr_chn[cidx]->id == PSD_CHANNEL_MASK)
-            {
-              /* Works around a bug in panotools psd files where the layer mask
-                 size is given as 0 but data exists. Set mask size to layer size.
-              */
-              if (empty_mask && lyr_a[lidx]->chn_info[cidx].data_len - 2 > 0)
-                {
-                  empty_mask = FALSE;
-                  if (lyr_a[lidx]->layer_mask.top == lyr_a[lidx]->layer_mask.bottom)
-                    {
-                      lyr_a[lidx]->layer_mask.top = lyr_a[lidx]->top;
-                      lyr_a[lidx]->layer_mask.bottom = lyr_a[lidx]->bottom;
-                    }
-                  if (lyr_a[lidx]->layer_mask.right == lyr_a[lidx]->layer_mask.left)
-                    {
-                      lyr_a[lidx]->layer_mask.right = lyr_a[lidx]->right;
-                      lyr_a[lidx]->layer_mask.left = lyr_a[lidx]->left;
-                    }
-                }
-              lyr_chn[cidx]->rows = (lyr_a[lidx]->layer_mask.bottom -
-                                    lyr_a[lidx]->layer_mask.top);
-              lyr_chn[cidx]->columns = (lyr_a[lidx]->layer_mask.right -
-                                        lyr_a[lidx]->layer_mask.left);
-            }
+      jobs             = layer_jobs[lidx];
+      layer_jobs[lidx] = NULL;
 
-          IFDBG(3) g_debug ("Channel id %d, %dx%d",
-                            lyr_chn[cidx]->id,
-                            lyr_chn[cidx]->columns,
-                            lyr_chn[cidx]->rows);
+      if (finish_channel_jobs (jobs, error) < 0)
+        goto read_error;
 
-          /* Only read channel data if there is any channel
-           * data. Note that the channel data can contain a
-           * compression method but no actual data.
-           */
-          if (lyr_a[lidx]->chn_info[cidx].data_len >= COMP_MODE_SIZE)
-            {
-              if (psd_read (input, &comp_mode, COMP_MODE_SIZE, error) < COMP_MODE_SIZE)
-                {
-                  psd_set_error (error);
-                  free_lyr_chn (lyr_chn, lyr_a[lidx]->num_channels);
-                  return -1;
-                }
+      IFDBG(2) g_debug ("Process Layer No %d (%s).", lidx, lyr_a[lidx]->name);
 
-              if (! img_a->ibm_pc_format)
-                comp_mode = GUINT16_FROM_BE (comp_mode);
-              else
-                comp_mode = GUINT16_FROM_LE (comp_mode);
-              IFDBG(3) g_debug ("Compression mode: %d", comp_mode);
-            }
-          if (lyr_a[lidx]->chn_info[cidx].data_len > COMP_MODE_SIZE)
-            {
-              switch (comp_mode)
-                {
-                  case PSD_COMP_RAW:        /* Planar raw data */
-                    IFDBG(3) g_debug ("Raw data length: %" G_GSIZE_FORMAT,
-                                      lyr_a[lidx]->chn_info[cidx].data_len - 2);
-                    if (read_channel_data (lyr_chn[cidx], img_a->bps,
-                                           PSD_COMP_RAW, NULL, input, 0,
-                                           error) < 1)
-                      {
-                        psd_set_error (error);
-                        free_lyr_chn (lyr_chn, lyr_a[lidx]->num_channels);
-                        return -1;
-                      }
-                    break;
+      lyr_chn    = layer_chn[lidx];
+      empty_mask = layer_empty_mask[lidx];
 
-                  case PSD_COMP_RLE:        /* Packbits */
-                    if (! read_RLE_channel (img_a, lyr_chn[cidx],
-                                            lyr_a[lidx]->chn_info[cidx].data_len,
-                                            input, error))
-                      {
-                        psd_set_error (error);
-                        free_lyr_chn (lyr_chn, lyr_a[lidx]->num_channels);
-                        return -1;
-                      }
-                    break;
-
-                  case PSD_COMP_ZIP:                 /* ? */
-                  case PSD_COMP_ZIP_PRED:
-                    if (read_channel_data (lyr_chn[cidx], img_a->bps,
-                                           comp_mode, NULL, input,
-                                           lyr_a[lidx]->chn_info[cidx].data_len - 2,
-                                           error) < 1)
-                      {
-                        psd_set_error (error);
-                        free_lyr_chn (lyr_chn, lyr_a[lidx]->num_channels);
-                        return -1;
-                      }
-                    break;
-
-                  default:
-                    g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
-                                 _("Unsupported compression mode: %d"), comp_mode);
-                    free_lyr_chn (lyr_chn, lyr_a[lidx]->num_channels);
-                    return -1;
-                    break;
-                }
-            }
-        }
+      /* Empty layer */
+      if (lyr_a[lidx]->bottom - lyr_a[lidx]->top == 0
+          || lyr_a[lidx]->right - lyr_a[lidx]->left == 0)
+          empty = TRUE;
+      else
+          empty = FALSE;
 
       /* Draw layer */
 
@@ -2747,13 +2948,18 @@ add_layers (GimpImage     *image,
         }
 
       free_lyr_chn (lyr_chn, lyr_a[lidx]->num_channels);
+      layer_chn[lidx] = NULL;
 
       g_free (lyr_a[lidx]->chn_info);
       g_free (lyr_a[lidx]->name);
       g_free (lyr_a[lidx]->layer_styles);
       g_free (lyr_a[lidx]);
     }
+  g_thread_pool_free (pool, FALSE, TRUE);
+  g_free (layer_jobs);
   g_free (lyr_a);
+  g_free (layer_chn);
+  g_free (layer_empty_mask);
   g_array_free (parent_group_stack, FALSE);
 
   /* Set the selected layers */
@@ -2761,6 +2967,20 @@ add_layers (GimpImage     *image,
   g_list_free (img_a->layer_selection);
 
   return 0;
+
+ read_error:
+  g_thread_pool_free (pool, FALSE, TRUE);
+  for (lidx = 0; lidx < img_a->num_layers; ++lidx)
+    {
+      if (layer_jobs[lidx])
+        finish_channel_jobs (layer_jobs[lidx], NULL);
+    }
+  g_free (layer_jobs);
+  free_lyr_chn_all (layer_chn, lyr_a, img_a->num_layers);
+  g_free (layer_empty_mask);
+  g_array_free (parent_group_stack, FALSE);
+
+  return -1;
 }
 
 static void
@@ -3015,7 +3235,7 @@ add_merged_image (GimpImage     *image,
                 chn_a[cidx].rows = img_a->rows;
                 if (read_channel_data (&chn_a[cidx], img_a->bps,
                                        PSD_COMP_RAW, NULL, input, 0,
-                                       error) < 1)
+                                       NULL, error) < 1)
                   return -1;
               }
             break;
@@ -3061,7 +3281,7 @@ add_merged_image (GimpImage     *image,
                 {
                   if (read_channel_data (&chn_a[cidx], img_a->bps,
                                         PSD_COMP_RLE, rle_pack_len[cidx], input, 0,
-                                        error) < 1)
+                                        NULL, error) < 1)
                     return -1;
                   g_free (rle_pack_len[cidx]);
                 }
@@ -3437,12 +3657,13 @@ read_channel_data (PSDchannel     *channel,
                    const guint32  *rle_pack_len,
                    GInputStream   *input,
                    guint32         comp_len,
+                   PSDChannelJob **job,
                    GError        **error)
 {
-  gchar    *raw_data = NULL;
   gchar    *src;
+  guint64   src_len;
   guint32   readline_len;
-  gint      i, j;
+  gint      i;
 
   if (bps == 1)
     readline_len = ((channel->columns + 7) / 8);
@@ -3461,58 +3682,123 @@ read_channel_data (PSDchannel     *channel,
       return -1;
     }
 
-  raw_data = g_malloc (readline_len * channel->rows);
   switch (compression)
     {
       case PSD_COMP_RAW:
-        if (psd_read (input, raw_data, readline_len * channel->rows, error) < readline_len * channel->rows)
-          {
-            psd_set_error (error);
-            g_free (raw_data);
-            return -1;
-          }
+        src_len = (guint64) readline_len * channel->rows;
         break;
 
       case PSD_COMP_RLE:
+        src_len = 0;
         for (i = 0; i < channel->rows; ++i)
-          {
-            src = gegl_scratch_alloc (rle_pack_len[i]);
-/*      FIXME check for over-run
-            if (PSD_TELL(input) + rle_pack_len[i] > block_end)
-              {
-                psd_set_error (TRUE, errno, error);
-                return -1;
-              }
-*/
-            if (psd_read (input, src, rle_pack_len[i], error) < rle_pack_len[i])
-              {
-                psd_set_error (error);
-                gegl_scratch_free (src);
-                g_free (raw_data);
-                return -1;
-              }
-            /* FIXME check for errors returned from decode packbits */
-            decode_packbits (src, raw_data + i * readline_len,
-                             rle_pack_len[i], readline_len);
-            gegl_scratch_free (src);
-          }
+          src_len += rle_pack_len[i];
         break;
+
       case PSD_COMP_ZIP:
       case PSD_COMP_ZIP_PRED:
+        src_len = comp_len;
+        break;
+
+      default:
+        return -1;
+    }
+
+  /* Read the whole (compressed) channel in one go, so that decoding
+   * can happen without touching the input stream.
+   */
+  src = (src_len <= G_MAXINT) ? g_try_malloc (MAX (src_len, 1)) : NULL;
+  if (! src)
+    {
+      g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
+                   _("Unsupported or invalid channel size"));
+      return -1;
+    }
+
+  if (psd_read (input, src, (gint) src_len, error) < (gint) src_len)
+    {
+      psd_set_error (error);
+      g_free (src);
+      return -1;
+    }
+
+  if (job)
+    {
+      /* Defer decoding to the caller's thread pool */
+      *job = g_new0 (PSDChannelJob, 1);
+
+      (*job)->channel     = channel;
+      (*job)->bps         = bps;
+      (*job)->compression = compression;
+      (*job)->src         = src;
+      (*job)->src_len     = src_len;
+
+      if (rle_pack_len)
+        (*job)->rle_pack_len = g_memdup2 (rle_pack_len,
+                                          channel->rows * sizeof (guint32));
+
+      return 1;
+    }
+
+  return decode_channel_data (channel, bps, compression, rle_pack_len,
+                              src, src_len, error);
+}
+
+/* Decodes the compressed channel data read by read_channel_data() into
+ * channel->data.  Takes ownership of src.  Does not access the input
+ * stream or any GIMP objects, and may therefore run in a worker thread.
+ */
+static gint
+decode_channel_data (PSDchannel     *channel,
+                     guint16         bps,
+                     guint16         compression,
+                     const guint32  *rle_pack_len,
+                     gchar          *src,
+                     gsize           src_len,
+                     GError        **error)
+{
+  gchar    *raw_data = NULL;
+  guint32   readline_len;
+  gint      i, j;
+
+  if (bps == 1)
+    readline_len = ((channel->columns + 7) / 8);
+  else
+    readline_len = (channel->columns * bps / 8);
+
+  switch (compression)
+    {
+      case PSD_COMP_RAW:
+        raw_data = src;
+        src      = NULL;
+        break;
+
+      case PSD_COMP_RLE:
         {
-          z_stream zs;
+          gsize offset = 0;
 
-          src = g_malloc (comp_len);
-          if (psd_read (input, src, comp_len, error) < comp_len)
+          raw_data = g_malloc (readline_len * channel->rows);
+
+          for (i = 0; i < channel->rows; ++i)
             {
-              psd_set_error (error);
-              g_free (src);
-              g_free (raw_data);
-              return -1;
+              /* FIXME check for errors returned from decode packbits */
+              decode_packbits (src + offset, raw_data + i * readline_len,
+                               rle_pack_len[i], readline_len);
+              offset += rle_pack_len[i];
             }
 
+          g_free (src);
+          break;
+        }
+
+      case PSD_COMP_ZIP:
+      case PSD_COMP_ZIP_PRED:
+        {
+          z_stream zs;
+
+          raw_data = g_malloc (readline_len * channel->rows);
+
           zs.next_in = (guchar*) src;
-          zs.avail_in = comp_len;
+          zs.avail_in = src_len;
           zs.next_out = (guchar*) raw_data;
           zs.avail_out = readline_len * channel->rows;
           zs.zalloc = zzalloc;
@@ -3535,6 +3821,10 @@ read_channel_data (PSDchannel     *channel,
           g_free (src);
           break;
         }
+
+      default:
+        g_free (src);
+        return -1;
     }
 
   /* Convert channel data to GIMP format */
@@ -156,6 +156,9 @@
     _OP_DEF(opexe_4, "quit",                           0,  1,       TST_NUMBER,                      OP_QUIT             )
     _OP_DEF(opexe_4, "gc",                             0,  0,       0,                               OP_GC               )
     _OP_DEF(opexe_4, "gc-verbose",                     0,  1,       TST_NONE,                        OP_GCVERB           )
+    _OP_DEF(opexe_4, "gc-incremental",                 0,  1,       TST_NONE,                        OP_GCINCR           )
+    _OP_DEF(opexe_4, "gc-heap-target",                 0,  1,       TST_NATURAL,                     OP_GCTARGET         )
+    _OP_DEF(opexe_4, "gc-stats",                       0,  0,       0,                               OP_GCSTATS          )
     _OP_DEF(opexe_4, "new-segment",                    0,  1,       TST_NUMBER,                      OP_NEWSEGMENT       )
     _OP_DEF(opexe_4, "oblist",                         0,  0,       0,                               OP_OBLIST           )
     _OP_DEF(opexe_4, "current-input-port",             0,  0,       0,                               OP_CURR_INPORT      )
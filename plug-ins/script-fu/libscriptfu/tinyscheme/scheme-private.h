@@ -80,12 +80,17 @@ int tracing;
 #ifndef CELL_SEGSIZE
 #define CELL_SEGSIZE    25000 /* # of cells in one segment */
 #endif
+#ifndef CELL_SEGSIZE_MAX
+#define CELL_SEGSIZE_MAX (CELL_SEGSIZE * 64) /* # of cells in largest segment */
+#endif
 #ifndef CELL_NSEGMENT
 #define CELL_NSEGMENT   50    /* # of segments for cells */
 #endif
 char *alloc_seg[CELL_NSEGMENT];
 pointer cell_seg[CELL_NSEGMENT];
+long    cell_seg_size[CELL_NSEGMENT];
 int     last_cell_seg;
+long    total_cells;     /* # of cells in all segments */
 
 /* We use 5 registers. */
 pointer args;            /* register for arguments of function */
@@ -143,6 +148,15 @@ int file_i;
 int nesting;
 
 char    gc_verbose;      /* if gc_verbose is not zero, print gc status */
+char    gc_incremental;  /* if not zero, sweep segments lazily after gc */
+int     gc_heap_target;  /* % of the heap a gc should leave free */
+int     sweep_seg;       /* next segment to sweep, -1 if none pending */
+pointer sweep_tail;      /* last cell of the free list while sweeping */
+long    sweep_freed;     /* # of cells reclaimed by the current gc */
+long    gc_count;        /* # of collections so far */
+gint64  gc_reclaimed;    /* # of cells reclaimed by all collections */
+gint64  gc_time;         /* time spent in gc, in microseconds */
+gint64  gc_max_pause;    /* longest single gc, in microseconds */
 char    no_memory;       /* Whether mem. alloc. has failed */
 
 #ifndef LINESIZE
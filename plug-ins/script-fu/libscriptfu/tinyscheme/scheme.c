@@ -183,6 +183,10 @@ static int utf8_stricmp(const char *s1, const char *s2)
 # define FIRST_CELLSEGS 3
 #endif
 
+#ifndef GC_HEAP_TARGET
+# define GC_HEAP_TARGET 20 /* % of the heap to keep free after gc */
+#endif
+
 enum scheme_types {
   T_STRING=1,
   T_NUMBER=2,
@@ -438,6 +442,8 @@ static port *port_rep_from_file(scheme *sc, FILE *, int prop);
 static void port_close(scheme *sc, pointer p, int flag);
 static void mark(pointer a);
 static void gc(scheme *sc, pointer a, pointer b);
+static void gc_sweep_step(scheme *sc);
+static void gc_sweep_finish(scheme *sc);
 static gint basic_inbyte (port *pt);
 static gint inbyte (scheme *sc);
 static void backbyte (scheme *sc, gint b);
@@ -655,13 +661,17 @@ static long binary_decode(const char *s) {
  return x;
 }
 
-/* allocate new cell segment */
+/* allocate new cell segment.  Segments grow with the heap, each one
+   holding half as many cells as the heap already has, between
+   CELL_SEGSIZE and CELL_SEGSIZE_MAX.
+*/
 static int alloc_cellseg(scheme *sc, int n) {
      pointer newp;
      pointer last;
      pointer p;
      char *cp;
      long i;
+     long size;
      int k;
      int adj=ADJ;
 
@@ -669,10 +679,14 @@ static int alloc_cellseg(scheme *sc, int n) {
        adj=sizeof(struct cell);
      }
 
+     /* segments are reordered below, finish sweeping them first */
+     gc_sweep_finish(sc);
+
      for (k = 0; k < n; k++) {
           if (sc->last_cell_seg >= CELL_NSEGMENT - 1)
                return k;
-          cp = (char*) sc->malloc(CELL_SEGSIZE * sizeof(struct cell)+adj);
+          size = MIN (MAX (sc->total_cells / 2, CELL_SEGSIZE), CELL_SEGSIZE_MAX);
+          cp = (char*) sc->malloc(size * sizeof(struct cell)+adj);
           if (cp == 0)
                return k;
           i = ++sc->last_cell_seg ;
@@ -684,13 +698,17 @@ static int alloc_cellseg(scheme *sc, int n) {
         /* insert new segment in address order */
           newp=(pointer)cp;
         sc->cell_seg[i] = newp;
+        sc->cell_seg_size[i] = size;
         while (i > 0 && sc->cell_seg[i - 1] > sc->cell_seg[i]) {
               p = sc->cell_seg[i];
             sc->cell_seg[i] = sc->cell_seg[i - 1];
-            sc->cell_seg[--i] = p;
+            sc->cell_seg[i - 1] = p;
+            sc->cell_seg_size[i] = sc->cell_seg_size[i - 1];
+            sc->cell_seg_size[--i] = size;
         }
-          sc->fcells += CELL_SEGSIZE;
-        last = newp + CELL_SEGSIZE - 1;
+          sc->fcells += size;
+          sc->total_cells += size;
+        last = newp + size - 1;
           for (p = newp; p <= last; p++) {
                typeflag(p) = 0;
                cdr(p) = p + 1;
@@ -730,12 +748,13 @@ static pointer _get_cell(scheme *sc, pointer a, pointer b) {
     return sc->sink;
   }
 
+  /* continue a pending incremental sweep before collecting again */
+  gc_sweep_step(sc);
+
   if (sc->free_cell == sc->NIL) {
-    const int min_to_be_recovered = sc->last_cell_seg*8;
+    /* gc grows the heap itself if too few cells were recovered */
     gc(sc,a, b);
-    if (sc->fcells < min_to_be_recovered
-        || sc->free_cell == sc->NIL) {
-      /* if only a few recovered, get more to avoid fruitless gc's */
+    if (sc->free_cell == sc->NIL) {
       if (!alloc_cellseg(sc,1) && sc->free_cell == sc->NIL) {
         g_warning ("%s", G_STRFUNC);
         sc->no_memory=1;
@@ -756,9 +775,13 @@ static pointer reserve_cells(scheme *sc, int n) {
        }
 
        /* Are there enough cells available? */
+       if (sc->fcells < n) {
+               gc_sweep_finish(sc);
+       }
        if (sc->fcells < n) {
                /* If not, try gc'ing some */
                gc(sc, sc->NIL, sc->NIL);
+               gc_sweep_finish(sc);
                if (sc->fcells < n) {
                        /* If there still aren't, try getting more heap */
                        if (!alloc_cellseg(sc,1)) {
@@ -782,12 +805,16 @@ static pointer get_consecutive_cells(scheme *sc, int n) {
 
   if(sc->no_memory) { return sc->sink; }
 
+  /* The free list must be complete to find a consecutive range */
+  gc_sweep_finish(sc);
+
   /* Are there any cells available? */
   x=find_consecutive_cells(sc,n);
   if (x != sc->NIL) { return x; }
 
   /* If not, try gc'ing some */
   gc(sc, sc->NIL, sc->NIL);
+  gc_sweep_finish(sc);
   x=find_consecutive_cells(sc,n);
   if (x != sc->NIL) { return x; }
 
@@ -1456,10 +1483,103 @@ E6:   /* up.  Undo the link switching from steps E4 and E5. */
      }
 }
 
-/* garbage collection. parameter a, b is marked. */
-static void gc(scheme *sc, pointer a, pointer b) {
+/* sweep cell segment i, appending its unmarked cells to the free-list.
+   Cells are scanned downwards so the segment's run is sorted by
+   address; segments are swept in ascending order, so the free-list
+   stays sorted too.
+*/
+static void gc_sweep_segment(scheme *sc, int i) {
   pointer p;
-  int i;
+  pointer head = sc->NIL;
+  pointer tail = sc->NIL;
+  long    n = 0;
+
+  p = sc->cell_seg[i] + sc->cell_seg_size[i];
+  while (--p >= sc->cell_seg[i]) {
+    if (is_mark(p)) {
+      clrmark(p);
+    } else {
+      /* reclaim cell */
+      if (typeflag(p) != 0) {
+        finalize_cell(sc, p);
+        typeflag(p) = 0;
+        car(p) = sc->NIL;
+      }
+      if (tail == sc->NIL) {
+        tail = p;
+      }
+      cdr(p) = head;
+      head = p;
+      n++;
+    }
+  }
+
+  if (head == sc->NIL) {
+    return;
+  }
+  /* the free-list is only consumed from its head while sweeping, so
+     sweep_tail is still its last cell if it is not empty */
+  if (sc->free_cell == sc->NIL) {
+    sc->free_cell = head;
+  } else {
+    cdr(sc->sweep_tail) = head;
+  }
+  sc->sweep_tail = tail;
+  sc->fcells += n;
+  sc->sweep_freed += n;
+  sc->gc_reclaimed += n;
+}
+
+/* the sweep is complete: grow the heap until the collection left at
+   least gc_heap_target percent of it free, so that a nearly full heap
+   does not trigger a fruitless gc after every few allocations */
+static void gc_sweep_done(scheme *sc) {
+  long total;
+
+  sc->sweep_seg = -1;
+
+  while ((gint64) sc->sweep_freed * 100 <
+         (gint64) sc->total_cells * sc->gc_heap_target) {
+    total = sc->total_cells;
+    if (!alloc_cellseg(sc, 1)) {
+      break;
+    }
+    sc->sweep_freed += sc->total_cells - total;
+  }
+}
+
+/* sweep pending segments until some cells are free */
+static void gc_sweep_step(scheme *sc) {
+  while (sc->sweep_seg >= 0 && sc->free_cell == sc->NIL) {
+    gc_sweep_segment(sc, sc->sweep_seg);
+    if (++sc->sweep_seg > sc->last_cell_seg) {
+      gc_sweep_done(sc);
+    }
+  }
+}
+
+/* sweep all pending segments */
+static void gc_sweep_finish(scheme *sc) {
+  while (sc->sweep_seg >= 0) {
+    gc_sweep_segment(sc, sc->sweep_seg);
+    if (++sc->sweep_seg > sc->last_cell_seg) {
+      gc_sweep_done(sc);
+    }
+  }
+}
+
+/* garbage collection. parameter a, b is marked.
+   In incremental mode only the first segments holding garbage are
+   swept here; the rest are swept by _get_cell as cells are needed.
+*/
+static void gc(scheme *sc, pointer a, pointer b) {
+  gint64 start;
+  gint64 pause;
+
+  /* unswept cells still carry the marks of the previous collection */
+  gc_sweep_finish(sc);
+
+  start = g_get_monotonic_time();
 
   if(sc->gc_verbose) {
     putstr(sc, "gc...");
@@ -1493,33 +1613,34 @@ static void gc(scheme *sc, pointer a, pointer b) {
   clrmark(sc->NIL);
   sc->fcells = 0;
   sc->free_cell = sc->NIL;
+  sc->sweep_tail = sc->NIL;
+  sc->sweep_freed = 0;
   /* free-list is kept sorted by address so as to maintain consecutive
-     ranges, if possible, for use with vectors. Here we scan the cells
-     (which are also kept sorted by address) downwards to build the
-     free-list in sorted order.
+     ranges, if possible, for use with vectors.
   */
-  for (i = sc->last_cell_seg; i >= 0; i--) {
-    p = sc->cell_seg[i] + CELL_SEGSIZE;
-    while (--p >= sc->cell_seg[i]) {
-      if (is_mark(p)) {
-        clrmark(p);
-      } else {
-        /* reclaim cell */
-        if (typeflag(p) != 0) {
-          finalize_cell(sc, p);
-          typeflag(p) = 0;
-          car(p) = sc->NIL;
-        }
-        ++sc->fcells;
-        cdr(p) = sc->free_cell;
-        sc->free_cell = p;
-      }
-    }
+  sc->sweep_seg = 0;
+  if (sc->gc_incremental) {
+    gc_sweep_step(sc);
+  } else {
+    gc_sweep_finish(sc);
   }
 
+  pause = g_get_monotonic_time() - start;
+  sc->gc_count++;
+  sc->gc_time += pause;
+  sc->gc_max_pause = MAX (sc->gc_max_pause, pause);
+
   if (sc->gc_verbose) {
-    char msg[80];
-    snprintf(msg,80,"done: %ld cells were recovered.\n", sc->fcells);
+    char msg[160];
+    if (sc->sweep_seg >= 0) {
+      snprintf(msg,160,"done: %ld cells were recovered so far, "
+               "heap is %ld cells (%" G_GINT64_FORMAT " us).\n",
+               sc->sweep_freed, sc->total_cells, pause);
+    } else {
+      snprintf(msg,160,"done: %ld cells were recovered, "
+               "heap is %ld cells (%" G_GINT64_FORMAT " us).\n",
+               sc->sweep_freed, sc->total_cells, pause);
+    }
     putstr(sc,msg);
   }
 }
@@ -4233,6 +4354,18 @@ static pointer opexe_3(scheme *sc, enum scheme_opcodes op) {
      return sc->T;
 }
 
+/* Prepends (name . value) to sc->args.  The list is built there since
+ * sc->args is marked by the GC, a list in a C local would not be
+ * protected while the next entries are allocated.
+ */
+static void gc_stats_prepend(scheme *sc, const char *name, long value) {
+     pointer sym;
+
+     sc->args = cons(sc, mk_integer(sc, value), sc->args);
+     sym = mk_symbol(sc, name);
+     car(sc->args) = cons(sc, sym, car(sc->args));
+}
+
 static pointer opexe_4(scheme *sc, enum scheme_opcodes op) {
      pointer x, y;
 
@@ -4418,6 +4551,42 @@ static pointer opexe_4(scheme *sc, enum scheme_opcodes op) {
           s_retbool(was);
      }
 
+     case OP_GCINCR:          /* gc-incremental */
+     {    int  was = sc->gc_incremental;
+
+          sc->gc_incremental = (car(sc->args) != sc->F);
+          if (!sc->gc_incremental) {
+               gc_sweep_finish(sc);
+          }
+          s_retbool(was);
+     }
+
+     case OP_GCTARGET:        /* gc-heap-target */
+     {    int  was = sc->gc_heap_target;
+
+          if (sc->args != sc->NIL) {
+               long target = ivalue(car(sc->args));
+
+               if (target > 90) {
+                    Error_1(sc,"gc-heap-target: percentage must be at most 90:",
+                            car(sc->args));
+               }
+               sc->gc_heap_target = (int) target;
+          }
+          s_return(sc,mk_integer(sc,was));
+     }
+
+     case OP_GCSTATS:         /* gc-stats */
+          sc->args = sc->NIL;
+          gc_stats_prepend(sc, "max-pause-us",    (long) sc->gc_max_pause);
+          gc_stats_prepend(sc, "time-us",         (long) sc->gc_time);
+          gc_stats_prepend(sc, "reclaimed-cells", (long) sc->gc_reclaimed);
+          gc_stats_prepend(sc, "collections",     sc->gc_count);
+          gc_stats_prepend(sc, "free-cells",      sc->fcells);
+          gc_stats_prepend(sc, "heap-cells",      sc->total_cells);
+          gc_stats_prepend(sc, "segments",        sc->last_cell_seg + 1);
+          s_return(sc,sc->args);
+
      case OP_NEWSEGMENT: /* new-segment */
           if (!is_pair(sc->args) || !is_number(car(sc->args))) {
                Error_0(sc,"new-segment: argument must be a number");
@@ -5252,6 +5421,14 @@ int scheme_init_custom_alloc(scheme *sc, func_alloc malloc, func_dealloc free) {
   sc->malloc=malloc;
   sc->free=free;
   sc->last_cell_seg = -1;
+  sc->total_cells = 0;
+  sc->sweep_seg = -1;
+  sc->gc_incremental = 0;
+  sc->gc_heap_target = GC_HEAP_TARGET;
+  sc->gc_count = 0;
+  sc->gc_reclaimed = 0;
+  sc->gc_time = 0;
+  sc->gc_max_pause = 0;
   sc->sink = &sc->_sink;
   sc->NIL = &sc->_NIL;
   sc->T = &sc->_HASHT;
@@ -5380,6 +5557,8 @@ void scheme_deinit(scheme *sc) {
   sc->loadport=sc->NIL;
   error_port_init (sc);
   sc->gc_verbose=0;
+  /* sweep everything now so all cells get finalized */
+  sc->gc_incremental=0;
   gc(sc,sc->NIL,sc->NIL);
 
   for(i=0; i<=sc->last_cell_seg; i++) {